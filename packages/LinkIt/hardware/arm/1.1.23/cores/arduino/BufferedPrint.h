@@ -0,0 +1,152 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _BufferedPrint_h
+#define _BufferedPrint_h
+
+#include <string.h>
+#include "Print.h"
+
+// DESCRIPTION
+//  BufferedPrint<N> collects everything printed to it in an N-byte buffer and
+//  passes it to another Print (the sink) with the sink's bulk write(buf, len)
+//  only when the buffer is full, when flush() is called and when it is
+//  destroyed. Many small print(), println() and printf() calls then cost one
+//  sink call per N bytes, which matters for sinks that do work per call,
+//  such as LFile, LBTServer or LBTClient.
+//
+//  Writes larger than the buffer are passed on directly after what is
+//  buffered. If the sink takes fewer bytes than it is given, the rest is
+//  dropped and getWriteError() reports it.
+//
+// EXAMPLE
+// <code>
+// #include <BufferedPrint.h>
+//
+// void sendReading(LFile &file, int value)
+// {
+//   BufferedPrint<128> out(file);
+//   out.print("{\"sensor\":");
+//   out.print(value);
+//   out.println("}");
+//   // the document reaches file in one write when out goes out of scope
+// }
+// </code>
+template<size_t N>
+class BufferedPrint : public Print
+{
+public:
+  // DESCRIPTION
+  //  Creates the buffer in front of sink. sink must outlive it.
+  explicit BufferedPrint(Print &sink):
+    m_sink(sink),
+    m_len(0)
+  {
+  }
+
+  // DESCRIPTION
+  //  Passes the buffered data to the sink.
+  ~BufferedPrint()
+  {
+    flush();
+  }
+
+  // DESCRIPTION
+  //  Buffers one byte.
+  // RETURNS
+  //  1, or 0 if the buffer was full and the sink did not take it.
+  virtual size_t write(uint8_t c)
+  {
+    if(m_len == N && !flush())
+    {
+      return 0;
+    }
+    m_buf[m_len++] = c;
+    return 1;
+  }
+
+  // DESCRIPTION
+  //  Buffers size bytes, or passes them on directly if they do not fit in
+  //  the buffer.
+  // RETURNS
+  //  Number of bytes accepted.
+  virtual size_t write(const uint8_t *buffer, size_t size)
+  {
+    if(size > N - m_len)
+    {
+      if(!flush())
+      {
+        return 0;
+      }
+      if(size >= N)
+      {
+        const size_t written = m_sink.write(buffer, size);
+        if(written < size)
+        {
+          setWriteError();
+        }
+        return written;
+      }
+    }
+    memcpy(m_buf + m_len, buffer, size);
+    m_len += size;
+    return size;
+  }
+
+  using Print::write;
+
+  // DESCRIPTION
+  //  Passes the buffered data to the sink. It does not flush the sink itself.
+  // RETURNS
+  //  true if the sink took all of it.
+  bool flush()
+  {
+    if(m_len == 0)
+    {
+      return true;
+    }
+    const size_t len = m_len;
+    m_len = 0;
+    if(m_sink.write(m_buf, len) < len)
+    {
+      setWriteError();
+      return false;
+    }
+    return true;
+  }
+
+  // DESCRIPTION
+  //  Number of bytes waiting in the buffer.
+  size_t pending() const
+  {
+    return m_len;
+  }
+
+  // DESCRIPTION
+  //  The Print that receives the data.
+  Print& sink() const
+  {
+    return m_sink;
+  }
+
+private:
+  BufferedPrint(const BufferedPrint&);
+  BufferedPrint& operator=(const BufferedPrint&);
+
+  Print &m_sink;
+  uint8_t m_buf[N];
+  size_t m_len;
+};
+
+#endif
@@ -0,0 +1,32 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LBarrier_h
+#define _LBarrier_h
+
+/* DOM-NOT_FOR_SDK-BEGIN */
+// Orders memory accesses for the lock-free rings and queues shared by the
+// Arduino thread and the MMI thread: data written before LBARRIER() is in
+// place before an index written after it, and likewise for reads.
+// On the single-core ARM926EJ-S it is enough to stop the compiler from
+// moving accesses across it. Host builds, such as the tests in extras/host,
+// run the threads on different cores and need a real fence.
+#ifdef __arm__
+#define LBARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define LBARRIER() __sync_synchronize()
+#endif
+/* DOM-NOT_FOR_SDK-END */
+
+#endif
@@ -0,0 +1,228 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "LConnectionPool.h"
+#include "vmlog.h"
+
+LConnectionPool::LConnectionPool(int maxConnections, unsigned long idleTimeout):
+	m_entries(NULL),
+	m_maxConnections(maxConnections > 0 ? maxConnections : 1),
+	m_idleTimeout(idleTimeout)
+{
+	m_entries = new LConnectionPoolEntry[m_maxConnections];
+	for(int i = 0; i < m_maxConnections; ++i)
+	{
+		m_entries[i].host = NULL;
+		m_entries[i].port = 0;
+		m_entries[i].apn = 0;
+		m_entries[i].idle = false;
+		m_entries[i].idleSince = 0;
+	}
+}
+
+LConnectionPool::~LConnectionPool()
+{
+	clear();
+	delete [] m_entries;
+}
+
+void LConnectionPool::evict(LConnectionPoolEntry *pEntry)
+{
+	vm_log_info("LConnectionPool evict %s:%d", pEntry->host, pEntry->port);
+	free(pEntry->host);
+	pEntry->host = NULL;
+	pEntry->idle = false;
+	// closes the socket unless a client still holds it
+	pEntry->handle = SharedHandle();
+}
+
+boolean LConnectionPool::check(LConnectionPoolEntry *pEntry)
+{
+	LTcpConnection *pConn = pEntry->handle.connection();
+	if(pConn == NULL)
+	{
+		return false;
+	}
+
+	// PIPE_CLOSED, PIPE_BROKEN and read EOF all leave the connection closed
+	if(pConn->m_handle < 0 || pConn->m_status != LTCP_CONN_CONNECTED)
+	{
+		evict(pEntry);
+		return false;
+	}
+
+	// the pool holds the only reference once the last client copy is gone
+	if(pConn->m_refCount > 1)
+	{
+		pEntry->idle = false;
+		return true;
+	}
+
+	if(!pEntry->idle)
+	{
+		pEntry->idle = true;
+		pEntry->idleSince = millis();
+		// the last user may have stopped without flushing
+		if(pConn->m_tx.available() && !pConn->flush())
+		{
+			evict(pEntry);
+			return false;
+		}
+	}
+	else if(millis() - pEntry->idleSince >= m_idleTimeout)
+	{
+		evict(pEntry);
+		return false;
+	}
+	return true;
+}
+
+void LConnectionPool::maintain()
+{
+	for(int i = 0; i < m_maxConnections; ++i)
+	{
+		check(&m_entries[i]);
+	}
+}
+
+int LConnectionPool::connect(LTcpClient &client, IPAddress ip, uint16_t port)
+{
+	char ipAddr[50] = {0};
+	sprintf(ipAddr, 
+			"%d.%d.%d.%d", 
+			ip[0],
+			ip[1], 
+			ip[2], 
+			ip[3]);
+	return connect(client, ipAddr, port);
+}
+
+int LConnectionPool::connect(LTcpClient &client, const char *host, uint16_t port)
+{
+	// returns a connection the client may already hold
+	client.stop();
+
+	const VMINT apn = client.getAPN();
+	LConnectionPoolEntry *pFree = NULL;
+	LConnectionPoolEntry *pOldest = NULL;
+	for(int i = 0; i < m_maxConnections; ++i)
+	{
+		LConnectionPoolEntry *pEntry = &m_entries[i];
+		if(!check(pEntry))
+		{
+			if(pFree == NULL)
+			{
+				pFree = pEntry;
+			}
+			continue;
+		}
+
+		if(!pEntry->idle)
+		{
+			continue;
+		}
+
+		if(pEntry->port == port && pEntry->apn == apn && strcmp(pEntry->host, host) == 0)
+		{
+			if(pEntry->handle.connection()->m_rx.available())
+			{
+				// the last user did not read the whole response
+				evict(pEntry);
+				if(pFree == NULL)
+				{
+					pFree = pEntry;
+				}
+				continue;
+			}
+
+			vm_log_info("LConnectionPool reuse %s:%d", host, port);
+			pEntry->idle = false;
+			client.m_handle = pEntry->handle;
+			return 1;
+		}
+
+		if(pOldest == NULL || (long)(pEntry->idleSince - pOldest->idleSince) < 0)
+		{
+			pOldest = pEntry;
+		}
+	}
+
+	if(pFree == NULL)
+	{
+		if(pOldest == NULL)
+		{
+			vm_log_info("LConnectionPool all %d connections in use", m_maxConnections);
+			return 0;
+		}
+		evict(pOldest);
+		pFree = pOldest;
+	}
+
+	if(!client.connect(host, port))
+	{
+		return 0;
+	}
+
+	pFree->host = (char*)malloc(strlen(host) + 1);
+	if(pFree->host == NULL)
+	{
+		// still connected, just not pooled
+		return 1;
+	}
+	strcpy(pFree->host, host);
+	pFree->port = port;
+	pFree->apn = apn;
+	pFree->idle = false;
+	pFree->handle = client.m_handle;
+	return 1;
+}
+
+void LConnectionPool::clear()
+{
+	for(int i = 0; i < m_maxConnections; ++i)
+	{
+		if(m_entries[i].host)
+		{
+			evict(&m_entries[i]);
+		}
+	}
+}
+
+int LConnectionPool::size() const
+{
+	int n = 0;
+	for(int i = 0; i < m_maxConnections; ++i)
+	{
+		if(m_entries[i].host)
+		{
+			n++;
+		}
+	}
+	return n;
+}
+
+int LConnectionPool::idleCount()
+{
+	int n = 0;
+	for(int i = 0; i < m_maxConnections; ++i)
+	{
+		if(check(&m_entries[i]) && m_entries[i].idle)
+		{
+			n++;
+		}
+	}
+	return n;
+}
@@ -0,0 +1,150 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LConnectionPool_h
+#define _LConnectionPool_h
+
+#include "LTcpClient.h"
+
+// default maximum number of sockets a pool keeps open, idle or in use
+#ifndef LCONNPOOL_MAX_CONNECTIONS
+#define LCONNPOOL_MAX_CONNECTIONS 4
+#endif
+
+// default time an unused connection stays open, in milliseconds
+#ifndef LCONNPOOL_IDLE_TIMEOUT
+#define LCONNPOOL_IDLE_TIMEOUT 30000
+#endif
+
+/* DOM-NOT_FOR_SDK-BEGIN */
+struct LConnectionPoolEntry
+{
+    char *host;             // NULL if the entry is free
+    uint16_t port;
+    VMINT apn;
+    SharedHandle handle;    // the pool's own reference
+    boolean idle;           // no client holds the connection
+    unsigned long idleSince;
+};
+/* DOM-NOT_FOR_SDK-END */
+
+// LConnectionPool Class
+//
+// Keeps TCP connections open after use so that later requests to the same
+// server skip the name lookup and the TCP handshake, which is slow over GPRS.
+// Connections are kept per host, port and bearer (Wi-Fi or GPRS).
+// A connection handed out by connect() returns to the pool when the client
+// calls stop() or is destroyed; it is closed when the server closes it,
+// when it has been unused for the idle timeout, or by clear().
+//
+// EXAMPLE:
+// <code>
+//     LConnectionPool pool;
+//     void upload(const char *data) {
+//         LGPRSClient c;
+//         if (pool.connect(c, "api.example.com", 80)) {
+//             c.print(data);
+//             // read the whole response, then
+//             c.stop();   // back to the pool, the socket stays open
+//         }
+//     }
+// </code>
+class LConnectionPool
+{
+public:
+    // DESCRIPTION
+    //   Constructs an empty pool.
+    // 
+    // PARAMETERS
+    //   maxConnections: maximum number of sockets open at the same time, idle or in use
+    //   idleTimeout: time in milliseconds after which an unused connection is closed
+    LConnectionPool(int maxConnections = LCONNPOOL_MAX_CONNECTIONS, unsigned long idleTimeout = LCONNPOOL_IDLE_TIMEOUT);
+
+    // DESCRIPTION
+    //   Closes all idle connections. Connections still held by clients are closed with them.
+    ~LConnectionPool();
+
+    // DESCRIPTION
+    //   Connects client to a server, reusing an idle connection to the same
+    //   host, port and bearer if there is one. The bearer is the one of client,
+    //   i.e. Wi-Fi for LWiFiClient and GPRS for LGPRSClient.
+    //   When the pool is full, the connection unused for the longest time is
+    //   closed to make room; if all of them are in use, connect() fails.
+    // 
+    // PARAMETERS
+    //   client: LWiFiClient or LGPRSClient to be connected. Its current connection is stopped.
+    //   host: server name or address
+    //   port: TCP port to be connected
+    // 
+    // RETURNS
+    //   1 if connected, 0 otherwise.
+    int connect(LTcpClient &client, const char *host, uint16_t port);
+
+    // DESCRIPTION
+    //   Connects client to a server, see connect(LTcpClient&, const char*, uint16_t).
+    // 
+    // PARAMETERS
+    //   client: LWiFiClient or LGPRSClient to be connected
+    //   ip: server address
+    //   port: TCP port to be connected
+    // 
+    // RETURNS
+    //   1 if connected, 0 otherwise.
+    int connect(LTcpClient &client, IPAddress ip, uint16_t port);
+
+    // DESCRIPTION
+    //   Closes connections that were closed by the server or have been idle
+    //   for longer than the idle timeout. connect() does this too; call
+    //   maintain() from loop() to free sockets while no requests are made.
+    // 
+    // PARAMETERS
+    //   N/A
+    // 
+    // RETURNS
+    //   N/A
+    void maintain();
+
+    // DESCRIPTION
+    //   Closes all idle connections and forgets the ones in use,
+    //   which are closed when their clients stop.
+    // 
+    // PARAMETERS
+    //   N/A
+    // 
+    // RETURNS
+    //   N/A
+    void clear();
+
+    // DESCRIPTION
+    //   Returns the number of connections in the pool, idle or in use.
+    int size() const;
+
+    // DESCRIPTION
+    //   Returns the number of idle connections in the pool.
+    int idleCount();
+
+private:
+    LConnectionPool(const LConnectionPool&);
+    LConnectionPool& operator=(const LConnectionPool&);
+
+    // updates the idle state of pEntry, returns false if it has been evicted
+    boolean check(LConnectionPoolEntry *pEntry);
+    void evict(LConnectionPoolEntry *pEntry);
+
+    LConnectionPoolEntry *m_entries;
+    int m_maxConnections;
+    unsigned long m_idleTimeout;
+};
+
+#endif
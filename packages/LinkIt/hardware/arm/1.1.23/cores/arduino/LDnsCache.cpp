@@ -0,0 +1,356 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "LDnsCache.h"
+#include "LTask.h"
+#include "vmtcp.h"
+#include "vmlog.h"
+
+// Entries are allocated and read on the Arduino thread. The MMI thread
+// issues the lookups and fills in their results, writing state last; a
+// pending entry is never reused. Each lookup carries the generation of its
+// entry, which only lookupHandler() changes, so that the answer to an
+// earlier use of a reused entry is dropped.
+
+// posted by the MMI thread whenever a lookup completes
+static VM_SIGNAL_ID s_dnsSignal = 0;
+
+// resolves names too long for the cache; it is never found by name
+static LDnsEntry s_scratch;
+
+LDnsCacheClass::LDnsCacheClass():
+	m_ttl(LDNS_CACHE_TTL),
+	m_negativeTtl(LDNS_NEGATIVE_TTL)
+{
+	memset(m_entries, 0, sizeof(m_entries));
+}
+
+boolean LDnsCacheClass::parseAddress(const char *host, IPAddress &result)
+{
+	int part = 0;
+	int value = -1;
+	uint8_t bytes[4];
+	for(const char *p = host; ; ++p)
+	{
+		if(*p >= '0' && *p <= '9')
+		{
+			value = (value < 0 ? 0 : value * 10) + (*p - '0');
+			if(value > 255)
+			{
+				return false;
+			}
+		}
+		else if((*p == '.' || *p == '\0') && value >= 0 && part < 4)
+		{
+			bytes[part++] = value;
+			value = -1;
+			if(*p == '\0')
+			{
+				break;
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	if(part != 4)
+	{
+		return false;
+	}
+	result = bytes;
+	return true;
+}
+
+// WAP and NET share the resolver, as in LGPRSClass::hostByName()
+VMINT LDnsCacheClass::cacheApn(VMINT apn)
+{
+	return (apn == VM_TCP_APN_CMWAP) ? VM_TCP_APN_CMNET : apn;
+}
+
+LDnsEntry* LDnsCacheClass::find(VMINT apn, const char *host)
+{
+	for(int i = 0; i < LDNS_CACHE_SIZE; ++i)
+	{
+		LDnsEntry *pEntry = &m_entries[i];
+		if(pEntry->state != LDNS_FREE && pEntry->apn == apn && strcmp(pEntry->name, host) == 0)
+		{
+			return pEntry;
+		}
+	}
+	return NULL;
+}
+
+boolean LDnsCacheClass::expired(const LDnsEntry *pEntry) const
+{
+	switch(pEntry->state)
+	{
+	case LDNS_RESOLVED:
+		return millis() - pEntry->time >= m_ttl;
+	case LDNS_FAILED:
+		return millis() - pEntry->time >= m_negativeTtl;
+	case LDNS_PENDING:
+		return false;
+	default:
+		return true;
+	}
+}
+
+LDnsEntry* LDnsCacheClass::allocate()
+{
+	// a free or expired entry, else the oldest answer
+	LDnsEntry *pOldest = NULL;
+	for(int i = 0; i < LDNS_CACHE_SIZE; ++i)
+	{
+		LDnsEntry *pEntry = &m_entries[i];
+		if(pEntry->state == LDNS_PENDING)
+		{
+			continue;
+		}
+		if(expired(pEntry))
+		{
+			return pEntry;
+		}
+		if(pOldest == NULL || (long)(pEntry->time - pOldest->time) < 0)
+		{
+			pOldest = pEntry;
+		}
+	}
+	return pOldest;
+}
+
+void LDnsCacheClass::complete(LDnsEntry *pEntry, vm_soc_dns_result *pDNS)
+{
+	if(pDNS && pDNS->num > 0)
+	{
+		// there may be several addresses, the first one is used
+		pEntry->address = pDNS->address[0];
+		pEntry->time = millis();
+		pEntry->state = LDNS_RESOLVED;
+	}
+	else
+	{
+		vm_log_info("LDnsCache %s not found, cause=%d", pEntry->name, pDNS ? pDNS->error_cause : -1);
+		pEntry->time = millis();
+		pEntry->state = LDNS_FAILED;
+	}
+}
+
+// one lookup in flight; the resolver writes dns until the callback
+struct LDnsLookup
+{
+	LDnsEntry *pEntry;
+	VMUINT32 generation;
+	vm_soc_dns_result dns;
+};
+
+VMINT LDnsCacheClass::lookupCallback(VMINT jobId, vm_soc_dns_result *pDNS, void *userData)
+{
+	LDnsLookup *pLookup = (LDnsLookup*)userData;
+	LDnsEntry *pEntry = pLookup->pEntry;
+	// an answer after the timeout still fills the entry, unless it was
+	// removed or reused since
+	if(pEntry->generation == pLookup->generation && pEntry->state != LDNS_FREE)
+	{
+		complete(pEntry, pDNS);
+		vm_signal_post(s_dnsSignal);
+	}
+	free(pLookup);
+	return 0;
+}
+
+struct LDnsLookupContext
+{
+	LDnsEntry *pEntry;
+	const char *host;
+};
+
+boolean LDnsCacheClass::lookupHandler(void *userData)
+{
+	LDnsLookupContext *pContext = (LDnsLookupContext*)userData;
+	LDnsEntry *pEntry = pContext->pEntry;
+
+	pEntry->generation++;
+	pEntry->time = millis();
+	pEntry->state = LDNS_PENDING;
+
+	LDnsLookup *pLookup = (LDnsLookup*)malloc(sizeof(LDnsLookup));
+	if(pLookup == NULL)
+	{
+		complete(pEntry, NULL);
+		return true;
+	}
+	pLookup->pEntry = pEntry;
+	pLookup->generation = pEntry->generation;
+
+	vm_log_info("vm_soc_get_host_by_name_ex: %s", pContext->host);
+	const VMINT ret = vm_soc_get_host_by_name_ex(pEntry->apn,
+												 pContext->host,
+												 &pLookup->dns,
+												 &lookupCallback,
+												 pLookup);
+	vm_log_info("vm_soc_get_host_by_name_ex ret = %d", ret);
+
+	if(ret > 0 || ret == VM_E_SOC_WOULDBLOCK)
+	{
+		// lookupCallback() reports the result and frees pLookup
+		return true;
+	}
+
+	complete(pEntry, (ret == VM_E_SOC_SUCCESS) ? &pLookup->dns : NULL);
+	free(pLookup);
+	return true;
+}
+
+int LDnsCacheClass::lookup(VMINT apn, const char *host, IPAddress &result)
+{
+	if(parseAddress(host, result))
+	{
+		return 1;
+	}
+
+	apn = cacheApn(apn);
+	LDnsEntry *pEntry = find(apn, host);
+	if(pEntry == NULL || expired(pEntry))
+	{
+		return -1;
+	}
+
+	switch(pEntry->state)
+	{
+	case LDNS_RESOLVED:
+		result = pEntry->address;
+		return 1;
+	case LDNS_FAILED:
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+int LDnsCacheClass::resolve(VMINT apn, const char *host, IPAddress &result, unsigned long timeoutMs)
+{
+	const int cached = lookup(apn, host, result);
+	if(cached >= 0)
+	{
+		return cached;
+	}
+
+	if(s_dnsSignal == 0)
+	{
+		s_dnsSignal = vm_signal_init();
+	}
+
+	apn = cacheApn(apn);
+	LDnsEntry *pEntry = find(apn, host);
+	if(pEntry == NULL || pEntry->state != LDNS_PENDING)
+	{
+		if(strlen(host) >= LDNS_MAX_NAME)
+		{
+			if(s_scratch.state == LDNS_PENDING)
+			{
+				return 0;
+			}
+			pEntry = &s_scratch;
+		}
+		else if(pEntry == NULL)
+		{
+			pEntry = allocate();
+			if(pEntry == NULL)
+			{
+				// every entry is being looked up
+				return 0;
+			}
+		}
+
+		// a late answer for the previous name leaves a free entry alone
+		pEntry->state = LDNS_FREE;
+		if(pEntry != &s_scratch)
+		{
+			strcpy(pEntry->name, host);
+		}
+		pEntry->apn = apn;
+
+		LDnsLookupContext context;
+		context.pEntry = pEntry;
+		context.host = host;
+		LTask.remoteCall(&lookupHandler, &context);
+	}
+
+	// wait for our lookup or the one already in progress
+	const unsigned long start = millis();
+	while(pEntry->state == LDNS_PENDING)
+	{
+		const unsigned long now = millis();
+		const unsigned long age = now - pEntry->time;
+		if(age >= LDNS_RESOLVE_TIMEOUT)
+		{
+			// an answer may still come and fill the entry
+			vm_log_info("LDnsCache %s timeout", pEntry->name);
+			pEntry->time = now;
+			pEntry->state = LDNS_FAILED;
+			break;
+		}
+		if(now - start >= timeoutMs)
+		{
+			// the caller gives up, the lookup goes on
+			return 0;
+		}
+
+		unsigned long wait = LDNS_RESOLVE_TIMEOUT - age;
+		if(wait > timeoutMs - (now - start))
+		{
+			wait = timeoutMs - (now - start);
+		}
+		vm_signal_timedwait(s_dnsSignal, (wait < 1000 ? wait : 1000) * 1000);
+	}
+
+	if(pEntry->state != LDNS_RESOLVED)
+	{
+		return 0;
+	}
+	result = pEntry->address;
+	return 1;
+}
+
+void LDnsCacheClass::remove(VMINT apn, const char *host)
+{
+	LDnsEntry *pEntry = find(cacheApn(apn), host);
+	if(pEntry && pEntry->state != LDNS_PENDING)
+	{
+		pEntry->state = LDNS_FREE;
+	}
+}
+
+void LDnsCacheClass::clear()
+{
+	for(int i = 0; i < LDNS_CACHE_SIZE; ++i)
+	{
+		if(m_entries[i].state != LDNS_PENDING)
+		{
+			m_entries[i].state = LDNS_FREE;
+		}
+	}
+}
+
+void LDnsCacheClass::setTtl(unsigned long ttlMs, unsigned long negativeTtlMs)
+{
+	m_ttl = ttlMs;
+	m_negativeTtl = negativeTtlMs;
+}
+
+LDnsCacheClass LDnsCache;
@@ -0,0 +1,167 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LDnsCache_h
+#define _LDnsCache_h
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "vmconn.h"
+
+// number of host names remembered
+#ifndef LDNS_CACHE_SIZE
+#define LDNS_CACHE_SIZE 8
+#endif
+
+// longest host name that is cached; longer names are resolved every time
+#ifndef LDNS_MAX_NAME
+#define LDNS_MAX_NAME 64
+#endif
+
+// time a resolved address is reused, in milliseconds.
+// The platform resolver does not report the record TTL.
+#ifndef LDNS_CACHE_TTL
+#define LDNS_CACHE_TTL 300000
+#endif
+
+// time a failed lookup is remembered, in milliseconds
+#ifndef LDNS_NEGATIVE_TTL
+#define LDNS_NEGATIVE_TTL 30000
+#endif
+
+// time after which a lookup that got no answer counts as failed, in milliseconds
+#ifndef LDNS_RESOLVE_TIMEOUT
+#define LDNS_RESOLVE_TIMEOUT 30000
+#endif
+
+/* DOM-NOT_FOR_SDK-BEGIN */
+enum LDnsEntryState
+{
+    LDNS_FREE,
+    LDNS_PENDING,   // lookup issued, the MMI thread completes it
+    LDNS_RESOLVED,
+    LDNS_FAILED
+};
+
+struct LDnsEntry
+{
+    char name[LDNS_MAX_NAME];
+    VMINT apn;
+    volatile VMINT state;       // LDnsEntryState
+    volatile VMUINT32 generation; // bumped by each lookup, to ignore stale callbacks
+    uint32_t address;
+    unsigned long time;         // millis() of the lookup or its result
+};
+/* DOM-NOT_FOR_SDK-END */
+
+// LDnsCache Class
+//
+// Shared host name cache used by LWiFi.hostByName(), LGPRS.hostByName() and
+// LWiFiClient/LGPRSClient::connect(). Addresses are kept for LDNS_CACHE_TTL
+// and failed lookups for LDNS_NEGATIVE_TTL. A name that is already being
+// looked up is not queried a second time. VM_TCP_APN_CMWAP names are
+// resolved and cached as VM_TCP_APN_CMNET ones.
+class LDnsCacheClass
+{
+public:
+    LDnsCacheClass();
+
+    // DESCRIPTION
+    //   Resolves a host name, from the cache if possible.
+    // 
+    // PARAMETERS
+    //   apn: bearer to query through, e.g. VM_TCP_APN_WIFI
+    //   host: name to be resolved. Dotted addresses are converted without a lookup.
+    //   result: receives the address
+    //   timeoutMs: longest time to wait for the network. A lookup that is still
+    //              running when it expires keeps going, and its answer is cached.
+    // 
+    // RETURNS
+    //   1 if resolved, 0 otherwise.
+    int resolve(VMINT apn, const char *host, IPAddress &result, unsigned long timeoutMs = LDNS_RESOLVE_TIMEOUT);
+
+    // DESCRIPTION
+    //   Looks a host name up in the cache only, without waiting for the network.
+    // 
+    // PARAMETERS
+    //   apn: bearer the name was resolved through
+    //   host: name to be resolved
+    //   result: receives the address
+    // 
+    // RETURNS
+    //   1 if the address is known, 0 if the name is known not to resolve,
+    //   -1 if the cache cannot tell.
+    int lookup(VMINT apn, const char *host, IPAddress &result);
+
+    // DESCRIPTION
+    //   Forgets a host name, e.g. after its cached address stopped answering.
+    // 
+    // PARAMETERS
+    //   apn: bearer the name was resolved through
+    //   host: name to be forgotten
+    // 
+    // RETURNS
+    //   N/A
+    void remove(VMINT apn, const char *host);
+
+    // DESCRIPTION
+    //   Forgets all host names.
+    // 
+    // PARAMETERS
+    //   N/A
+    // 
+    // RETURNS
+    //   N/A
+    void clear();
+
+    // DESCRIPTION
+    //   Sets how long addresses and failed lookups are kept.
+    // 
+    // PARAMETERS
+    //   ttlMs: lifetime of a resolved address in milliseconds
+    //   negativeTtlMs: lifetime of a failed lookup in milliseconds
+    // 
+    // RETURNS
+    //   N/A
+    void setTtl(unsigned long ttlMs, unsigned long negativeTtlMs);
+
+    // DESCRIPTION
+    //   Converts a dotted address such as "192.168.0.1".
+    // 
+    // PARAMETERS
+    //   host: string to be converted
+    //   result: receives the address
+    // 
+    // RETURNS
+    //   true if host is a dotted address.
+    static boolean parseAddress(const char *host, IPAddress &result);
+
+private:
+    static VMINT cacheApn(VMINT apn);
+    LDnsEntry* find(VMINT apn, const char *host);
+    LDnsEntry* allocate();
+    boolean expired(const LDnsEntry *pEntry) const;
+
+    static boolean lookupHandler(void *userData);
+    static VMINT lookupCallback(VMINT jobId, vm_soc_dns_result *pDNS, void *userData);
+    static void complete(LDnsEntry *pEntry, vm_soc_dns_result *pDNS);
+
+    LDnsEntry m_entries[LDNS_CACHE_SIZE];
+    unsigned long m_ttl;
+    unsigned long m_negativeTtl;
+};
+
+extern LDnsCacheClass LDnsCache;
+
+#endif
@@ -0,0 +1,930 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include <string.h>
+#include <math.h>
+#include "LFormat.h"
+#include "Print.h"
+
+// significant digits taken from a double; further digits are printed as 0
+#define LFORMAT_MAX_DIGITS 17
+
+// default number of fraction digits of %f, %e and %g
+#define LFORMAT_DEFAULT_PRECISION 6
+
+// the decimal digits of 0 to 99, two characters each
+static const char s_digitPairs[201] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static const char s_upperDigits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+static const char s_lowerDigits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+// 10^0 to 10^22, all exact in a double. Up to 10^17 they are the fraction
+// scales of the fixed point conversion.
+#define LFORMAT_EXACT_POW10 22
+static const double s_pow10[LFORMAT_EXACT_POW10 + 1] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+	1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+	1e20, 1e21, 1e22
+};
+
+// 10^(2^i): brings any double into [1, 10) in at most 9 steps
+static const double s_pow10Steps[9] = { 1e1, 1e2, 1e4, 1e8, 1e16, 1e32, 1e64, 1e128, 1e256 };
+
+/*****************************************************************************
+*
+* Output buffer
+*
+*****************************************************************************/
+
+// collects output and passes it on in chunks of LFORMAT_CHUNK_SIZE bytes
+class LFormatSink
+{
+public:
+	LFormatSink(Print &out):
+		m_out(out),
+		m_len(0),
+		m_count(0)
+	{
+	}
+
+	void put(char c)
+	{
+		if(m_len == sizeof(m_buf))
+		{
+			flush();
+		}
+		m_buf[m_len++] = c;
+	}
+
+	void put(const char *str, size_t len)
+	{
+		if(len >= sizeof(m_buf))
+		{
+			// no point in copying long strings
+			flush();
+			m_count += m_out.write((const uint8_t*)str, len);
+			return;
+		}
+		if(len > sizeof(m_buf) - m_len)
+		{
+			flush();
+		}
+		memcpy(m_buf + m_len, str, len);
+		m_len += len;
+	}
+
+	void fill(char c, size_t n)
+	{
+		while(n)
+		{
+			if(m_len == sizeof(m_buf))
+			{
+				flush();
+			}
+			size_t chunk = sizeof(m_buf) - m_len;
+			if(chunk > n)
+			{
+				chunk = n;
+			}
+			memset(m_buf + m_len, c, chunk);
+			m_len += chunk;
+			n -= chunk;
+		}
+	}
+
+	// writes what is left, returns the number of bytes written in total
+	size_t flush()
+	{
+		if(m_len)
+		{
+			m_count += m_out.write(m_buf, m_len);
+			m_len = 0;
+		}
+		return m_count;
+	}
+
+private:
+	Print &m_out;
+	uint8_t m_buf[LFORMAT_CHUNK_SIZE];
+	size_t m_len;
+	size_t m_count;
+};
+
+/*****************************************************************************
+*
+* Integer conversion
+*
+*****************************************************************************/
+
+static char* utoa10(uint32_t value, char *end)
+{
+	// one division for every two digits; the compiler turns it into a multiply
+	while(value >= 100)
+	{
+		const uint32_t q = value / 100;
+		const uint32_t r = (value - q * 100) * 2;
+		end -= 2;
+		end[0] = s_digitPairs[r];
+		end[1] = s_digitPairs[r + 1];
+		value = q;
+	}
+
+	if(value >= 10)
+	{
+		end -= 2;
+		end[0] = s_digitPairs[value * 2];
+		end[1] = s_digitPairs[value * 2 + 1];
+	}
+	else
+	{
+		*--end = '0' + value;
+	}
+	return end;
+}
+
+static char* utoa10(uint64_t value, char *end)
+{
+	// 64 bit divisions are library calls on ARM: only split off groups of
+	// 8 digits with them and convert the groups in 32 bits
+	while(value > 0xFFFFFFFFULL)
+	{
+		const uint64_t q = value / 100000000;
+		char *group = utoa10((uint32_t)(value - q * 100000000), end);
+		end -= 8;
+		while(group > end)
+		{
+			*--group = '0';
+		}
+		value = q;
+	}
+	return utoa10((uint32_t)value, end);
+}
+
+template<typename T>
+static char* utoaBase(T value, char *end, unsigned base, const char *digits)
+{
+	if((base & (base - 1)) == 0)
+	{
+		// powers of two by shifting
+		unsigned shift = 1;
+		while((1U << shift) < base)
+		{
+			shift++;
+		}
+		do
+		{
+			*--end = digits[value & (base - 1)];
+			value >>= shift;
+		} while(value);
+		return end;
+	}
+
+	do
+	{
+		const T q = value / base;
+		*--end = digits[value - q * base];
+		value = q;
+	} while(value);
+	return end;
+}
+
+static char* utoa(uint64_t value, char *end, unsigned base, const char *digits)
+{
+	if(value <= 0xFFFFFFFFULL)
+	{
+		return base == 10 ? utoa10((uint32_t)value, end) : utoaBase((uint32_t)value, end, base, digits);
+	}
+	return base == 10 ? utoa10(value, end) : utoaBase(value, end, base, digits);
+}
+
+char* lformat_ultoa(unsigned long value, char *end, uint8_t base)
+{
+	if(base < 2 || base > 36)
+	{
+		base = 10;
+	}
+	return utoa(value, end, base, s_upperDigits);
+}
+
+/*****************************************************************************
+*
+* Float conversion
+*
+*****************************************************************************/
+
+// a finite, non-negative double split into the pieces of its text
+struct LFormatFloat
+{
+	char intBuf[24];
+	char *intDigits;		// integer part, in intBuf
+	size_t intLen;
+	size_t intZeros;		// zeros after the integer part, for values >= 1e19
+	char fracBuf[LFORMAT_MAX_DIGITS];
+	size_t fracLen;			// fraction digits in fracBuf
+	size_t fracZeros;		// zeros after them
+};
+
+// Dekker's exact product: a * b is exactly p + the returned value,
+// where p is the rounded a * b
+static double productError(double a, double b, double p)
+{
+	const double split = 134217729.0;	// 2^27 + 1
+	double t = a * split;
+	const double ah = t - (t - a);
+	const double al = a - ah;
+	t = b * split;
+	const double bh = t - (t - b);
+	const double bl = b - bh;
+	return ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+}
+
+// decides the rounding of frac * scale, whose rounded value is scaled and
+// whose rest below the last digit is rest. printf rounds exact halves to
+// even as the C library does, print(double) rounds them up as it always did.
+static bool roundUp(double frac, double scale, double scaled, double rest, uint32_t lastDigit, bool halfEven)
+{
+	if(rest != 0.5)
+	{
+		return rest > 0.5;
+	}
+	if(!halfEven)
+	{
+		return true;
+	}
+
+	// rare: the multiply may have rounded to the half, look at what it dropped
+	const double err = productError(frac, scale, scaled);
+	if(err != 0)
+	{
+		return err > 0;
+	}
+	return (lastDigit & 1) != 0;
+}
+
+// fixed point: value becomes an integer part and prec fraction digits,
+// rounded to nearest with a single multiply
+static void splitFixed(double value, int prec, bool halfEven, LFormatFloat &f)
+{
+	const int places = prec < LFORMAT_MAX_DIGITS ? prec : LFORMAT_MAX_DIGITS;
+	char * const intEnd = f.intBuf + sizeof(f.intBuf);
+	char * const fracEnd = f.fracBuf + places;
+	char *fracStart = fracEnd;
+
+	f.intZeros = 0;
+	f.fracLen = places;
+	f.fracZeros = prec - places;
+
+	if(value < 4294967296.0 && places <= 9)
+	{
+		// everything in 32 bits
+		uint32_t ip = (uint32_t)value;
+		const uint32_t scale = (uint32_t)s_pow10[places];
+		const double frac = value - ip;
+		const double scaled = frac * s_pow10[places];
+		uint32_t fp = (uint32_t)scaled;
+		if(roundUp(frac, s_pow10[places], scaled, scaled - fp, places ? fp : ip, halfEven))
+		{
+			fp++;
+		}
+		if(fp >= scale)
+		{
+			fp -= scale;
+			if(++ip == 0)
+			{
+				// 4294967295.9 rounds up to 2^32
+				f.intDigits = utoa10((uint64_t)4294967296ULL, intEnd);
+				f.intLen = intEnd - f.intDigits;
+				memset(f.fracBuf, '0', places);
+				return;
+			}
+		}
+		f.intDigits = utoa10(ip, intEnd);
+		if(places)
+		{
+			fracStart = utoa10(fp, fracEnd);
+		}
+	}
+	else
+	{
+		if(value >= 1e19)
+		{
+			// keep the leading digits, everything below them is zero
+			for(int i = 8; i >= 0; --i)
+			{
+				if(value >= 1e19 * s_pow10Steps[i])
+				{
+					value /= s_pow10Steps[i];
+					f.intZeros += 1U << i;
+				}
+			}
+			if(value >= 1e19)
+			{
+				value /= 10;
+				f.intZeros++;
+			}
+			f.intDigits = utoa10((uint64_t)value, intEnd);
+		}
+		else
+		{
+			uint64_t ip = (uint64_t)value;
+			const uint64_t scale = (uint64_t)s_pow10[places];
+			const double frac = value - (double)ip;
+			const double scaled = frac * s_pow10[places];
+			uint64_t fp = (uint64_t)scaled;
+			if(roundUp(frac, s_pow10[places], scaled, scaled - (double)fp, (uint32_t)(places ? fp : ip), halfEven))
+			{
+				fp++;
+			}
+			if(fp >= scale)
+			{
+				fp -= scale;
+				ip++;
+			}
+			f.intDigits = utoa10(ip, intEnd);
+			if(places)
+			{
+				fracStart = utoa10(fp, fracEnd);
+			}
+		}
+	}
+
+	f.intLen = intEnd - f.intDigits;
+	// leading zeros of the fraction
+	while(fracStart > f.fracBuf)
+	{
+		*--fracStart = '0';
+	}
+}
+
+// scales value (> 0) into [1, 10) and returns its decimal exponent
+static int normalize(double &value)
+{
+	const double original = value;
+	int exp = 0;
+	if(value >= 10)
+	{
+		for(int i = 8; i >= 0; --i)
+		{
+			if(value >= s_pow10Steps[i])
+			{
+				value /= s_pow10Steps[i];
+				exp += 1 << i;
+			}
+		}
+	}
+	else if(value < 1)
+	{
+		for(int i = 8; i >= 0; --i)
+		{
+			if(value * s_pow10Steps[i] < 10)
+			{
+				value *= s_pow10Steps[i];
+				exp -= 1 << i;
+			}
+		}
+	}
+
+	// the steps round several times; redo it with a single exact power
+	// of ten where there is one
+	if(exp > 0 && exp <= LFORMAT_EXACT_POW10)
+	{
+		value = original / s_pow10[exp];
+	}
+	else if(exp < 0 && exp >= -LFORMAT_EXACT_POW10)
+	{
+		value = original * s_pow10[-exp];
+	}
+	return exp;
+}
+
+// scientific: one integer digit, prec fraction digits, returns the exponent
+static int splitExp(double value, int prec, bool halfEven, LFormatFloat &f)
+{
+	int exp = 0;
+	if(value != 0)
+	{
+		exp = normalize(value);
+	}
+	splitFixed(value, prec, halfEven, f);
+	if(f.intLen > 1)
+	{
+		// 9.99 rounded up to 10.0
+		f.intDigits = f.intBuf + sizeof(f.intBuf) - 1;
+		*f.intDigits = '1';
+		f.intLen = 1;
+		memset(f.fracBuf, '0', f.fracLen);
+		exp++;
+	}
+	return exp;
+}
+
+// removes the trailing zeros of the fraction, as %g does
+static void trimFraction(LFormatFloat &f)
+{
+	f.fracZeros = 0;
+	while(f.fracLen && f.fracBuf[f.fracLen - 1] == '0')
+	{
+		f.fracLen--;
+	}
+}
+
+/*****************************************************************************
+*
+* printf
+*
+*****************************************************************************/
+
+enum
+{
+	LFORMAT_LEFT = 1,		// '-'
+	LFORMAT_PLUS = 2,		// '+'
+	LFORMAT_SPACE = 4,		// ' '
+	LFORMAT_ALT = 8,		// '#'
+	LFORMAT_ZERO = 16		// '0'
+};
+
+// the pieces of one converted field, in output order
+struct LFormatField
+{
+	LFormatField():
+		sign(0),
+		prefix(""),
+		leadZeros(0),
+		body(""),
+		bodyLen(0),
+		bodyZeros(0),
+		point(false),
+		frac(""),
+		fracLen(0),
+		fracZeros(0),
+		suffix(""),
+		suffixLen(0)
+	{
+	}
+
+	char sign;
+	const char *prefix;		// "0x" and the like
+	size_t leadZeros;
+	const char *body;
+	size_t bodyLen;
+	size_t bodyZeros;
+	bool point;
+	const char *frac;
+	size_t fracLen;
+	size_t fracZeros;
+	const char *suffix;		// exponent
+	size_t suffixLen;
+};
+
+// pads the field to width and writes it
+static void emit(LFormatSink &sink, const LFormatField &field, int flags, int width, bool zeroPad)
+{
+	const size_t prefixLen = strlen(field.prefix);
+	size_t leadZeros = field.leadZeros;
+	size_t pad = 0;
+	const size_t len = (field.sign ? 1 : 0) + prefixLen + leadZeros + field.bodyLen + field.bodyZeros +
+					   (field.point ? 1 : 0) + field.fracLen + field.fracZeros + field.suffixLen;
+	if(width > 0 && (size_t)width > len)
+	{
+		pad = width - len;
+	}
+
+	if(pad && !(flags & LFORMAT_LEFT))
+	{
+		if(zeroPad)
+		{
+			leadZeros += pad;
+		}
+		else
+		{
+			sink.fill(' ', pad);
+		}
+		pad = 0;
+	}
+
+	if(field.sign)
+	{
+		sink.put(field.sign);
+	}
+	sink.put(field.prefix, prefixLen);
+	sink.fill('0', leadZeros);
+	sink.put(field.body, field.bodyLen);
+	sink.fill('0', field.bodyZeros);
+	if(field.point)
+	{
+		sink.put('.');
+	}
+	sink.put(field.frac, field.fracLen);
+	sink.fill('0', field.fracZeros);
+	sink.put(field.suffix, field.suffixLen);
+	sink.fill(' ', pad);
+}
+
+static char signOf(bool negative, int flags)
+{
+	if(negative)
+	{
+		return '-';
+	}
+	if(flags & LFORMAT_PLUS)
+	{
+		return '+';
+	}
+	if(flags & LFORMAT_SPACE)
+	{
+		return ' ';
+	}
+	return 0;
+}
+
+static void formatInteger(LFormatSink &sink, uint64_t value, bool negative, char conv, int flags, int width, int prec)
+{
+	char buf[24];
+	char * const end = buf + sizeof(buf);
+	LFormatField field;
+
+	unsigned base = 10;
+	const char *digits = s_lowerDigits;
+	switch(conv)
+	{
+	case 'o':
+		base = 8;
+		break;
+	case 'x':
+		base = 16;
+		if((flags & LFORMAT_ALT) && value)
+		{
+			field.prefix = "0x";
+		}
+		break;
+	case 'X':
+		base = 16;
+		digits = s_upperDigits;
+		if((flags & LFORMAT_ALT) && value)
+		{
+			field.prefix = "0X";
+		}
+		break;
+	case 'd':
+	case 'i':
+		field.sign = signOf(negative, flags);
+		break;
+	}
+
+	// precision 0 prints nothing for 0
+	char *str = (prec == 0 && value == 0) ? end : utoa(value, end, base, digits);
+	field.body = str;
+	field.bodyLen = end - str;
+	if(prec > 0 && (size_t)prec > field.bodyLen)
+	{
+		field.leadZeros = prec - field.bodyLen;
+	}
+	if(base == 8 && (flags & LFORMAT_ALT) && field.leadZeros == 0 && (field.bodyLen == 0 || *str != '0'))
+	{
+		field.leadZeros = 1;
+	}
+
+	emit(sink, field, flags, width, (flags & LFORMAT_ZERO) && prec < 0);
+}
+
+static void formatFloat(LFormatSink &sink, double value, char conv, int flags, int width, int prec)
+{
+	const bool upper = conv == 'F' || conv == 'E' || conv == 'G';
+	const bool negative = value < 0 || (value == 0 && 1 / value < 0);
+	LFormatField field;
+	field.sign = signOf(negative, flags);
+	if(negative)
+	{
+		value = -value;
+	}
+
+	if(isnan(value) || isinf(value))
+	{
+		// never zero padded
+		field.body = isnan(value) ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf");
+		field.bodyLen = 3;
+		emit(sink, field, flags, width, false);
+		return;
+	}
+
+	if(prec < 0)
+	{
+		prec = LFORMAT_DEFAULT_PRECISION;
+	}
+
+	LFormatFloat f;
+	bool scientific = (conv == 'e' || conv == 'E');
+	int exp = 0;
+	if(scientific)
+	{
+		exp = splitExp(value, prec, true, f);
+	}
+	else if(conv == 'g' || conv == 'G')
+	{
+		// prec significant digits, in the style that needs fewer characters
+		const int sig = prec ? prec : 1;
+		exp = splitExp(value, sig - 1, true, f);
+		if(exp < -4 || exp >= sig)
+		{
+			scientific = true;
+		}
+		else
+		{
+			splitFixed(value, sig - 1 - exp, true, f);
+		}
+		if(!(flags & LFORMAT_ALT))
+		{
+			trimFraction(f);
+		}
+	}
+	else
+	{
+		splitFixed(value, prec, true, f);
+	}
+
+	field.body = f.intDigits;
+	field.bodyLen = f.intLen;
+	field.bodyZeros = f.intZeros;
+	field.frac = f.fracBuf;
+	field.fracLen = f.fracLen;
+	field.fracZeros = f.fracZeros;
+	field.point = f.fracLen || f.fracZeros || (flags & LFORMAT_ALT);
+
+	char suffix[8];
+	if(scientific)
+	{
+		// e+dd, with at least two exponent digits
+		char * const end = suffix + sizeof(suffix);
+		char *str = utoa10((uint32_t)(exp < 0 ? -exp : exp), end);
+		if(end - str < 2)
+		{
+			*--str = '0';
+		}
+		*--str = exp < 0 ? '-' : '+';
+		*--str = upper ? 'E' : 'e';
+		field.suffix = str;
+		field.suffixLen = end - str;
+	}
+
+	emit(sink, field, flags, width, (flags & LFORMAT_ZERO) != 0);
+}
+
+size_t lformat(Print &out, const char *fmt, va_list args)
+{
+	LFormatSink sink(out);
+
+	while(*fmt)
+	{
+		// literal text up to the next conversion, in one piece
+		const char *text = fmt;
+		while(*fmt && *fmt != '%')
+		{
+			fmt++;
+		}
+		if(fmt != text)
+		{
+			sink.put(text, fmt - text);
+		}
+		if(*fmt == 0)
+		{
+			break;
+		}
+		const char *spec = fmt++;
+
+		int flags = 0;
+		for(;; fmt++)
+		{
+			if(*fmt == '-')
+				flags |= LFORMAT_LEFT;
+			else if(*fmt == '+')
+				flags |= LFORMAT_PLUS;
+			else if(*fmt == ' ')
+				flags |= LFORMAT_SPACE;
+			else if(*fmt == '#')
+				flags |= LFORMAT_ALT;
+			else if(*fmt == '0')
+				flags |= LFORMAT_ZERO;
+			else
+				break;
+		}
+
+		int width = 0;
+		if(*fmt == '*')
+		{
+			width = va_arg(args, int);
+			if(width < 0)
+			{
+				flags |= LFORMAT_LEFT;
+				width = -width;
+			}
+			fmt++;
+		}
+		else
+		{
+			while(*fmt >= '0' && *fmt <= '9')
+			{
+				width = width * 10 + (*fmt++ - '0');
+			}
+		}
+
+		// -1: not given
+		int prec = -1;
+		if(*fmt == '.')
+		{
+			fmt++;
+			prec = 0;
+			if(*fmt == '*')
+			{
+				prec = va_arg(args, int);
+				if(prec < 0)
+				{
+					prec = -1;
+				}
+				fmt++;
+			}
+			else
+			{
+				while(*fmt >= '0' && *fmt <= '9')
+				{
+					prec = prec * 10 + (*fmt++ - '0');
+				}
+			}
+		}
+
+		// 'H': char, 'h': short, 0: int, 'l': long, 'L': long long
+		char size = 0;
+		switch(*fmt)
+		{
+		case 'h':
+			size = (fmt[1] == 'h') ? 'H' : 'h';
+			fmt += (size == 'H') ? 2 : 1;
+			break;
+		case 'l':
+			size = (fmt[1] == 'l') ? 'L' : 'l';
+			fmt += (size == 'L') ? 2 : 1;
+			break;
+		case 'j':
+			size = 'L';
+			fmt++;
+			break;
+		case 'z':
+		case 't':
+			size = (sizeof(size_t) > sizeof(int)) ? 'l' : 0;
+			fmt++;
+			break;
+		}
+
+		const char conv = *fmt;
+		if(conv == 0)
+		{
+			// incomplete conversion at the end
+			sink.put(spec, fmt - spec);
+			break;
+		}
+		fmt++;
+
+		switch(conv)
+		{
+		case 'd':
+		case 'i':
+		{
+			int64_t value;
+			if(size == 'L')
+				value = va_arg(args, long long);
+			else if(size == 'l')
+				value = va_arg(args, long);
+			else if(size == 'h')
+				value = (short)va_arg(args, int);
+			else if(size == 'H')
+				value = (signed char)va_arg(args, int);
+			else
+				value = va_arg(args, int);
+			const bool negative = value < 0;
+			formatInteger(sink, negative ? 0 - (uint64_t)value : (uint64_t)value, negative, conv, flags, width, prec);
+			break;
+		}
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+		{
+			uint64_t value;
+			if(size == 'L')
+				value = va_arg(args, unsigned long long);
+			else if(size == 'l')
+				value = va_arg(args, unsigned long);
+			else if(size == 'h')
+				value = (unsigned short)va_arg(args, unsigned int);
+			else if(size == 'H')
+				value = (unsigned char)va_arg(args, unsigned int);
+			else
+				value = va_arg(args, unsigned int);
+			formatInteger(sink, value, false, conv, flags, width, prec);
+			break;
+		}
+		case 'p':
+			formatInteger(sink, (uintptr_t)va_arg(args, void*), false, 'x', flags | LFORMAT_ALT, width, prec);
+			break;
+		case 'c':
+		{
+			LFormatField field;
+			const char c = (char)va_arg(args, int);
+			field.body = &c;
+			field.bodyLen = 1;
+			emit(sink, field, flags, width, false);
+			break;
+		}
+		case 's':
+		{
+			LFormatField field;
+			const char *str = va_arg(args, const char*);
+			if(str == NULL)
+			{
+				str = "(null)";
+			}
+			field.body = str;
+			if(prec >= 0)
+			{
+				// may not be terminated within prec characters
+				const char *end = (const char*)memchr(str, 0, prec);
+				field.bodyLen = end ? end - str : prec;
+			}
+			else
+			{
+				field.bodyLen = strlen(str);
+			}
+			emit(sink, field, flags, width, false);
+			break;
+		}
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+			formatFloat(sink, va_arg(args, double), conv, flags, width, prec);
+			break;
+		case '%':
+			sink.put('%');
+			break;
+		default:
+			// not supported, copy it
+			sink.put(spec, fmt - spec);
+			break;
+		}
+	}
+
+	return sink.flush();
+}
+
+size_t lformat_float(Print &out, double value, uint8_t digits)
+{
+	if(isnan(value))
+	{
+		return out.write("nan");
+	}
+	if(isinf(value))
+	{
+		return out.write("inf");
+	}
+	// the integer part must fit in 32 bits; constant determined empirically
+	if(value > 4294967040.0 || value < -4294967040.0)
+	{
+		return out.write("ovf");
+	}
+
+	LFormatSink sink(out);
+	if(value < 0)
+	{
+		sink.put('-');
+		value = -value;
+	}
+
+	LFormatFloat f;
+	splitFixed(value, digits, false, f);
+	sink.put(f.intDigits, f.intLen);
+	if(digits)
+	{
+		sink.put('.');
+		sink.put(f.fracBuf, f.fracLen);
+		sink.fill('0', f.fracZeros);
+	}
+	return sink.flush();
+}
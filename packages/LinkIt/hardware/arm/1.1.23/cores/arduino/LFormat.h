@@ -0,0 +1,60 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LFormat_h
+#define _LFormat_h
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+class Print;
+
+/* DOM-NOT_FOR_SDK-BEGIN */
+// Number and printf formatting behind Print::print() and Print::printf().
+// Output is collected in a buffer of LFORMAT_CHUNK_SIZE bytes on the stack
+// and handed to Print::write() whenever it fills, so there is no limit on
+// its length. Integers are converted two decimal digits per division and
+// floats in fixed point, with a single floating point multiply for all
+// the fraction digits instead of one per digit.
+
+// bytes collected before each Print::write() call
+#ifndef LFORMAT_CHUNK_SIZE
+#define LFORMAT_CHUNK_SIZE 64
+#endif
+
+// room needed by lformat_ultoa() for any value and base
+#define LFORMAT_ULTOA_SIZE (8 * sizeof(unsigned long))
+
+// writes value in the given base (2 to 36, others mean 10) with upper case
+// letters, so that its last digit is just before end.
+// Returns a pointer to its first digit.
+char* lformat_ultoa(unsigned long value, char *end, uint8_t base);
+
+// prints value with the given number of fraction digits as print(double)
+// does: "nan", "inf", and "ovf" when the integer part exceeds 32 bits.
+// Returns the number of bytes written.
+size_t lformat_float(Print &out, double value, uint8_t digits);
+
+// printf() into out. Supports the flags "-+ #0", width and precision
+// (also as *), the length modifiers hh h l ll j z t, and the conversions
+// d i u o x X c s p f F e E g G and %%; other conversions are copied as is.
+// Float digits beyond the 17th significant one are printed as zeros, and
+// the value printed may be up to two units in the last place of a double
+// off, so %.17g does not always read back as the same double.
+// Returns the number of bytes written.
+size_t lformat(Print &out, const char *fmt, va_list args);
+/* DOM-NOT_FOR_SDK-END */
+
+#endif
@@ -0,0 +1,246 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "LRingBuffer.h"
+#include "LBarrier.h"
+
+LRingBuffer::LRingBuffer():
+	m_buf(NULL),
+	m_size(0),
+	m_owned(false),
+	m_head(0),
+	m_tail(0)
+{
+}
+
+LRingBuffer::~LRingBuffer()
+{
+	end();
+}
+
+bool LRingBuffer::begin(size_t size)
+{
+	end();
+
+	m_buf = (uint8_t*)malloc(size + 1);
+	if(m_buf == NULL)
+	{
+		return false;
+	}
+	m_size = size + 1;
+	m_owned = true;
+	return true;
+}
+
+void LRingBuffer::begin(uint8_t *storage, size_t storageSize)
+{
+	end();
+	m_buf = storage;
+	m_size = storageSize;
+}
+
+void LRingBuffer::end()
+{
+	if(m_owned)
+	{
+		free(m_buf);
+	}
+	m_owned = false;
+	m_buf = NULL;
+	m_size = 0;
+	m_head = 0;
+	m_tail = 0;
+}
+
+size_t LRingBuffer::available() const
+{
+	const size_t head = m_head;
+	const size_t tail = m_tail;
+	return (head >= tail) ? (head - tail) : (m_size - tail + head);
+}
+
+size_t LRingBuffer::space() const
+{
+	if(m_size == 0)
+	{
+		return 0;
+	}
+	return m_size - 1 - available();
+}
+
+int LRingBuffer::peek() const
+{
+	const size_t tail = m_tail;
+	if(m_head == tail)
+	{
+		return -1;
+	}
+	LBARRIER();
+	return m_buf[tail];
+}
+
+int LRingBuffer::read()
+{
+	const size_t tail = m_tail;
+	if(m_head == tail)
+	{
+		return -1;
+	}
+
+	LBARRIER();
+	const uint8_t b = m_buf[tail];
+	LBARRIER();
+	m_tail = (tail + 1 == m_size) ? 0 : tail + 1;
+	return b;
+}
+
+size_t LRingBuffer::read(uint8_t *buf, size_t len)
+{
+	size_t done = 0;
+	while(done < len)
+	{
+		size_t chunk = 0;
+		const uint8_t *src = readBuffer(chunk);
+		if(chunk == 0)
+		{
+			break;
+		}
+		if(chunk > len - done)
+		{
+			chunk = len - done;
+		}
+		memcpy(buf + done, src, chunk);
+		consume(chunk);
+		done += chunk;
+	}
+	return done;
+}
+
+size_t LRingBuffer::readUntil(uint8_t terminator, uint8_t *buf, size_t len)
+{
+	size_t done = 0;
+	while(done < len)
+	{
+		size_t chunk = 0;
+		const uint8_t *src = readBuffer(chunk);
+		if(chunk == 0)
+		{
+			break;
+		}
+		if(chunk > len - done)
+		{
+			chunk = len - done;
+		}
+		const uint8_t *found = (const uint8_t*)memchr(src, terminator, chunk);
+		if(found)
+		{
+			chunk = found - src + 1;
+		}
+		memcpy(buf + done, src, chunk);
+		consume(chunk);
+		done += chunk;
+		if(found)
+		{
+			break;
+		}
+	}
+	return done;
+}
+
+size_t LRingBuffer::write(const uint8_t *buf, size_t len)
+{
+	size_t done = 0;
+	while(done < len)
+	{
+		size_t chunk = 0;
+		uint8_t *dst = writeBuffer(chunk);
+		if(chunk == 0)
+		{
+			break;
+		}
+		if(chunk > len - done)
+		{
+			chunk = len - done;
+		}
+		memcpy(dst, buf + done, chunk);
+		commit(chunk);
+		done += chunk;
+	}
+	return done;
+}
+
+bool LRingBuffer::write(uint8_t b)
+{
+	return write(&b, 1) == 1;
+}
+
+uint8_t* LRingBuffer::writeBuffer(size_t &len)
+{
+	const size_t head = m_head;
+	const size_t tail = m_tail;
+
+	if(m_size == 0)
+	{
+		len = 0;
+	}
+	else if(head >= tail)
+	{
+		// up to the end of the array, keeping one slot free if tail is at 0
+		len = m_size - head - (tail == 0 ? 1 : 0);
+	}
+	else
+	{
+		len = tail - head - 1;
+	}
+	return m_buf + head;
+}
+
+void LRingBuffer::commit(size_t len)
+{
+	size_t head = m_head + len;
+	if(head >= m_size)
+	{
+		head -= m_size;
+	}
+	LBARRIER();
+	m_head = head;
+}
+
+const uint8_t* LRingBuffer::readBuffer(size_t &len) const
+{
+	const size_t head = m_head;
+	const size_t tail = m_tail;
+
+	len = (head >= tail) ? (head - tail) : (m_size - tail);
+	LBARRIER();
+	return m_buf + tail;
+}
+
+void LRingBuffer::consume(size_t len)
+{
+	size_t tail = m_tail + len;
+	if(tail >= m_size)
+	{
+		tail -= m_size;
+	}
+	LBARRIER();
+	m_tail = tail;
+}
+
+void LRingBuffer::clear()
+{
+	m_tail = m_head;
+}
@@ -0,0 +1,89 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LRingBuffer_h
+#define _LRingBuffer_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* DOM-NOT_FOR_SDK-BEGIN */
+// Byte ring buffer with a size chosen at run time.
+// One thread may write while another one reads without locking:
+// the writer only moves head and the reader only moves tail.
+class LRingBuffer
+{
+public:
+	LRingBuffer();
+	~LRingBuffer();
+
+	// allocates room for size bytes, dropping any previous content.
+	// Returns false if out of memory.
+	bool begin(size_t size);
+
+	// uses storageSize bytes at storage, which stay the caller's, and holds
+	// one byte less than that. Drops any previous content.
+	void begin(uint8_t *storage, size_t storageSize);
+
+	// frees the buffer, unless it is the caller's
+	void end();
+
+	// number of bytes the buffer can hold, 0 before begin()
+	size_t capacity() const { return m_size ? m_size - 1 : 0; }
+
+	// number of bytes that can be read
+	size_t available() const;
+
+	// number of bytes that can be written
+	size_t space() const;
+
+	// reader side
+	int peek() const;
+	int read();
+	size_t read(uint8_t *buf, size_t len);
+
+	// reader side; as read(buf, len), but stops after the first terminator
+	// byte, which is the last byte copied
+	size_t readUntil(uint8_t terminator, uint8_t *buf, size_t len);
+
+	// writer side; stores as many bytes as fit and returns that count
+	size_t write(const uint8_t *buf, size_t len);
+	bool write(uint8_t b);
+
+	// writer side without copying: returns the contiguous free area
+	// and its length, then commit() publishes len bytes written there.
+	uint8_t* writeBuffer(size_t &len);
+	void commit(size_t len);
+
+	// reader side without copying: returns the contiguous readable area
+	// and its length, then consume() drops len bytes from it.
+	const uint8_t* readBuffer(size_t &len) const;
+	void consume(size_t len);
+
+	// reader side; drops everything that can be read
+	void clear();
+
+private:
+	LRingBuffer(const LRingBuffer&);
+	LRingBuffer& operator=(const LRingBuffer&);
+
+	uint8_t *m_buf;
+	size_t m_size;				// allocated bytes, one more than capacity()
+	bool m_owned;				// m_buf was allocated by begin(size)
+	volatile size_t m_head;		// next byte to write
+	volatile size_t m_tail;		// next byte to read
+};
+/* DOM-NOT_FOR_SDK-END */
+
+#endif
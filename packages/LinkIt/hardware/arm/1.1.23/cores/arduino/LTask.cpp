@@ -16,13 +16,75 @@
 #include "vmsys.h"
 #include "vmthread.h"
 #include "LTask.h"
+#include "LTaskProfile.h"
+#include "LBarrier.h"
 #include "Arduino.h"
 
 
+#define LTASK_RING_MASK (LTASK_RING_SIZE - 1)
+
+// size of a data cache line of the ARM926EJ-S core
+#define LTASK_CACHE_LINE 32
+
+// calls waiting for the MMI thread. Only the Arduino thread writes head and
+// only the MMI thread writes tail, so the ring needs no lock. Both indexes
+// run freely and are masked on access; each one has its own cache line.
+struct LTaskRing
+{
+	volatile VMUINT32 head;
+	VMUINT8 pad0[LTASK_CACHE_LINE - sizeof(VMUINT32)];
+	volatile VMUINT32 tail;
+	VMUINT8 pad1[LTASK_CACHE_LINE - sizeof(VMUINT32)];
+	msg_struct* volatile slots[LTASK_RING_SIZE];
+};
+
+static LTaskRing s_ring __attribute__((aligned(LTASK_CACHE_LINE)));
+
+// message slots of asynchronous calls, shared by all _LTaskClass instances
+static msg_struct s_asyncSlots[LTASK_MAX_PENDING_CALLS];
+static VMINT s_asyncSeq[LTASK_MAX_PENDING_CALLS];
+// zero until asyncPoolInit() creates it
+static vm_thread_mutex_struct s_asyncMutex;
+static VM_SIGNAL_ID s_asyncSignal = 0;
+
+static void asyncPoolInit()
+{
+	if(s_asyncMutex.guard == 0)
+	{
+		vm_mutex_create(&s_asyncMutex);
+	}
+	if(s_asyncSignal == 0)
+	{
+		s_asyncSignal = vm_signal_init();
+	}
+}
+
+static msg_struct* asyncSlotFromToken(LTaskCallToken token)
+{
+	if(token < 0)
+	{
+		return NULL;
+	}
+
+	const VMINT index = token & 0xFF;
+	if(index >= LTASK_MAX_PENDING_CALLS || s_asyncSeq[index] != (token >> 8))
+	{
+		return NULL;
+	}
+
+	if(s_asyncSlots[index].state == LTASK_CALL_FREE)
+	{
+		return NULL;
+	}
+	return &s_asyncSlots[index];
+}
+
+
 _LTaskClass::_LTaskClass()
 {
 	m_handle = 0;
 	m_signal = 0;
+	m_msg.state = LTASK_CALL_FREE;
 }
 
 void _LTaskClass::begin(void)
@@ -79,22 +141,208 @@ void _LTaskClass::post_signal()
 		begin();
 	}
 	
+	// completes a call that returned false in dispatch()
+	LTASK_PROFILE_END(&m_msg);
 	vm_signal_post(m_signal);
 }
 
+void _LTaskClass::submit(msg_struct* pMsg, remote_call_ptr func, void* userdata, VM_SIGNAL_ID signal)
+{
+	pMsg->remote_func = func;
+	pMsg->userdata = userdata;
+	pMsg->signal = signal;
+	pMsg->result = false;
+	LTASK_PROFILE_SEND(pMsg);
+
+	const VMUINT32 head = s_ring.head;
+	while(head - s_ring.tail >= LTASK_RING_SIZE)
+	{
+		// cannot happen with the default sizes, see LTASK_RING_SIZE
+		vm_thread_sleep(1);
+	}
+	s_ring.slots[head & LTASK_RING_MASK] = pMsg;
+	LBARRIER();
+	s_ring.head = head + 1;
+	LBARRIER();
+
+	// the MMI thread re-reads head after each call it has taken off the ring,
+	// so it only needs a message if it had already emptied the ring.
+	if(s_ring.tail == head)
+	{
+		sendMsg(VM_MSG_ARDUINO_CALL, NULL);
+	}
+}
+
 void _LTaskClass::remoteCall(remote_call_ptr func,  void* userdata)
 {
 		if(m_handle == 0)
 		{
 			begin();
 		}
-    mutexLock();
-    m_msg.remote_func = (remote_call_ptr)func;
-    m_msg.userdata = userdata;
-    m_msg.signal = m_signal;
-    sendMsg(VM_MSG_ARDUINO_CALL, &m_msg);
+    // m_msg is never marked pending, so dispatch() completes it through m_signal,
+    // which also lets the handler defer completion to post_signal().
+    m_msg.state = LTASK_CALL_FREE;
+    submit(&m_msg, func, userdata, m_signal);
     vm_signal_wait(m_signal);
-    mutexUnlock();
+}
+
+int _LTaskClass::batch(LTaskBatch &batch)
+{
+	while(batch.m_next < batch.m_count)
+	{
+		remoteCall(&LTaskBatch::runSteps, &batch);
+	}
+	return batch.m_next;
+}
+
+LTaskCallToken _LTaskClass::remoteCallAsync(remote_call_ptr func, void* userdata)
+{
+	if(m_handle == 0)
+	{
+		begin();
+	}
+	asyncPoolInit();
+
+	VMINT index = -1;
+	vm_mutex_lock(&s_asyncMutex);
+	for(VMINT i = 0; i < LTASK_MAX_PENDING_CALLS; ++i)
+	{
+		if(s_asyncSlots[i].state == LTASK_CALL_FREE)
+		{
+			s_asyncSlots[i].state = LTASK_CALL_PENDING;
+			index = i;
+			break;
+		}
+	}
+	vm_mutex_unlock(&s_asyncMutex);
+
+	if(index < 0)
+	{
+		return LTASK_INVALID_CALL;
+	}
+
+	const LTaskCallToken token = (s_asyncSeq[index] << 8) | index;
+	submit(&s_asyncSlots[index], func, userdata, s_asyncSignal);
+	return token;
+}
+
+boolean _LTaskClass::remoteCallDone(LTaskCallToken token)
+{
+	msg_struct *pMsg = asyncSlotFromToken(token);
+	if(pMsg == NULL)
+	{
+		return false;
+	}
+	return (pMsg->state == LTASK_CALL_DONE);
+}
+
+boolean _LTaskClass::remoteCallWait(LTaskCallToken token)
+{
+	msg_struct *pMsg = asyncSlotFromToken(token);
+	if(pMsg == NULL)
+	{
+		return false;
+	}
+
+	// the signal is shared by all asynchronous calls,
+	// so a wakeup may belong to another slot.
+	while(pMsg->state != LTASK_CALL_DONE)
+	{
+		vm_signal_wait(s_asyncSignal);
+	}
+	LBARRIER();
+	const boolean result = pMsg->result;
+
+	vm_mutex_lock(&s_asyncMutex);
+	const VMINT index = pMsg - s_asyncSlots;
+	s_asyncSeq[index] = (s_asyncSeq[index] + 1) & 0x7FFFFF;
+	pMsg->state = LTASK_CALL_FREE;
+	vm_mutex_unlock(&s_asyncMutex);
+	return result;
+}
+
+void _LTaskClass::dispatch(msg_struct* pMsg)
+{
+	const boolean isAsync = (pMsg->state == LTASK_CALL_PENDING);
+	LTASK_PROFILE_START(pMsg);
+	pMsg->result = pMsg->remote_func(pMsg->userdata);
+	if(isAsync)
+	{
+		LTASK_PROFILE_END(pMsg);
+		LBARRIER();
+		pMsg->state = LTASK_CALL_DONE;
+		vm_signal_post(s_asyncSignal);
+	}
+	else if(pMsg->result)
+	{
+		LTASK_PROFILE_END(pMsg);
+		vm_signal_post(pMsg->signal);
+	}
+}
+
+void _LTaskClass::drain()
+{
+	VMUINT32 tail = s_ring.tail;
+	while(tail != s_ring.head)
+	{
+		LBARRIER();
+		dispatch(s_ring.slots[tail & LTASK_RING_MASK]);
+		++tail;
+		LBARRIER();
+		s_ring.tail = tail;
+		LBARRIER();
+	}
+}
+
+LTaskBatch::LTaskBatch()
+{
+	clear();
+}
+
+boolean LTaskBatch::add(remote_call_ptr func, void* userdata)
+{
+	if(m_count >= LTASK_MAX_BATCH_STEPS)
+	{
+		return false;
+	}
+
+	m_func[m_count] = func;
+	m_userdata[m_count] = userdata;
+	m_result[m_count] = false;
+	m_count++;
+	return true;
+}
+
+void LTaskBatch::clear()
+{
+	m_count = 0;
+	m_next = 0;
+}
+
+boolean LTaskBatch::result(int index) const
+{
+	if(index < 0 || index >= m_next)
+	{
+		return false;
+	}
+	return m_result[index];
+}
+
+boolean LTaskBatch::runSteps(void* userdata)
+{
+	LTaskBatch *pThis = (LTaskBatch*)userdata;
+	while(pThis->m_next < pThis->m_count)
+	{
+		const int i = pThis->m_next++;
+		pThis->m_result[i] = pThis->m_func[i](pThis->m_userdata[i]);
+		if(!pThis->m_result[i])
+		{
+			// this step posts the signal by itself later on,
+			// so the remaining steps have to wait for the next hop.
+			return false;
+		}
+	}
+	return true;
 }
 
 _LTaskClass LTask = _LTaskClass();
@@ -19,6 +19,67 @@
 #include "vmthread.h"
 #include "message.h"
 
+// number of message slots shared by all asynchronous remote calls
+#ifndef LTASK_MAX_PENDING_CALLS
+#define LTASK_MAX_PENDING_CALLS 8
+#endif
+
+// capacity of the ring of calls waiting for the MMI thread, a power of two.
+// The Arduino thread has at most one synchronous call and
+// LTASK_MAX_PENDING_CALLS asynchronous calls queued at a time, so the
+// default never fills up.
+#ifndef LTASK_RING_SIZE
+#define LTASK_RING_SIZE 16
+#endif
+
+// maximum number of handlers collected by one LTaskBatch
+#ifndef LTASK_MAX_BATCH_STEPS
+#define LTASK_MAX_BATCH_STEPS 8
+#endif
+
+// token returned by remoteCallAsync()
+typedef VMINT LTaskCallToken;
+#define LTASK_INVALID_CALL (-1)
+
+class _LTaskClass;
+
+// Collects several remote_call_ptr handlers that _LTaskClass::batch() runs
+// back-to-back inside a single VM_MSG_ARDUINO_CALL dispatch.
+// Steps run in the order they were added. A step that defers its completion
+// (returns false and posts the signal later) ends the current hop; the
+// remaining steps run in the next hop once the signal arrives.
+class LTaskBatch
+{
+public:
+	LTaskBatch();
+
+	// appends a step. Returns false if LTASK_MAX_BATCH_STEPS steps are already queued.
+	boolean add(remote_call_ptr func, void* userdata);
+
+	// removes all steps and results so the batch can be reused.
+	void clear();
+
+	// number of steps added
+	int count() const { return m_count; }
+
+	// number of steps that have run
+	int completed() const { return m_next; }
+
+	// value returned by the handler of step index, false if it has not run
+	boolean result(int index) const;
+
+	friend class _LTaskClass;
+
+private:
+	static boolean runSteps(void* userdata);
+
+	remote_call_ptr m_func[LTASK_MAX_BATCH_STEPS];
+	void* m_userdata[LTASK_MAX_BATCH_STEPS];
+	boolean m_result[LTASK_MAX_BATCH_STEPS];
+	int m_count;
+	int m_next;
+};
+
 class _LTaskClass
 {
 private:
@@ -27,6 +88,7 @@ private:
 	VM_THREAD_HANDLE m_handle;
     VM_SIGNAL_ID m_signal;
 	void sendMsg(VMUINT32 msg_id, void* user_data);
+	void submit(msg_struct* pMsg, remote_call_ptr func, void* userdata, VM_SIGNAL_ID signal);
 
 public:
 	_LTaskClass();
@@ -35,11 +97,42 @@ public:
 	void mutexLock();
 	void mutexUnlock();
 	void stop(void);
+
+	// runs func(userdata) on the MMI thread and blocks until it completes.
+	// Calls are queued on a lock-free ring with a single producer, so
+	// remoteCall(), batch() and remoteCallAsync() must only be used from
+	// the Arduino thread.
 	void remoteCall(remote_call_ptr func,  void* userdata);
 
+	// runs all steps of batch on the MMI thread, using as few hops as the
+	// steps allow, and blocks until the last one completes.
+	// Returns the number of steps that ran.
+	int batch(LTaskBatch &batch);
+
+	// queues func(userdata) on the MMI thread and returns immediately.
+	// Several calls may be in flight at once; they run in submission order.
+	// func must finish its work on the MMI thread: its return value is
+	// reported by remoteCallWait() instead of deferring completion to post_signal().
+	// Returns LTASK_INVALID_CALL if all LTASK_MAX_PENDING_CALLS slots are in use.
+	LTaskCallToken remoteCallAsync(remote_call_ptr func, void* userdata);
+
+	// returns true once the call identified by token has run.
+	boolean remoteCallDone(LTaskCallToken token);
+
+	// blocks until the call identified by token has run, releases its slot
+	// and returns the value returned by func.
+	boolean remoteCallWait(LTaskCallToken token);
+
 public:
 	void post_signal();
 
+	// called by the MMI thread for each VM_MSG_ARDUINO_CALL message;
+	// runs every call queued so far.
+	static void drain();
+
+private:
+	static void dispatch(msg_struct* pMsg);
+
 };
 
 extern _LTaskClass LTask;
@@ -0,0 +1,212 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include "LTaskProfile.h"
+
+#ifdef LTASK_PROFILE
+
+#include <string.h>
+#include "BufferedPrint.h"
+
+LTaskProfileClass::LTaskProfileClass():
+	m_count(0)
+{
+	memset(m_entries, 0, sizeof(m_entries));
+	memset(&m_mutex, 0, sizeof(m_mutex));
+}
+
+LTaskProfileEntry* LTaskProfileClass::lookup(remote_call_ptr func, boolean create)
+{
+	for(int i = 0; i < m_count; ++i)
+	{
+		if(m_entries[i].func == func)
+		{
+			return &m_entries[i];
+		}
+	}
+
+	if(!create)
+	{
+		return NULL;
+	}
+
+	// both threads may add entries
+	if(m_mutex.guard == 0)
+	{
+		vm_mutex_create(&m_mutex);
+	}
+	vm_mutex_lock(&m_mutex);
+
+	LTaskProfileEntry *pEntry = NULL;
+	for(int i = 0; i < m_count; ++i)
+	{
+		if(m_entries[i].func == func)
+		{
+			pEntry = &m_entries[i];
+			break;
+		}
+	}
+
+	if(pEntry == NULL && m_count < LTASK_PROFILE_MAX_HANDLERS)
+	{
+		pEntry = &m_entries[m_count];
+		memset(pEntry, 0, sizeof(LTaskProfileEntry));
+		pEntry->func = func;
+		__asm__ __volatile__("" ::: "memory");
+		m_count++;
+	}
+
+	vm_mutex_unlock(&m_mutex);
+	return pEntry;
+}
+
+void LTaskProfileClass::registerName(remote_call_ptr func, const char *name)
+{
+	LTaskProfileEntry *pEntry = lookup(func, true);
+	if(pEntry)
+	{
+		pEntry->name = name;
+	}
+}
+
+int LTaskProfileClass::count() const
+{
+	return m_count;
+}
+
+const LTaskProfileEntry* LTaskProfileClass::entry(int index) const
+{
+	if(index < 0 || index >= m_count)
+	{
+		return NULL;
+	}
+	return &m_entries[index];
+}
+
+const LTaskProfileEntry* LTaskProfileClass::find(remote_call_ptr func) const
+{
+	for(int i = 0; i < m_count; ++i)
+	{
+		if(m_entries[i].func == func)
+		{
+			return &m_entries[i];
+		}
+	}
+	return NULL;
+}
+
+void LTaskProfileClass::reset()
+{
+	for(int i = 0; i < m_count; ++i)
+	{
+		memset(&m_entries[i].wait, 0, sizeof(LTaskProfileHistogram));
+		memset(&m_entries[i].exec, 0, sizeof(LTaskProfileHistogram));
+	}
+}
+
+void LTaskProfileClass::add(LTaskProfileHistogram &hist, VMUINT32 value)
+{
+	int bucket = 0;
+	VMUINT32 v = value >> 1;
+	while(v && bucket < LTASK_PROFILE_BUCKETS - 1)
+	{
+		v >>= 1;
+		bucket++;
+	}
+
+	if(hist.count == 0 || value < hist.min)
+	{
+		hist.min = value;
+	}
+	if(value > hist.max)
+	{
+		hist.max = value;
+	}
+	hist.count++;
+	hist.buckets[bucket]++;
+}
+
+void LTaskProfileClass::record(remote_call_ptr func, VMUINT32 sendTime, VMUINT32 startTime, VMUINT32 endTime)
+{
+	LTaskProfileEntry *pEntry = lookup(func, true);
+	if(pEntry == NULL)
+	{
+		// table full
+		return;
+	}
+
+	add(pEntry->wait, vm_ust_get_duration(sendTime, startTime));
+	add(pEntry->exec, vm_ust_get_duration(startTime, endTime));
+}
+
+void LTaskProfileClass::dumpHistogram(Print &p, const char *label, const LTaskProfileHistogram &hist)
+{
+	p.print("  ");
+	p.print(label);
+	p.print(" n=");
+	p.print(hist.count);
+	p.print(" min=");
+	p.print(hist.min);
+	p.print(" max=");
+	p.print(hist.max);
+	p.print(" us |");
+
+	// print the buckets from the first to the last non-empty one
+	int first = 0;
+	int last = LTASK_PROFILE_BUCKETS - 1;
+	while(first < LTASK_PROFILE_BUCKETS && hist.buckets[first] == 0)
+	{
+		first++;
+	}
+	while(last > first && hist.buckets[last] == 0)
+	{
+		last--;
+	}
+	for(int i = first; i <= last; ++i)
+	{
+		p.print(' ');
+		p.print(i ? (1UL << i) : 0UL);
+		p.print(':');
+		p.print(hist.buckets[i]);
+	}
+	p.println();
+}
+
+void LTaskProfileClass::dump(Print &p) const
+{
+	// many small prints; hand them to p in a few larger writes
+	BufferedPrint<128> out(p);
+
+	out.println("LTask profile (handler / wait / exec):");
+	for(int i = 0; i < m_count; ++i)
+	{
+		const LTaskProfileEntry &e = m_entries[i];
+		if(e.name)
+		{
+			out.print(e.name);
+		}
+		else
+		{
+			out.print("0x");
+			out.print((unsigned long)e.func, HEX);
+		}
+		out.println();
+		dumpHistogram(out, "wait", e.wait);
+		dumpHistogram(out, "exec", e.exec);
+	}
+}
+
+LTaskProfileClass LTaskProfile;
+
+#endif // LTASK_PROFILE
@@ -0,0 +1,120 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LTaskProfile_h
+#define _LTaskProfile_h
+
+#include "message.h"
+
+// Remote call profiling. Build the core with -DLTASK_PROFILE to record, for
+// each handler, the queue wait (remoteCall() -> handler start) and the
+// execution time (handler start -> signal posted) in microseconds.
+// Without LTASK_PROFILE the hooks below expand to nothing.
+
+#ifdef LTASK_PROFILE
+
+#include "Print.h"
+#include "vmdatetime.h"
+
+// number of log2 buckets per histogram. Bucket 0 counts 0-1us, bucket i
+// counts [2^i, 2^(i+1)) us and the last bucket also counts everything above.
+#ifndef LTASK_PROFILE_BUCKETS
+#define LTASK_PROFILE_BUCKETS 20
+#endif
+
+// number of different handlers that can be tracked
+#ifndef LTASK_PROFILE_MAX_HANDLERS
+#define LTASK_PROFILE_MAX_HANDLERS 24
+#endif
+
+struct LTaskProfileHistogram
+{
+	VMUINT32 count;
+	VMUINT32 min;
+	VMUINT32 max;
+	VMUINT32 buckets[LTASK_PROFILE_BUCKETS];
+};
+
+struct LTaskProfileEntry
+{
+	remote_call_ptr func;
+	const char *name;			// NULL if not registered
+	LTaskProfileHistogram wait;	// queue wait time
+	LTaskProfileHistogram exec;	// execution time
+};
+
+class LTaskProfileClass
+{
+public:
+	LTaskProfileClass();
+
+	// gives func a readable name in dump(). name must stay valid.
+	void registerName(remote_call_ptr func, const char *name);
+
+	// number of handlers seen so far
+	int count() const;
+
+	// returns the statistics of the index-th handler, NULL if out of range
+	const LTaskProfileEntry* entry(int index) const;
+
+	// returns the statistics of func, NULL if it never ran
+	const LTaskProfileEntry* find(remote_call_ptr func) const;
+
+	// clears all statistics, registered names are kept
+	void reset();
+
+	// prints one line per handler and histogram to p
+	void dump(Print &p) const;
+
+	/* DOM-NOT_FOR_SDK-BEGIN */
+	// called by the MMI thread when a call has completed
+	void record(remote_call_ptr func, VMUINT32 sendTime, VMUINT32 startTime, VMUINT32 endTime);
+	/* DOM-NOT_FOR_SDK-END */
+
+private:
+	LTaskProfileEntry* lookup(remote_call_ptr func, boolean create);
+	static void add(LTaskProfileHistogram &hist, VMUINT32 value);
+	static void dumpHistogram(Print &p, const char *label, const LTaskProfileHistogram &hist);
+
+	LTaskProfileEntry m_entries[LTASK_PROFILE_MAX_HANDLERS];
+	volatile int m_count;
+	vm_thread_mutex_struct m_mutex;
+};
+
+extern LTaskProfileClass LTaskProfile;
+
+/* DOM-NOT_FOR_SDK-BEGIN */
+#define LTASK_PROFILE_SEND(pMsg) \
+	do { (pMsg)->sendTime = vm_ust_get_current_time(); (pMsg)->startTime = 0; } while(0)
+#define LTASK_PROFILE_START(pMsg) \
+	do { (pMsg)->startTime = vm_ust_get_current_time(); } while(0)
+#define LTASK_PROFILE_END(pMsg) \
+	do { \
+		if((pMsg)->startTime) \
+		{ \
+			LTaskProfile.record((pMsg)->remote_func, (pMsg)->sendTime, (pMsg)->startTime, vm_ust_get_current_time()); \
+			(pMsg)->startTime = 0; \
+		} \
+	} while(0)
+/* DOM-NOT_FOR_SDK-END */
+
+#else
+
+#define LTASK_PROFILE_SEND(pMsg)
+#define LTASK_PROFILE_START(pMsg)
+#define LTASK_PROFILE_END(pMsg)
+
+#endif // LTASK_PROFILE
+
+#endif
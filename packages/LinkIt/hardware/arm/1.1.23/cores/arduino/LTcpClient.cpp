@@ -14,39 +14,300 @@
 #include <Arduino.h>
 #include "LTask.h"
 #include "LTcpClient.h"
+#include "LDnsCache.h"
 #include "vmconn.h"
 #include "vmtcp.h"
 #include "vmlog.h"
 
 #define APN_ID VM_TCP_APN_WIFI
 
+// posted by the MMI thread whenever a connection attempt finishes
+static VM_SIGNAL_ID s_connectSignal = 0;
+
+// posted by the MMI thread whenever data or a close arrives on any
+// connection; waiters check their own connection again
+static VM_SIGNAL_ID s_rxSignal = 0;
+
+// posted by the MMI thread when a socket that flush() waits for took data
+static VM_SIGNAL_ID s_txSignal = 0;
+
+LTcpConnection::LTcpConnection(VMINT handle, VMINT serverHandle, size_t rxSize, size_t txSize):
+	m_handle(handle),
+	m_serverHandle(serverHandle),
+	m_refCount(1),
+	m_status(handle < 0 ? LTCP_CONN_CLOSED : LTCP_CONN_CONNECTED),
+	m_readable(true),
+	m_events(false),
+	m_txWaiting(false),
+	m_txBlocked(false),
+	m_txKicked(false),
+	m_drainCall(LTASK_INVALID_CALL),
+	m_connectResult(LTCP_CONNECT_FAILED),
+	m_deadline(0),
+	m_hasDeadline(false)
+{
+	if(rxSize)
+	{
+		m_rx.begin(rxSize);
+	}
+	if(txSize)
+	{
+		m_tx.begin(txSize);
+	}
+}
+
+void LTcpConnection::fill()
+{
+	if(m_handle < 0)
+	{
+		return;
+	}
+
+	while(true)
+	{
+		size_t len = 0;
+		uint8_t *pBuf = m_rx.writeBuffer(len);
+		if(len == 0)
+		{
+			// buffer full, the rest stays in the socket
+			return;
+		}
+
+		VMINT ret = VM_TCP_READ_EOF;
+		if(m_serverHandle != -1)
+		{
+			ret = vm_soc_svr_read(m_serverHandle, m_handle, pBuf, len);
+		}
+		else
+		{
+			ret = vm_tcp_read(m_handle, pBuf, len);
+		}
+
+		if(ret > 0)
+		{
+			m_rx.commit(ret);
+			continue;
+		}
+
+		if(ret == VM_TCP_READ_EOF && m_status == LTCP_CONN_CONNECTED)
+		{
+			vm_log_info("LTcpConnection socket %d disconnected", m_handle);
+			m_status = LTCP_CONN_CLOSED;
+		}
+		// socket drained, VM_TCP_EVT_CAN_READ tells when more arrives
+		m_readable = false;
+
+		if(m_status != LTCP_CONN_CONNECTED && m_serverHandle == -1)
+		{
+			// nothing more will arrive, m_rx keeps what is left to read.
+			// LTcpServer closes its sockets itself, see LTcpServer::poll().
+			vm_tcp_close(m_handle);
+			m_handle = -1;
+		}
+		return;
+	}
+}
+
+void LTcpConnection::dataArrived(boolean closed)
+{
+	m_readable = true;
+	if(closed)
+	{
+		// fill() reads on until the socket is empty, then closes it
+		m_status = LTCP_CONN_CLOSED;
+	}
+	fill();
+	if(s_rxSignal)
+	{
+		vm_signal_post(s_rxSignal);
+	}
+}
+
+boolean LTcpConnection::fillHandler(void *userData)
+{
+	((LTcpConnection*)userData)->fill();
+	return true;
+}
+
+VMINT LTcpConnection::send(const uint8_t *buf, size_t len)
+{
+	if(m_handle < 0 || m_status != LTCP_CONN_CONNECTED)
+	{
+		return -1;
+	}
+
+	VMINT ret = 0;
+	if(m_serverHandle != -1)
+	{
+		ret = vm_soc_svr_send(m_serverHandle, m_handle, (void*)buf, len);
+	}
+	else
+	{
+		ret = vm_tcp_write(m_handle, (void*)buf, len);
+	}
+
+	if(ret < 0)
+	{
+		vm_log_info("LTcpConnection socket %d write failed %d", m_handle, ret);
+		m_status = LTCP_CONN_CLOSED;
+	}
+	return ret;
+}
+
+void LTcpConnection::drain()
+{
+	boolean progress = false;
+	// LTcpServer::drainQueue() calls again once the frame is out
+	while(!m_txBlocked)
+	{
+		size_t len = 0;
+		const uint8_t *pBuf = m_tx.readBuffer(len);
+		if(len == 0)
+		{
+			break;
+		}
+
+		const VMINT ret = send(pBuf, len);
+		if(ret < 0)
+		{
+			break;
+		}
+
+		// partial writes keep the rest for the next VM_TCP_EVT_CAN_WRITE
+		m_tx.consume(ret);
+		progress = progress || ret > 0;
+		if((size_t)ret < len)
+		{
+			break;
+		}
+	}
+
+	if(m_status != LTCP_CONN_CONNECTED)
+	{
+		// nobody will take this data any more
+		m_tx.clear();
+	}
+
+	// done, or flush() starts its timeout again
+	if(m_txWaiting && (progress || m_tx.available() == 0))
+	{
+		m_txWaiting = false;
+		vm_signal_post(s_txSignal);
+	}
+}
+
+boolean LTcpConnection::flushHandler(void *userData)
+{
+	LTcpConnection *pConn = (LTcpConnection*)userData;
+	pConn->drain();
+	pConn->m_txWaiting = (pConn->m_tx.available() && pConn->m_events);
+	return true;
+}
+
+boolean LTcpConnection::drainHandler(void *userData)
+{
+	LTcpConnection *pConn = (LTcpConnection*)userData;
+	// data written from now on needs another kick()
+	pConn->m_txKicked = false;
+	pConn->drain();
+	return true;
+}
+
+void LTcpConnection::kick()
+{
+	if(m_txKicked || m_tx.available() == 0 || m_handle < 0)
+	{
+		// a drainHandler() that has not started yet will send it
+		return;
+	}
+
+	if(m_drainCall != LTASK_INVALID_CALL)
+	{
+		// the previous one has started, it is done or finishes shortly
+		LTask.remoteCallWait(m_drainCall);
+	}
+	m_txKicked = true;
+	m_drainCall = LTask.remoteCallAsync(&drainHandler, this);
+	if(m_drainCall == LTASK_INVALID_CALL)
+	{
+		// no free slot; the next write(), read() or flush() sends it
+		m_txKicked = false;
+	}
+}
+
+boolean LTcpConnection::flush()
+{
+	if(s_txSignal == 0)
+	{
+		s_txSignal = vm_signal_init();
+	}
+
+	unsigned long start = millis();
+	while(m_tx.available())
+	{
+		if(m_status != LTCP_CONN_CONNECTED)
+		{
+			return false;
+		}
+
+		const size_t pending = m_tx.available();
+		LTask.remoteCall(&flushHandler, this);
+		if(m_tx.available() < pending)
+		{
+			start = millis();
+			continue;
+		}
+
+		const unsigned long waited = millis() - start;
+		if(waited >= LTCP_WRITE_TIMEOUT)
+		{
+			vm_log_info("LTcpConnection write timeout, %d bytes pending", pending);
+			return false;
+		}
+
+		if(m_events)
+		{
+			// drain() posts the signal once the socket took data. In
+			// slices, so the wait in microseconds cannot overflow.
+			const unsigned long wait = LTCP_WRITE_TIMEOUT - waited;
+			vm_signal_timedwait(s_txSignal, (wait < 1000 ? wait : 1000) * 1000);
+		}
+		else
+		{
+			// no write events on this socket, try again later
+			delay(1);
+		}
+	}
+	return true;
+}
+
 SharedHandle::SharedHandle():
-	m_handle(INVALID_HANDLE),
-	m_serverHandle(INVALID_HANDLE),
-	m_pSharedCount(NULL)
+	m_pConn(NULL)
 {
 }
 
 SharedHandle::SharedHandle(VMINT handle):
-	m_handle(handle),
-	m_serverHandle(INVALID_HANDLE),
-	m_pSharedCount(new VMINT(1))
+	m_pConn(new LTcpConnection(handle, INVALID_HANDLE, LTCP_RX_BUFFER_SIZE, LTCP_TX_BUFFER_SIZE))
 {
-	vm_log_info("SharedHandle create: c:%d, s:%d", m_handle, m_serverHandle);
+	vm_log_info("SharedHandle create: c:%d", handle);
 }
 
 SharedHandle::SharedHandle(VMINT clientHandle, VMINT serverHandle):
-	m_handle(clientHandle),
-	m_serverHandle(serverHandle),
-	m_pSharedCount(new VMINT(1))
+	m_pConn(new LTcpConnection(clientHandle,
+							   serverHandle,
+							   clientHandle < 0 ? 0 : LTCP_RX_BUFFER_SIZE,
+							   clientHandle < 0 ? 0 : LTCP_TX_BUFFER_SIZE))
+{
+	vm_log_info("SharedHandle create: c:%d, s:%d", clientHandle, serverHandle);
+}
+
+SharedHandle::SharedHandle(LTcpConnection *pConn):
+	m_pConn(pConn)
 {
-	vm_log_info("SharedHandle create: c:%d, s:%d", m_handle, m_serverHandle);
 }
 
 SharedHandle::SharedHandle(const SharedHandle& rhs):
-	m_handle(rhs.m_handle),
-	m_serverHandle(rhs.m_serverHandle),
-	m_pSharedCount(rhs.m_pSharedCount)
+	m_pConn(rhs.m_pConn)
 {
 	incRef();
 }
@@ -56,18 +317,29 @@ SharedHandle::~SharedHandle()
 	decRef();
 }
 
-void SharedHandle::invalidateHandle()
+boolean SharedHandle::detach(SharedHandle &last)
 {
-	m_handle = INVALID_HANDLE;
-	m_serverHandle = INVALID_HANDLE; 
+	if(m_pConn == NULL || m_pConn->m_refCount > 1 || m_pConn->m_handle == INVALID_HANDLE)
+	{
+		*this = SharedHandle();
+		return false;
+	}
+
+	last = SharedHandle();
+	last.m_pConn = m_pConn;
+	m_pConn = NULL;
+	return true;
 }
 
 SharedHandle& SharedHandle::operator =(const SharedHandle& rhs)
 {
+	if(m_pConn == rhs.m_pConn)
+	{
+		return *this;
+	}
+
 	decRef();
-	m_handle = rhs.m_handle;
-	m_serverHandle = rhs.m_serverHandle;
-	m_pSharedCount = rhs.m_pSharedCount;
+	m_pConn = rhs.m_pConn;
 	incRef();
 
 	return *this;
@@ -75,88 +347,109 @@ SharedHandle& SharedHandle::operator =(const SharedHandle& rhs)
 
 SharedHandle::operator bool() const
 {
-	return (m_handle != INVALID_HANDLE);
+	return (m_pConn != NULL && m_pConn->m_handle != INVALID_HANDLE);
 }
 
 boolean SharedHandle::releaseTcpHandle(void *userData)
 {
-	SharedHandle *pThis = (SharedHandle*)userData;
-	vm_log_info("SharedHandle release: c=%d, s=%d", pThis->m_handle, pThis->m_serverHandle);
-	if (pThis->m_serverHandle != -1)
+	LTcpConnection *pConn = (LTcpConnection*)userData;
+	vm_log_info("SharedHandle release: c=%d, s=%d", pConn->m_handle, pConn->m_serverHandle);
+	if (pConn->m_serverHandle != -1)
 	{
-		VMINT ret = vm_soc_svr_close_client(pThis->m_handle);
+		VMINT ret = vm_soc_svr_close_client(pConn->m_handle);
 	}
 	else
 	{
-		vm_tcp_close(pThis->m_handle);
+		vm_tcp_close(pConn->m_handle);
 	}
+	pConn->m_handle = INVALID_HANDLE;
+	pConn->m_readable = false;
 	return true;
 }
 
 void SharedHandle::releaseHandle()
 {
-	if(m_handle == INVALID_HANDLE)
+	if(m_pConn->m_handle != INVALID_HANDLE)
 	{
-		invalidateHandle();
-		return;
+		// send what is still buffered before closing
+		m_pConn->flush();
+		LTask.remoteCall(&releaseTcpHandle, m_pConn);
 	}
-	
-	LTask.remoteCall(&releaseTcpHandle, (void*)this);
-	invalidateHandle();
+	if(m_pConn->m_drainCall != LTASK_INVALID_CALL)
+	{
+		// frees the slot of the last kick(), it has run by now
+		LTask.remoteCallWait(m_pConn->m_drainCall);
+	}
+	delete m_pConn;
+	m_pConn = NULL;
 }
 
 void SharedHandle::incRef()
 {
-	if(m_pSharedCount != NULL)
+	if(m_pConn != NULL)
 	{
-		(*m_pSharedCount)++;
+		m_pConn->m_refCount++;
 	}
 }
 
 void SharedHandle::decRef()
 {
-	if(m_pSharedCount == NULL)
+	if(m_pConn == NULL)
 	{
 		return;
 	}
 	
-	if(*m_pSharedCount)
-		*m_pSharedCount -= 1;
+	if(m_pConn->m_refCount)
+		m_pConn->m_refCount -= 1;
 
-	if(*m_pSharedCount <= 0)
+	if(m_pConn->m_refCount <= 0)
 	{
 		releaseHandle();
-		delete m_pSharedCount;
-		m_pSharedCount = NULL;
+	}
+	else
+	{
+		m_pConn = NULL;
 	}
 }
 
 LTcpClient::LTcpClient():
 	m_handle(),
-	m_peekByte(-1),
-	m_peekBuffered(false)
+	m_rxBufferSize(LTCP_RX_BUFFER_SIZE),
+	m_txBufferSize(LTCP_TX_BUFFER_SIZE),
+	m_connectTimeout(LTCP_CONNECT_TIMEOUT)
 {
 
 }
 
 LTcpClient::LTcpClient(const LTcpClient &rhs):
 	m_handle(rhs.m_handle),
-	m_peekByte(-1),
-	m_peekBuffered(false)
+	m_rxBufferSize(rhs.m_rxBufferSize),
+	m_txBufferSize(rhs.m_txBufferSize),
+	m_connectTimeout(rhs.m_connectTimeout)
 {
 }
 
 LTcpClient::LTcpClient(VMINT handle):
 	m_handle(handle),
-	m_peekByte(-1),
-	m_peekBuffered(false)
+	m_rxBufferSize(LTCP_RX_BUFFER_SIZE),
+	m_txBufferSize(LTCP_TX_BUFFER_SIZE),
+	m_connectTimeout(LTCP_CONNECT_TIMEOUT)
 {
 }
 
 LTcpClient::LTcpClient(VMINT handle, VMINT serverHandle):
 	m_handle(handle, serverHandle),
-	m_peekByte(-1),
-	m_peekBuffered(false)
+	m_rxBufferSize(LTCP_RX_BUFFER_SIZE),
+	m_txBufferSize(LTCP_TX_BUFFER_SIZE),
+	m_connectTimeout(LTCP_CONNECT_TIMEOUT)
+{
+}
+
+LTcpClient::LTcpClient(const SharedHandle &handle):
+	m_handle(handle),
+	m_rxBufferSize(LTCP_RX_BUFFER_SIZE),
+	m_txBufferSize(LTCP_TX_BUFFER_SIZE),
+	m_connectTimeout(LTCP_CONNECT_TIMEOUT)
 {
 }
 
@@ -164,38 +457,58 @@ LTcpClient::~LTcpClient()
 {
 }
 
+void LTcpClient::setReceiveBufferSize(size_t size)
+{
+	m_rxBufferSize = size;
+}
+
+void LTcpClient::setTransmitBufferSize(size_t size)
+{
+	m_txBufferSize = size;
+}
+
 struct LTcpConnectContext
 {
 	const char *ipAddr;
 	VMINT port;
-	LTcpClient *pInstance;
+	VMINT apn;
+	LTcpConnection *pConn;
 };
 
 void LTcpClient::connectCallback(VMINT handle, VMINT event, void *userData)
 {
-	LTcpClient *pThis = (LTcpClient*)userData;
+	LTcpConnection *pConn = (LTcpConnection*)userData;
 	vm_log_info("connectCallback handle=%d event=%d userData=%d", handle, event, userData);
 	switch(event)
 	{
 	case VM_TCP_EVT_CONNECTED:
-		pThis->m_handle = SharedHandle(handle);
-		LTask.post_signal();
+		pConn->m_handle = handle;
+		pConn->m_status = LTCP_CONN_CONNECTED;
+		vm_signal_post(s_connectSignal);
 		break;
 	case VM_TCP_EVT_CAN_WRITE:
+		pConn->drain();
 		break;
 	case VM_TCP_EVT_CAN_READ:
+		pConn->dataArrived(false);
 		break;
 	case VM_TCP_EVT_PIPE_BROKEN:
-		pThis->m_handle.invalidateHandle();
-		LTask.post_signal();
-		break;
 	case VM_TCP_EVT_HOST_NOT_FOUND:
-		pThis->m_handle.invalidateHandle();
-		LTask.post_signal();
-		break;
 	case VM_TCP_EVT_PIPE_CLOSED:
-		pThis->m_handle.invalidateHandle();
-		LTask.post_signal();
+		if(pConn->m_status == LTCP_CONN_CONNECTING)
+		{
+			pConn->m_connectResult = (event == VM_TCP_EVT_HOST_NOT_FOUND) ?
+										LTCP_CONNECT_HOST_NOT_FOUND : LTCP_CONNECT_FAILED;
+			pConn->m_status = LTCP_CONN_FAILED;
+			vm_signal_post(s_connectSignal);
+		}
+		else
+		{
+			// keep what the peer sent before closing
+			pConn->dataArrived(true);
+			// wakes up a pending flush()
+			pConn->drain();
+		}
 		break;
 	}
 	return;
@@ -208,11 +521,21 @@ boolean LTcpClient::connectIP(void *userData)
 	vm_log_info("connectIP, IP=%s, port=%d", pContext->ipAddr, pContext->port);
 	VMINT clientHandle = vm_tcp_connect_ex(pContext->ipAddr, 
 										   pContext->port, 
-										   pContext->pInstance->getAPN(),
-										   pContext->pInstance,
+										   pContext->apn,
+										   pContext->pConn,
 										   &connectCallback);
 	vm_log_info("vm_tcp_connect returns %d", clientHandle);
-	return false;
+	if(clientHandle < 0)
+	{
+		// no callback will follow
+		pContext->pConn->m_connectResult = LTCP_CONNECT_FAILED;
+		pContext->pConn->m_status = LTCP_CONN_FAILED;
+		return true;
+	}
+
+	// connectCallback() reports the result
+	pContext->pConn->m_handle = clientHandle;
+	return true;
 }
 
 int LTcpClient::connect(IPAddress ip, uint16_t port)
@@ -233,260 +556,522 @@ int LTcpClient::connect(const char *host, uint16_t port)
 {
 	vm_log_info("LTcpClient::connect(char) to %s:%d", host, port);
 
-	if(connected())
+	// fills the cache so that connectAsync() connects to the address.
+	// The lookup is part of the connect timeout; if it does not succeed in
+	// time, the socket resolves the name itself.
+	const unsigned long start = millis();
+	IPAddress ip;
+	LDnsCache.resolve(getAPN(), host, ip, m_connectTimeout ? m_connectTimeout : LDNS_RESOLVE_TIMEOUT);
+
+	unsigned long timeoutMs = m_connectTimeout;
+	if(timeoutMs)
 	{
-		vm_log_info("LTcpClient::connect() while already connected. stop() first.");
-		stop();
+		const unsigned long elapsed = millis() - start;
+		timeoutMs = (elapsed < timeoutMs) ? timeoutMs - elapsed : 1;
+	}
+
+	if(!connectAsync(host, port, timeoutMs))
+	{
+		return 0;
+	}
+
+	LTcpClient *pThis = this;
+	waitConnect(&pThis, 1, 0);
+	if(connectStatus() != LTCP_CONNECT_CONNECTED)
+	{
+		// the cached address may be stale, look the name up again next time
+		LDnsCache.remove(getAPN(), host);
 	}
-	
-	LTcpConnectContext context;
-	context.ipAddr = host;
-	context.port = port;
-	context.pInstance = this;
-	LTask.remoteCall(&connectIP, &context);	
 	return connected();
 }
 
-struct LTcpReadWriteContext
+int LTcpClient::connectAsync(IPAddress ip, uint16_t port, unsigned long timeoutMs)
 {
-	VMINT handle;
-	VMINT serverHandle;
-	void *buf;
-	VMINT len;
-	VMINT lenProcessed;	// bytes read or written
-	LTcpClient *pInst;
+	char ipAddr[50] = {0};
+	sprintf(ipAddr, 
+			"%d.%d.%d.%d", 
+			ip[0],
+			ip[1], 
+			ip[2], 
+			ip[3]);
+	return connectAsync(ipAddr, port, timeoutMs);
+}
 
-	LTcpReadWriteContext():
-		handle(-1),
-		serverHandle(-1),
-		buf(NULL),
-		len(0),
-		lenProcessed(0),
-		pInst(NULL)
-	{
+int LTcpClient::connectAsync(const char *host, uint16_t port, unsigned long timeoutMs)
+{
+	vm_log_info("LTcpClient::connectAsync to %s:%d", host, port);
 
+	if(s_connectSignal == 0)
+	{
+		s_connectSignal = vm_signal_init();
 	}
-};
 
-boolean LTcpClient::wifiWrite(void *userData)
-{
-	vm_log_info("wifiWrite");
-	LTcpReadWriteContext *pContext = (LTcpReadWriteContext*)userData;
-	if (pContext->serverHandle != -1)
+	LTaskBatch batch;
+	SharedHandle last;
+	if(connected())
 	{
-		pContext->lenProcessed = vm_soc_svr_send(pContext->serverHandle,
-												 pContext->handle, 
-												 pContext->buf, 
-												 pContext->len);
+		vm_log_info("LTcpClient::connect() while already connected. stop() first.");
 	}
-	else
+	// close the old socket in the same hop as the new connect
+	if(m_handle.detach(last))
+	{
+		last.connection()->flush();
+		batch.add(&SharedHandle::releaseTcpHandle, last.connection());
+	}
+
+	LTcpConnection *pConn = new LTcpConnection(-1, -1, m_rxBufferSize, m_txBufferSize);
+	pConn->m_status = LTCP_CONN_CONNECTING;
+	pConn->m_events = true;
+	pConn->m_hasDeadline = (timeoutMs != 0);
+	pConn->m_deadline = millis() + timeoutMs;
+	m_handle = SharedHandle(pConn);
+
+	// use the cached address, else let the socket resolve the name. That
+	// includes names whose last lookup failed, the failure may have passed.
+	const VMINT apn = getAPN();
+	char ipAddr[16] = {0};
+	IPAddress ip;
+	if(LDnsCache.lookup(apn, host, ip) > 0)
 	{
-		pContext->lenProcessed = vm_tcp_write(pContext->handle, 
-											  pContext->buf, 
-											  pContext->len);
+		sprintf(ipAddr, "%d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
+		host = ipAddr;
 	}
 	
-	vm_log_info("wifiWrite wrote %d", pContext->lenProcessed);
-	return true;
+	LTcpConnectContext context;
+	context.ipAddr = host;
+	context.port = port;
+	context.apn = apn;
+	context.pConn = pConn;
+	batch.add(&connectIP, &context);
+	LTask.batch(batch);
+
+	return (pConn->m_status != LTCP_CONN_FAILED);
 }
 
-size_t LTcpClient::write(uint8_t b)
+LTcpConnectStatus LTcpClient::connectStatus()
 {
-	vm_log_info("wifiWrite arduino (byte)");
-	LTcpReadWriteContext c;
-	c.handle = m_handle.m_handle;
-	c.serverHandle = m_handle.m_serverHandle;
-	c.buf = &b;
-	c.len = 1;
-	c.pInst = this;
-	LTask.remoteCall(&wifiWrite, &c);
+	LTcpConnection *pConn = m_handle.connection();
+	if(pConn == NULL)
+	{
+		return LTCP_CONNECT_IDLE;
+	}
 
-	vm_log_info("written %d bytes", c.lenProcessed);
-	return c.lenProcessed;
+	switch(pConn->m_status)
+	{
+	case LTCP_CONN_CONNECTING:
+		if(pConn->m_hasDeadline && (long)(millis() - pConn->m_deadline) >= 0)
+		{
+			vm_log_info("LTcpClient::connectStatus() timeout");
+			// closing the socket also stops its callbacks
+			if(pConn->m_handle != SharedHandle::INVALID_HANDLE)
+			{
+				LTask.remoteCall(&SharedHandle::releaseTcpHandle, pConn);
+			}
+			pConn->m_connectResult = LTCP_CONNECT_TIMED_OUT;
+			pConn->m_status = LTCP_CONN_FAILED;
+			return LTCP_CONNECT_TIMED_OUT;
+		}
+		return LTCP_CONNECT_PENDING;
+	case LTCP_CONN_FAILED:
+		return (LTcpConnectStatus)pConn->m_connectResult;
+	default:
+		return LTCP_CONNECT_CONNECTED;
+	}
 }
 
-size_t LTcpClient::write(const uint8_t *buf, size_t size)
+int LTcpClient::waitConnect(LTcpClient *clients[], int count, unsigned long timeoutMs)
 {
-	vm_log_info("wifiWrite arduino (buffered)");
-	LTcpReadWriteContext c;
-	c.handle = m_handle.m_handle;
-	c.serverHandle = m_handle.m_serverHandle;
-	c.buf = (void*)buf;
-	c.len = size;
-	c.pInst = this;
-	LTask.remoteCall(&wifiWrite, &c);
+	const unsigned long start = millis();
+	while(true)
+	{
+		// nearest point in time at which something may change without a signal
+		boolean pending = false;
+		unsigned long wait = timeoutMs;
+		for(int i = 0; i < count; ++i)
+		{
+			const LTcpConnectStatus status = clients[i]->connectStatus();
+			if(status == LTCP_CONNECT_CONNECTED)
+			{
+				return i;
+			}
+			if(status != LTCP_CONNECT_PENDING)
+			{
+				continue;
+			}
+
+			pending = true;
+			LTcpConnection *pConn = clients[i]->m_handle.connection();
+			if(pConn->m_hasDeadline)
+			{
+				unsigned long left = pConn->m_deadline - millis();
+				if((long)left <= 0)
+				{
+					// expired since the check above, look again soon
+					left = 1;
+				}
+				if(wait == 0 || left < wait)
+				{
+					wait = left;
+				}
+			}
+		}
 
-	vm_log_info("written %d bytes", c.lenProcessed);
-	return c.lenProcessed;
+		if(!pending)
+		{
+			return -1;
+		}
+
+		if(timeoutMs)
+		{
+			const unsigned long elapsed = millis() - start;
+			if(elapsed >= timeoutMs)
+			{
+				return -1;
+			}
+			if(timeoutMs - elapsed < wait)
+			{
+				wait = timeoutMs - elapsed;
+			}
+		}
+
+		if(wait == 0)
+		{
+			vm_signal_wait(s_connectSignal);
+		}
+		else
+		{
+			// in slices, so the wait in microseconds cannot overflow
+			vm_signal_timedwait(s_connectSignal, (wait < 1000 ? wait + 1 : 1000) * 1000);
+		}
+	}
 }
 
-int LTcpClient::available()
+void LTcpClient::setConnectTimeout(unsigned long timeoutMs)
 {
-	return (peek() == -1) ? 0 : 1;
+	m_connectTimeout = timeoutMs;
 }
 
-boolean LTcpClient::wifiRead(void *userData)
+struct LTcpWritevContext
 {
-	LTcpReadWriteContext *pContext = (LTcpReadWriteContext*)userData;
-	LTcpClient *pThis = pContext->pInst;
+	LTcpConnection *pConn;
+	const LIoVec *iov;
+	int count;
+	size_t skip;	// leading bytes of iov already in m_tx
+	size_t sent;
+};
 
-	pContext->lenProcessed = 0;
-	
-	// parameter check
-	if(pContext->len <= 0)
-	{	
+boolean LTcpClient::sendSegments(void *userData)
+{
+	LTcpWritevContext *pContext = (LTcpWritevContext*)userData;
+	LTcpConnection *pConn = pContext->pConn;
+	pContext->sent = 0;
+
+	// buffered data goes first
+	pConn->drain();
+	if(pConn->m_tx.available())
+	{
 		return true;
 	}
 
-	vm_log_info("wifiRead len=%d", pContext->len);
+	size_t skip = pContext->skip;
+	for(int i = 0; i < pContext->count; ++i)
+	{
+		if(skip >= pContext->iov[i].len)
+		{
+			skip -= pContext->iov[i].len;
+			continue;
+		}
 
-	// check peek state
-	if(pThis->m_peekBuffered)
-	{	
-		// insert the peeked byte
-		*((VMINT8*)pContext->buf) = pThis->m_peekByte;
-		pContext->buf = (VMINT8*)pContext->buf + 1;
-		pContext->lenProcessed += 1;
-		pContext->len--;
-		// clear peek state
-		pThis->m_peekByte = -1;
-		pThis->m_peekBuffered = false;
+		const size_t len = pContext->iov[i].len - skip;
+		const VMINT ret = pConn->send(pContext->iov[i].buf + skip, len);
+		skip = 0;
+		if(ret <= 0)
+		{
+			break;
+		}
+		pContext->sent += ret;
+		if((size_t)ret < len)
+		{
+			break;
+		}
 	}
+	return true;
+}
 
-	VMINT readResult = VM_TCP_READ_EOF;
-	
-	// actually read from TCP socket
-	if (pContext->serverHandle != -1)
+size_t LTcpClient::writev(const LIoVec *iov, int count)
+{
+	LTcpConnection *pConn = m_handle.connection();
+	if(!connected() || pConn->m_tx.capacity() == 0)
 	{
-		readResult = vm_soc_svr_read(pContext->serverHandle,
-									 pContext->handle, 
-									 pContext->buf, 
-									 pContext->len);
+		setWriteError();
+		return 0;
 	}
-	else
+
+	size_t total = 0;
+	for(int i = 0; i < count; ++i)
 	{
-		readResult = vm_tcp_read(pContext->handle, 
-								 pContext->buf, 
-								 pContext->len);
+		total += iov[i].len;
 	}
 
-	if (readResult > 0)
+	// small messages are cheaper to copy into the transmit buffer
+	size_t copied = 0;
+	if(pConn->m_tx.available() + total < pConn->txHighWater())
 	{
-		pContext->lenProcessed += readResult;
+		for(int i = 0; i < count; ++i)
+		{
+			const size_t done = pConn->m_tx.write(iov[i].buf, iov[i].len);
+			copied += done;
+			if(done < iov[i].len)
+			{
+				break;
+			}
+		}
+		if(copied == total)
+		{
+			pConn->kick();
+			return total;
+		}
 	}
-	
-	if (readResult == VM_TCP_READ_EOF)
+
+	// hand the rest of the segments to the socket as they are, in one hop
+	LTcpWritevContext context;
+	context.pConn = pConn;
+	context.iov = iov;
+	context.count = count;
+	context.skip = copied;
+	context.sent = 0;
+	LTask.remoteCall(&sendSegments, &context);
+
+	// buffer whatever the socket did not take
+	size_t written = copied + context.sent;
+	size_t skip = copied + context.sent;
+	for(int i = 0; i < count; ++i)
 	{
-		// we may cache a peek byte even if the socket is disconnected
-		vm_log_info("wifiRead socket disconnected");
+		if(skip >= iov[i].len)
+		{
+			skip -= iov[i].len;
+			continue;
+		}
+
+		const size_t len = iov[i].len - skip;
+		const size_t done = write(iov[i].buf + skip, len);
+		written += done;
+		skip = 0;
+		if(done < len)
+		{
+			break;
+		}
 	}
-	
-	vm_log_info("wifiRead %d bytes", pContext->lenProcessed);
-	return true;
+	return written;
 }
 
-int LTcpClient::read()
+size_t LTcpClient::write(uint8_t b)
 {
-	// read a single byte
-	LTcpReadWriteContext c;
-	uint8_t ret = 0;
-	c.handle = m_handle.m_handle;
-	c.serverHandle = m_handle.m_serverHandle;
-	c.buf = &ret;
-	c.len = 1;
-	c.pInst = this;
-	LTask.remoteCall(&wifiRead, &c);
-	if(c.lenProcessed > 0)
+	return write(&b, 1);
+}
+
+size_t LTcpClient::write(const uint8_t *buf, size_t size)
+{
+	LTcpConnection *pConn = m_handle.connection();
+	if(!connected() || pConn->m_tx.capacity() == 0)
 	{
-		return (int)ret;
+		setWriteError();
+		return 0;
 	}
-	else
+
+	const size_t highWater = pConn->txHighWater();
+	size_t written = 0;
+	while(written < size)
 	{
-		// if no data available, return -1
-		return -1;
-	}	
-}
+		written += pConn->m_tx.write(buf + written, size - written);
 
-int LTcpClient::read(uint8_t *buf, size_t size)
-{
-	// read a single byte
-	LTcpReadWriteContext c;
-	uint8_t ret = 0;
-	c.handle = m_handle.m_handle;
-	c.serverHandle = m_handle.m_serverHandle;
-	c.buf = buf;
-	c.len = size;
-	c.pInst = this;
-	vm_log_info("wifiRead call with buf=%d, size=%d", c.buf, c.len);
-	LTask.remoteCall(&wifiRead, &c);
-	vm_log_info("LTcpClient::read return %d", c.lenProcessed);
-	return c.lenProcessed;
+		if(pConn->m_tx.available() >= highWater || written < size)
+		{
+			if(!pConn->flush())
+			{
+				setWriteError();
+				break;
+			}
+		}
+	}
+
+	// the MMI thread sends the rest meanwhile
+	pConn->kick();
+	return written;
 }
 
-boolean LTcpClient::wifiPeek(void *userData)
+LTcpConnection* LTcpClient::receive()
 {
-	LTcpClient *pThis = (LTcpClient*)userData;
+	LTcpConnection *pConn = m_handle.connection();
+	if(pConn == NULL)
+	{
+		return pConn;
+	}
 
-	if(pThis->m_peekBuffered)
+	// a closed socket may still hold data that did not fit into m_rx
+	if(pConn->m_status != LTCP_CONN_CONNECTED &&
+	   !(pConn->m_status == LTCP_CONN_CLOSED && pConn->m_readable))
 	{
-		return true;
+		return pConn;
 	}
 
-	// read and store the peeked byte
-	LTcpReadWriteContext cntx;
-	cntx.buf = &pThis->m_peekByte;
-	cntx.len = sizeof(pThis->m_peekByte);
-	cntx.handle = pThis->m_handle.m_handle;
-	cntx.serverHandle = pThis->m_handle.m_serverHandle;
-	cntx.lenProcessed = 0;
-	cntx.pInst = pThis;
-	if(!wifiRead(&cntx))
+	// send the pending request before looking for the response,
+	// in the same hop as reading it.
+	LTaskBatch batch;
+	if(pConn->m_tx.available())
 	{
-		vm_log_error("read fail in wifiPeek");
+		batch.add(&LTcpConnection::flushHandler, pConn);
 	}
 
-	if (cntx.lenProcessed > 0)
+	// buffer empty: only ask the MMI thread if the socket may have more
+	if(pConn->m_rx.available() == 0 && (pConn->m_readable || !pConn->m_events))
 	{
-		pThis->m_peekBuffered = true;
+		batch.add(&LTcpConnection::fillHandler, pConn);
 	}
-	else
+
+	if(batch.count())
 	{
-		pThis->m_peekBuffered = false;
+		LTask.batch(batch);
 	}
+	return pConn;
+}
 
-	return true;
+int LTcpClient::available()
+{
+	LTcpConnection *pConn = receive();
+	if(pConn == NULL)
+	{
+		return 0;
+	}
+	return pConn->m_rx.available();
 }
 
-int LTcpClient::peek()
+int LTcpClient::read()
 {
-	// peek() must return -1 when there is no data to read
-	if (m_handle == -1)
+	LTcpConnection *pConn = receive();
+	if(pConn == NULL)
 	{
-		vm_log_info("peek() with invalid handle, return -1");
 		return -1;
 	}
+	return pConn->m_rx.read();
+}
+
+int LTcpClient::read(uint8_t *buf, size_t size)
+{
+	LTcpConnection *pConn = receive();
+	if(pConn == NULL)
+	{
+		return 0;
+	}
 
-	LTask.remoteCall(&wifiPeek, this);
+	size_t done = pConn->m_rx.read(buf, size);
+	if(done < size && done > 0)
+	{
+		// the buffer may have been full, fetch the rest
+		pConn = receive();
+		done += pConn->m_rx.read(buf + done, size - done);
+	}
+	vm_log_info("LTcpClient::read return %d", done);
+	return done;
+}
 
-	if (m_peekBuffered)
+int LTcpClient::readAvailableUntil(uint8_t terminator, uint8_t *buf, size_t size)
+{
+	LTcpConnection *pConn = receive();
+	if(pConn == NULL)
 	{
-		return (int)m_peekByte;
+		return 0;
 	}
-	else
+	return pConn->m_rx.readUntil(terminator, buf, size);
+}
+
+bool LTcpClient::waitAvailable(unsigned long timeout)
+{
+	if(s_rxSignal == 0)
+	{
+		s_rxSignal = vm_signal_init();
+	}
+
+	const unsigned long start = millis();
+	while(true)
+	{
+		// an event that arrives after this check leaves the signal set
+		LTcpConnection *pConn = receive();
+		if(pConn == NULL)
+		{
+			return false;
+		}
+		if(pConn->m_rx.available())
+		{
+			return true;
+		}
+		if(pConn->m_status != LTCP_CONN_CONNECTED && !pConn->m_readable)
+		{
+			return false;
+		}
+
+		const unsigned long elapsed = millis() - start;
+		if(elapsed >= timeout)
+		{
+			return false;
+		}
+
+		const unsigned long wait = timeout - elapsed;
+		if(!pConn->m_events)
+		{
+			// no read events for this socket, look again shortly
+			delay(1);
+			continue;
+		}
+		// in slices, so the wait in microseconds cannot overflow
+		vm_signal_timedwait(s_rxSignal, (wait < 1000 ? wait : 1000) * 1000);
+	}
+}
+
+int LTcpClient::peek()
+{
+	LTcpConnection *pConn = receive();
+	if(pConn == NULL)
 	{
 		return -1;
 	}
+	return pConn->m_rx.peek();
 }
 
 void LTcpClient::stop()
 {
+	// a client served by LTcpServer::begin(maxClients) shares its connection
+	// with the server slot, so the last reference is not ours: close it now.
+	LTcpConnection *pConn = m_handle.connection();
+	if(pConn && pConn->m_events && pConn->m_serverHandle != -1 &&
+	   pConn->m_handle != SharedHandle::INVALID_HANDLE)
+	{
+		pConn->flush();
+		LTask.remoteCall(&SharedHandle::releaseTcpHandle, pConn);
+		pConn->m_status = LTCP_CONN_CLOSED;
+	}
+
 	// release reference to handle
 	m_handle = SharedHandle();
 }
 
 uint8_t LTcpClient::connected()
 {
-	return bool(m_handle);
+	LTcpConnection *pConn = m_handle.connection();
+	if(pConn == NULL)
+	{
+		return false;
+	}
+	if(pConn->m_status == LTCP_CONN_CONNECTED)
+	{
+		return pConn->m_handle != SharedHandle::INVALID_HANDLE;
+	}
+
+	// like Arduino's EthernetClient, a closed connection counts as
+	// connected until its received data has been read, including what
+	// the socket still holds. fill() closes the socket once it is empty.
+	return pConn->m_status == LTCP_CONN_CLOSED &&
+		   (pConn->m_rx.available() || (pConn->m_readable && pConn->m_handle != SharedHandle::INVALID_HANDLE));
 }
 
 LTcpClient::operator bool()
@@ -496,9 +1081,12 @@ LTcpClient::operator bool()
 
 void LTcpClient::flush()
 {
-	// both read() and write() are inherently flush()ed.
-	// so we simply return here.
-	return;
+	LTcpConnection *pConn = m_handle.connection();
+	if(pConn == NULL)
+	{
+		return;
+	}
+	pConn->flush();
 }
 
 VMINT LTcpClient::getAPN() const
@@ -17,9 +17,119 @@
 #include "Print.h"
 #include "Client.h"
 #include "IPAddress.h"
+#include "LRingBuffer.h"
+#include "LTask.h"
+
+// default size of the receive buffer of each TCP connection, in bytes
+#ifndef LTCP_RX_BUFFER_SIZE
+#define LTCP_RX_BUFFER_SIZE 1024
+#endif
+
+// default size of the transmit buffer of each TCP connection, in bytes
+#ifndef LTCP_TX_BUFFER_SIZE
+#define LTCP_TX_BUFFER_SIZE 1024
+#endif
+
+// write() waits for the transmit buffer to be sent once it is this many
+// percent full, of the size set by LTcpClient::setTransmitBufferSize()
+#ifndef LTCP_TX_HIGH_WATER_PERCENT
+#define LTCP_TX_HIGH_WATER_PERCENT 75
+#endif
+
+// how long write() and flush() wait for a socket that accepts no data,
+// in milliseconds
+#ifndef LTCP_WRITE_TIMEOUT
+#define LTCP_WRITE_TIMEOUT 10000
+#endif
+
+// default time connect() waits for the server, in milliseconds
+#ifndef LTCP_CONNECT_TIMEOUT
+#define LTCP_CONNECT_TIMEOUT 30000
+#endif
+
+// progress of a connection attempt, see LTcpClient::connectStatus()
+enum LTcpConnectStatus
+{
+    LTCP_CONNECT_IDLE,              // no connection attempt
+    LTCP_CONNECT_PENDING,           // still connecting
+    LTCP_CONNECT_CONNECTED,         // connected (it may have been closed since)
+    LTCP_CONNECT_HOST_NOT_FOUND,    // the host name could not be resolved
+    LTCP_CONNECT_FAILED,            // refused, unreachable or cancelled
+    LTCP_CONNECT_TIMED_OUT          // no answer within the timeout
+};
 
 
 /* DOM-NOT_FOR_SDK-BEGIN */
+// state of a LTcpConnection
+enum LTcpConnectionStatus
+{
+    LTCP_CONN_CONNECTING,   // vm_tcp_connect_ex() issued, waiting for VM_TCP_EVT_CONNECTED
+    LTCP_CONN_CONNECTED,
+    LTCP_CONN_CLOSED,       // closed by peer or broken, unread data may remain
+    LTCP_CONN_FAILED        // connect failed
+};
+
+// State of one TCP socket, shared by all LTcpClient copies of it.
+// The MMI thread writes received data into m_rx and the Arduino thread reads it;
+// the Arduino thread writes outgoing data into m_tx and the MMI thread sends it.
+class LTcpConnection
+{
+public:
+    LTcpConnection(VMINT handle, VMINT serverHandle, size_t rxSize, size_t txSize);
+
+    // moves readable socket data into m_rx. Once a closed connect()ed socket
+    // is empty, it is closed and m_handle becomes -1. MMI thread only.
+    void fill();
+    static boolean fillHandler(void *userData);
+
+    // read or close event: pulls the socket data into m_rx, marks the
+    // connection closed if asked to and wakes LTcpClient::waitAvailable().
+    // MMI thread only.
+    void dataArrived(boolean closed);
+
+    // writes to the socket, marks the connection closed on error. MMI thread only.
+    VMINT send(const uint8_t *buf, size_t len);
+
+    // sends as much of m_tx as the socket takes. MMI thread only.
+    void drain();
+
+    // drain(), and asks drain() to post the flush() signal once
+    // VM_TCP_EVT_CAN_WRITE lets more data out
+    static boolean flushHandler(void *userData);
+
+    // drain() queued by kick()
+    static boolean drainHandler(void *userData);
+
+    // queues drain() on the MMI thread without waiting for it, so that
+    // written data goes out while the Arduino thread carries on.
+    // Arduino thread only.
+    void kick();
+
+    // sends m_tx and waits until the socket has taken all of it. Gives up
+    // after LTCP_WRITE_TIMEOUT milliseconds without progress or when the
+    // connection closes and returns false then. Arduino thread only.
+    boolean flush();
+
+    // fill level of m_tx at which write() flushes
+    size_t txHighWater() const { return m_tx.capacity() * LTCP_TX_HIGH_WATER_PERCENT / 100; }
+
+    VMINT m_handle;                 // socket handle, -1 if none
+    VMINT m_serverHandle;           // server handle for accepted sockets, -1 otherwise
+    VMINT m_refCount;
+    volatile VMINT m_status;        // LTcpConnectionStatus
+    volatile boolean m_readable;    // the socket may hold data that is not in m_rx yet
+    boolean m_events;               // VM_TCP_EVT_xxx are delivered for this socket
+    boolean m_txWaiting;            // flush() waits for VM_TCP_EVT_CAN_WRITE
+    boolean m_txBlocked;            // an LTcpServer broadcast frame is partly sent, m_tx waits
+    volatile boolean m_txKicked;    // the drainHandler() queued by kick() has not started yet
+    LTaskCallToken m_drainCall;     // last drainHandler() queued by kick()
+    volatile VMINT m_connectResult; // LTcpConnectStatus once m_status is LTCP_CONN_FAILED
+    unsigned long m_deadline;       // millis() when connecting gives up
+    boolean m_hasDeadline;
+    LRingBuffer m_rx;
+    LRingBuffer m_tx;
+};
+
 // partially mimic the behavior of std::shard_ptr
 // since we don't have tr1/0x/11 support right now.
 class SharedHandle
@@ -28,15 +138,23 @@ public:
     SharedHandle();
     explicit SharedHandle(VMINT handle);
     SharedHandle(VMINT clientHandle, VMINT serverHandle);
+    explicit SharedHandle(LTcpConnection *pConn);   // takes over the reference of pConn
     SharedHandle(const SharedHandle& rhs);
     ~SharedHandle();
 
-    void invalidateHandle();
+    // drops this reference. If it was the last one, the connection is moved
+    // into last instead of being released, so the caller can queue
+    // releaseTcpHandle(last.connection()) itself.
+    // Returns true if last received the connection.
+    boolean detach(SharedHandle &last);
 
     SharedHandle& operator =(const SharedHandle& rhs);
     operator bool() const;
 
+    LTcpConnection* connection() const { return m_pConn; }
+
     friend class LTcpClient;
+    friend class LTcpServer;
     
 protected:
     static const VMINT INVALID_HANDLE = -1;
@@ -46,9 +164,7 @@ protected:
     static boolean releaseTcpHandle(void *userData);
 
 private:    
-    VMINT m_handle;
-    VMINT m_serverHandle;
-    VMINT *m_pSharedCount;
+    LTcpConnection *m_pConn;
 };
 /* DOM-NOT_FOR_SDK-END */
 
@@ -82,6 +198,7 @@ public:
   LTcpClient(const LTcpClient &rhs);
   LTcpClient(VMINT handle);
   LTcpClient(VMINT handle, VMINT serverHandle);
+  LTcpClient(const SharedHandle &handle);
   ~LTcpClient();
   /* DOM-NOT_FOR_SDK-END */
 
@@ -118,6 +235,78 @@ public:
   // </code>
   virtual int connect(const char *host, uint16_t port);
 
+  // DESCRIPTION
+  //   Starts connecting to a TCP server and returns immediately.
+  //   Use connectStatus() or waitConnect() to learn the result and stop() to cancel.
+  //   Several clients may be connecting at the same time.
+  // 
+  // PARAMETERS
+  //   host: server name or address, e.g. "www.somewebsite.com" or "172.21.84.11"
+  //   port: TCP port to be connected
+  //   timeoutMs: time in milliseconds after which the attempt fails with
+  //              LTCP_CONNECT_TIMED_OUT, 0 to wait forever
+  // 
+  // RETURNS
+  //   1 if the attempt has started, 0 if it failed immediately.
+  //
+  // EXAMPLE
+  // <code>
+  //     LGPRSClient primary, fallback;
+  //     primary.connectAsync("primary.example.com", 80, 10000);
+  //     fallback.connectAsync("fallback.example.com", 80, 10000);
+  //     LTcpClient *clients[2] = { &primary, &fallback };
+  //     int winner = LTcpClient::waitConnect(clients, 2, 10000);
+  //     if (winner != 0) primary.stop();   // cancel the loser
+  //     if (winner != 1) fallback.stop();
+  // </code>
+  int connectAsync(const char *host, uint16_t port, unsigned long timeoutMs = LTCP_CONNECT_TIMEOUT);
+
+  // DESCRIPTION
+  //   Starts connecting to a TCP server and returns immediately, see connectAsync(const char*, uint16_t, unsigned long).
+  // 
+  // PARAMETERS
+  //   ip: server address
+  //   port: TCP port to be connected
+  //   timeoutMs: time in milliseconds after which the attempt fails, 0 to wait forever
+  // 
+  // RETURNS
+  //   1 if the attempt has started, 0 if it failed immediately.
+  int connectAsync(IPAddress ip, uint16_t port, unsigned long timeoutMs = LTCP_CONNECT_TIMEOUT);
+
+  // DESCRIPTION
+  //   Queries the progress of the last connect() or connectAsync().
+  //   An attempt that has run out of time is cancelled here.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   One of LTCP_CONNECT_IDLE, LTCP_CONNECT_PENDING, LTCP_CONNECT_CONNECTED,
+  //   LTCP_CONNECT_HOST_NOT_FOUND, LTCP_CONNECT_FAILED or LTCP_CONNECT_TIMED_OUT.
+  LTcpConnectStatus connectStatus();
+
+  // DESCRIPTION
+  //   Waits until one of the clients has connected or all of their attempts have failed.
+  // 
+  // PARAMETERS
+  //   clients: clients on which connectAsync() has been called
+  //   count: number of entries in clients
+  //   timeoutMs: maximum time to wait in milliseconds, 0 to wait forever
+  // 
+  // RETURNS
+  //   Index of the first connected client, -1 if none connected in time.
+  static int waitConnect(LTcpClient *clients[], int count, unsigned long timeoutMs);
+
+  // DESCRIPTION
+  //   Sets how long connect() waits for the server. The default is LTCP_CONNECT_TIMEOUT milliseconds.
+  // 
+  // PARAMETERS
+  //   timeoutMs: timeout in milliseconds, 0 to wait forever
+  // 
+  // RETURNS
+  //   N/A
+  void setConnectTimeout(unsigned long timeoutMs);
+
   // DESCRIPTION
   //   Writes data to server after connected to one.
   // 
@@ -125,7 +314,7 @@ public:
   //   byte: Single byte to be sent
   // 
   // RETURNS
-  //   Total written bytes.
+  //   Total written bytes. The data is buffered, see flush().
   virtual size_t write(uint8_t);
   
 
@@ -137,7 +326,7 @@ public:
   //   size: Size of byteArray, in bytes
   // 
   // RETURNS
-  //   Total written bytes.
+  //   Total written bytes. The data is buffered, see flush().
   //
   // EXAMPLE
   // <code>
@@ -146,6 +335,26 @@ public:
   // </code>
   virtual size_t write(const uint8_t *buf, size_t size);
 
+  // DESCRIPTION
+  //   Writes several buffers, e.g. a header, a body and a trailer, as one stream.
+  //   Small messages are buffered like write(); larger ones are passed to the
+  //   socket directly in a single call to the network thread, without copying
+  //   them into one buffer first.
+  // 
+  // PARAMETERS
+  //   iov: array of buffers, sent in order
+  //   count: number of entries in iov
+  // 
+  // RETURNS
+  //   Total written bytes.
+  //
+  // EXAMPLE
+  // <code>
+  //     LIoVec iov[2] = { { header, headerLen }, { body, bodyLen } };
+  //     client.writev(iov, 2);  // client is an instance of LWiFiClient or LGPRSClient.
+  // </code>
+  virtual size_t writev(const LIoVec *iov, int count);
+
   // DESCRIPTION
   //   Queries if there are incoming data from server side and returns the number of byte available for read after connecting to a server.
   // 
@@ -154,10 +363,7 @@ public:
   // 
   // RETURNS
   //   0: There is no data available for read.
-  //   1: There is data available for read. (The current implementation is not
-  //      compatible with the Arduino. A compatible implementation would mean
-  //      that the return value is the size of the data available for read, i.e.
-  //      >0: Size of the data available for read, in bytes)
+  //   >0: Size of the data available for read, in bytes
   //
   // EXAMPLE
   // <code>
@@ -203,6 +409,24 @@ public:
   //   0: There are no data to read
   virtual int read(uint8_t *buf, size_t size);
 
+  /* DOM-NOT_FOR_SDK-BEGIN */
+  // used by readBytesUntil(): as read(buf, size), but stops after terminator
+  virtual int readAvailableUntil(uint8_t terminator, uint8_t *buf, size_t size);
+  /* DOM-NOT_FOR_SDK-END */
+
+  // DESCRIPTION
+  //   Waits until data sent from the server side is available to read.
+  //   The Arduino thread sleeps until the socket reports new data, the
+  //   connection closes or the timeout expires.
+  // 
+  // PARAMETERS
+  //   timeout: Longest wait in milliseconds
+  // 
+  // RETURNS
+  //   true: Data is available
+  //   false: Timed out, or the connection is closed and all data has been read
+  virtual bool waitAvailable(unsigned long timeout);
+
   // DESCRIPTION
   //   Queries the first unread byte sent from the connected server side.
   //   This byte is not considered as read; therefore this method will return the same byte until read() is called. 
@@ -215,14 +439,17 @@ public:
   virtual int peek();
 
   // DESCRIPTION
-  //   Drops all data sent from server side to this client object.
+  //   Sends all data written so far and waits until the socket has taken it,
+  //   or until LTCP_WRITE_TIMEOUT milliseconds pass without progress.
+  //   write() puts data into a transmit buffer that is sent in the background;
+  //   once the buffer is LTCP_TX_HIGH_WATER_PERCENT percent full, write() waits as flush() does.
   // 
   // PARAMETERS
   //   N/A
   // 
   // RETURNS
   //   N/A
-  virtual void flush(); // flush is not currrently supported.
+  virtual void flush();
 
   // DESCRIPTION
   //   Disconnects from the connected TCP server.
@@ -256,20 +483,48 @@ public:
   //   flase: the client object is not in connected state.
   virtual operator bool();
 
+  // DESCRIPTION
+  //   Sets the size of the receive buffer used by the next connect().
+  //   Incoming data is moved into this buffer as it arrives, so read(), peek()
+  //   and available() are served without waiting for the network.
+  //   The default is LTCP_RX_BUFFER_SIZE bytes.
+  // 
+  // PARAMETERS
+  //   size: buffer size in bytes
+  // 
+  // RETURNS
+  //   N/A
+  void setReceiveBufferSize(size_t size);
+
+  // DESCRIPTION
+  //   Sets the size of the transmit buffer used by the next connect().
+  //   The default is LTCP_TX_BUFFER_SIZE bytes.
+  // 
+  // PARAMETERS
+  //   size: buffer size in bytes
+  // 
+  // RETURNS
+  //   N/A
+  void setTransmitBufferSize(size_t size);
+
 public:
   friend class LTcpServer;
+  friend class LConnectionPool;
 
 protected:
   /* DOM-NOT_FOR_SDK-BEGIN */
   SharedHandle m_handle;    // Manages underlying TCP resource handles. Reference counted, copy-constructable.
-  VMINT8 m_peekByte;        // buffer to store the peek byte
-  boolean m_peekBuffered;   // is the buffer valid or not
+  size_t m_rxBufferSize;    // receive buffer size of the next connection
+  size_t m_txBufferSize;    // transmit buffer size of the next connection
+  unsigned long m_connectTimeout;
+
+  static boolean sendSegments(void *userData);
+
+  // makes sure m_rx holds data if the socket has some, returns the connection
+  LTcpConnection* receive();
 
   static boolean connectIP(void *userData);
   static void connectCallback(VMINT handle, VMINT event, void *userData);
-  static boolean wifiRead(void *userData);
-  static boolean wifiWrite(void *userData);
-  static boolean wifiPeek(void *userData);
     
 
   virtual VMINT getAPN() const = 0;
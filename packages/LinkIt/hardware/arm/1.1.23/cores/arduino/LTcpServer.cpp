@@ -20,16 +20,206 @@
 #include "vmlog.h"
 #include "vmsock.h"
 #include "vmnwsetting.h"
+#include "LBarrier.h"
+
+#if LTCP_BROADCAST_QUEUE_DEPTH < 2
+#error LTCP_BROADCAST_QUEUE_DEPTH must be at least 2
+#endif
+
+// posted when a blocked broadcast write() may find room
+static VM_SIGNAL_ID s_broadcastSignal = 0;
+
+// one broadcast write, shared by the send queues of all clients.
+// refCount is only touched by the MMI thread.
+struct LTcpBroadcastFrame
+{
+	int refCount;
+	size_t size;
+	uint8_t data[1];
+};
+
+struct LTcpSendQueue
+{
+	LTcpBroadcastFrame *frames[LTCP_BROADCAST_QUEUE_DEPTH];
+	int first;			// oldest frame
+	int count;
+	size_t offset;		// bytes of the oldest frame already sent
+	boolean pending;	// has not taken the frame of a blocked write() yet
+};
+
+static LTcpBroadcastFrame* newFrame(size_t size)
+{
+	LTcpBroadcastFrame *pFrame = (LTcpBroadcastFrame*)malloc(sizeof(LTcpBroadcastFrame) + size);
+	if(pFrame)
+	{
+		pFrame->refCount = 1;
+		pFrame->size = size;
+	}
+	return pFrame;
+}
+
+static void releaseFrame(LTcpBroadcastFrame *pFrame)
+{
+	if(--pFrame->refCount == 0)
+	{
+		free(pFrame);
+	}
+}
 
 LTcpServer::LTcpServer(uint16_t port):
 	m_port(port),
-	m_handle(-1)
+	m_handle(-1),
+	m_slots(NULL),
+	m_lastActive(NULL),
+	m_maxClients(0),
+	m_acceptQueue(NULL),
+	m_acceptHead(0),
+	m_acceptTail(0),
+	m_nextReady(0),
+	m_idleTimeout(LTCP_SERVER_IDLE_TIMEOUT),
+	m_sendQueues(NULL),
+	m_slowPolicy(LTCP_SLOW_CLIENT_DROP_OLDEST),
+	m_broadcastWaiting(false)
+{
+}
+
+int LTcpServer::findSlot(VMINT hClient) const
+{
+	for(int i = 0; i < m_maxClients; ++i)
+	{
+		if(m_slots[i].connection()->m_handle == hClient)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+void LTcpServer::acceptSlot(VMINT hServer, VMINT hClient)
+{
+	for(int i = 0; i < m_maxClients; ++i)
+	{
+		// free once closed and no client object holds it any more
+		LTcpConnection *pConn = m_slots[i].connection();
+		if(pConn->m_handle != -1 || pConn->m_refCount > 1)
+		{
+			continue;
+		}
+
+		pConn->m_rx.clear();
+		pConn->m_tx.clear();
+		clearQueue(i);
+		pConn->m_serverHandle = hServer;
+		pConn->m_readable = true;
+		pConn->m_txWaiting = false;
+		pConn->m_status = LTCP_CONN_CONNECTED;
+		m_lastActive[i] = millis();
+		LBARRIER();
+		pConn->m_handle = hClient;
+
+		// the queue holds more entries than there are slots, it cannot overflow
+		const int head = m_acceptHead;
+		m_acceptQueue[head] = i;
+		LBARRIER();
+		m_acceptHead = (head + 1) % (m_maxClients + 1);
+		return;
+	}
+
+	vm_log_info("server full, refusing client handle=%d", hClient);
+	vm_soc_svr_close_client(hClient);
+}
+
+void LTcpServer::clearQueue(int slot)
 {
+	LTcpSendQueue &q = m_sendQueues[slot];
+	while(q.count)
+	{
+		releaseFrame(q.frames[q.first]);
+		q.first = (q.first + 1) % LTCP_BROADCAST_QUEUE_DEPTH;
+		q.count--;
+	}
+	q.first = 0;
+	q.offset = 0;
+	q.pending = false;
+	m_slots[slot].connection()->m_txBlocked = false;
+}
+
+void LTcpServer::drainQueue(int slot)
+{
+	LTcpSendQueue &q = m_sendQueues[slot];
+	LTcpConnection *pConn = m_slots[slot].connection();
+	while(true)
+	{
+		if(q.offset == 0)
+		{
+			// between frames, the data written to this client alone goes
+			// out first and whole, so that the two never interleave
+			pConn->m_txBlocked = false;
+			if(pConn->m_tx.available())
+			{
+				pConn->drain();
+				if(pConn->m_tx.available())
+				{
+					break;
+				}
+			}
+			if(q.count == 0)
+			{
+				break;
+			}
+		}
+
+		LTcpBroadcastFrame *pFrame = q.frames[q.first];
+		// parenthesized to keep the send() macro of vmsock.h out
+		const VMINT ret = (pConn->send)(pFrame->data + q.offset, pFrame->size - q.offset);
+		if(ret < 0)
+		{
+			// nobody will take this data any more
+			clearQueue(slot);
+			break;
+		}
+		if(ret > 0)
+		{
+			// a client that only receives broadcasts is not idle
+			m_lastActive[slot] = millis();
+		}
+
+		// partial writes keep the rest for the next VM_SOC_SVR_EVT_WRITE,
+		// ahead of anything else written to this client
+		q.offset += ret;
+		if(q.offset < pFrame->size)
+		{
+			pConn->m_txBlocked = true;
+			break;
+		}
+		releaseFrame(pFrame);
+		q.first = (q.first + 1) % LTCP_BROADCAST_QUEUE_DEPTH;
+		q.count--;
+		q.offset = 0;
+	}
+
+	if(m_broadcastWaiting && q.count < LTCP_BROADCAST_QUEUE_DEPTH)
+	{
+		m_broadcastWaiting = false;
+		vm_signal_post(s_broadcastSignal);
+	}
+}
+
+void LTcpServer::closeSlot(int slot)
+{
+	LTcpConnection *pConn = m_slots[slot].connection();
+	clearQueue(slot);
+	if(pConn->m_handle != -1)
+	{
+		SharedHandle::releaseTcpHandle(pConn);
+	}
+	pConn->m_status = LTCP_CONN_CLOSED;
 }
 
 void LTcpServer::serverCallback(VMINT handle, VMINT event, VMINT param, void *user_data)
 {
 	LTcpServer *pThis = (LTcpServer*)user_data;
+	int slot = -1;
 	vm_log_info("serverCallback handle=%d, evt=%d, param=%d", handle, event, param);
 	switch(event)
 	{
@@ -44,13 +234,43 @@ void LTcpServer::serverCallback(VMINT handle, VMINT event, VMINT param, void *us
 		break;
 	case VM_SOC_SVR_EVT_ACCEPT:
 		vm_log_info("new client handle=%d", param);
-		pThis->m_clients.push_back(param);
+		if(pThis->m_maxClients)
+		{
+			pThis->acceptSlot(handle, param);
+		}
+		else
+		{
+			pThis->m_clients.push_back(param);
+		}
 		break;
     case VM_SOC_SVR_EVT_READ:
+		slot = pThis->findSlot(param);
+		if(slot >= 0)
+		{
+			pThis->m_slots[slot].connection()->dataArrived(false);
+			pThis->m_lastActive[slot] = millis();
+		}
 		break;
     case VM_SOC_SVR_EVT_WRITE:
+		slot = pThis->findSlot(param);
+		if(slot >= 0)
+		{
+			// sends the client's own data and the broadcast frames in turn
+			pThis->drainQueue(slot);
+		}
 		break;
     case VM_SOC_SVR_EVT_CLOSED:
+		slot = pThis->findSlot(param);
+		if(slot >= 0)
+		{
+			// keep what the peer sent before closing
+			LTcpConnection *pConn = pThis->m_slots[slot].connection();
+			pConn->dataArrived(true);
+			// wakes up a pending broadcast write() or flush(); the queue
+			// goes first, it may hold back m_tx
+			pThis->drainQueue(slot);
+			pConn->drain();
+		}
 		break;
     case VM_SOC_SVR_EVT_FAILED:
 		vm_log_info("open server on port=%d failed param=%d", pThis->m_port, param);
@@ -91,12 +311,316 @@ boolean LTcpServer::deinitServer(void *userData)
 	return false;
 }
 
+void LTcpServer::begin(int maxClients)
+{
+	if(m_slots == NULL)
+	{
+		if(maxClients < 1)
+		{
+			maxClients = 1;
+		}
+
+		m_slots = new SharedHandle[maxClients];
+		m_lastActive = new unsigned long[maxClients];
+		m_acceptQueue = new int[maxClients + 1];
+		m_sendQueues = new LTcpSendQueue[maxClients];
+		memset(m_sendQueues, 0, sizeof(LTcpSendQueue) * maxClients);
+		m_acceptHead = 0;
+		m_acceptTail = 0;
+		m_nextReady = 0;
+		for(int i = 0; i < maxClients; ++i)
+		{
+			LTcpConnection *pConn = new LTcpConnection(-1, -1, LTCP_RX_BUFFER_SIZE, LTCP_TX_BUFFER_SIZE);
+			pConn->m_events = true;
+			m_slots[i] = SharedHandle(pConn);
+			m_lastActive[i] = 0;
+		}
+		LBARRIER();
+		m_maxClients = maxClients;
+	}
+	begin();
+}
+
+boolean LTcpServer::closeSlots(void *userData)
+{
+	LTcpServer* pThis = (LTcpServer*)userData;
+	for(int i = 0; i < pThis->m_maxClients; ++i)
+	{
+		// send what is still queued before closing
+		pThis->drainQueue(i);
+		pThis->m_slots[i].connection()->drain();
+		pThis->closeSlot(i);
+	}
+	return true;
+}
+
 void LTcpServer::end()
 {
-	LTask.remoteCall(deinitServer, this);
+	LTaskBatch batch;
+	if(m_maxClients)
+	{
+		batch.add(&closeSlots, this);
+	}
+	batch.add(&deinitServer, this);
+	LTask.batch(batch);
+
+	if(m_slots)
+	{
+		// client objects still holding a slot keep its connection alive
+		m_maxClients = 0;
+		delete [] m_slots;
+		delete [] m_lastActive;
+		delete [] m_acceptQueue;
+		delete [] m_sendQueues;
+		m_slots = NULL;
+		m_lastActive = NULL;
+		m_acceptQueue = NULL;
+		m_sendQueues = NULL;
+	}
 	return;
 }
 
+int LTcpServer::poll(int ready[], int maxCount)
+{
+	if(m_maxClients == 0)
+	{
+		return 0;
+	}
+
+	// close clients that idled too long, and closed ones nobody will read
+	LTaskBatch batch;
+	for(int i = 0; i < m_maxClients; ++i)
+	{
+		LTcpConnection *pConn = m_slots[i].connection();
+		if(pConn->m_handle == -1 || pConn->m_rx.available())
+		{
+			continue;
+		}
+
+		const boolean idle = m_idleTimeout && (millis() - m_lastActive[i] >= m_idleTimeout);
+		const boolean dead = (pConn->m_status != LTCP_CONN_CONNECTED && pConn->m_refCount == 1);
+		if(idle || dead)
+		{
+			vm_log_info("closing client handle=%d idle=%d", pConn->m_handle, idle);
+			pConn->m_status = LTCP_CONN_CLOSED;
+			if(!batch.add(&SharedHandle::releaseTcpHandle, pConn))
+			{
+				LTask.batch(batch);
+				batch.clear();
+				batch.add(&SharedHandle::releaseTcpHandle, pConn);
+			}
+		}
+	}
+	if(batch.count())
+	{
+		LTask.batch(batch);
+	}
+
+	int count = 0;
+	for(int i = 0; i < m_maxClients && count < maxCount; ++i)
+	{
+		LTcpConnection *pConn = m_slots[i].connection();
+		if(pConn->m_handle != -1 && (pConn->m_rx.available() || pConn->m_status != LTCP_CONN_CONNECTED))
+		{
+			ready[count++] = i;
+		}
+	}
+	return count;
+}
+
+int LTcpServer::clientCount()
+{
+	int count = 0;
+	for(int i = 0; i < m_maxClients; ++i)
+	{
+		if(m_slots[i].connection()->m_handle != -1)
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+void LTcpServer::setIdleTimeout(unsigned long timeoutMs)
+{
+	m_idleTimeout = timeoutMs;
+}
+
+void LTcpServer::setSlowClientPolicy(LTcpSlowClientPolicy policy)
+{
+	m_slowPolicy = policy;
+}
+
+struct LTcpBroadcastContext
+{
+	LTcpServer *pInst;
+	LTcpBroadcastFrame *pFrame;
+	boolean first;			// first attempt: queue to every client
+	boolean last;			// LTCP_SLOW_CLIENT_BLOCK timed out
+	int pending;			// clients that had no room
+	size_t totalQueued;
+};
+
+boolean LTcpServer::broadcastHandler(void *userData)
+{
+	LTcpBroadcastContext *pCntx = (LTcpBroadcastContext*)userData;
+	LTcpServer *pThis = pCntx->pInst;
+	LTcpBroadcastFrame *pFrame = pCntx->pFrame;
+	pCntx->pending = 0;
+	for(int i = 0; i < pThis->m_maxClients; ++i)
+	{
+		LTcpSendQueue &q = pThis->m_sendQueues[i];
+		LTcpConnection *pConn = pThis->m_slots[i].connection();
+		if(!pCntx->first && !q.pending)
+		{
+			continue;
+		}
+		q.pending = false;
+
+		if(pConn->m_handle == -1 || pConn->m_status != LTCP_CONN_CONNECTED)
+		{
+			pThis->clearQueue(i);
+			continue;
+		}
+
+		if(q.count == LTCP_BROADCAST_QUEUE_DEPTH)
+		{
+			if(pThis->m_slowPolicy == LTCP_SLOW_CLIENT_DROP_OLDEST)
+			{
+				// a partly sent frame must be completed, drop the one after it
+				const int drop = q.offset ? 1 : 0;
+				releaseFrame(q.frames[(q.first + drop) % LTCP_BROADCAST_QUEUE_DEPTH]);
+				for(int k = drop; k < q.count - 1; ++k)
+				{
+					q.frames[(q.first + k) % LTCP_BROADCAST_QUEUE_DEPTH] = q.frames[(q.first + k + 1) % LTCP_BROADCAST_QUEUE_DEPTH];
+				}
+				q.count--;
+			}
+			else if(pThis->m_slowPolicy == LTCP_SLOW_CLIENT_BLOCK && !pCntx->last)
+			{
+				q.pending = true;
+				pCntx->pending++;
+				continue;
+			}
+			else
+			{
+				vm_log_info("closing slow client handle=%d", pConn->m_handle);
+				pThis->closeSlot(i);
+				continue;
+			}
+		}
+
+		q.frames[(q.first + q.count) % LTCP_BROADCAST_QUEUE_DEPTH] = pFrame;
+		q.count++;
+		pFrame->refCount++;
+		pThis->m_lastActive[i] = millis();
+		pCntx->totalQueued += pFrame->size;
+		pThis->drainQueue(i);
+	}
+
+	pThis->m_broadcastWaiting = (pCntx->pending != 0);
+	if(pCntx->pending == 0)
+	{
+		// the queues hold their own references
+		releaseFrame(pFrame);
+	}
+	return true;
+}
+
+size_t LTcpServer::broadcast(LTcpBroadcastFrame *pFrame)
+{
+	if(s_broadcastSignal == 0)
+	{
+		s_broadcastSignal = vm_signal_init();
+	}
+
+	LTcpBroadcastContext cntx;
+	cntx.pInst = this;
+	cntx.pFrame = pFrame;
+	cntx.first = true;
+	cntx.last = false;
+	cntx.pending = 0;
+	cntx.totalQueued = 0;
+	LTask.remoteCall(&broadcastHandler, &cntx);
+
+	// only LTCP_SLOW_CLIENT_BLOCK leaves clients pending
+	const unsigned long start = millis();
+	while(cntx.pending)
+	{
+		const unsigned long waited = millis() - start;
+		if(waited >= LTCP_BROADCAST_BLOCK_TIMEOUT)
+		{
+			cntx.last = true;
+		}
+		else
+		{
+			vm_signal_timedwait(s_broadcastSignal, (LTCP_BROADCAST_BLOCK_TIMEOUT - waited) * 1000);
+		}
+		cntx.first = false;
+		LTask.remoteCall(&broadcastHandler, &cntx);
+	}
+	return cntx.totalQueued;
+}
+
+SharedHandle LTcpServer::slotHandle(int slot)
+{
+	if(slot < 0 || slot >= m_maxClients || m_slots[slot].connection()->m_handle == -1)
+	{
+		return SharedHandle();
+	}
+	return m_slots[slot];
+}
+
+SharedHandle LTcpServer::availableSlot()
+{
+	flush();
+
+	int ready[1];
+	poll(ready, 0);
+
+	// new clients first, in the order they connected
+	while(m_acceptTail != m_acceptHead)
+	{
+		const int tail = m_acceptTail;
+		const int slot = m_acceptQueue[tail];
+		LBARRIER();
+		m_acceptTail = (tail + 1) % (m_maxClients + 1);
+
+		SharedHandle handle = slotHandle(slot);
+		if(handle)
+		{
+			return handle;
+		}
+	}
+
+	// then each client with unread data in turn
+	for(int k = 0; k < m_maxClients; ++k)
+	{
+		const int slot = (m_nextReady + k) % m_maxClients;
+		LTcpConnection *pConn = m_slots[slot].connection();
+		if(pConn->m_handle != -1 && pConn->m_rx.available())
+		{
+			m_nextReady = (slot + 1) % m_maxClients;
+			return m_slots[slot];
+		}
+	}
+	return SharedHandle();
+}
+
+// a write of the plain begin() mode: the same segments to every client
+struct LTcpServerWriteContext
+{
+	LTcpServer *pInst;
+	const LIoVec *iov;
+	int count;
+	size_t size;					// of all segments
+	boolean started;
+	std::vector<VMINT> clients;		// the clients when the write started
+	std::vector<size_t> sent;		// bytes each of them has taken
+	size_t totalWritten;
+	boolean pending;				// some client has not taken all segments yet
+};
+
 struct LTcpAcceptConnectionContext
 {
 	LTcpServer *pInst;
@@ -110,8 +634,9 @@ boolean LTcpServer::acceptConnection(void *userData)
 	vm_log_info("acceptConnection() client count=%d", pCntx->pInst->m_clients.size());	
 	if (pCntx->pInst->m_clients.size() > 0)
 	{		
-		const VMINT hClient = pCntx->pInst->m_clients.back();
-		pCntx->pInst->m_clients.pop_back();
+		// oldest first, later clients must not starve the early ones
+		const VMINT hClient = pCntx->pInst->m_clients.front();
+		pCntx->pInst->m_clients.erase(pCntx->pInst->m_clients.begin());
 		pCntx->hClient = hClient;
 	}
 	else
@@ -128,6 +653,9 @@ void LTcpServer::availableImpl(VMINT& hClient, VMINT& hServer)
 	LTcpAcceptConnectionContext cntx;
 	cntx.pInst = this;
 	cntx.hClient = -1;
+
+	// send pending broadcast data first
+	flush();
 	LTask.remoteCall(&acceptConnection, &cntx);
 
 	hClient = cntx.hClient;
@@ -141,40 +669,179 @@ size_t LTcpServer::write(uint8_t data)
 	return write(&data, 1);
 }
 
-struct LTcpServerWriteContext
-{
-	LTcpServer *pInst;
-	VMINT totalWritten;
-	const uint8_t *buf;
-	size_t size;
-};
-
 boolean LTcpServer::wifiServerWrite(void *userData)
 {
 	LTcpServerWriteContext *pCntx = (LTcpServerWriteContext*)userData;
 	LTcpServer *pThis = pCntx->pInst;
-	pCntx->totalWritten = 0;
-	for(int i = 0; i < pThis->m_clients.size(); ++i)
+	if(!pCntx->started)
+	{
+		pCntx->started = true;
+		pCntx->clients = pThis->m_clients;
+		pCntx->sent.assign(pCntx->clients.size(), 0);
+	}
+
+	pCntx->pending = false;
+	for(size_t i = 0; i < pCntx->clients.size(); ++i)
 	{
-		VMINT written = vm_tcp_write_sync(pThis->m_clients[i], (void*)pCntx->buf, (VMINT)pCntx->size);
-		if(written > 0)
+		while(pCntx->sent[i] < pCntx->size)
 		{
-			pCntx->totalWritten += written;
+			// segment and offset of the next byte for this client
+			size_t skip = pCntx->sent[i];
+			int j = 0;
+			while(skip >= pCntx->iov[j].len)
+			{
+				skip -= pCntx->iov[j].len;
+				++j;
+			}
+
+			const size_t len = pCntx->iov[j].len - skip;
+			const VMINT ret = vm_soc_svr_send(pThis->m_handle, pCntx->clients[i], pCntx->iov[j].buf + skip, len);
+			if(ret < 0)
+			{
+				// skip the rest for this client, the stream is broken anyway
+				pCntx->sent[i] = pCntx->size;
+				break;
+			}
+			pCntx->sent[i] += ret;
+			pCntx->totalWritten += ret;
+			if((size_t)ret < len)
+			{
+				// the socket is full, the next call sends the rest
+				pCntx->pending = true;
+				break;
+			}
 		}
 	}
+	return true;
 }
 
-size_t LTcpServer::write(const uint8_t *buf, size_t size)
+size_t LTcpServer::sendPlain(const LIoVec *iov, int count)
 {
 	LTcpServerWriteContext cntx;
 	cntx.pInst = this;
+	cntx.iov = iov;
+	cntx.count = count;
+	cntx.size = 0;
+	for(int j = 0; j < count; ++j)
+	{
+		cntx.size += iov[j].len;
+	}
+	cntx.started = false;
 	cntx.totalWritten = 0;
-	cntx.buf = buf;
-	cntx.size = size;
-	LTask.remoteCall(&wifiServerWrite, &cntx);
+	cntx.pending = false;
+
+	unsigned long start = millis();
+	size_t progress = 0;
+	while(true)
+	{
+		LTask.remoteCall(&wifiServerWrite, &cntx);
+		if(!cntx.pending)
+		{
+			break;
+		}
+
+		if(cntx.totalWritten != progress)
+		{
+			progress = cntx.totalWritten;
+			start = millis();
+		}
+		else if(millis() - start > LTCP_WRITE_TIMEOUT)
+		{
+			vm_log_info("LTcpServer write timeout");
+			break;
+		}
+		// no write events for the sockets of this mode, try again later
+		delay(1);
+	}
 	return cntx.totalWritten;
 }
 
+size_t LTcpServer::writev(const LIoVec *iov, int count)
+{
+	if(m_maxClients)
+	{
+		// one frame with the buffered data and all segments
+		const size_t buffered = m_tx.available();
+		size_t size = buffered;
+		for(int j = 0; j < count; ++j)
+		{
+			size += iov[j].len;
+		}
+		LTcpBroadcastFrame *pFrame = newFrame(size);
+		if(pFrame == NULL)
+		{
+			return 0;
+		}
+		size_t offset = m_tx.read(pFrame->data, buffered);
+		for(int j = 0; j < count; ++j)
+		{
+			memcpy(pFrame->data + offset, iov[j].buf, iov[j].len);
+			offset += iov[j].len;
+		}
+		return broadcast(pFrame);
+	}
+
+	// buffered data goes first
+	size_t total = flush();
+	total += sendPlain(iov, count);
+	return total;
+}
+
+size_t LTcpServer::write(const uint8_t *buf, size_t size)
+{
+	if(m_tx.capacity() == 0 && !m_tx.begin(LTCP_TX_BUFFER_SIZE))
+	{
+		return 0;
+	}
+
+	const size_t highWater = m_tx.capacity() * LTCP_TX_HIGH_WATER_PERCENT / 100;
+	size_t written = 0;
+	while(written < size)
+	{
+		written += m_tx.write(buf + written, size - written);
+		if(m_tx.available() >= highWater || written < size)
+		{
+			// empties m_tx, also when clients time out
+			flush();
+		}
+	}
+	return written;
+}
+
+size_t LTcpServer::flush()
+{
+	if(m_tx.available() == 0)
+	{
+		return 0;
+	}
+
+	if(m_maxClients)
+	{
+		size_t totalQueued = 0;
+		LTcpBroadcastFrame *pFrame = newFrame(m_tx.available());
+		if(pFrame)
+		{
+			m_tx.read(pFrame->data, pFrame->size);
+			totalQueued = broadcast(pFrame);
+		}
+		m_tx.clear();
+		return totalQueued;
+	}
+
+	// each contiguous part of m_tx in turn
+	size_t total = 0;
+	while(m_tx.available())
+	{
+		LIoVec iov;
+		size_t len = 0;
+		iov.buf = m_tx.readBuffer(len);
+		iov.len = len;
+		total += sendPlain(&iov, 1);
+		m_tx.consume(len);
+	}
+	return total;
+}
+
 struct LTcpServerIPContext
 {
 	VMINT handle;
@@ -17,9 +17,37 @@
 #include "Print.h"
 #include "Client.h"
 #include "Server.h"
+#include "LTcpClient.h"
 #include <vector>
 
-class LTcpClient;
+// default time after which begin(maxClients) closes a client that sent nothing, in milliseconds
+#ifndef LTCP_SERVER_IDLE_TIMEOUT
+#define LTCP_SERVER_IDLE_TIMEOUT 60000
+#endif
+
+// number of broadcast writes queued per client by begin(maxClients)
+#ifndef LTCP_BROADCAST_QUEUE_DEPTH
+#define LTCP_BROADCAST_QUEUE_DEPTH 8
+#endif
+
+// longest time LTCP_SLOW_CLIENT_BLOCK waits for a client, in milliseconds
+#ifndef LTCP_BROADCAST_BLOCK_TIMEOUT
+#define LTCP_BROADCAST_BLOCK_TIMEOUT 5000
+#endif
+
+// what write() does for a client whose broadcast queue is full,
+// see LTcpServer::setSlowClientPolicy()
+enum LTcpSlowClientPolicy
+{
+  LTCP_SLOW_CLIENT_DROP_OLDEST,   // drops the oldest write not started yet
+  LTCP_SLOW_CLIENT_DISCONNECT,    // closes the client
+  LTCP_SLOW_CLIENT_BLOCK          // waits for room, then closes the client after LTCP_BROADCAST_BLOCK_TIMEOUT
+};
+
+/* DOM-NOT_FOR_SDK-BEGIN */
+struct LTcpBroadcastFrame;
+struct LTcpSendQueue;
+/* DOM-NOT_FOR_SDK-END */
 
 //LTcpServer Class
 //
@@ -65,6 +93,35 @@ public:
   //   N/A
   void begin();
 
+  // DESCRIPTION
+  //   Starts listening and serves up to maxClients clients at the same time.
+  //   Each client gets its own receive and transmit buffers, which the network
+  //   events fill and drain, so checking clients for data costs no call to
+  //   the network thread. available() returns new clients in the order they
+  //   connected, then clients with unread data in turn, and keeps returning the
+  //   same connection for a client until it is stopped.
+  //   Further clients are refused while maxClients are connected.
+  // 
+  // PARAMETERS
+  //   maxClients: number of client connections served at the same time
+  // 
+  // RETURNS
+  //   N/A
+  //
+  // EXAMPLE
+  // <code>
+  //     LWiFiServer server(80);
+  //     server.begin(4);
+  //     ...
+  //     int ready[4];
+  //     int n = server.poll(ready, 4);
+  //     for (int i = 0; i < n; ++i) {
+  //         LWiFiClient c = server.client(ready[i]);
+  //         while (c.available()) handle(c.read());
+  //     }
+  // </code>
+  void begin(int maxClients);
+
   // DESCRIPTION
   //   Close all
   //   Stops listening to a TCP port that accepts client connections.
@@ -83,8 +140,10 @@ public:
   //   byte: Write a single byte to all connected clients.
   // 
   // RETURNS
-  //   Actual written bytes.
-  //   Since this counts all bytes written to all connected clients, this value can be bigger than the size parameter passed to this method.
+  //   Number of bytes accepted. The data is buffered and sent to all clients
+  //   once LTCP_TX_HIGH_WATER_PERCENT percent of LTCP_TX_BUFFER_SIZE are pending, on flush() or on the next available().
+  //   After begin(maxClients), sending queues the data to each client without
+  //   waiting for it, see setSlowClientPolicy().
   virtual size_t write(uint8_t);
 
   // DESCRIPTION
@@ -95,10 +154,33 @@ public:
   //   size: buf size in bytes
   // 
   // RETURNS
-  //   Actual written bytes.
-  //   Since this counts all bytes written to all connected clients, this value can be bigger than the size parameter passed to this method.
+  //   Number of bytes accepted. The data is buffered, see write(uint8_t).
   virtual size_t write(const uint8_t *buf, size_t size);
 
+  // DESCRIPTION
+  //   Sends the data buffered by write() to all connected clients.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   Actual written bytes.
+  //   Since this counts all bytes written to all connected clients, this value can be bigger than the number of bytes buffered.
+  size_t flush();
+
+  // DESCRIPTION
+  //   Writes several buffers to all connected clients as one stream.
+  //   Buffered data goes first, then the segments, without copying
+  //   them into one buffer first.
+  // 
+  // PARAMETERS
+  //   iov: array of buffers, sent in order
+  //   count: number of entries in iov
+  // 
+  // RETURNS
+  //   Actual written bytes, counted over all clients.
+  virtual size_t writev(const LIoVec *iov, int count);
+
   // DESCRIPTION
   //   returns the IP address of the server. An IP address is only valid after begin() is called.
   // 
@@ -109,6 +191,49 @@ public:
   //   IP address of the server  
   IPAddress serverIP();
 
+  // DESCRIPTION
+  //   Lists the clients that have unread data or have been closed by the peer,
+  //   and closes clients idle for longer than the idle timeout.
+  //   Only for servers started with begin(maxClients).
+  // 
+  // PARAMETERS
+  //   ready: receives the slot numbers of the ready clients, see client()
+  //   maxCount: number of entries in ready
+  // 
+  // RETURNS
+  //   Number of slot numbers stored in ready.
+  int poll(int ready[], int maxCount);
+
+  // DESCRIPTION
+  //   Returns the number of connected clients of a server started with begin(maxClients).
+  int clientCount();
+
+  // DESCRIPTION
+  //   Sets the time after which a client that neither sent nor received
+  //   anything is closed.
+  //   The default is LTCP_SERVER_IDLE_TIMEOUT milliseconds.
+  // 
+  // PARAMETERS
+  //   timeoutMs: timeout in milliseconds, 0 to keep idle clients
+  // 
+  // RETURNS
+  //   N/A
+  void setIdleTimeout(unsigned long timeoutMs);
+
+  // DESCRIPTION
+  //   Chooses what happens when a client of a server started with begin(maxClients)
+  //   reads slower than write() sends. Each write is stored once and queued to every
+  //   client, and each client sends its queue as its connection can take it, so a
+  //   slow client does not delay the others. When LTCP_BROADCAST_QUEUE_DEPTH writes
+  //   are queued for a client, the policy decides. The default is LTCP_SLOW_CLIENT_DROP_OLDEST.
+  // 
+  // PARAMETERS
+  //   policy: LTCP_SLOW_CLIENT_DROP_OLDEST, LTCP_SLOW_CLIENT_DISCONNECT or LTCP_SLOW_CLIENT_BLOCK
+  // 
+  // RETURNS
+  //   N/A
+  void setSlowClientPolicy(LTcpSlowClientPolicy policy);
+
   using Print::write;
 
 protected:
@@ -125,6 +250,12 @@ protected:
   //   An pointer to LTcpClient object representing the connection between this server object and the remote client.
   //   This object will turn to false if there is no incoming connection.
   void availableImpl(VMINT& hClient, VMINT& hServer);
+
+  // available() of a server started with begin(maxClients)
+  SharedHandle availableSlot();
+
+  // connection of a slot, empty if the slot is not connected
+  SharedHandle slotHandle(int slot);
   /* DOM-NOT_FOR_SDK-END */
 
 protected:
@@ -136,8 +267,40 @@ protected:
   static boolean acceptConnection(void *userData);
   static void serverCallback(VMINT handle, VMINT event, VMINT param, void *user_data);
   static boolean wifiServerWrite(void *userData);
+  static boolean closeSlots(void *userData);
+  static boolean broadcastHandler(void *userData);
+
+  // plain begin() mode: sends the segments to every client, giving up on the
+  // clients that take nothing for LTCP_WRITE_TIMEOUT milliseconds.
+  // Returns the bytes sent, counted over all clients.
+  size_t sendPlain(const LIoVec *iov, int count);
+
+  // begin(maxClients) broadcast: queues frame to every client, takes ownership of it
+  size_t broadcast(LTcpBroadcastFrame *pFrame);
+
+  // slot of a client handle, -1 if none. MMI thread only.
+  int findSlot(VMINT hClient) const;
+  void acceptSlot(VMINT hServer, VMINT hClient);
+  // MMI thread only
+  void drainQueue(int slot);
+  void clearQueue(int slot);
+  void closeSlot(int slot);
   
   std::vector<VMINT> m_clients;
+  LRingBuffer m_tx;                 // data written but not sent yet
+
+  // begin(maxClients) mode
+  SharedHandle *m_slots;            // one preallocated connection per client
+  unsigned long *m_lastActive;      // millis() of the last data received, queued or sent per slot
+  int m_maxClients;                 // 0 in the plain begin() mode
+  int *m_acceptQueue;               // slots accepted but not returned by available() yet
+  volatile int m_acceptHead;        // written by the MMI thread
+  volatile int m_acceptTail;        // written by the Arduino thread
+  int m_nextReady;                  // round robin position of availableSlot()
+  unsigned long m_idleTimeout;
+  LTcpSendQueue *m_sendQueues;      // broadcast writes not sent yet, per slot
+  LTcpSlowClientPolicy m_slowPolicy;
+  volatile boolean m_broadcastWaiting;  // a blocked write() waits for queue room
   /* DOM-NOT_FOR_SDK-END */	
 };
 
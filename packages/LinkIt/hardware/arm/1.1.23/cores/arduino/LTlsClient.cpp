@@ -0,0 +1,747 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+   See the GNU Lesser General Public License for more details.
+*/
+#include <Arduino.h>
+#include <string.h>
+#include "LTask.h"
+#include "LTlsClient.h"
+#include "LDnsCache.h"
+#include "vmlog.h"
+#include "vmtls.h"
+
+// vmsock.h maps the BSD socket names to vm_xxx() macros
+#undef connect
+
+// A vm_tls context per server. It outlives its connections so that the next
+// connection to the same server can resume the TLS session kept in it.
+// The table is only touched on the MMI thread.
+struct LTlsSession
+{
+    char host[LDNS_MAX_NAME];
+    uint16_t port;
+    VMINT apn;
+    VMINT ctx;                      // vm_tls context, -1 if the slot is free
+    LTlsConnection *pConn;          // connection using the context, NULL if idle
+    boolean handshaked;             // a session has been established in ctx
+    unsigned long lastUsed;
+    vm_sockaddr_ex_struct addr;
+};
+
+static LTlsSession s_sessions[LTLS_SESSION_CACHE_SIZE];
+static boolean s_sessionsInit = false;
+
+// posted by the MMI thread whenever a connection attempt finishes
+static VM_SIGNAL_ID s_tlsSignal = 0;
+
+// posted by the MMI thread when data arrives or a connection closes,
+// wakes LTlsClient::waitAvailable(); 0 until the first wait
+static VM_SIGNAL_ID s_rxSignal = 0;
+
+static void deleteSession(LTlsSession *pSession)
+{
+    vm_log_info("LTlsSession delete ctx %d", pSession->ctx);
+    vm_tls_delete_ctx(pSession->ctx);
+    pSession->ctx = -1;
+    pSession->pConn = NULL;
+    pSession->handshaked = false;
+}
+
+static LTlsSession* findSession(VMINT ctx)
+{
+    for(int i = 0; i < LTLS_SESSION_CACHE_SIZE; ++i)
+    {
+        if(s_sessions[i].ctx == ctx && ctx >= 0)
+        {
+            return &s_sessions[i];
+        }
+    }
+    return NULL;
+}
+
+LTlsConnection::LTlsConnection(size_t rxSize, size_t txSize):
+    m_pSession(NULL),
+    m_status(LTLS_CONN_CONNECTING),
+    m_readable(false),
+    m_txWaiting(false),
+    m_reused(false)
+{
+    m_rx.begin(rxSize);
+    m_tx.begin(txSize);
+}
+
+void LTlsConnection::fill()
+{
+    if(m_pSession == NULL)
+    {
+        return;
+    }
+
+    while(true)
+    {
+        size_t len = 0;
+        uint8_t *pBuf = m_rx.writeBuffer(len);
+        if(len == 0)
+        {
+            // buffer full, the rest stays in the connection
+            return;
+        }
+
+        const VMINT ret = vm_tls_read(m_pSession->ctx, pBuf, len);
+        if(ret > 0)
+        {
+            m_rx.commit(ret);
+            continue;
+        }
+
+        if(ret != VM_TLS_ERR_WOULDBLOCK && m_status == LTLS_CONN_CONNECTED)
+        {
+            vm_log_info("LTlsConnection ctx %d read returns %d", m_pSession->ctx, ret);
+            m_status = LTLS_CONN_CLOSED;
+        }
+        // drained, VM_TLS_READ tells when more arrives
+        m_readable = false;
+        return;
+    }
+}
+
+void LTlsConnection::drain()
+{
+    while(m_pSession && m_status == LTLS_CONN_CONNECTED)
+    {
+        size_t len = 0;
+        const uint8_t *pBuf = m_tx.readBuffer(len);
+        if(len == 0)
+        {
+            break;
+        }
+
+        const VMINT ret = vm_tls_write(m_pSession->ctx, pBuf, len);
+        if(ret == VM_TLS_ERR_WOULDBLOCK)
+        {
+            // VM_TLS_WRITE tells when to go on
+            break;
+        }
+        if(ret < 0)
+        {
+            vm_log_info("LTlsConnection ctx %d write failed %d", m_pSession->ctx, ret);
+            m_status = LTLS_CONN_CLOSED;
+            break;
+        }
+
+        m_tx.consume(ret);
+        if((size_t)ret < len)
+        {
+            break;
+        }
+    }
+
+    if(m_status != LTLS_CONN_CONNECTED)
+    {
+        // nobody will take this data any more
+        m_tx.clear();
+    }
+
+    if(m_txWaiting && m_tx.available() == 0)
+    {
+        m_txWaiting = false;
+        LTask.post_signal();
+    }
+}
+
+void LTlsConnection::fail()
+{
+    if(m_status == LTLS_CONN_CONNECTING)
+    {
+        m_status = LTLS_CONN_FAILED;
+        vm_signal_post(s_tlsSignal);
+    }
+    else
+    {
+        // keep what the peer sent before closing
+        fill();
+        m_status = LTLS_CONN_CLOSED;
+        // wakes up a pending flush() and waitAvailable()
+        drain();
+        if(s_rxSignal)
+        {
+            vm_signal_post(s_rxSignal);
+        }
+    }
+}
+
+boolean LTlsConnection::fillHandler(void *userData)
+{
+    ((LTlsConnection*)userData)->fill();
+    return true;
+}
+
+boolean LTlsConnection::flushHandler(void *userData)
+{
+    LTlsConnection *pConn = (LTlsConnection*)userData;
+    pConn->drain();
+    if(pConn->m_tx.available() == 0)
+    {
+        return true;
+    }
+
+    // drain() posts the signal once VM_TLS_WRITE has emptied m_tx
+    pConn->m_txWaiting = true;
+    return false;
+}
+
+static void tlsCallback(vm_tls_event_struct *pEvent)
+{
+    LTlsSession *pSession = findSession(pEvent->res_id);
+    if(pSession == NULL || pSession->pConn == NULL)
+    {
+        return;
+    }
+
+    LTlsConnection *pConn = pSession->pConn;
+    vm_log_info("tlsCallback ctx=%d msg=%d", pEvent->res_id, pEvent->msg);
+    switch(pEvent->msg)
+    {
+    case VM_MSG_ID_APP_SOC_NOTIFY_IND:
+        {
+            vm_tls_soc_notify_ind_struct *pInd = (vm_tls_soc_notify_ind_struct*)pEvent;
+            if(pInd->event_type == VM_SOC_CONNECT && pInd->result)
+            {
+                const VMINT ret = vm_tls_handshake(pSession->ctx);
+                if(ret != VM_TLS_ERR_NONE && ret != VM_TLS_ERR_WOULDBLOCK)
+                {
+                    vm_log_info("vm_tls_handshake returns %d", ret);
+                    pConn->fail();
+                }
+            }
+            else if(pInd->event_type == VM_SOC_CONNECT || pInd->event_type == VM_SOC_CLOSE)
+            {
+                pConn->fail();
+            }
+        }
+        break;
+    case VM_MSG_ID_APP_TLS_NOTIFY_IND:
+        {
+            vm_tls_notify_ind_struct *pInd = (vm_tls_notify_ind_struct*)pEvent;
+            switch(pInd->event)
+            {
+            case VM_TLS_HANDSHAKE_READY:
+                // certificates loaded, vm_tls_new_conn() has completed
+                if(vm_tls_connect(pSession->ctx, &pSession->addr) < 0 &&
+                   vm_tls_handshake(pSession->ctx) < 0)
+                {
+                    pConn->fail();
+                }
+                break;
+            case VM_TLS_HANDSHAKE_DONE:
+                if(pInd->result)
+                {
+                    pSession->handshaked = true;
+                    pConn->m_status = LTLS_CONN_CONNECTED;
+                    vm_signal_post(s_tlsSignal);
+                }
+                else
+                {
+                    vm_log_info("TLS handshake failed %d", pInd->error);
+                    pConn->fail();
+                }
+                break;
+            case VM_TLS_READ:
+                pConn->m_readable = true;
+                pConn->fill();
+                if(s_rxSignal)
+                {
+                    vm_signal_post(s_rxSignal);
+                }
+                break;
+            case VM_TLS_WRITE:
+                pConn->drain();
+                break;
+            case VM_TLS_CLOSE:
+                pConn->fail();
+                break;
+            }
+        }
+        break;
+    case VM_MSG_ID_APP_TLS_ALERT_IND:
+        {
+            vm_tls_alert_ind_struct *pInd = (vm_tls_alert_ind_struct*)pEvent;
+            if(pInd->alert_level == VM_TLS_ALERT_LV_FATAL)
+            {
+                pConn->fail();
+            }
+        }
+        break;
+    }
+}
+
+struct LTlsConnectContext
+{
+    const char *host;               // name the certificate is checked against
+    uint16_t port;
+    VMINT apn;
+    IPAddress ip;
+    LTlsConnection *pConn;
+};
+
+boolean LTlsClient::connectHandler(void *userData)
+{
+    LTlsConnectContext *pContext = (LTlsConnectContext*)userData;
+    LTlsConnection *pConn = pContext->pConn;
+
+    if(!s_sessionsInit)
+    {
+        for(int i = 0; i < LTLS_SESSION_CACHE_SIZE; ++i)
+        {
+            s_sessions[i].ctx = -1;
+            s_sessions[i].pConn = NULL;
+        }
+        s_sessionsInit = true;
+    }
+
+    // an idle context for the same server, else a free slot,
+    // else the idle context unused for the longest time
+    LTlsSession *pSession = NULL;
+    LTlsSession *pFree = NULL;
+    LTlsSession *pOldest = NULL;
+    const boolean named = strlen(pContext->host) < LDNS_MAX_NAME;
+    for(int i = 0; i < LTLS_SESSION_CACHE_SIZE; ++i)
+    {
+        LTlsSession *p = &s_sessions[i];
+        if(p->ctx < 0)
+        {
+            if(pFree == NULL)
+            {
+                pFree = p;
+            }
+            continue;
+        }
+        if(p->pConn)
+        {
+            continue;
+        }
+        if(named && p->handshaked && p->port == pContext->port && p->apn == pContext->apn &&
+           strcmp(p->host, pContext->host) == 0)
+        {
+            pSession = p;
+            break;
+        }
+        if(pOldest == NULL || (long)(p->lastUsed - pOldest->lastUsed) < 0)
+        {
+            pOldest = p;
+        }
+    }
+
+    if(pSession)
+    {
+        vm_log_info("LTlsClient resume session of %s:%d", pContext->host, pContext->port);
+        pConn->m_reused = true;
+    }
+    else
+    {
+        if(pFree == NULL && pOldest)
+        {
+            deleteSession(pOldest);
+            pFree = pOldest;
+        }
+        if(pFree == NULL)
+        {
+            vm_log_info("LTlsClient all %d sessions in use", LTLS_SESSION_CACHE_SIZE);
+            pConn->m_status = LTLS_CONN_FAILED;
+            return true;
+        }
+
+        pSession = pFree;
+        pSession->ctx = vm_tls_new_ctx(VM_TLS_ALL_VERSIONS, VM_SOC_SOCK_STREAM, pContext->apn, VM_TLS_CLIENT_SIDE, &tlsCallback);
+        vm_log_info("vm_tls_new_ctx returns %d", pSession->ctx);
+        if(pSession->ctx < 0)
+        {
+            pSession->ctx = -1;
+            pConn->m_status = LTLS_CONN_FAILED;
+            return true;
+        }
+        strncpy(pSession->host, named ? pContext->host : "", LDNS_MAX_NAME);
+        pSession->port = pContext->port;
+        pSession->apn = pContext->apn;
+        pSession->handshaked = false;
+        vm_tls_check_peer_name(pSession->ctx, pContext->host);
+    }
+
+    pSession->pConn = pConn;
+    pSession->lastUsed = millis();
+    pConn->m_pSession = pSession;
+
+    memset(&pSession->addr, 0, sizeof(pSession->addr));
+    pSession->addr.sock_type = VM_SOC_SOCK_STREAM;
+    pSession->addr.addr_len = 4;
+    pSession->addr.port = pContext->port;
+    for(int i = 0; i < 4; ++i)
+    {
+        pSession->addr.addr[i] = pContext->ip[i];
+    }
+
+    VMINT ret = vm_tls_new_conn(pSession->ctx, &pSession->addr);
+    vm_log_info("vm_tls_new_conn returns %d", ret);
+    if(ret == VM_TLS_ERR_WAITING_CERT)
+    {
+        // VM_TLS_HANDSHAKE_READY follows
+        return true;
+    }
+    if(ret >= 0)
+    {
+        ret = vm_tls_connect(pSession->ctx, &pSession->addr);
+        vm_log_info("vm_tls_connect returns %d", ret);
+        if(ret == VM_TLS_ERR_NONE)
+        {
+            ret = vm_tls_handshake(pSession->ctx);
+        }
+    }
+    if(ret < 0 && ret != VM_TLS_ERR_WOULDBLOCK)
+    {
+        pConn->m_status = LTLS_CONN_FAILED;
+    }
+    return true;
+}
+
+boolean LTlsClient::closeHandler(void *userData)
+{
+    LTlsConnection *pConn = (LTlsConnection*)userData;
+    LTlsSession *pSession = pConn->m_pSession;
+    if(pSession == NULL)
+    {
+        return true;
+    }
+
+    pConn->drain();
+    const boolean reusable = pSession->handshaked && pConn->m_status == LTLS_CONN_CONNECTED;
+    if(reusable)
+    {
+        vm_tls_shutdown(pSession->ctx);
+    }
+    vm_tls_delete_conn(pSession->ctx);
+
+    pConn->m_pSession = NULL;
+    pSession->pConn = NULL;
+    pSession->lastUsed = millis();
+    if(!reusable || pSession->host[0] == '\0')
+    {
+        // a broken session must not be resumed
+        deleteSession(pSession);
+    }
+    return true;
+}
+
+boolean LTlsClient::clearHandler(void *userData)
+{
+    for(int i = 0; i < LTLS_SESSION_CACHE_SIZE; ++i)
+    {
+        if(s_sessions[i].ctx >= 0 && s_sessions[i].pConn == NULL)
+        {
+            deleteSession(&s_sessions[i]);
+        }
+    }
+    return true;
+}
+
+void LTlsClient::clearSessions()
+{
+    if(s_sessionsInit)
+    {
+        LTask.remoteCall(&clearHandler, NULL);
+    }
+}
+
+LTlsClient::LTlsClient():
+    m_pConn(NULL),
+    m_rxBufferSize(LTLS_RX_BUFFER_SIZE),
+    m_txBufferSize(LTLS_TX_BUFFER_SIZE),
+    m_connectTimeout(LTLS_CONNECT_TIMEOUT)
+{
+}
+
+LTlsClient::~LTlsClient()
+{
+    stop();
+}
+
+int LTlsClient::connect(IPAddress ip, uint16_t port)
+{
+    char ipAddr[16] = {0};
+    sprintf(ipAddr, "%d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
+    return connectTo(ipAddr, ip, port);
+}
+
+int LTlsClient::connect(const char *host, uint16_t port)
+{
+    vm_log_info("LTlsClient::connect to %s:%d", host, port);
+    IPAddress ip;
+    if(!LDnsCache.resolve(getAPN(), host, ip))
+    {
+        stop();
+        return 0;
+    }
+    return connectTo(host, ip, port);
+}
+
+int LTlsClient::connectTo(const char *host, const IPAddress &ip, uint16_t port)
+{
+    stop();
+
+    if(s_tlsSignal == 0)
+    {
+        s_tlsSignal = vm_signal_init();
+    }
+
+    m_pConn = new LTlsConnection(m_rxBufferSize, m_txBufferSize);
+
+    LTlsConnectContext context;
+    context.host = host;
+    context.port = port;
+    context.apn = getAPN();
+    context.ip = ip;
+    context.pConn = m_pConn;
+    LTask.remoteCall(&connectHandler, &context);
+
+    const unsigned long start = millis();
+    while(m_pConn->m_status == LTLS_CONN_CONNECTING)
+    {
+        // 0 waits without a deadline, as LTcpClient does
+        unsigned long wait = 1000;
+        if(m_connectTimeout)
+        {
+            const unsigned long elapsed = millis() - start;
+            if(elapsed >= m_connectTimeout)
+            {
+                vm_log_info("LTlsClient::connect timeout");
+                break;
+            }
+            if(m_connectTimeout - elapsed < wait)
+            {
+                wait = m_connectTimeout - elapsed;
+            }
+        }
+        vm_signal_timedwait(s_tlsSignal, wait * 1000);
+    }
+
+    if(m_pConn->m_status != LTLS_CONN_CONNECTED)
+    {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+boolean LTlsClient::flushTx()
+{
+    while(m_pConn && m_pConn->m_tx.available())
+    {
+        if(m_pConn->m_status != LTLS_CONN_CONNECTED)
+        {
+            return false;
+        }
+        LTask.remoteCall(&LTlsConnection::flushHandler, m_pConn);
+    }
+    return true;
+}
+
+size_t LTlsClient::write(uint8_t b)
+{
+    return write(&b, 1);
+}
+
+size_t LTlsClient::write(const uint8_t *buf, size_t size)
+{
+    if(!connected() || m_pConn->m_tx.capacity() == 0)
+    {
+        setWriteError();
+        return 0;
+    }
+
+    size_t written = 0;
+    while(written < size)
+    {
+        written += m_pConn->m_tx.write(buf + written, size - written);
+
+        if(m_pConn->m_tx.available() >= LTLS_TX_HIGH_WATER || written < size)
+        {
+            if(!flushTx())
+            {
+                setWriteError();
+                break;
+            }
+        }
+    }
+    return written;
+}
+
+LTlsConnection* LTlsClient::receive()
+{
+    if(m_pConn == NULL || m_pConn->m_status != LTLS_CONN_CONNECTED)
+    {
+        return m_pConn;
+    }
+
+    // send the pending request in the same hop as reading the response
+    LTaskBatch batch;
+    if(m_pConn->m_tx.available())
+    {
+        batch.add(&LTlsConnection::flushHandler, m_pConn);
+    }
+    if(m_pConn->m_rx.available() == 0 && m_pConn->m_readable)
+    {
+        batch.add(&LTlsConnection::fillHandler, m_pConn);
+    }
+    if(batch.count())
+    {
+        LTask.batch(batch);
+    }
+    return m_pConn;
+}
+
+int LTlsClient::available()
+{
+    LTlsConnection *pConn = receive();
+    if(pConn == NULL)
+    {
+        return 0;
+    }
+    return pConn->m_rx.available();
+}
+
+bool LTlsClient::waitAvailable(unsigned long timeout)
+{
+    if(s_rxSignal == 0)
+    {
+        s_rxSignal = vm_signal_init();
+    }
+
+    const unsigned long start = millis();
+    while(true)
+    {
+        // an event that arrives after this check leaves the signal set
+        LTlsConnection *pConn = receive();
+        if(pConn == NULL)
+        {
+            return false;
+        }
+        if(pConn->m_rx.available())
+        {
+            return true;
+        }
+        if(pConn->m_status != LTLS_CONN_CONNECTED)
+        {
+            return false;
+        }
+
+        const unsigned long elapsed = millis() - start;
+        if(elapsed >= timeout)
+        {
+            return false;
+        }
+        // in slices, so the wait in microseconds cannot overflow
+        const unsigned long wait = timeout - elapsed;
+        vm_signal_timedwait(s_rxSignal, (wait < 1000 ? wait : 1000) * 1000);
+    }
+}
+
+int LTlsClient::read()
+{
+    LTlsConnection *pConn = receive();
+    if(pConn == NULL)
+    {
+        return -1;
+    }
+    return pConn->m_rx.read();
+}
+
+int LTlsClient::read(uint8_t *buf, size_t size)
+{
+    LTlsConnection *pConn = receive();
+    if(pConn == NULL)
+    {
+        return 0;
+    }
+
+    size_t done = pConn->m_rx.read(buf, size);
+    if(done < size && done > 0)
+    {
+        // the buffer may have been full, fetch the rest
+        pConn = receive();
+        done += pConn->m_rx.read(buf + done, size - done);
+    }
+    return done;
+}
+
+int LTlsClient::peek()
+{
+    LTlsConnection *pConn = receive();
+    if(pConn == NULL)
+    {
+        return -1;
+    }
+    return pConn->m_rx.peek();
+}
+
+void LTlsClient::flush()
+{
+    flushTx();
+}
+
+void LTlsClient::stop()
+{
+    if(m_pConn == NULL)
+    {
+        return;
+    }
+
+    // sends what is still buffered, then closes and keeps the session
+    LTaskBatch batch;
+    if(m_pConn->m_status == LTLS_CONN_CONNECTED && m_pConn->m_tx.available())
+    {
+        batch.add(&LTlsConnection::flushHandler, m_pConn);
+    }
+    batch.add(&closeHandler, m_pConn);
+    LTask.batch(batch);
+    delete m_pConn;
+    m_pConn = NULL;
+}
+
+uint8_t LTlsClient::connected()
+{
+    if(m_pConn == NULL)
+    {
+        return false;
+    }
+    return m_pConn->m_status == LTLS_CONN_CONNECTED ||
+           (m_pConn->m_status == LTLS_CONN_CLOSED && m_pConn->m_rx.available());
+}
+
+LTlsClient::operator bool()
+{
+    return connected();
+}
+
+boolean LTlsClient::reusedContext()
+{
+    return connected() && m_pConn->m_reused;
+}
+
+void LTlsClient::setConnectTimeout(unsigned long timeoutMs)
+{
+    m_connectTimeout = timeoutMs;
+}
+
+void LTlsClient::setBufferSizes(size_t rxSize, size_t txSize)
+{
+    m_rxBufferSize = rxSize;
+    m_txBufferSize = txSize;
+}
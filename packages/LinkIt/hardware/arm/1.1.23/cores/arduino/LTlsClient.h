@@ -0,0 +1,318 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+   See the GNU Lesser General Public License for more details.
+*/
+#ifndef LTlsClient_h
+#define LTlsClient_h
+#include "Arduino.h"
+#include "Print.h"
+#include "Client.h"
+#include "IPAddress.h"
+#include "LRingBuffer.h"
+
+// default size of the receive buffer of each TLS connection, in bytes
+#ifndef LTLS_RX_BUFFER_SIZE
+#define LTLS_RX_BUFFER_SIZE 1024
+#endif
+
+// default size of the transmit buffer of each TLS connection, in bytes
+#ifndef LTLS_TX_BUFFER_SIZE
+#define LTLS_TX_BUFFER_SIZE 1024
+#endif
+
+// write() sends the transmit buffer once it holds this many bytes
+#ifndef LTLS_TX_HIGH_WATER
+#define LTLS_TX_HIGH_WATER (LTLS_TX_BUFFER_SIZE * 3 / 4)
+#endif
+
+// default time connect() waits for the TCP and TLS handshakes, in milliseconds
+#ifndef LTLS_CONNECT_TIMEOUT
+#define LTLS_CONNECT_TIMEOUT 30000
+#endif
+
+// number of servers whose TLS session is kept for resumption.
+// This also limits the number of TLS connections open at the same time.
+#ifndef LTLS_SESSION_CACHE_SIZE
+#define LTLS_SESSION_CACHE_SIZE 4
+#endif
+
+/* DOM-NOT_FOR_SDK-BEGIN */
+// state of a LTlsConnection
+enum LTlsConnectionStatus
+{
+    LTLS_CONN_CONNECTING,   // TCP connect or TLS handshake in progress
+    LTLS_CONN_CONNECTED,
+    LTLS_CONN_CLOSED,       // closed by peer or broken, unread data may remain
+    LTLS_CONN_FAILED        // connect or handshake failed
+};
+
+struct LTlsSession;
+
+// State of one TLS connection. Like LTcpConnection, the MMI thread fills m_rx
+// and drains m_tx as the TLS events arrive.
+class LTlsConnection
+{
+public:
+    LTlsConnection(size_t rxSize, size_t txSize);
+
+    // all of these run on the MMI thread
+    void fill();
+    void drain();
+    void fail();
+    static boolean fillHandler(void *userData);
+    static boolean flushHandler(void *userData);
+
+    LTlsSession *m_pSession;        // NULL once closed
+    volatile VMINT m_status;        // LTlsConnectionStatus
+    volatile boolean m_readable;    // the connection may hold data that is not in m_rx yet
+    boolean m_txWaiting;            // flushHandler() waits for VM_TLS_WRITE
+    boolean m_reused;               // opened on a cached context
+    LRingBuffer m_rx;
+    LRingBuffer m_tx;
+};
+/* DOM-NOT_FOR_SDK-END */
+
+//LTlsClient Class
+//
+// LTlsClient is the base implementation of LWiFiTlsClient and LGPRSTlsClient,
+// TLS (SSL) clients that work like LWiFiClient and LGPRSClient.
+// The TLS context of the last LTLS_SESSION_CACHE_SIZE servers is kept, so
+// connecting to one of them again reuses it and the platform can resume the
+// session held in it instead of repeating the full handshake.
+// 
+// EXAMPLE:
+// <code>
+//     LGPRS.attachGPRS();
+//     LGPRSTlsClient c;
+//     c.connect("www.website.com", 443);
+// </code>
+class LTlsClient : public Client {
+
+public:
+  // DESCRIPTION
+  //   Constructs a LTlsClient object which can be used to connect to a remote TLS server.
+  // 
+  // PARAMETERS
+  //    N/A
+  LTlsClient();
+
+  /* DOM-NOT_FOR_SDK-BEGIN */
+  ~LTlsClient();
+  /* DOM-NOT_FOR_SDK-END */
+
+  // DESCRIPTION
+  //   Connects to a TLS server. The server certificate must be issued for the address given.
+  // 
+  // PARAMETERS
+  //   ip: IPAddress object, e.g. IPAddress server (172, 21, 84, 11), that denotes server address
+  //   port: TCP port to be connected
+  // 
+  // RETURNS
+  //   1 if connected, 0 otherwise.
+  virtual int connect(IPAddress ip, uint16_t port);
+
+  // DESCRIPTION
+  //   Connects to a TLS server and checks that its certificate is issued for host.
+  // 
+  // PARAMETERS
+  //   host: server name, e.g. "www.somewebsite.com"
+  //   port: TCP port to be connected
+  // 
+  // RETURNS
+  //   1 if connected, 0 otherwise.
+  //
+  // EXAMPLE
+  // <code>
+  //     client.connect("www.somewebsite.com", 443);  // client is an instance of LWiFiTlsClient or LGPRSTlsClient.
+  // </code>
+  virtual int connect(const char *host, uint16_t port);
+
+  // DESCRIPTION
+  //   Writes data to the server. The data is buffered, see flush().
+  // 
+  // PARAMETERS
+  //   byte: Single byte to be sent
+  // 
+  // RETURNS
+  //   Total written bytes.
+  virtual size_t write(uint8_t);
+
+  // DESCRIPTION
+  //   Writes data to the server. The data is buffered, see flush().
+  // 
+  // PARAMETERS
+  //   byteArray: byteArray to be sent
+  //   size: Size of byteArray, in bytes
+  // 
+  // RETURNS
+  //   Total written bytes.
+  virtual size_t write(const uint8_t *buf, size_t size);
+
+  // DESCRIPTION
+  //   Returns the number of bytes available for read.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   Size of the data available for read, in bytes
+  virtual int available();
+
+  // DESCRIPTION
+  //   Waits until data sent by the server is available to read.
+  //   The Arduino thread sleeps until the connection reports new data,
+  //   closes, or the timeout expires.
+  // 
+  // PARAMETERS
+  //   timeout: Longest wait in milliseconds
+  // 
+  // RETURNS
+  //   true: Data is available
+  //   false: Timed out, or the connection is closed and all data has been read
+  virtual bool waitAvailable(unsigned long timeout);
+
+  // DESCRIPTION
+  //   Reads one byte sent by the server.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   The data byte value. -1 is returned if there is no data available.
+  virtual int read();
+
+  // DESCRIPTION
+  //   Reads data sent by the server into a buffer.
+  // 
+  // PARAMETERS
+  //   buf: uint8_t buffer to store the incoming data
+  //   size: Buffer size in bytes
+  // 
+  // RETURNS
+  //   Total bytes read, 0 if there is no data.
+  virtual int read(uint8_t *buf, size_t size);
+
+  // DESCRIPTION
+  //   Returns the first unread byte without removing it.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   The first unread byte, -1 if there is none
+  virtual int peek();
+
+  // DESCRIPTION
+  //   Sends all data written so far and waits until the connection has taken it.
+  //   write() keeps data in a transmit buffer until it is LTLS_TX_HIGH_WATER full,
+  //   flush() is called, or the client reads, checks available() or stops.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   N/A
+  virtual void flush();
+
+  // DESCRIPTION
+  //   Closes the connection. The TLS session is kept for the next connect() to the same server.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   N/A
+  virtual void stop();
+
+  // DESCRIPTION
+  //   Queries if this client is connected. A connection closed by the server
+  //   counts as connected until its received data has been read.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   1: connected, 0: not connected
+  virtual uint8_t connected();
+
+  // DESCRIPTION
+  //   An LWiFiTlsClient or LGPRSTlsClient object evaluates to true if it is connected.
+  virtual operator bool();
+
+  // DESCRIPTION
+  //   Queries if the last connect() reused the cached TLS context of the server,
+  //   which holds the session of an earlier connection. The platform does not
+  //   report whether the handshake then resumed that session or was a full one.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   true if a cached context was reused, false if a new one was created or if not connected.
+  boolean reusedContext();
+
+  // DESCRIPTION
+  //   Sets how long connect() waits. The default is LTLS_CONNECT_TIMEOUT milliseconds.
+  // 
+  // PARAMETERS
+  //   timeoutMs: timeout in milliseconds, 0 to wait forever
+  // 
+  // RETURNS
+  //   N/A
+  void setConnectTimeout(unsigned long timeoutMs);
+
+  // DESCRIPTION
+  //   Sets the size of the receive and transmit buffers used by the next connect().
+  // 
+  // PARAMETERS
+  //   rxSize: receive buffer size in bytes
+  //   txSize: transmit buffer size in bytes
+  // 
+  // RETURNS
+  //   N/A
+  void setBufferSizes(size_t rxSize, size_t txSize);
+
+  // DESCRIPTION
+  //   Forgets all cached TLS sessions, e.g. after the bearer changed.
+  //   Open connections keep working.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   N/A
+  static void clearSessions();
+
+protected:
+  /* DOM-NOT_FOR_SDK-BEGIN */
+  LTlsConnection *m_pConn;
+  size_t m_rxBufferSize;
+  size_t m_txBufferSize;
+  unsigned long m_connectTimeout;
+
+  int connectTo(const char *host, const IPAddress &ip, uint16_t port);
+  boolean flushTx();
+  LTlsConnection* receive();
+
+  static boolean connectHandler(void *userData);
+  static boolean closeHandler(void *userData);
+  static boolean clearHandler(void *userData);
+
+  virtual VMINT getAPN() const = 0;
+
+private:
+  LTlsClient(const LTlsClient&);
+  LTlsClient& operator=(const LTlsClient&);
+  /* DOM-NOT_FOR_SDK-END */
+};
+
+#endif  // LTlsClient_h
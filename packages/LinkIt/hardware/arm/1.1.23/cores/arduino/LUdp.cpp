@@ -19,16 +19,41 @@
 #include "vmsim.h"
 #include "vmudp.h"
 #include "LUdp.h"
+#include "LBarrier.h"
+
+// open sockets, so udpCallback() can find the instance of a handle.
+// Only the MMI thread walks and changes the list.
+LUDP *LUDP::s_udpList = NULL;
 
 LUDP::LUDP():
 	m_port(-1),
-	m_sendToPort(-1),
 	m_serverHandle(-1),
 	m_sendToIP(INADDR_NONE),
+	m_sendToPort(-1),
+	m_writePos(0),
+	m_txPackets(NULL),
+	m_txArena(NULL),
+	m_txSlots(LUDP_TX_QUEUE_SLOTS),
+	m_txArenaSize(LUDP_TX_ARENA_SIZE),
+	m_txAllocSlots(0),
+	m_txAllocArenaSize(0),
+	m_txCount(0),
+	m_txStart(0),
+	m_txOpen(false),
 	m_recvIP(INADDR_NONE),
 	m_recvPort(-1),
-	m_writePos(0),
-	m_recvPos(0)
+	m_recvPos(0),
+	m_rxPackets(NULL),
+	m_rxData(NULL),
+	m_rxSlots(LUDP_RX_QUEUE_SLOTS),
+	m_rxMaxPacket(LUDP_RX_MAX_PACKET),
+	m_rxAllocSlots(0),
+	m_rxAllocMaxPacket(0),
+	m_rxHead(0),
+	m_rxTail(0),
+	m_rxStalled(false),
+	m_recvCurrent(false),
+	m_nextUdp(NULL)
 {
 
 }
@@ -36,6 +61,121 @@ LUDP::LUDP():
 LUDP::~LUDP()
 {
 	stop();
+	freeReceiveQueue();
+	freeSendQueue();
+}
+
+void LUDP::setReceiveQueue(int slots, int maxPacketSize)
+{
+	m_rxSlots = slots > 0 ? slots : 1;
+	m_rxMaxPacket = maxPacketSize > 0 ? maxPacketSize : 1;
+}
+
+boolean LUDP::allocReceiveQueue()
+{
+	if(m_rxPackets && m_rxAllocSlots == m_rxSlots && m_rxAllocMaxPacket == m_rxMaxPacket)
+	{
+		return true;
+	}
+
+	freeReceiveQueue();
+	m_rxPackets = (LUDPPacket*)malloc(sizeof(LUDPPacket) * (m_rxSlots + 1));
+	m_rxData = (VMUINT8*)malloc(m_rxMaxPacket * (m_rxSlots + 1));
+	if(m_rxPackets == NULL || m_rxData == NULL)
+	{
+		vm_log_error("LUDP receive queue allocation failed");
+		freeReceiveQueue();
+		return false;
+	}
+	m_rxAllocSlots = m_rxSlots;
+	m_rxAllocMaxPacket = m_rxMaxPacket;
+	return true;
+}
+
+void LUDP::freeReceiveQueue()
+{
+	free(m_rxPackets);
+	free(m_rxData);
+	m_rxPackets = NULL;
+	m_rxData = NULL;
+	m_rxAllocSlots = 0;
+	m_rxAllocMaxPacket = 0;
+}
+
+void LUDP::setSendQueue(int slots, int arenaSize)
+{
+	m_txSlots = slots > 0 ? slots : 1;
+	m_txArenaSize = arenaSize > 0 ? arenaSize : 1;
+}
+
+boolean LUDP::allocSendQueue()
+{
+	if(m_txPackets && (m_txCount || (m_txAllocSlots == m_txSlots && m_txAllocArenaSize == m_txArenaSize)))
+	{
+		// queued datagrams keep the current arena
+		return true;
+	}
+
+	freeSendQueue();
+	m_txPackets = (LUDPPacket*)malloc(sizeof(LUDPPacket) * m_txSlots);
+	m_txArena = (VMUINT8*)malloc(m_txArenaSize);
+	if(m_txPackets == NULL || m_txArena == NULL)
+	{
+		vm_log_error("LUDP send arena allocation failed");
+		freeSendQueue();
+		return false;
+	}
+	m_txAllocSlots = m_txSlots;
+	m_txAllocArenaSize = m_txArenaSize;
+	return true;
+}
+
+void LUDP::freeSendQueue()
+{
+	free(m_txPackets);
+	free(m_txArena);
+	m_txPackets = NULL;
+	m_txArena = NULL;
+	m_txAllocSlots = 0;
+	m_txAllocArenaSize = 0;
+	m_txCount = 0;
+	m_txStart = 0;
+	m_writePos = 0;
+	m_txOpen = false;
+}
+
+void LUDP::drainPackets()
+{
+	m_rxStalled = false;
+	while(true)
+	{
+		const int head = m_rxHead;
+		const int next = (head + 1) % (m_rxAllocSlots + 1);
+		if(next == m_rxTail)
+		{
+			// the rest waits in the platform buffer until parsePacket() makes room
+			m_rxStalled = true;
+			break;
+		}
+
+		vm_sockaddr_struct recvfrom = {0};
+		const VMINT receivedSize = vm_udp_recvfrom(m_serverHandle,
+												   m_rxData + head * m_rxAllocMaxPacket,
+												   m_rxAllocMaxPacket,
+												   &recvfrom);
+		if(receivedSize < 0 || (receivedSize == 0 && recvfrom.port == 0))
+		{
+			// nothing more to read; an empty datagram still has a sender
+			break;
+		}
+
+		LUDPPacket &packet = m_rxPackets[head];
+		memcpy(packet.ip, recvfrom.addr, 4);
+		packet.port = recvfrom.port;
+		packet.len = receivedSize;
+		LBARRIER();
+		m_rxHead = next;
+	}
 }
 
 void LUDP::udpCallback(VMINT hdl, VMINT event)
@@ -45,6 +185,14 @@ void LUDP::udpCallback(VMINT hdl, VMINT event)
 	case VM_UDP_EVT_WRITE:
 		break;
 	case VM_UDP_EVT_READ:
+		for(LUDP *pUdp = s_udpList; pUdp; pUdp = pUdp->m_nextUdp)
+		{
+			if(pUdp->m_serverHandle == hdl)
+			{
+				pUdp->drainPackets();
+				break;
+			}
+		}
 		break;
 	case VM_UDP_EVT_PIPE_BROKEN:
 	case VM_UDP_EVT_PIPE_CLOSED:
@@ -71,6 +219,11 @@ boolean LUDP::udpBegin(void* userdata)
 	}
 	else
 	{
+		pThis->m_rxHead = 0;
+		pThis->m_rxTail = 0;
+		pThis->m_rxStalled = false;
+		pThis->m_nextUdp = s_udpList;
+		s_udpList = pThis;
 		// no need to wait for VM_UDP_EVT_WRITE???
 		return true;
 	}
@@ -78,8 +231,28 @@ boolean LUDP::udpBegin(void* userdata)
 
 uint8_t LUDP::begin(uint16_t port)
 {
+	LTaskBatch batch;
+
+	// a different queue size cannot be swapped under an open socket
+	if(m_rxPackets && (m_rxAllocSlots != m_rxSlots || m_rxAllocMaxPacket != m_rxMaxPacket))
+	{
+		stop();
+	}
+	if(!allocReceiveQueue())
+	{
+		return 0;
+	}
+	flush();
+
+	// re-opening: close the current socket in the same hop
+	if(m_serverHandle != -1)
+	{
+		batch.add(&udpStop, this);
+	}
+
 	m_port = port;
-	LTask.remoteCall(&udpBegin, this);
+	batch.add(&udpBegin, this);
+	LTask.batch(batch);
 
 	if(m_serverHandle == -1)
 	{
@@ -95,6 +268,14 @@ uint8_t LUDP::begin(uint16_t port)
 boolean LUDP::udpStop(void* userdata)
 {
 	LUDP* pThis = (LUDP*)userdata;
+	for(LUDP **ppUdp = &s_udpList; *ppUdp; ppUdp = &(*ppUdp)->m_nextUdp)
+	{
+		if(*ppUdp == pThis)
+		{
+			*ppUdp = pThis->m_nextUdp;
+			break;
+		}
+	}
 	vm_udp_close(pThis->m_serverHandle);
 	pThis->m_serverHandle = -1;
 	return true;
@@ -106,16 +287,23 @@ void LUDP::stop()
 		return;
 
 	LTask.remoteCall(&udpStop, this);
+	flush();
 	return;
 }
 
 int LUDP::beginPacket(IPAddress ip, uint16_t port)
 {
+	if(!allocSendQueue() || m_txCount == m_txAllocSlots)
+	{
+		return 0;
+	}
+
 	m_sendToPort = port;
 	m_sendToIP = ip;
 
-	m_writeBuffer.resize(INIT_WRITE_BUFFER_SIZE);
+	// a datagram begun again replaces the unfinished one
 	m_writePos = 0;
+	m_txOpen = true;
 
 	vm_log_info("beginPacket(IP)");
 	return 1;
@@ -124,142 +312,191 @@ int LUDP::beginPacket(IPAddress ip, uint16_t port)
 struct LUDPSendContext
 {
 	LUDP *pThis;
-	VMINT sentComplete;
+	int *results;
+	int maxResults;
+	int sentCount;			// datagrams sent completely
+	VMINT sentComplete;		// result of the last datagram
 };
 
 boolean LUDP::udpSend(void* userdata)
 {
 	LUDPSendContext *pCntx = (LUDPSendContext*)userdata;
 	LUDP* pThis = pCntx->pThis;
-	VMINT remainBuffer = pThis->m_writePos;
-	VMUINT8 *pBuf = &pThis->m_writeBuffer[0];
-
-	vm_sockaddr_struct sendto = {0};
-	sendto.addr[0] = pThis->m_sendToIP[0];
-	sendto.addr[1] = pThis->m_sendToIP[1];
-	sendto.addr[2] = pThis->m_sendToIP[2];
-	sendto.addr[3] = pThis->m_sendToIP[3];
-	sendto.addr_len = 4;
-	sendto.port = pThis->m_sendToPort;
-
-	vm_log_info("send packet len:%d to %d.%d.%d.%d:%d",
-				remainBuffer,
-				sendto.addr[0],
-				sendto.addr[1],
-				sendto.addr[2],
-				sendto.addr[3],
-				sendto.port);
-
-	while(remainBuffer > 0)
-	{
-		VMINT sentBytes = 0;
-		sentBytes = vm_udp_sendto(pThis->m_serverHandle,
-								  pBuf,
-								  remainBuffer,
-								  &sendto);
-		
-		vm_log_info("vm_udp_sendto returns %d", sentBytes);
-
-
-		if(sentBytes <= 0)
-		{
-			vm_log_error("vm_udp_sendto sent no content");
-			break;
-		}	
+	VMUINT8 *pBuf = pThis->m_txArena;
 
-		pBuf += sentBytes;
-		remainBuffer -= sentBytes;
+	for(int i = 0; i < pThis->m_txCount; ++i)
+	{
+		const LUDPPacket &packet = pThis->m_txPackets[i];
+		VMINT remainBuffer = packet.len;
+
+		vm_sockaddr_struct sendto = {0};
+		memcpy(sendto.addr, packet.ip, 4);
+		sendto.addr_len = 4;
+		sendto.port = packet.port;
+
+		vm_log_info("send packet len:%d to %d.%d.%d.%d:%d",
+					remainBuffer,
+					sendto.addr[0],
+					sendto.addr[1],
+					sendto.addr[2],
+					sendto.addr[3],
+					sendto.port);
+
+		VMUINT8 *pData = pBuf;
+		while(remainBuffer > 0)
+		{
+			VMINT sentBytes = 0;
+			sentBytes = vm_udp_sendto(pThis->m_serverHandle,
+									  pData,
+									  remainBuffer,
+									  &sendto);
+			
+			vm_log_info("vm_udp_sendto returns %d", sentBytes);
+
+
+			if(sentBytes <= 0)
+			{
+				vm_log_error("vm_udp_sendto sent no content");
+				break;
+			}	
+
+			pData += sentBytes;
+			remainBuffer -= sentBytes;
+		}
+
+		// check if buffer is completely sent
+		pCntx->sentComplete = (remainBuffer <= 0) ? 1 : 0;
+		pCntx->sentCount += pCntx->sentComplete;
+		if(pCntx->results && i < pCntx->maxResults)
+		{
+			pCntx->results[i] = pCntx->sentComplete;
+		}
+		pBuf += packet.len;
 	}
 
-	// check if buffer is completely sent
-	if(remainBuffer <= 0)
+	return true;
+}
+
+int LUDP::queuePacket()
+{
+	if(!m_txOpen)
 	{
-		pCntx->sentComplete = 1;
+		return 0;
 	}
-	else
+
+	LUDPPacket &packet = m_txPackets[m_txCount];
+	packet.ip[0] = m_sendToIP[0];
+	packet.ip[1] = m_sendToIP[1];
+	packet.ip[2] = m_sendToIP[2];
+	packet.ip[3] = m_sendToIP[3];
+	packet.port = m_sendToPort;
+	packet.len = m_writePos;
+	m_txCount++;
+	m_txStart += m_writePos;
+	m_writePos = 0;
+	m_txOpen = false;
+
+	// reset socket address
+	m_sendToIP = INADDR_NONE;
+	m_sendToPort = -1;
+	return 1;
+}
+
+int LUDP::sendQueued(int results[], int maxResults)
+{
+	LUDPSendContext cntx;
+	cntx.pThis = this;
+	cntx.results = results;
+	cntx.maxResults = maxResults;
+	cntx.sentCount = 0;
+	cntx.sentComplete = 0;
+	if(m_txCount)
 	{
-		pCntx->sentComplete = 0;
+		LTask.remoteCall(&udpSend, &cntx);
 	}
 
-	return true;
+	// the arena is reused as is, nothing to free. A datagram begun but not
+	// yet queued moves to the front and stays open.
+	if(m_txOpen && m_txStart)
+	{
+		memmove(m_txArena, m_txArena + m_txStart, m_writePos);
+	}
+	m_txCount = 0;
+	m_txStart = 0;
+	return cntx.sentCount;
 }
 
 int LUDP::endPacket()
 {
 	vm_log_info("endPacket");
+	if(!queuePacket())
+	{
+		return 0;
+	}
+
 	LUDPSendContext cntx;
 	cntx.pThis = this;
+	cntx.results = NULL;
+	cntx.maxResults = 0;
+	cntx.sentCount = 0;
 	cntx.sentComplete = 0;
 	LTask.remoteCall(&udpSend, &cntx);
-	
-	// release buffer
-	m_writePos = 0;
-	m_writeBuffer.clear();
-	
-	// reset socket address
-	m_sendToIP = INADDR_NONE;
-	m_sendToPort = -1;
+	m_txCount = 0;
+	m_txStart = 0;
 	return cntx.sentComplete;
 }
 
-size_t LUDP::LUDP::write(uint8_t byte)
+size_t LUDP::write(uint8_t byte)
 {
-	if(m_writePos >= m_writeBuffer.size())
-	{
-		m_writeBuffer.resize(m_writeBuffer.size() + INIT_WRITE_BUFFER_SIZE);
-	}
-	m_writeBuffer[m_writePos] = byte;
-	m_writePos++;
-
-	return 1;
+	return write(&byte, 1);
 }
 
 size_t LUDP::write(const uint8_t *buffer, size_t size)
 {
-	if((m_writePos + size) >= m_writeBuffer.size())
+	if(!m_txOpen)
 	{
-		m_writeBuffer.resize(m_writeBuffer.size() + size);
+		return 0;
 	}
 
-	for(size_t i = 0; i < size; ++i)
+	// the datagram is truncated at the end of the arena
+	const size_t room = m_txAllocArenaSize - m_txStart - m_writePos;
+	if(size > room)
 	{
-		m_writeBuffer[m_writePos] = buffer[i];
-		m_writePos++;
+		setWriteError();
+		size = room;
 	}
 
+	memcpy(m_txArena + m_txStart + m_writePos, buffer, size);
+	m_writePos += size;
 	return size;
 }
 
+size_t LUDP::writev(const LIoVec *iov, int count)
+{
+	// vm_udp_sendto() takes a single buffer, so the segments
+	// are gathered in the arena.
+	size_t total = 0;
+	for(int i = 0; i < count; ++i)
+	{
+		total += write(iov[i].buf, iov[i].len);
+	}
+	return total;
+}
+
 boolean LUDP::udpRecv(void* userdata)
 {
 	LUDP *pThis = (LUDP*)userdata;
-	vm_sockaddr_struct recvfrom = {0};
-
-	// allocate buffer for receiving
-	pThis->m_recvBuffer.resize(INIT_RECV_BUFFER_SIZE);
-	const VMINT receivedSize = vm_udp_recvfrom(pThis->m_serverHandle,
-											   &pThis->m_recvBuffer[0],
-											   pThis->m_recvBuffer.size(),
-											   &recvfrom);
-
-	if(receivedSize > 0)
-	{
-		// content retrieved
-		pThis->m_recvBuffer.resize(receivedSize);
-		pThis->m_recvIP = IPAddress(recvfrom.addr[0],
-					    			recvfrom.addr[1],
-					    			recvfrom.addr[2],
-					    			recvfrom.addr[3]);
-		pThis->m_recvPort = recvfrom.port;
-		pThis->m_recvPos = 0;
-	}
-	else
+	pThis->drainPackets();
+	return true;
+}
+
+void LUDP::releasePacket()
+{
+	if(m_recvCurrent)
 	{
-		// nothing to read
-		pThis->m_recvBuffer.clear();
+		m_recvCurrent = false;
+		m_rxTail = (m_rxTail + 1) % (m_rxAllocSlots + 1);
 	}
-	
-	return true;
 }
 
 int LUDP::parsePacket()
@@ -276,15 +513,33 @@ int LUDP::parsePacket()
 		return remainBytes;
 	}
 
-	// is incoming packet ready?
 	flush();
-	LTask.remoteCall(&udpRecv, this);
+
+	// datagrams left in the platform buffer get no new VM_UDP_EVT_READ
+	if(m_rxStalled)
+	{
+		LTask.remoteCall(&udpRecv, this);
+	}
+
+	// is incoming packet ready?
+	const int tail = m_rxTail;
+	if(tail == m_rxHead)
+	{
+		return 0;
+	}
+
+	LBARRIER();
+	const LUDPPacket &packet = m_rxPackets[tail];
+	m_recvCurrent = true;
+	m_recvIP = IPAddress(packet.ip[0], packet.ip[1], packet.ip[2], packet.ip[3]);
+	m_recvPort = packet.port;
+	m_recvPos = 0;
 	return available();
 }
 
 void LUDP::flush()
 {
-	m_recvBuffer.clear();
+	releasePacket();
 	m_recvPos = 0;
 	m_recvIP = INADDR_NONE;
 	m_recvPort = -1;
@@ -292,13 +547,10 @@ void LUDP::flush()
 
 int LUDP::available()
 {
-	if(m_recvIP == INADDR_NONE)
+	if(!m_recvCurrent)
 		return 0;
 
-	if(m_recvBuffer.size() == 0)
-		return 0;
-
-	const int remainBytes = m_recvBuffer.size() - m_recvPos;
+	const int remainBytes = m_rxPackets[m_rxTail].len - m_recvPos;
 
 	if(remainBytes > 0)
 	{
@@ -317,7 +569,7 @@ int LUDP::read()
 		return -1;
 	}
 
-	VMUINT8 byte = m_recvBuffer[m_recvPos];
+	VMUINT8 byte = m_rxData[m_rxTail * m_rxAllocMaxPacket + m_recvPos];
 	m_recvPos++;
 
 	return (int)byte;
@@ -330,9 +582,37 @@ int LUDP::read(unsigned char* buffer, size_t len)
 		return -1;
 	}
 
-	const size_t readLen = std::min(m_recvBuffer.size() - m_recvPos, len);
+	size_t readLen = available();
+	if(readLen > len)
+	{
+		readLen = len;
+	}
+
+	memcpy(buffer, m_rxData + m_rxTail * m_rxAllocMaxPacket + m_recvPos, readLen);
+	m_recvPos += readLen;
+
+	return readLen;
+}
+
+int LUDP::readAvailableUntil(uint8_t terminator, uint8_t *buffer, size_t len)
+{
+	size_t readLen = available();
+	if(readLen > len)
+	{
+		readLen = len;
+	}
+	if(readLen == 0)
+	{
+		return 0;
+	}
 
-	memcpy(buffer, &m_recvBuffer[m_recvPos], readLen);
+	const VMUINT8 *src = m_rxData + m_rxTail * m_rxAllocMaxPacket + m_recvPos;
+	const VMUINT8 *found = (const VMUINT8*)memchr(src, terminator, readLen);
+	if(found)
+	{
+		readLen = found - src + 1;
+	}
+	memcpy(buffer, src, readLen);
 	m_recvPos += readLen;
 
 	return readLen;
@@ -345,6 +625,6 @@ int LUDP::peek()
 		return -1;
 	}
 
-	VMUINT8 byte = m_recvBuffer[m_recvPos];
+	VMUINT8 byte = m_rxData[m_rxTail * m_rxAllocMaxPacket + m_recvPos];
 	return (int)byte;
 }
@@ -15,10 +15,40 @@
 #define ludp_h
 
 #include <Udp.h>
-#include <vector>
 
 #define UDP_TX_PACKET_MAX_SIZE 24
 
+// default number of received datagrams queued per socket, see LUDP::setReceiveQueue()
+#ifndef LUDP_RX_QUEUE_SLOTS
+#define LUDP_RX_QUEUE_SLOTS 4
+#endif
+
+// default largest datagram kept by the receive queue, longer ones are truncated
+#ifndef LUDP_RX_MAX_PACKET
+#define LUDP_RX_MAX_PACKET 1024
+#endif
+
+// default number of datagrams queuePacket() can hold, see LUDP::setSendQueue()
+#ifndef LUDP_TX_QUEUE_SLOTS
+#define LUDP_TX_QUEUE_SLOTS 8
+#endif
+
+// default size of the buffer datagrams are assembled in, shared by all queued datagrams
+#ifndef LUDP_TX_ARENA_SIZE
+#define LUDP_TX_ARENA_SIZE 2048
+#endif
+
+/* DOM-NOT_FOR_SDK-BEGIN */
+// a queued datagram. Received ones are in slot i of the queue's data block,
+// outgoing ones follow each other in the send arena.
+struct LUDPPacket
+{
+  VMUINT8 ip[4];
+  uint16_t port;
+  uint16_t len;
+};
+/* DOM-NOT_FOR_SDK-END */
+
 //LUDP Class
 //
 // LUDP is the base implementation of LWiFiUDP and LGPRSUDP. 
@@ -48,16 +78,38 @@ protected:
 
   IPAddress m_sendToIP; // remote IP address for outgoing packet whilst it's being processed
   uint16_t m_sendToPort; // remote port for the outgoing packet whilst it's being processed
-  std::vector<VMUINT8> m_writeBuffer;
-  VMINT m_writePos;
+  VMINT m_writePos;            // bytes in the datagram being assembled
+
+  // outgoing datagrams, back to back in m_txArena: the queued ones,
+  // then the one being assembled
+  LUDPPacket *m_txPackets;     // m_txSlots entries
+  VMUINT8 *m_txArena;
+  int m_txSlots;
+  int m_txArenaSize;
+  int m_txAllocSlots;          // sizes of the allocated arena
+  int m_txAllocArenaSize;
+  int m_txCount;               // queued datagrams
+  int m_txStart;               // arena offset of the datagram being assembled
+  boolean m_txOpen;            // beginPacket() was called
 
   IPAddress m_recvIP; // remote IP address for outgoing packet whilst it's being processed
   uint16_t m_recvPort; // remote port for the outgoing packet whilst it's being processed
-  std::vector<VMUINT8> m_recvBuffer;
   VMINT m_recvPos;
 
-  static const VMINT INIT_WRITE_BUFFER_SIZE = 32;
-  static const VMINT INIT_RECV_BUFFER_SIZE = 1024;  // typical MTU of web is 512 bytes, 1KB buffer should be sufficient
+  // received datagrams, filled by the MMI thread on VM_UDP_EVT_READ
+  LUDPPacket *m_rxPackets;     // m_rxSlots + 1 entries, one always free
+  VMUINT8 *m_rxData;           // m_rxMaxPacket bytes per entry
+  int m_rxSlots;
+  int m_rxMaxPacket;
+  int m_rxAllocSlots;          // sizes of the allocated queue
+  int m_rxAllocMaxPacket;
+  volatile int m_rxHead;       // written by the MMI thread
+  volatile int m_rxTail;       // written by the Arduino thread, the packet being read
+  volatile boolean m_rxStalled;  // the queue was full while datagrams were pending
+  boolean m_recvCurrent;       // the packet at m_rxTail is being read
+
+  LUDP *m_nextUdp;             // open sockets, see s_udpList
+  static LUDP *s_udpList;
 
   static boolean udpBegin(void* userdata);
   static boolean udpStop(void* userdata);
@@ -65,6 +117,20 @@ protected:
   static boolean udpRecv(void* userdata);
   static void udpCallback(VMINT hdl, VMINT event);
 
+  // moves all pending datagrams into the queue. MMI thread only.
+  void drainPackets();
+  boolean allocReceiveQueue();
+  void freeReceiveQueue();
+  boolean allocSendQueue();
+  void freeSendQueue();
+  // drops the packet being read
+  void releasePacket();
+
+private:
+  // owns its queues and is linked into s_udpList
+  LUDP(const LUDP&);
+  LUDP& operator=(const LUDP&);
+
 protected:
   // child class shoudl return proper APN enum
   virtual VMINT getAPN() const = 0;
@@ -111,6 +177,43 @@ public:
   // </code>
   virtual uint8_t begin(uint16_t port);
 
+  // DESCRIPTION
+  //   Sets the size of the receive queue used by the next begin().
+  //   Incoming datagrams are moved into this queue as they arrive, so a burst
+  //   is not lost between two parsePacket() calls, and parsePacket() does not
+  //   wait for the network. When the queue is full, further datagrams wait in
+  //   the platform buffer. The defaults are LUDP_RX_QUEUE_SLOTS datagrams of
+  //   up to LUDP_RX_MAX_PACKET bytes.
+  // 
+  // PARAMETERS
+  //   slots: number of datagrams the queue holds
+  //   maxPacketSize: largest datagram kept, in bytes; longer ones are truncated
+  // 
+  // RETURNS
+  //   N/A
+  //
+  // EXAMPLE
+  // <code>
+  //     udp.setReceiveQueue(16, 256);  // up to 16 telemetry datagrams of 256 bytes
+  //     udp.begin(1234);
+  // </code>
+  void setReceiveQueue(int slots, int maxPacketSize);
+
+  // DESCRIPTION
+  //   Sets the size of the buffer outgoing datagrams are assembled in.
+  //   It is allocated once, by the first beginPacket() after this call,
+  //   so sending does not allocate memory. The defaults are LUDP_TX_QUEUE_SLOTS
+  //   datagrams and LUDP_TX_ARENA_SIZE bytes shared by all of them.
+  //   Takes effect when no datagram is queued.
+  // 
+  // PARAMETERS
+  //   slots: number of datagrams queuePacket() can hold
+  //   arenaSize: bytes shared by the queued datagrams and the one being written
+  // 
+  // RETURNS
+  //   N/A
+  void setSendQueue(int slots, int arenaSize);
+
   // DESCRIPTION
   //   Stop listening for UDP datagram and uninitializes UDP module.
   // 
@@ -134,7 +237,7 @@ public:
   //   port: the port on the remote host
   // 
   // RETURNS
-  //   1 if succeeded, 0 if failed.
+  //   1 if succeeded, 0 if failed, e.g. when the send queue is full.
   //
   // EXAMPLE
   // <code>
@@ -168,6 +271,7 @@ public:
 
   // DESCRIPTION
   //   Send the datagram after calling beginPacket() and write().
+  //   Datagrams queued with queuePacket() are sent first, in the same call to the network thread.
   // 
   // PARAMETERS
   //   N/A
@@ -184,6 +288,46 @@ public:
   // </code>
   virtual int endPacket();
 
+  // DESCRIPTION
+  //   Ends the datagram started by beginPacket() like endPacket(), but keeps it
+  //   for sendQueued() instead of sending it. Datagrams queued this way may go to
+  //   different destinations and are all sent in a single call to the network thread.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   1 if the datagram was queued, 0 if beginPacket() was not called.
+  //
+  // EXAMPLE
+  // <code>
+  //     for (int i = 0; i < 4; ++i) {
+  //         udp.beginPacket(viewers[i], 5000);
+  //         udp.write(frame, frameSize);
+  //         udp.queuePacket();
+  //     }
+  //     int results[4];
+  //     udp.sendQueued(results, 4);
+  // </code>
+  int queuePacket();
+
+  // DESCRIPTION
+  //   Sends all datagrams queued by queuePacket(), in order, and empties the queue.
+  //   A datagram begun with beginPacket() but not queued yet stays open.
+  // 
+  // PARAMETERS
+  //   results: receives 1 for each datagram sent completely and 0 for each one that failed,
+  //            in queuing order. May be NULL.
+  //   maxResults: number of entries in results
+  // 
+  // RETURNS
+  //   Number of datagrams sent completely.
+  int sendQueued(int results[] = NULL, int maxResults = 0);
+
+  // DESCRIPTION
+  //   Returns the number of datagrams waiting for sendQueued().
+  int queuedPackets() const { return m_txCount; }
+
   // DESCRIPTION
   //   Append 1 single byte into the datagram
   // 
@@ -191,7 +335,7 @@ public:
   //   N/A
   // 
   // RETURNS
-  //   1 if succeeded, 0 if failed.
+  //   1 if succeeded, 0 if failed, e.g. when the send buffer is full.
   virtual size_t write(uint8_t);
 
   // DESCRIPTION
@@ -201,8 +345,19 @@ public:
   //   buffer: the buffer to be appended
   //   size: size of the buffer
   // RETURNS
-  //   1 if succeeded, 0 if failed.
+  //   Number of bytes appended, less than size when the send buffer is full.
   virtual size_t write(const uint8_t *buffer, size_t size);
+
+  // DESCRIPTION
+  //   Append several buffers into the datagram.
+  //   The datagram is still sent as one piece by endPacket().
+  // 
+  // PARAMETERS
+  //   iov: array of buffers to be appended, in order
+  //   count: number of entries in iov
+  // RETURNS
+  //   Total appended bytes.
+  virtual size_t writev(const LIoVec *iov, int count);
   
   using Print::write;
 
@@ -214,6 +369,7 @@ public:
   // 
   // RETURNS
   //   size of the datagram packet, in bytes. 0 is returned if there is no incoming packet.
+  //   While the current packet still has unread bytes, their count is returned instead.
   //
   // EXAMPLE
   // <code>
@@ -263,6 +419,9 @@ public:
   // Read up to len characters from the current packet and place them into buffer
   // Returns the number of characters read, or 0 if none are available
   virtual int read(char* buffer, size_t len) { return read((unsigned char*)buffer, len); };
+
+  // used by readBytesUntil(): as read(buffer, len), but stops after terminator
+  virtual int readAvailableUntil(uint8_t terminator, uint8_t *buffer, size_t len);
   /* DOM-NOT_FOR_SDK-END */
 
   // Return the next byte from the current packet without moving on to the next byte
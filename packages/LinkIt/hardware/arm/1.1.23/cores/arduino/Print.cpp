@@ -27,6 +27,7 @@
 #include "Arduino.h"
 
 #include "Print.h"
+#include "LFormat.h"
 
 // Public Methods //////////////////////////////////////////////////////////////
 
@@ -40,6 +41,17 @@ size_t Print::write(const uint8_t *buffer, size_t size)
   return n;
 }
 
+size_t Print::writev(const LIoVec *iov, int count)
+{
+  size_t n = 0;
+  for (int i = 0; i < count; i++) {
+    const size_t done = write(iov[i].buf, iov[i].len);
+    n += done;
+    if (done < iov[i].len) break;
+  }
+  return n;
+}
+
 size_t Print::print(const __FlashStringHelper *ifsh)
 {
   return print(reinterpret_cast<const char *>(ifsh));
@@ -79,13 +91,13 @@ size_t Print::print(long n, int base)
 {
   if (base == 0) {
     return write(n);
-  } else if (base == 10) {
-    if (n < 0) {
-      int t = print('-');
-      n = -n;
-      return printNumber(n, 10) + t;
-    }
-    return printNumber(n, 10);
+  } else if (base == 10 && n < 0) {
+    // sign and digits in one write; unsigned negation also works for LONG_MIN
+    char buf[LFORMAT_ULTOA_SIZE + 1];
+    char *end = buf + sizeof(buf);
+    char *str = lformat_ultoa(0UL - (unsigned long)n, end, 10);
+    *--str = '-';
+    return write(str, end - str);
   } else {
     return printNumber(n, base);
   }
@@ -193,81 +205,31 @@ size_t Print::println(const Printable& x)
 }
 
 
-#include <stdarg.h>
 size_t Print::printf(const char *fmt, ...)
 {
-    va_list args;
-    char buf[256] = {0};
-  
-    va_start(args, fmt);
-    vsprintf(buf, fmt, args);
-    va_end(args);	
-
-    return write(buf, strlen(buf));
+  va_list args;
+  va_start(args, fmt);
+  size_t n = lformat(*this, fmt, args);
+  va_end(args);
+  return n;
 }
 
-// Private Methods /////////////////////////////////////////////////////////////
-
-size_t Print::printNumber(unsigned long n, uint8_t base) {
-  char buf[8 * sizeof(long) + 1]; // Assumes 8-bit chars plus zero byte.
-  char *str = &buf[sizeof(buf) - 1];
-
-  *str = '\0';
-
-  // prevent crash if called with base == 1
-  if (base < 2) base = 10;
-
-  do {
-    unsigned long m = n;
-    n /= base;
-    char c = m - base * n;
-    *--str = c < 10 ? c + '0' : c + 'A' - 10;
-  } while(n);
-
-  return write(str);
+size_t Print::vprintf(const char *fmt, va_list args)
+{
+  return lformat(*this, fmt, args);
 }
 
-size_t Print::printFloat(double number, uint8_t digits) 
-{ 
-  size_t n = 0;
-  
-  if (isnan(number)) return print("nan");
-  if (isinf(number)) return print("inf");
-  if (number > 4294967040.0) return print ("ovf");  // constant determined empirically
-  if (number <-4294967040.0) return print ("ovf");  // constant determined empirically
-  
-  // Handle negative numbers
-  if (number < 0.0)
-  {
-     n += print('-');
-     number = -number;
-  }
+// Private Methods /////////////////////////////////////////////////////////////
 
-  // Round correctly so that print(1.999, 2) prints as "2.00"
-  double rounding = 0.5;
-  for (uint8_t i=0; i<digits; ++i)
-    rounding /= 10.0;
-  
-  number += rounding;
-
-  // Extract the integer part of the number and print it
-  unsigned long int_part = (unsigned long)number;
-  double remainder = number - (double)int_part;
-  n += print(int_part);
-
-  // Print the decimal point, but only if there are digits beyond
-  if (digits > 0) {
-    n += print("."); 
-  }
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+  char buf[LFORMAT_ULTOA_SIZE];
+  char *end = buf + sizeof(buf);
+  char *str = lformat_ultoa(n, end, base);
+  return write(str, end - str);
+}
 
-  // Extract digits from the remainder one at a time
-  while (digits-- > 0)
-  {
-    remainder *= 10.0;
-    int toPrint = int(remainder);
-    n += print(toPrint);
-    remainder -= toPrint; 
-  } 
-  
-  return n;
+size_t Print::printFloat(double number, uint8_t digits)
+{
+  return lformat_float(*this, number, digits);
 }
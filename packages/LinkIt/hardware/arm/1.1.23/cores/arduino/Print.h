@@ -23,6 +23,7 @@
 #define Print_h
 
 #include <inttypes.h>
+#include <stdarg.h>
 #include <stdio.h> // for size_t
 
 #include "WString.h"
@@ -33,6 +34,13 @@
 #define OCT 8
 #define BIN 2
 
+// one buffer of a scatter/gather write, see Print::writev()
+struct LIoVec
+{
+  const uint8_t *buf;
+  size_t len;
+};
+
 class Print
 {
   private:
@@ -56,6 +64,9 @@ class Print
     size_t write(const char *buffer, size_t size) {
       return write((const uint8_t *)buffer, size);
     }
+    // writes count buffers in order, as if write() was called for each one.
+    // Network classes override it to hand all of them over at once.
+    virtual size_t writev(const LIoVec *iov, int count);
     
     size_t print(const __FlashStringHelper *);
     size_t print(const String &);
@@ -81,8 +92,9 @@ class Print
     size_t println(double, int = 2);
     size_t println(const Printable&);
     size_t println(void);
-    /* format param */
+    /* format param, see LFormat.h for the supported conversions */
     size_t printf(const char *fmt, ...);
+    size_t vprintf(const char *fmt, va_list args);
 };
 
 #endif
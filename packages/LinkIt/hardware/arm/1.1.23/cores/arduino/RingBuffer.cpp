@@ -22,25 +22,73 @@
 #include "RingBuffer.h"
 #include <string.h>
 
-RingBuffer::RingBuffer( void )
+RingBufferBase::RingBufferBase( uint8_t *storage, size_t storageSize ) :
+    _stored( 0 ),
+    _dropped( 0 ),
+    _highWater( 0 )
 {
-    memset( _aucBuffer, 0, SERIAL_BUFFER_SIZE ) ;
-    _iHead=0 ;
-    _iTail=0 ;
+    _ring.begin( storage, storageSize ) ;
 }
 
-void RingBuffer::store_char( uint8_t c )
+void RingBufferBase::store_char( uint8_t c )
 {
-  int i = (uint32_t)(_iHead + 1) % SERIAL_BUFFER_SIZE ;
+  store( &c, 1 ) ;
+}
+
+size_t RingBufferBase::store( const uint8_t *data, size_t len )
+{
+  size_t done = 0 ;
+  while ( done < len )
+  {
+    size_t chunk = 0 ;
+    uint8_t *dst = writeBuffer( chunk ) ;
+    if ( chunk == 0 )
+    {
+      break ;
+    }
+    if ( chunk > len - done )
+    {
+      chunk = len - done ;
+    }
+    memcpy( dst, data + done, chunk ) ;
+    commit( chunk ) ;
+    done += chunk ;
+  }
+
+  // if the buffer is full we don't write the rest, but count it
+  drop( len - done ) ;
+  return done ;
+}
+
+void RingBufferBase::commit( size_t len )
+{
+  _ring.commit( len ) ;
 
-  // if we should be storing the received character into the location
-  // just before the tail (meaning that the head would advance to the
-  // current location of the tail), we're about to overflow the buffer
-  // and so we don't write the character or advance the head.
-  if ( i != _iTail )
+  _stored += len ;
+  const uint32_t level = _ring.available() ;
+  if ( level > _highWater )
   {
-    _aucBuffer[_iHead] = c ;
-    _iHead = i ;
+    _highWater = level ;
   }
 }
 
+void RingBufferBase::drop( size_t len )
+{
+  _dropped += len ;
+}
+
+void RingBufferBase::getStats( RingBufferStats &stats ) const
+{
+  stats.stored = _stored ;
+  stats.dropped = _dropped ;
+  stats.highWater = _highWater ;
+}
+
+void RingBufferBase::clearStats( void )
+{
+  // the writer may count a few more bytes in between; the counters are
+  // only statistics
+  _stored = 0 ;
+  _dropped = 0 ;
+  _highWater = _ring.available() ;
+}
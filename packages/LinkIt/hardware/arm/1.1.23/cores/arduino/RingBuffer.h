@@ -22,24 +22,83 @@
 #ifndef _RING_BUFFER_
 #define _RING_BUFFER_
 
+#include <stddef.h>
 #include <stdint.h>
+#include "LRingBuffer.h"
 
-// Define constants and variables for buffering incoming serial data.  We're
-// using a ring buffer (I think), in which head is the index of the location
-// to which to write the next incoming character and tail is the index of the
-// location from which to read.
+// Define constants and variables for buffering incoming serial data.
+// The bytes are kept in an LRingBuffer, so one thread may store (the DCL
+// or SPP callback) while another reads (the Arduino thread) without
+// locking. RingBufferBase adds the receive statistics.
+//
+// RingBuffer<N> holds the storage; the code works on RingBufferBase, so
+// Serial, Serial1 and the Bluetooth classes can each use their own size.
 #define SERIAL_BUFFER_SIZE (2*1024)
 
-class RingBuffer
+// receive statistics of a RingBuffer, see UARTClass::getStats()
+struct RingBufferStats
 {
-  public:
-    uint8_t _aucBuffer[SERIAL_BUFFER_SIZE] ;
-    int _iHead ;
-    int _iTail ;
+  uint32_t stored;      // bytes stored
+  uint32_t dropped;     // bytes lost because the buffer was full
+  uint32_t highWater;   // highest fill level seen, in bytes
+};
 
+class RingBufferBase
+{
   public:
-    RingBuffer( void ) ;
+    // number of bytes the buffer holds
+    size_t capacity( void ) const { return _ring.capacity() ; }
+
+    // writer side; a byte that does not fit is counted as dropped
     void store_char( uint8_t c ) ;
+
+    // writer side; stores as much as fits, counts the rest as dropped and
+    // returns the number of bytes stored
+    size_t store( const uint8_t *data, size_t len ) ;
+
+    // writer side without copying: returns the contiguous free area and its
+    // length, then commit() publishes len bytes written there
+    uint8_t* writeBuffer( size_t &len ) { return _ring.writeBuffer( len ) ; }
+    void commit( size_t len ) ;
+
+    // writer side; counts len bytes lost before they could be stored
+    void drop( size_t len ) ;
+
+    // reader side
+    size_t available( void ) const { return _ring.available() ; }
+    int peek( void ) const { return _ring.peek() ; }
+    int read( void ) { return _ring.read() ; }
+    size_t read( uint8_t *buf, size_t len ) { return _ring.read( buf, len ) ; }
+    size_t readUntil( uint8_t terminator, uint8_t *buf, size_t len ) { return _ring.readUntil( terminator, buf, len ) ; }
+    void clear( void ) { _ring.clear() ; }
+
+    void getStats( RingBufferStats &stats ) const ;
+    void clearStats( void ) ;
+
+  protected:
+    // storageSize bytes at storage, holding one byte less
+    RingBufferBase( uint8_t *storage, size_t storageSize ) ;
+
+  private:
+    RingBufferBase( const RingBufferBase& ) ;
+    RingBufferBase& operator=( const RingBufferBase& ) ;
+
+    LRingBuffer _ring ;
+    volatile uint32_t _stored ;
+    volatile uint32_t _dropped ;
+    volatile uint32_t _highWater ;
+} ;
+
+// ring buffer of N bytes
+template <size_t N>
+class RingBuffer : public RingBufferBase
+{
+  public:
+    RingBuffer( void ) : RingBufferBase( _storage, sizeof( _storage ) ) {}
+
+  private:
+    // LRingBuffer keeps one byte free
+    uint8_t _storage[N + 1] ;
 } ;
 
 #endif /* _RING_BUFFER_ */
@@ -27,14 +27,18 @@
 #define NO_SKIP_CHAR  1  // a magic char not found in a valid ASCII numeric field
 
 // private method to read stream with timeout
+// sleeps in waitAvailable() instead of polling read() until data arrives
 int Stream::timedRead()
 {
   int c;
   _startMillis = millis();
-  do {
+  while (true) {
     c = read();
     if (c >= 0) return c;
-  } while(millis() - _startMillis < _timeout);
+    unsigned long elapsed = millis() - _startMillis;
+    if (elapsed >= _timeout) break;
+    waitAvailable(_timeout - elapsed);
+  }
   return -1;     // -1 indicates timeout
 }
 
@@ -43,10 +47,13 @@ int Stream::timedPeek()
 {
   int c;
   _startMillis = millis();
-  do {
+  while (true) {
     c = peek();
     if (c >= 0) return c;
-  } while(millis() - _startMillis < _timeout);
+    unsigned long elapsed = millis() - _startMillis;
+    if (elapsed >= _timeout) break;
+    waitAvailable(_timeout - elapsed);
+  }
   return -1;     // -1 indicates timeout
 }
 
@@ -209,6 +216,54 @@ float Stream::parseFloat(char skipChar){
     return value;
 }
 
+bool Stream::waitAvailable(unsigned long timeout)
+{
+  unsigned long start = millis();
+  while (available() <= 0) {
+    if (millis() - start >= timeout) return false;
+    delay(1);
+  }
+  return true;
+}
+
+bool Stream::waitSignal(VM_SIGNAL_ID signal, unsigned long timeout)
+{
+  if (signal == 0) return Stream::waitAvailable(timeout);
+
+  unsigned long start = millis();
+  while (available() <= 0) {
+    unsigned long elapsed = millis() - start;
+    if (elapsed >= timeout) return false;
+    // in slices, so the time in microseconds cannot overflow
+    unsigned long wait = timeout - elapsed;
+    vm_signal_timedwait(signal, (wait < 1000 ? wait : 1000) * 1000);
+  }
+  return true;
+}
+
+int Stream::read(uint8_t *buffer, size_t size)
+{
+  size_t count = 0;
+  while (count < size) {
+    int c = read();
+    if (c < 0) break;
+    buffer[count++] = (uint8_t)c;
+  }
+  return count;
+}
+
+int Stream::readAvailableUntil(uint8_t terminator, uint8_t *buffer, size_t size)
+{
+  size_t count = 0;
+  while (count < size) {
+    int c = read();
+    if (c < 0) break;
+    buffer[count++] = (uint8_t)c;
+    if (c == terminator) break;
+  }
+  return count;
+}
+
 // read characters from stream into buffer
 // terminates if length characters have been read, or timeout (see setTimeout)
 // returns the number of characters placed in the buffer
@@ -218,10 +273,15 @@ size_t Stream::readBytes(char *buffer, size_t length)
 {
   size_t count = 0;
   while (count < length) {
+    // take everything buffered at once, wait only when there is nothing
+    int n = read((uint8_t *)buffer + count, length - count);
+    if (n > 0) {
+      count += n;
+      continue;
+    }
     int c = timedRead();
     if (c < 0) break;
-    *buffer++ = (char)c;
-    count++;
+    buffer[count++] = (char)c;
   }
   return count;
 }
@@ -236,10 +296,19 @@ size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length)
   if (length < 1) return 0;
   size_t index = 0;
   while (index < length) {
+    int n = readAvailableUntil((uint8_t)terminator, (uint8_t *)buffer + index, length - index);
+    if (n > 0) {
+      index += n;
+      if (buffer[index - 1] == terminator) {
+        // consumed, but not part of the result
+        index--;
+        break;
+      }
+      continue;
+    }
     int c = timedRead();
-    if (c < 0 || c == terminator) break;
-    *buffer++ = (char)c;
-    index++;
+    if (c < 0 || c == (uint8_t)terminator) break;
+    buffer[index++] = (char)c;
   }
   return index; // return number of characters, not including null terminator
 }
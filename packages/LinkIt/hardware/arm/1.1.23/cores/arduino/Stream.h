@@ -24,6 +24,7 @@
 
 #include <inttypes.h>
 #include "Print.h"
+#include "vmthread.h"
 
 // compatability macros for testing
 /*
@@ -44,12 +45,35 @@ class Stream : public Print
     int timedPeek();    // private method to peek stream with timeout
     int peekNextDigit(); // returns the next numeric digit in the stream or -1 if timeout
 
+    // waitAvailable() for classes fed by events: sleeps on signal, which the
+    // event handler posts after storing data, until available() is non-zero
+    // or timeout milliseconds have passed. A signal of 0 (not started yet)
+    // falls back to Stream::waitAvailable().
+    bool waitSignal(VM_SIGNAL_ID signal, unsigned long timeout);
+
   public:
     virtual int available() = 0;
     virtual int read() = 0;
     virtual int peek() = 0;
     virtual void flush() = 0;
 
+    // reads up to size bytes that are available now, without waiting.
+    // Returns the number of bytes read; 0 or -1 if none are available.
+    // The default calls read() per byte; classes that buffer data copy it
+    // in bulk, and readBytes() and readBytesUntil() are built on them.
+    virtual int read(uint8_t *buffer, size_t size);
+
+    // as read(buffer, size), but stops after the first terminator byte,
+    // which is stored as the last byte read
+    virtual int readAvailableUntil(uint8_t terminator, uint8_t *buffer, size_t size);
+
+    // waits up to timeout milliseconds for data to read. Returns true once
+    // available() is non-zero, false on timeout. The default checks
+    // available() every millisecond and sleeps in between; classes fed by
+    // driver or network events block on a signal those events post, so an
+    // idle wait costs no CPU. timedRead() and timedPeek() are built on it.
+    virtual bool waitAvailable(unsigned long timeout);
+
     Stream() {_timeout=1000;}
 
 // parsing methods
@@ -0,0 +1,127 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include "StringBuilder.h"
+
+StringBuilder::StringBuilder(unsigned int capacity)
+{
+	m_str.reserve(capacity);
+}
+
+StringBuilder& StringBuilder::append(const char *cstr)
+{
+	print(cstr);
+	return *this;
+}
+
+StringBuilder& StringBuilder::append(const char *buffer, unsigned int length)
+{
+	write((const uint8_t*)buffer, length);
+	return *this;
+}
+
+StringBuilder& StringBuilder::append(const String &str)
+{
+	print(str);
+	return *this;
+}
+
+StringBuilder& StringBuilder::append(const __FlashStringHelper *str)
+{
+	print(str);
+	return *this;
+}
+
+StringBuilder& StringBuilder::append(char c)
+{
+	write((uint8_t)c);
+	return *this;
+}
+
+StringBuilder& StringBuilder::append(int value, int base)
+{
+	print(value, base);
+	return *this;
+}
+
+StringBuilder& StringBuilder::append(unsigned int value, int base)
+{
+	print(value, base);
+	return *this;
+}
+
+StringBuilder& StringBuilder::append(long value, int base)
+{
+	print(value, base);
+	return *this;
+}
+
+StringBuilder& StringBuilder::append(unsigned long value, int base)
+{
+	print(value, base);
+	return *this;
+}
+
+StringBuilder& StringBuilder::append(double value, int digits)
+{
+	print(value, digits);
+	return *this;
+}
+
+bool StringBuilder::reserve(unsigned int capacity)
+{
+	return m_str.reserve(capacity);
+}
+
+void StringBuilder::clear()
+{
+	// assigning keeps the buffer, it is large enough for ""
+	m_str = "";
+	clearWriteError();
+}
+
+unsigned int StringBuilder::length() const
+{
+	return m_str.length();
+}
+
+const String& StringBuilder::str() const
+{
+	return m_str;
+}
+
+const char* StringBuilder::c_str() const
+{
+	return m_str.c_str();
+}
+
+size_t StringBuilder::write(uint8_t c)
+{
+	if(!m_str.concat((char)c))
+	{
+		setWriteError();
+		return 0;
+	}
+	return 1;
+}
+
+size_t StringBuilder::write(const uint8_t *buffer, size_t size)
+{
+	if(!m_str.concat((const char*)buffer, size))
+	{
+		setWriteError();
+		return 0;
+	}
+	return size;
+}
@@ -0,0 +1,95 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _StringBuilder_h
+#define _StringBuilder_h
+
+#include "Print.h"
+#include "WString.h"
+
+// DESCRIPTION
+//  StringBuilder assembles a String from text and numbers. Everything that
+//  can be printed, including printf(), can be appended to it; numbers and
+//  floats are formatted straight into the String instead of going through
+//  temporary String objects as "a" + String(1) + "b" does.
+//
+//  Give the expected length to the constructor or to reserve() to build
+//  the whole text in a single heap block.
+//
+// EXAMPLE
+// <code>
+// #include <StringBuilder.h>
+//
+// String makeReport(int id, float temperature)
+// {
+//   StringBuilder sb(32);
+//   sb.append("id=").append(id).append(" t=").append(temperature, 1);
+//   return sb.str();
+// }
+// </code>
+class StringBuilder : public Print
+{
+public:
+  // DESCRIPTION
+  //  Creates an empty builder with room for capacity characters.
+  explicit StringBuilder(unsigned int capacity = 0);
+
+  // DESCRIPTION
+  //  Appends text, a character or a number.
+  // PARAMETERS
+  //  base: the base of integers, DEC by default
+  //  digits: the number of fraction digits of floats, 2 by default
+  // RETURNS
+  //  The builder itself, so calls can be chained.
+  StringBuilder& append(const char *cstr);
+  StringBuilder& append(const char *buffer, unsigned int length);
+  StringBuilder& append(const String &str);
+  StringBuilder& append(const __FlashStringHelper *str);
+  StringBuilder& append(char c);
+  StringBuilder& append(int value, int base = DEC);
+  StringBuilder& append(unsigned int value, int base = DEC);
+  StringBuilder& append(long value, int base = DEC);
+  StringBuilder& append(unsigned long value, int base = DEC);
+  StringBuilder& append(double value, int digits = 2);
+
+  // DESCRIPTION
+  //  Makes room for capacity characters in total.
+  // RETURNS
+  //  true on success, false if out of memory.
+  bool reserve(unsigned int capacity);
+
+  // DESCRIPTION
+  //  Empties the builder but keeps its memory for the next text.
+  //  It also clears getWriteError().
+  void clear();
+
+  // DESCRIPTION
+  //  Number of characters appended so far.
+  unsigned int length() const;
+
+  // DESCRIPTION
+  //  The text appended so far. If memory ran out, getWriteError() is set
+  //  and the text ends at the last append that fit.
+  const String& str() const;
+  const char* c_str() const;
+
+  virtual size_t write(uint8_t c);
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  using Print::write;
+
+private:
+  String m_str;
+};
+
+#endif
@@ -28,44 +28,76 @@ typedef struct
 
 // Constructors ////////////////////////////////////////////////////////////////
 
-UARTClass::UARTClass( int usbNum, RingBuffer* pRx_buffer )
+UARTClass::UARTClass( int usbNum, RingBufferBase* pRx_buffer, size_t txBufferSize )
 {
     _rx_buffer = pRx_buffer ;
     _usbNum = usbNum;
     uart_handle = -1;
+    memset(&_tx_mutex, 0, sizeof(_tx_mutex));
+    _tx_signal = 0;
+    _tx_size = txBufferSize;
+    _rx_signal = 0;
 }
 
 void UartIrqHandler(void* parameter, VM_DCL_EVENT event, VM_DCL_HANDLE device_handle)
 {
-    if(event == VM_UART_READY_TO_READ)
+    if(event == VM_UART_READY_TO_WRITE)
     {
-        char data[SERIAL_BUFFER_SIZE];
-        int i;
+        // the port has room again: hand it the next chunk and wake a writer
+        UARTClass *port = (device_handle == g_APinDescription[0].ulHandle) ? &Serial1 : &Serial;
+        port->drainTx();
+        vm_signal_post(port->_tx_signal);
+    }
+    else if(event == VM_UART_READY_TO_READ)
+    {
+        UARTClass *port = (device_handle == g_APinDescription[0].ulHandle) ? &Serial1 : &Serial;
+        RingBufferBase *rx = port->_rx_buffer;
         VM_DCL_STATUS status;
         VM_DCL_BUFF_LEN returned_len;
 
-        status = vm_dcl_read(device_handle,(VM_DCL_BUFF*)data,SERIAL_BUFFER_SIZE,&returned_len,vm_dcl_get_ownerid());
-        if(status<VM_DCL_STATUS_OK)
-        {
-            vm_log_info((char*)"read failed");
-        }  
-        if(device_handle == g_APinDescription[0].ulHandle)
+        // read straight into the ring, in up to two pieces when it wraps
+        for(;;)
         {
-            for(i=0;i<returned_len;i++)
+            size_t len = 0;
+            uint8_t *dst = rx->writeBuffer(len);
+            if(len == 0)
             {
-                Serial1._rx_buffer->store_char(data[i]);
+                // full: empty the driver anyway, so the next event reports
+                // new data, and count what is lost
+                uint8_t discard[SERIAL_RX_DISCARD_SIZE];
+                returned_len = 0;
+                status = vm_dcl_read(device_handle,(VM_DCL_BUFF*)discard,sizeof(discard),&returned_len,vm_dcl_get_ownerid());
+                if(status < VM_DCL_STATUS_OK || returned_len <= 0)
+                {
+                    break;
+                }
+                rx->drop(returned_len);
+                continue;
             }
-        }
-        else
-        {
-            for(i=0;i<returned_len;i++)
+
+            returned_len = 0;
+            status = vm_dcl_read(device_handle,(VM_DCL_BUFF*)dst,len,&returned_len,vm_dcl_get_ownerid());
+            if(status < VM_DCL_STATUS_OK)
             {
-                Serial._rx_buffer->store_char(data[i]);
+                vm_log_info((char*)"read failed");
+                break;
+            }
+            if(returned_len <= 0)
+            {
+                break;
+            }
+            rx->commit(returned_len);
+            if((size_t)returned_len < len)
+            {
+                // the driver is empty
+                break;
             }
         }
-    }
-    else
-    {
+        // wake a reader sleeping in waitAvailable()
+        if(port->_rx_signal)
+        {
+            vm_signal_post(port->_rx_signal);
+        }
     }
 }
 
@@ -105,7 +137,24 @@ void UARTClass::begin( const uint32_t dwBaudRate )
     data.rUARTConfig.ucXoffChar = 0x13;
     data.rUARTConfig.fgDSRCheck = 0;
     vm_dcl_control(uart_handle,VM_SIO_CMD_SET_DCB_CONFIG,(void *)&data);
-    vm_dcl_registercallback(uart_handle,VM_UART_READY_TO_READ,(VM_DCL_CALLBACK)UartIrqHandler,(void*)NULL);
+
+    if(_tx_mutex.guard == 0)
+    {
+        vm_mutex_create(&_tx_mutex);
+    }
+    if(_tx_signal == 0)
+    {
+        _tx_signal = vm_signal_init();
+    }
+    if(_rx_signal == 0)
+    {
+        _rx_signal = vm_signal_init();
+    }
+    if(_tx_buffer.capacity() == 0 && _tx_size)
+    {
+        // without it, write() hands the data to the port directly
+        _tx_buffer.begin(_tx_size);
+    }
 
     if(_usbNum == 2)
     {
@@ -115,13 +164,21 @@ void UARTClass::begin( const uint32_t dwBaudRate )
     {
         usb_device_handle = uart_handle;
     }
+
+    // UartIrqHandler() finds the port by its pin handle and uses the
+    // signals and the transmit buffer, so all of them are set first
+    vm_dcl_registercallback(uart_handle,VM_UART_READY_TO_READ,(VM_DCL_CALLBACK)UartIrqHandler,(void*)NULL);
+    vm_dcl_registercallback(uart_handle,VM_UART_READY_TO_WRITE,(VM_DCL_CALLBACK)UartIrqHandler,(void*)NULL);
 }
 
 void UARTClass::end( void )
 {
+    flush();
+
 // clear any received data
-    _rx_buffer->_iHead = _rx_buffer->_iTail ;
+    _rx_buffer->clear() ;
     vm_dcl_close(uart_handle);
+    uart_handle = -1;
   
     if(_usbNum == 2)
     {
@@ -136,79 +193,141 @@ void UARTClass::end( void )
 
 int UARTClass::available( void )
 {
-    return (uint32_t)(SERIAL_BUFFER_SIZE + _rx_buffer->_iHead - _rx_buffer->_iTail) % SERIAL_BUFFER_SIZE ;
+    return _rx_buffer->available() ;
 }
 
 int UARTClass::peek( void )
 {
-    if( _rx_buffer->_iHead == _rx_buffer->_iTail )
-        return -1 ;
-
-    return _rx_buffer->_aucBuffer[_rx_buffer->_iTail] ;
+    return _rx_buffer->peek() ;
 }
 
 int UARTClass::read( void )
 {
-// if the head isn't ahead of the tail, we don't have any characters
-    if ( _rx_buffer->_iHead == _rx_buffer->_iTail )
-        return -1 ;
+    return _rx_buffer->read() ;
+}
 
-    uint8_t uc = _rx_buffer->_aucBuffer[_rx_buffer->_iTail] ;
-    _rx_buffer->_iTail = (unsigned int)(_rx_buffer->_iTail + 1) % SERIAL_BUFFER_SIZE ;
-    return uc ;
+int UARTClass::read( uint8_t *buffer, size_t size )
+{
+    return _rx_buffer->read( buffer, size ) ;
 }
 
+int UARTClass::readAvailableUntil( uint8_t terminator, uint8_t *buffer, size_t size )
+{
+    return _rx_buffer->readUntil( terminator, buffer, size ) ;
+}
 
-void UARTClass::flush( void )
+bool UARTClass::waitAvailable( unsigned long timeout )
+{
+    // posted by UartIrqHandler(); 0 until begin()
+    return waitSignal(_rx_signal, timeout);
+}
+
+void UARTClass::getStats( RingBufferStats &stats )
+{
+    _rx_buffer->getStats( stats ) ;
+}
+
+void UARTClass::clearStats( void )
+{
+    _rx_buffer->clearStats() ;
+}
+
+bool UARTClass::txIdle( void )
 {
     vm_dcl_sio_check_tx_buffer_t return_data;
-    VM_DCL_STATUS status;
-    VMINT command = 0;
-    if(uart_handle != -1)
+    const VMINT command = (_usbNum == 2) ? VM_UART_CHECK_TX_BUFFER : VM_USB_CHECK_TX_BUFFER;
+
+    return_data.return_result = 0;
+    vm_dcl_control(uart_handle, command, (vm_dcl_sio_check_tx_buffer_t*)&return_data);
+    return return_data.return_result == 1;
+}
+
+void UARTClass::drainTx( void )
+{
+    // called by the Arduino thread after queuing and by the MMI thread on
+    // VM_UART_READY_TO_WRITE; only one of them may consume at a time
+    vm_mutex_lock(&_tx_mutex);
+    while(uart_handle != -1)
     {
-        if(_usbNum == 2)
+        size_t len = 0;
+        const uint8_t *data = _tx_buffer.readBuffer(len);
+        if(len == 0)
         {
-            command = VM_UART_CHECK_TX_BUFFER;
+            break;
         }
-        else
+
+        VM_DCL_BUFF_LEN written = 0;
+        vm_dcl_write(uart_handle, (VM_DCL_BUFF*)data, len, &written, vm_dcl_get_ownerid());
+        _tx_buffer.consume(written);
+        if(written < len)
         {
-            command = VM_USB_CHECK_TX_BUFFER;   
+            // the port is full; VM_UART_READY_TO_WRITE continues from here
+            break;
         }
-        status = vm_dcl_control(uart_handle, command, (vm_dcl_sio_check_tx_buffer_t*)&return_data);
-        while(return_data.return_result!=1)
+    }
+    vm_mutex_unlock(&_tx_mutex);
+}
+
+void UARTClass::flush( void )
+{
+    if(uart_handle == -1)
+    {
+        return;
+    }
+
+    while(_tx_buffer.available())
+    {
+        drainTx();
+        if(_tx_buffer.available())
         {
-            status = vm_dcl_control(uart_handle, command, (vm_dcl_sio_check_tx_buffer_t*)&return_data);
+            vm_signal_timedwait(_tx_signal, SERIAL_TX_WAIT * 1000);
         }
     }
+
+    // then the bytes inside the driver. VM_UART_READY_TO_WRITE only
+    // reports room after a write came up short, not that the driver has
+    // sent everything, so there is no event to wait for here
+    while(!txIdle())
+    {
+        delay(1);
+    }
 }
 
 size_t UARTClass::write( const uint8_t uc_data )
 {
-    vm_dcl_sio_check_tx_buffer_t return_data;
-    VM_DCL_STATUS status;
-    VMINT command = 0;
-    VM_DCL_BUFF_LEN writen_len = 0;
-    int count = 0;
-    if(uart_handle != -1)
+    return write(&uc_data, 1);
+}
+
+size_t UARTClass::write( const uint8_t *buffer, size_t size )
+{
+    if(uart_handle == -1)
     {
-        if(_usbNum == 2)
+        return 0;
+    }
+
+    size_t done = 0;
+    while(done < size)
+    {
+        if(_tx_buffer.capacity())
         {
-            command = VM_UART_CHECK_TX_BUFFER;
+            done += _tx_buffer.write(buffer + done, size - done);
+            drainTx();
         }
         else
         {
-            command = VM_USB_CHECK_TX_BUFFER; 
+            // no transmit buffer: write straight from the caller's data
+            VM_DCL_BUFF_LEN written = 0;
+            vm_dcl_write(uart_handle, (VM_DCL_BUFF*)(buffer + done), size - done, &written, vm_dcl_get_ownerid());
+            done += written;
         }
-        status = vm_dcl_control(uart_handle, command, (vm_dcl_sio_check_tx_buffer_t*)&return_data);
-        while(return_data.return_result!=1)
+
+        if(done < size)
         {
-            status = vm_dcl_control(uart_handle, command, (vm_dcl_sio_check_tx_buffer_t*)&return_data);
-        }  
-        status = vm_dcl_write(uart_handle,(VM_DCL_BUFF*)&uc_data,1,&writen_len,vm_dcl_get_ownerid());
-        return writen_len;
+            // full; sleep until the port takes more
+            vm_signal_timedwait(_tx_signal, SERIAL_TX_WAIT * 1000);
+        }
     }
-    return 0;
-  
+    return size;
 }
 
 UARTClass::operator bool()
@@ -22,24 +22,60 @@
 
 #include "HardwareSerial.h"
 #include "RingBuffer.h"
+#include "LRingBuffer.h"
+#include "vmthread.h"
 #include "vmdcl.h"
 #include "vmdcl_gpio.h"
 #include "vmdcl_sio.h"
 #include <chip.h>
 
+// default number of bytes queued for transmission per port; write() only
+// waits when it is full. 0 writes straight to the port.
+#ifndef SERIAL_TX_BUFFER_SIZE
+#define SERIAL_TX_BUFFER_SIZE 1024
+#endif
+
+// bytes read and thrown away per call while the receive buffer is full
+#ifndef SERIAL_RX_DISCARD_SIZE
+#define SERIAL_RX_DISCARD_SIZE 64
+#endif
+
+// longest wait in milliseconds for a ready-to-write event before the
+// transmit buffer is checked again
+#ifndef SERIAL_TX_WAIT
+#define SERIAL_TX_WAIT 10
+#endif
+
 // UARTClass is designed for LinkIt One board connecte with other hardware device through UART
 // LinkIt One has 2 serial ports: Serial and Serial1. Serial communicates on USB port, Serial1
 // on pins0(RX) and pins1(TX).
 class UARTClass : public HardwareSerial
 {
   protected:
-    RingBuffer *_rx_buffer ;
+    RingBufferBase *_rx_buffer ;
   protected:
     int _usbNum ;
     VM_DCL_HANDLE uart_handle;
 
+    /* DOM-NOT_FOR_SDK-BEGIN */
+    // filled by write() on the Arduino thread and drained by drainTx() on
+    // either thread; _tx_mutex keeps the drains apart
+    LRingBuffer _tx_buffer;
+    vm_thread_mutex_struct _tx_mutex;
+    VM_SIGNAL_ID _tx_signal;
+    size_t _tx_size;
+
+    // posted on VM_UART_READY_TO_READ once the data is in _rx_buffer
+    VM_SIGNAL_ID _rx_signal;
+
+    void drainTx( void ) ;
+    bool txIdle( void ) ;
+    /* DOM-NOT_FOR_SDK-END */
+
   public:
-    UARTClass( int usbNum, RingBuffer* pRx_buffer ) ;
+    // the receive buffer and the transmit buffer size are chosen per port,
+    // see SERIAL_RX_BUFFER_SIZE and the other sizes in variant.h
+    UARTClass( int usbNum, RingBufferBase* pRx_buffer, size_t txBufferSize = SERIAL_TX_BUFFER_SIZE ) ;
     
 // Method
   public:
@@ -118,19 +154,68 @@ int peek( void ) ;
  //</code> 
 int read( void ) ;
 
- //  waits for the transmission of outgoing serial data to complete
+ //  reads the received serial data that is buffered, without waiting
+ //
+ // RETURNS
+ // the number of bytes read, 0 if no data is available
+int read( uint8_t *buffer, //[OUT] buffer for the data
+          size_t size      //[IN] size of buffer
+        ) ;
+
+ //  as read(buffer, size), but stops after the first terminator byte,
+ //  which is the last byte read
+int readAvailableUntil( uint8_t terminator, uint8_t *buffer, size_t size ) ;
+
+ //  waits until received data is available to read. The Arduino thread
+ //  sleeps until the port reports new data or the timeout expires.
+ //
+ // RETURNS
+ // true if data is available, false on timeout
+bool waitAvailable( unsigned long timeout //[IN] longest wait in milliseconds
+                  ) ;
+
+ //  get the receive statistics of the port: bytes received, bytes lost
+ //  because the receive buffer was full, and its highest fill level.
+ //
+ // EXAMPLE
+ //<code>
+ //RingBufferStats stats;
+ //Serial1.getStats(stats);
+ //if (stats.dropped)
+ //{
+ //    Serial.println("Serial1 overflow, read more often");
+ //}
+ //</code>
+void getStats( RingBufferStats &stats //[OUT] receive statistics
+             ) ;
+
+ //  resets the receive statistics
+void clearStats( void ) ;
+
+ //  waits for the transmission of outgoing serial data to complete.
+ //  The Arduino thread sleeps while the port sends the queued data.
 void flush( void ) ;
 
-// write a char 
+// write a char. It is queued and sent in the background; the call only
+// waits when SERIAL_TX_BUFFER_SIZE bytes are already queued.
 //
 // RETURNS
 // the number of write
 size_t write( const uint8_t c //[IN] input char
             ) ;
+
+// write a buffer. The data is queued and handed to the port in chunks as
+// large as it accepts; the call only waits while the queue is full.
+//
+// RETURNS
+// the number of bytes written
+size_t write( const uint8_t *buffer, //[IN] data to send
+              size_t size            //[IN] number of bytes in buffer
+            ) ;
     
     friend void UartIrqHandler(void* parameter, VM_DCL_EVENT event, VM_DCL_HANDLE device_handle);
     
-    // pull in write(str) and write(buf, size) from Print
+    // pull in write(str) and write(const char*, size) from Print
     using Print::write ; 
     	
 // Check if the serail port is ready. 
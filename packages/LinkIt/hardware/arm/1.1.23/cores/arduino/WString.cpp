@@ -22,6 +22,7 @@
 #include "WString.h"
 #include "itoa.h"
 #include "avr/dtostrf.h"
+#include "LFormat.h"
 
 /*********************************************/
 /*  Constructors                             */
@@ -123,7 +124,7 @@ String::String(double value, unsigned char decimalPlaces)
 
 String::~String()
 {
-	free(buffer);
+	if (!isInline()) free(buffer);
 }
 
 /*********************************************/
@@ -139,7 +140,7 @@ inline void String::init(void)
 
 void String::invalidate(void)
 {
-	if (buffer) free(buffer);
+	if (buffer && !isInline()) free(buffer);
 	buffer = NULL;
 	capacity = len = 0;
 }
@@ -154,8 +155,35 @@ unsigned char String::reserve(unsigned int size)
 	return 0;
 }
 
+// grows the buffer by half its capacity, or to size if that is larger.
+// Falls back to exactly size when the heap cannot provide the extra room.
+unsigned char String::grow(unsigned int size)
+{
+	if (buffer && capacity >= size) return 1;
+	unsigned int newCapacity = capacity + (capacity >> 1);
+	if (newCapacity > size && changeBuffer(newCapacity)) {
+		if (len == 0) buffer[0] = 0;
+		return 1;
+	}
+	return reserve(size);
+}
+
 unsigned char String::changeBuffer(unsigned int maxStrLen)
 {
+	if (!buffer || isInline()) {
+		if (maxStrLen < STRING_INLINE_SIZE) {
+			buffer = inline_buffer;
+			capacity = STRING_INLINE_SIZE - 1;
+			return 1;
+		}
+		// moving out of the inline buffer (or first allocation)
+		char *newbuffer = (char *)malloc(maxStrLen + 1);
+		if (!newbuffer) return 0;
+		if (buffer) memcpy(newbuffer, buffer, len + 1);
+		buffer = newbuffer;
+		capacity = maxStrLen;
+		return 1;
+	}
 	char *newbuffer = (char *)realloc(buffer, maxStrLen + 1);
 	if (newbuffer) {
 		buffer = newbuffer;
@@ -200,10 +228,20 @@ void String::move(String &rhs)
 			len = rhs.len;
 			rhs.len = 0;
 			return;
-		} else {
+		} else if (!isInline()) {
 			free(buffer);
 		}
 	}
+	if (rhs.isInline()) {
+		// an inline buffer can't be taken over, copy it
+		buffer = inline_buffer;
+		capacity = rhs.capacity;
+		len = rhs.len;
+		memcpy(inline_buffer, rhs.inline_buffer, len + 1);
+		rhs.len = 0;
+		rhs.buffer[0] = 0;
+		return;
+	}
 	buffer = rhs.buffer;
 	capacity = rhs.capacity;
 	len = rhs.len;
@@ -267,8 +305,16 @@ unsigned char String::concat(const char *cstr, unsigned int length)
 	unsigned int newlen = len + length;
 	if (!cstr) return 0;
 	if (length == 0) return 1;
-	if (!reserve(newlen)) return 0;
-	strcpy(buffer + len, cstr);
+	if (buffer && cstr >= buffer && cstr < buffer + len) {
+		// appending (part of) ourselves: the buffer may move in grow()
+		unsigned int offset = cstr - buffer;
+		if (!grow(newlen)) return 0;
+		cstr = buffer + offset;
+	} else if (!grow(newlen)) {
+		return 0;
+	}
+	memcpy(buffer + len, cstr, length);
+	buffer[newlen] = 0;
 	len = newlen;
 	return 1;
 }
@@ -281,45 +327,42 @@ unsigned char String::concat(const char *cstr)
 
 unsigned char String::concat(char c)
 {
-	char buf[2];
-	buf[0] = c;
-	buf[1] = 0;
-	return concat(buf, 1);
+	if (!grow(len + 1)) return 0;
+	buffer[len++] = c;
+	buffer[len] = 0;
+	return 1;
 }
 
 unsigned char String::concat(unsigned char num)
 {
-	char buf[1 + 3 * sizeof(unsigned char)];
-	itoa(num, buf, 10);
-	return concat(buf, strlen(buf));
+	return concat((unsigned long)num);
 }
 
 unsigned char String::concat(int num)
 {
-	char buf[2 + 3 * sizeof(int)];
-	itoa(num, buf, 10);
-	return concat(buf, strlen(buf));
+	return concat((long)num);
 }
 
 unsigned char String::concat(unsigned int num)
 {
-	char buf[1 + 3 * sizeof(unsigned int)];
-	utoa(num, buf, 10);
-	return concat(buf, strlen(buf));
+	return concat((unsigned long)num);
 }
 
 unsigned char String::concat(long num)
 {
-	char buf[2 + 3 * sizeof(long)];
-	ltoa(num, buf, 10);
-	return concat(buf, strlen(buf));
+	char buf[1 + LFORMAT_ULTOA_SIZE];
+	char *end = buf + sizeof(buf);
+	char *begin = lformat_ultoa(num < 0 ? 0UL - (unsigned long)num : (unsigned long)num, end, 10);
+	if (num < 0) *--begin = '-';
+	return concat(begin, end - begin);
 }
 
 unsigned char String::concat(unsigned long num)
 {
-	char buf[1 + 3 * sizeof(unsigned long)];
-	ultoa(num, buf, 10);
-	return concat(buf, strlen(buf));
+	char buf[LFORMAT_ULTOA_SIZE];
+	char *end = buf + sizeof(buf);
+	char *begin = lformat_ultoa(num, end, 10);
+	return concat(begin, end - begin);
 }
 
 unsigned char String::concat(float num)
@@ -342,7 +385,7 @@ unsigned char String::concat(const __FlashStringHelper * str)
 	int length = strlen_P((const char *) str);
 	if (length == 0) return 1;
 	unsigned int newlen = len + length;
-	if (!reserve(newlen)) return 0;
+	if (!grow(newlen)) return 0;
 	strcpy_P(buffer + len, (const char *) str);
 	len = newlen;
 	return 1;
@@ -697,7 +740,7 @@ void String::remove(unsigned int index, unsigned int count){
 	if (index + count > len) { count = len - index; }
 	char *writeTo = buffer + index;
 	len = len - count;
-	strncpy(writeTo, buffer + index + count,len - index);
+	memmove(writeTo, buffer + index + count, len - index);
 	buffer[len] = 0;
 }
 
@@ -34,6 +34,14 @@
 //     -felide-constructors
 //     -std=c++0x
 
+// Strings shorter than STRING_INLINE_SIZE characters are kept inside the
+// String object itself instead of on the heap, so short temporaries such
+// as String(42) or String('x') never call malloc().  Each String is this
+// many bytes larger.
+#ifndef STRING_INLINE_SIZE
+#define STRING_INLINE_SIZE 12
+#endif
+
 class __FlashStringHelper;
 #define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(PSTR(string_literal)))
 
@@ -76,7 +84,9 @@ public:
 	// memory management
 	// return true on success, false on failure (in which case, the string
 	// is left unchanged).  reserve(0), if successful, will validate an
-	// invalid string (i.e., "if (s)" will be true afterwards)
+	// invalid string (i.e., "if (s)" will be true afterwards).
+	// concatenation grows the buffer by half of its size at a time, so
+	// reserve() the final length up front to avoid any extra room.
 	unsigned char reserve(unsigned int size);
 	inline unsigned int length(void) const {return len;}
 
@@ -98,6 +108,7 @@ public:
 	// concatenation is considered unsucessful.  
 	unsigned char concat(const String &str);
 	unsigned char concat(const char *cstr);
+	unsigned char concat(const char *cstr, unsigned int length);	// length bytes of cstr, need not be terminated
 	unsigned char concat(char c);
 	unsigned char concat(unsigned char c);
 	unsigned char concat(int num);
@@ -191,11 +202,13 @@ protected:
 	char *buffer;	        // the actual char array
 	unsigned int capacity;  // the array length minus one (for the '\0')
 	unsigned int len;       // the String length (not counting the '\0')
+	char inline_buffer[STRING_INLINE_SIZE];	// buffer for short strings
 protected:
 	void init(void);
 	void invalidate(void);
 	unsigned char changeBuffer(unsigned int maxStrLen);
-	unsigned char concat(const char *cstr, unsigned int length);
+	unsigned char grow(unsigned int size);
+	inline unsigned char isInline(void) const {return buffer == inline_buffer;}
 
 	// copy and move
 	String & copy(const char *cstr, unsigned int length);
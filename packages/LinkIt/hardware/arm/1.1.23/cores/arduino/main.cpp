@@ -27,6 +27,7 @@
 #include "vmpromng.h"
 #include "vmlog.h"
 #include "vmtel.h"
+#include "LTask.h"
 
 typedef VMINT (*vm_get_sym_entry_t)(char* symbol);
 extern vm_get_sym_entry_t vm_get_sym_entry;
@@ -42,11 +43,7 @@ void __handle_sysevt(VMINT message, VMINT param)
 {
     if(message == VM_MSG_ARDUINO_CALL)
     {
-    	 msg_struct* pMsg = (msg_struct*)param;
-    	 if(pMsg->remote_func(pMsg->userdata))
-        {
-        	vm_signal_post(pMsg->signal);
-    	 }
+    	 _LTaskClass::drain();
         return ;
     }
 }
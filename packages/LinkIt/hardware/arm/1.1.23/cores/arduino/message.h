@@ -27,11 +27,22 @@ extern "C" {
 
 typedef boolean (*remote_call_ptr)(void* user_data);
 
+// state of a message slot, see _LTaskClass::remoteCallAsync()
+#define LTASK_CALL_FREE      0
+#define LTASK_CALL_PENDING   1
+#define LTASK_CALL_DONE      2
+
 typedef struct _msg_struct
 {
 	VM_SIGNAL_ID signal;
 	remote_call_ptr remote_func;
 	void* userdata;
+	volatile VMINT state;	// LTASK_CALL_xxx, only used by asynchronous calls
+	boolean result;			// return value of remote_func
+#ifdef LTASK_PROFILE
+	VMUINT32 sendTime;		// vm_ust_get_current_time() when queued
+	VMUINT32 startTime;		// when remote_func started, 0 once recorded
+#endif
 }msg_struct;
 
 #ifdef __cplusplus
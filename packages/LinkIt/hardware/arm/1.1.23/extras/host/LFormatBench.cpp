@@ -0,0 +1,202 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+// Host microbenchmark of Print::print(long), print(double) and printf()
+// against the code they replaced, which is kept below as OldPrint. It
+// first checks that both give the same output. From the platform folder:
+//
+//   gcc -c cores/arduino/itoa.c cores/arduino/avr/dtostrf.c
+//   g++ -std=gnu++98 -O2 -Icores/arduino -Ivariants/linkit_one -Isystem/libmtk -Isystem/libmtk/include
+//       cores/arduino/Print.cpp cores/arduino/LFormat.cpp cores/arduino/WString.cpp itoa.o dtostrf.o
+//       extras/host/LFormatBench.cpp -o lformat_bench
+//   ./lformat_bench
+//
+// The host has a hardware FPU; the board formats floats in soft-float, where
+// the old per-digit loop costs more.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <time.h>
+#include "Print.h"
+
+// print(long), print(double) and printf() as they were before LFormat
+class OldPrint
+{
+public:
+	OldPrint(Print &out) : m_out(out) {}
+
+	size_t print(long n)
+	{
+		if(n < 0)
+		{
+			const size_t t = m_out.write('-');
+			return printNumber(-n, 10) + t;
+		}
+		return printNumber(n, 10);
+	}
+
+	size_t print(double number, uint8_t digits)
+	{
+		size_t n = 0;
+		if(isnan(number)) return m_out.write("nan");
+		if(isinf(number)) return m_out.write("inf");
+		if(number > 4294967040.0) return m_out.write("ovf");
+		if(number < -4294967040.0) return m_out.write("ovf");
+
+		if(number < 0.0)
+		{
+			n += m_out.write('-');
+			number = -number;
+		}
+
+		double rounding = 0.5;
+		for(uint8_t i = 0; i < digits; ++i)
+			rounding /= 10.0;
+		number += rounding;
+
+		unsigned long int_part = (unsigned long)number;
+		double remainder = number - (double)int_part;
+		n += printNumber(int_part, 10);
+		if(digits > 0)
+		{
+			n += m_out.write(".");
+		}
+		while(digits-- > 0)
+		{
+			remainder *= 10.0;
+			int toPrint = int(remainder);
+			n += printNumber(toPrint, 10);
+			remainder -= toPrint;
+		}
+		return n;
+	}
+
+	size_t printf(const char *fmt, ...)
+	{
+		va_list args;
+		char buf[256] = {0};
+		va_start(args, fmt);
+		vsprintf(buf, fmt, args);
+		va_end(args);
+		return m_out.write(buf, strlen(buf));
+	}
+
+private:
+	size_t printNumber(unsigned long n, uint8_t base)
+	{
+		char buf[8 * sizeof(long) + 1];
+		char *str = &buf[sizeof(buf) - 1];
+		*str = '\0';
+		if(base < 2) base = 10;
+		do
+		{
+			unsigned long m = n;
+			n /= base;
+			char c = m - base * n;
+			*--str = c < 10 ? c + '0' : c + 'A' - 10;
+		} while(n);
+		return m_out.write(str);
+	}
+
+	Print &m_out;
+};
+
+// collects what is printed
+class StrPrint : public Print
+{
+public:
+	std::string s;
+	virtual size_t write(uint8_t c) { s += (char)c; return 1; }
+	virtual size_t write(const uint8_t *buffer, size_t size) { s.append((const char*)buffer, size); return size; }
+};
+
+// drops what is printed, so only the formatting is timed
+class NullPrint : public Print
+{
+public:
+	virtual size_t write(uint8_t) { return 1; }
+	virtual size_t write(const uint8_t *, size_t size) { return size; }
+};
+
+static double seconds()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void compare(int count)
+{
+	int longDiffs = 0;
+	int doubleDiffs = 0;
+	srand(1);
+	for(int i = 0; i < count; ++i)
+	{
+		const long v = (long)(int)(rand() * 2654435761u) >> (rand() % 31);
+		StrPrint a, b;
+		OldPrint(a).print(v);
+		b.print(v);
+		longDiffs += (a.s != b.s);
+
+		const double d = ((double)rand() / RAND_MAX - 0.5) * pow(10, rand() % 12 - 3);
+		const int digits = rand() % 8;
+		StrPrint c, e;
+		OldPrint(c).print(d, digits);
+		e.print(d, digits);
+		if(c.s != e.s)
+		{
+			if(doubleDiffs < 5)
+			{
+				printf("  print(%.17g, %d): old %s, new %s\n", d, digits, c.s.c_str(), e.s.c_str());
+			}
+			doubleDiffs++;
+		}
+	}
+	printf("print(long) differs in %d of %d values, print(double) in %d\n\n", longDiffs, count, doubleDiffs);
+}
+
+int main()
+{
+	compare(200000);
+
+	NullPrint out;
+	OldPrint old(out);
+	const int N = 2000000;
+	volatile size_t sink = 0;
+	double t;
+
+	t = seconds();
+	for(int i = 0; i < N; ++i) sink += old.print(i * 7919L - 1000000);
+	printf("print(long)      old %6.1f ns  ", (seconds() - t) / N * 1e9);
+	t = seconds();
+	for(int i = 0; i < N; ++i) sink += out.print(i * 7919L - 1000000);
+	printf("new %6.1f ns\n", (seconds() - t) / N * 1e9);
+
+	t = seconds();
+	for(int i = 0; i < N; ++i) sink += old.print(i * 0.37 - 5000, 4);
+	printf("print(double, 4) old %6.1f ns  ", (seconds() - t) / N * 1e9);
+	t = seconds();
+	for(int i = 0; i < N; ++i) sink += out.print(i * 0.37 - 5000, 4);
+	printf("new %6.1f ns\n", (seconds() - t) / N * 1e9);
+
+	t = seconds();
+	for(int i = 0; i < N; ++i) sink += old.printf("t=%lu v=%d s=%s x=%04x", (unsigned long)i, -i, "abc", i & 0xffff);
+	printf("printf, 4 fields old %6.1f ns  ", (seconds() - t) / N * 1e9);
+	t = seconds();
+	for(int i = 0; i < N; ++i) sink += out.printf("t=%lu v=%d s=%s x=%04x", (unsigned long)i, -i, "abc", i & 0xffff);
+	printf("new %6.1f ns\n", (seconds() - t) / N * 1e9);
+	return 0;
+}
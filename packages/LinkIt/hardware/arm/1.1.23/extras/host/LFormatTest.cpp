@@ -0,0 +1,168 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+// Host test of Print::printf() and the LFormat conversions against the C
+// library's vsnprintf(). From the platform folder:
+//
+//   gcc -c cores/arduino/itoa.c cores/arduino/avr/dtostrf.c
+//   g++ -std=gnu++98 -O2 -Icores/arduino -Ivariants/linkit_one -Isystem/libmtk -Isystem/libmtk/include
+//       cores/arduino/Print.cpp cores/arduino/LFormat.cpp cores/arduino/WString.cpp itoa.o dtostrf.o
+//       extras/host/LFormatTest.cpp -o lformat_test
+//   ./lformat_test
+//
+// It prints the cases that differ and exits with 1 if there are any.
+// Floats are converted in double precision, see LFormat.h, so their last
+// digits may differ from the C library's exact expansion; such output is
+// accepted when it reads back within two units in the last place.
+
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "Print.h"
+#include "LFormat.h"
+
+// collects what is printed
+class StrPrint : public Print
+{
+public:
+	std::string s;
+	virtual size_t write(uint8_t c) { s += (char)c; return 1; }
+	virtual size_t write(const uint8_t *buffer, size_t size) { s.append((const char*)buffer, size); return size; }
+};
+
+static int s_cases = 0;
+static int s_failures = 0;
+static int s_rounded = 0;
+
+// true if got and want read as numbers at most two units in the last place
+// of a double apart, with the same text around them
+static bool closeEnough(const char *got, const char *want)
+{
+	char *gotEnd;
+	char *wantEnd;
+	const double a = strtod(got, &gotEnd);
+	const double b = strtod(want, &wantEnd);
+	if(gotEnd == got || wantEnd == want || strcmp(gotEnd, wantEnd) != 0)
+	{
+		return false;
+	}
+	return fabs(a - b) <= 2 * DBL_EPSILON * fabs(b);
+}
+
+// prints fmt with both and compares; float conversions may differ from the
+// C library in the last digits
+static void check(bool isFloat, const char *fmt, ...)
+{
+	va_list args, copy;
+	va_start(args, fmt);
+	va_copy(copy, args);
+	char want[4096];
+	vsnprintf(want, sizeof(want), fmt, args);
+	StrPrint out;
+	const size_t n = out.vprintf(fmt, copy);
+	va_end(copy);
+	va_end(args);
+
+	s_cases++;
+	if(n == out.s.size() && out.s == want)
+	{
+		return;
+	}
+	if(n == out.s.size() && isFloat && closeEnough(out.s.c_str(), want))
+	{
+		s_rounded++;
+		return;
+	}
+	s_failures++;
+	printf("FAIL \"%s\": got \"%s\", want \"%s\"\n", fmt, out.s.c_str(), want);
+}
+
+static void testIntegers()
+{
+	const int values[] = {0, 1, -1, 9, 10, 99, 100, 12345, -12345, INT_MAX, INT_MIN, 1000000000};
+	const char *formats[] = {"%d", "%5d", "%-5d|", "%05d", "%+d", "% d", "%.3d", "%8.3d", "%.0d", "%x",
+		"%#x", "%#X", "%o", "%#o", "%#.0o", "%u", "%hhd", "%hd", "%*d", "%-*d|"};
+	for(size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+	{
+		for(size_t j = 0; j < sizeof(formats) / sizeof(formats[0]); ++j)
+		{
+			if(strchr(formats[j], '*'))
+			{
+				check(false, formats[j], 7, values[i]);
+			}
+			else
+			{
+				check(false, formats[j], values[i]);
+			}
+		}
+	}
+
+	const long long wide[] = {0, 1, -1, 4294967295LL, 4294967296LL, 123456789012345LL, LLONG_MAX, LLONG_MIN};
+	for(size_t i = 0; i < sizeof(wide) / sizeof(wide[0]); ++i)
+	{
+		check(false, "%lld", wide[i]);
+		check(false, "%llx", wide[i]);
+		check(false, "%llu", wide[i]);
+		check(false, "%20lld|", wide[i]);
+		check(false, "%llo", wide[i]);
+	}
+	check(false, "%ld %lu %zu", -5L, 7UL, (size_t)9);
+}
+
+static void testFloats()
+{
+	const double values[] = {0, -0.0, 1, -1, 0.5, 0.125, 1.999, 3.14159265358979, 1e-5, 123456.789,
+		4294967295.9, 4294967296.5, 1e15, 1e18, 9.99e18, 1.5e19, 1e22, 1e100, 1.7976931348623157e308,
+		1e-300, 5e-324, 2.5, 0.05, 99.995, 1.0 / 3, 100, 0.0001234, 123456789.0};
+	const char *formats[] = {"%f", "%.0f", "%.1f", "%.2f", "%.9f", "%.12f", "%10.3f", "%-10.3f|", "%010.3f",
+		"%+f", "% f", "%#.0f", "%e", "%.0e", "%.3e", "%E", "%12.4e", "%g", "%G", "%.3g", "%.10g", "%#g",
+		"%.0g", "%010g", "%.17g"};
+	for(size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+	{
+		for(size_t j = 0; j < sizeof(formats) / sizeof(formats[0]); ++j)
+		{
+			check(true, formats[j], values[i]);
+		}
+	}
+	check(true, "%f %F %e %g", INFINITY, -INFINITY, NAN, INFINITY);
+	check(true, "%5f|%-6F|", INFINITY, NAN);
+}
+
+static void testStrings()
+{
+	check(false, "%s|%10s|%-10s|%.2s|%c|%5c|%%", "abc", "abc", "abc", "abc", 'x', 'y');
+	check(false, "%.3s", "ab");
+	check(false, "no conversions");
+	check(false, "%d%s%d", 1, "two", 3);
+
+	// longer than the 256 bytes the old printf() had on the stack
+	const std::string big(1000, 'z');
+	check(false, "[%s]", big.c_str());
+	check(false, "%1000d", 5);
+	check(false, "%s %s %s", big.c_str(), big.c_str(), big.c_str());
+}
+
+int main()
+{
+	testIntegers();
+	testFloats();
+	testStrings();
+	printf("%d cases, %d differ from vsnprintf, %d more only in the last digits of a float\n",
+		s_cases, s_failures, s_rounded);
+	return s_failures ? 1 : 0;
+}
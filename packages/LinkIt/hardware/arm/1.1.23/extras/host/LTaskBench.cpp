@@ -0,0 +1,168 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+// Host throughput benchmark of LTask remote calls, on the pthread stand-ins
+// of LVmHost. It compares the ring of LTask.cpp with the path it replaced,
+// which took a mutex, sent one message per call and waited for a signal.
+// From the platform folder:
+//
+//   g++ -std=gnu++98 -O2 -Icores/arduino -Ivariants/linkit_one -Isystem/libmtk -Isystem/libmtk/include
+//       cores/arduino/LTask.cpp extras/host/LVmHost.cpp extras/host/LTaskBench.cpp -lpthread -o ltask_bench
+//   ./ltask_bench [calls]
+//
+// The numbers measure thread hand-offs on the host, not on the board;
+// what carries over is the ratio and the messages needed per call.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "LTask.h"
+#include "LVmHost.h"
+
+// remoteCall() as it was before the ring: one message per call,
+// serialized by the instance mutex
+class MutexTask
+{
+public:
+	void begin()
+	{
+		vm_mutex_create(&m_mutex);
+		m_handle = vm_thread_get_main_handle();
+		m_signal = vm_signal_init();
+	}
+
+	void remoteCall(remote_call_ptr func, void* userdata)
+	{
+		vm_mutex_lock(&m_mutex);
+		m_msg.remote_func = func;
+		m_msg.userdata = userdata;
+		m_msg.signal = m_signal;
+		vm_thread_send_msg(m_handle, VM_MSG_ARDUINO_CALL, &m_msg);
+		vm_signal_wait(m_signal);
+		vm_mutex_unlock(&m_mutex);
+	}
+
+private:
+	vm_thread_mutex_struct m_mutex;
+	msg_struct m_msg;
+	VM_THREAD_HANDLE m_handle;
+	VM_SIGNAL_ID m_signal;
+};
+
+// the ring sends no user data; the old path sent its message slot
+static void onMessage(VMUINT32 msgId, void *userData)
+{
+	if(msgId != VM_MSG_ARDUINO_CALL)
+	{
+		return;
+	}
+	if(userData == NULL)
+	{
+		_LTaskClass::drain();
+		return;
+	}
+
+	msg_struct* pMsg = (msg_struct*)userData;
+	if(pMsg->remote_func(pMsg->userdata))
+	{
+		vm_signal_post(pMsg->signal);
+	}
+}
+
+// remote_call_ptr; the cheapest possible handler
+static boolean nop(void *userdata)
+{
+	++*(volatile unsigned long*)userdata;
+	return true;
+}
+
+static double seconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void report(const char *name, unsigned long calls, double elapsed, unsigned long messages, unsigned long handled)
+{
+	printf("%-34s %10.0f calls/s %6.3f msgs/call%s\n", name, calls / elapsed,
+		(double)messages / calls, handled == calls ? "" : "  (handler count mismatch)");
+}
+
+static void benchMutex(unsigned long calls)
+{
+	MutexTask task;
+	task.begin();
+	volatile unsigned long handled = 0;
+
+	const unsigned long before = LVmHost::messages();
+	const double start = seconds();
+	for(unsigned long i = 0; i < calls; ++i)
+	{
+		task.remoteCall(nop, (void*)&handled);
+	}
+	report("mutex + message per call", calls, seconds() - start, LVmHost::messages() - before, handled);
+}
+
+static void benchRing(unsigned long calls)
+{
+	volatile unsigned long handled = 0;
+
+	const unsigned long before = LVmHost::messages();
+	const double start = seconds();
+	for(unsigned long i = 0; i < calls; ++i)
+	{
+		LTask.remoteCall(nop, (void*)&handled);
+	}
+	report("ring, remoteCall", calls, seconds() - start, LVmHost::messages() - before, handled);
+}
+
+// under load: LTASK_MAX_PENDING_CALLS calls in flight at a time
+static void benchRingAsync(unsigned long calls)
+{
+	volatile unsigned long handled = 0;
+	LTaskCallToken tokens[LTASK_MAX_PENDING_CALLS];
+	calls -= calls % LTASK_MAX_PENDING_CALLS;
+
+	const unsigned long before = LVmHost::messages();
+	const double start = seconds();
+	for(unsigned long i = 0; i < calls; i += LTASK_MAX_PENDING_CALLS)
+	{
+		for(int j = 0; j < LTASK_MAX_PENDING_CALLS; ++j)
+		{
+			tokens[j] = LTask.remoteCallAsync(nop, (void*)&handled);
+		}
+		for(int j = 0; j < LTASK_MAX_PENDING_CALLS; ++j)
+		{
+			LTask.remoteCallWait(tokens[j]);
+		}
+	}
+	report("ring, remoteCallAsync x8 in flight", calls, seconds() - start, LVmHost::messages() - before, handled);
+}
+
+int main(int argc, char *argv[])
+{
+	const unsigned long calls = (argc > 1) ? strtoul(argv[1], NULL, 10) : 200000;
+
+	LVmHost::start(onMessage);
+	// one run of each to warm up, then the measured runs
+	benchMutex(calls / 10);
+	benchRing(calls / 10);
+	printf("\n");
+	benchMutex(calls);
+	benchRing(calls);
+	benchRingAsync(calls);
+	LVmHost::stop();
+	return 0;
+}
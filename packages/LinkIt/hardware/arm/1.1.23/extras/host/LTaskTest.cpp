@@ -0,0 +1,176 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+// Host test of LTask remote calls, on the pthread stand-ins of LVmHost.
+// From the platform folder:
+//
+//   g++ -std=gnu++98 -O2 -Icores/arduino -Ivariants/linkit_one -Isystem/libmtk -Isystem/libmtk/include
+//       cores/arduino/LTask.cpp extras/host/LVmHost.cpp extras/host/LTaskTest.cpp -lpthread -o ltask_test
+//   ./ltask_test
+//
+// It prints one line per case and exits with 1 if any of them failed.
+
+#include <pthread.h>
+#include <stdio.h>
+#include "LTask.h"
+#include "LVmHost.h"
+
+static int s_failures = 0;
+static pthread_t s_mmiThread;
+static bool s_mmiKnown = false;
+
+static void check(bool ok, const char *name)
+{
+	printf("%s %s\n", ok ? "ok  " : "FAIL", name);
+	if(!ok)
+	{
+		s_failures++;
+	}
+}
+
+// what main.cpp does with the messages of the MMI thread
+static void onMessage(VMUINT32 msgId, void * /* userData */)
+{
+	if(msgId == VM_MSG_ARDUINO_CALL)
+	{
+		s_mmiThread = pthread_self();
+		s_mmiKnown = true;
+		_LTaskClass::drain();
+	}
+}
+
+struct Call
+{
+	int order;
+	bool onMmi;
+};
+
+static int s_order = 0;
+
+// remote_call_ptr; runs on the MMI thread
+static boolean record(void *userdata)
+{
+	Call *call = (Call*)userdata;
+	call->order = ++s_order;
+	call->onMmi = s_mmiKnown && pthread_equal(pthread_self(), s_mmiThread);
+	return true;
+}
+
+static void testRemoteCall()
+{
+	Call call = {0, false};
+	const unsigned long before = LVmHost::messages();
+	LTask.remoteCall(record, &call);
+	check(call.order != 0 && call.onMmi && LVmHost::messages() == before + 1, "remoteCall runs on the MMI thread");
+}
+
+static pthread_mutex_t s_gateLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_gateCond = PTHREAD_COND_INITIALIZER;
+static bool s_gateOpen = false;
+static bool s_gateReached = false;
+
+// remote_call_ptr; keeps the MMI thread busy until the test opens the gate
+static boolean gate(void *userdata)
+{
+	pthread_mutex_lock(&s_gateLock);
+	s_gateReached = true;
+	pthread_cond_broadcast(&s_gateCond);
+	while(!s_gateOpen)
+	{
+		pthread_cond_wait(&s_gateCond, &s_gateLock);
+	}
+	pthread_mutex_unlock(&s_gateLock);
+	return record(userdata);
+}
+
+// calls queued while the MMI thread is busy complete in the same hop.
+// The previous call may still be leaving drain() when the first one is
+// queued, so that one may need no message at all.
+static void testOneHop()
+{
+	Call calls[LTASK_MAX_PENDING_CALLS];
+	LTaskCallToken tokens[LTASK_MAX_PENDING_CALLS];
+	s_order = 0;
+	for(int i = 0; i < LTASK_MAX_PENDING_CALLS; ++i)
+	{
+		calls[i].order = 0;
+		calls[i].onMmi = false;
+	}
+
+	const unsigned long before = LVmHost::messages();
+	tokens[0] = LTask.remoteCallAsync(gate, &calls[0]);
+	pthread_mutex_lock(&s_gateLock);
+	while(!s_gateReached)
+	{
+		pthread_cond_wait(&s_gateCond, &s_gateLock);
+	}
+	pthread_mutex_unlock(&s_gateLock);
+
+	bool queued = (tokens[0] != LTASK_INVALID_CALL);
+	for(int i = 1; i < LTASK_MAX_PENDING_CALLS; ++i)
+	{
+		tokens[i] = LTask.remoteCallAsync(record, &calls[i]);
+		queued = queued && tokens[i] != LTASK_INVALID_CALL && !LTask.remoteCallDone(tokens[i]);
+	}
+	const bool poolFull = (LTask.remoteCallAsync(record, NULL) == LTASK_INVALID_CALL);
+
+	pthread_mutex_lock(&s_gateLock);
+	s_gateOpen = true;
+	pthread_cond_broadcast(&s_gateCond);
+	pthread_mutex_unlock(&s_gateLock);
+
+	bool done = true;
+	for(int i = 0; i < LTASK_MAX_PENDING_CALLS; ++i)
+	{
+		done = LTask.remoteCallWait(tokens[i]) && done;
+		done = done && calls[i].order == i + 1 && calls[i].onMmi;
+	}
+	const unsigned long hops = LVmHost::messages() - before;
+	printf("     %d calls, %lu message(s)\n", LTASK_MAX_PENDING_CALLS, hops);
+	check(queued && poolFull, "remoteCallAsync queues up to LTASK_MAX_PENDING_CALLS");
+	check(done && hops <= 1, "queued calls complete in order in one hop");
+	check(!LTask.remoteCallDone(tokens[0]) && !LTask.remoteCallWait(tokens[0]), "a collected token is stale");
+}
+
+// remote_call_ptr; runs on the MMI thread
+static boolean step(void *userdata)
+{
+	int *count = (int*)userdata;
+	++*count;
+	return true;
+}
+
+static void testBatch()
+{
+	LTaskBatch batch;
+	int count = 0;
+	for(int i = 0; i < LTASK_MAX_BATCH_STEPS; ++i)
+	{
+		batch.add(step, &count);
+	}
+	const unsigned long before = LVmHost::messages();
+	const int completed = LTask.batch(batch);
+	check(completed == LTASK_MAX_BATCH_STEPS && count == LTASK_MAX_BATCH_STEPS &&
+		LVmHost::messages() <= before + 1, "batch runs all steps in one hop");
+}
+
+int main()
+{
+	LVmHost::start(onMessage);
+	testRemoteCall();
+	testOneHop();
+	testBatch();
+	LVmHost::stop();
+	return s_failures ? 1 : 0;
+}
@@ -0,0 +1,298 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+// Host test of LTlsClient, on the pthread stand-ins of LVmHost and the
+// vmtls.h stand-ins of LTlsHost. From the platform folder:
+//
+//   gcc -c cores/arduino/itoa.c cores/arduino/avr/dtostrf.c
+//   g++ -std=gnu++98 -O2 -Icores/arduino -Ivariants/linkit_one -Isystem/libmtk -Isystem/libmtk/include
+//       -include extras/host/LTlsHost.h cores/arduino/LTlsClient.cpp cores/arduino/LDnsCache.cpp
+//       cores/arduino/LRingBuffer.cpp cores/arduino/LTask.cpp cores/arduino/Stream.cpp cores/arduino/Print.cpp
+//       cores/arduino/LFormat.cpp cores/arduino/WString.cpp cores/arduino/IPAddress.cpp itoa.o dtostrf.o
+//       extras/host/LVmHost.cpp extras/host/LTlsHost.cpp extras/host/LTlsClientTest.cpp -lpthread -o ltls_test
+//   ./ltls_test
+//
+// It prints one line per case and exits with 1 if any of them failed.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include "LTask.h"
+#include "LTlsClient.h"
+#include "LTlsHost.h"
+#include "LVmHost.h"
+#include "vmconn.h"
+#include "vmlog.h"
+
+// LDnsCache.cpp needs it; the cases connect to addresses, not names
+VMINT vm_soc_get_host_by_name_ex(VMINT, const VMCHAR *, vm_soc_dns_result *,
+	VMINT (*)(VMINT, vm_soc_dns_result *, void *), void *)
+{
+	return -1;
+}
+
+// logging is off
+int _vm_log_module(const char *, const int) { return 0; }
+void _vm_log_info(char *, ...) {}
+void _vm_log_error(char *, ...) {}
+
+uint32_t millis(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+
+void delay(uint32_t ms)
+{
+	usleep(ms * 1000);
+}
+
+// LTlsClient with the part LWiFiTlsClient and LGPRSTlsClient add
+class TestTlsClient : public LTlsClient
+{
+protected:
+	virtual VMINT getAPN() const { return 0; }
+};
+
+static int s_failures = 0;
+
+static void check(bool ok, const char *name)
+{
+	printf("%s %s\n", ok ? "ok  " : "FAIL", name);
+	if(!ok)
+	{
+		s_failures++;
+	}
+}
+
+// what main.cpp does with the messages of the MMI thread
+static void onMessage(VMUINT32 msgId, void *userData)
+{
+	if(msgId == VM_MSG_ARDUINO_CALL)
+	{
+		_LTaskClass::drain();
+	}
+	else
+	{
+		LTlsHost::handle(msgId, userData);
+	}
+}
+
+static std::string pattern(size_t len)
+{
+	std::string s;
+	for(size_t i = 0; i < len; ++i)
+	{
+		s += (char)('a' + i % 26);
+	}
+	return s;
+}
+
+static void testConnect()
+{
+	TestTlsClient client;
+	const int created = LTlsHost::contextsCreated();
+	const int handshakes = LTlsHost::handshakes();
+	const int ok = client.connect(IPAddress(10, 0, 0, 1), 443);
+	const VMINT ctx = LTlsHost::lastContext();
+	check(ok == 1 && client.connected() && !client.reusedContext() && LTlsHost::contextsCreated() == created + 1 &&
+		LTlsHost::handshakes() == handshakes + 1 && LTlsHost::peerName(ctx) == "10.0.0.1",
+		"connect() creates a context and completes the handshake");
+	client.stop();
+	check(!client.connected() && LTlsHost::contextAlive(ctx), "stop() keeps the context");
+
+	LTlsHost::failHandshakes(true);
+	const int failed = client.connect(IPAddress(10, 0, 0, 99), 443);
+	LTlsHost::failHandshakes(false);
+	check(failed == 0 && !client.connected() && !LTlsHost::contextAlive(LTlsHost::lastContext()),
+		"a failed handshake deletes its context");
+}
+
+// both rings are smaller than the data, so it passes through them in pieces
+static void testReadWrite()
+{
+	TestTlsClient client;
+	client.setBufferSizes(64, 64);
+	client.connect(IPAddress(10, 0, 0, 2), 443);
+	const VMINT ctx = LTlsHost::lastContext();
+
+	const std::string request = pattern(300);
+	LTlsHost::setWriteLimit(16);
+	const size_t written = client.write((const uint8_t*)request.data(), request.size());
+	client.flush();
+	LTlsHost::setWriteLimit(0);
+	check(written == request.size() && LTlsHost::serverReceived(ctx) == request,
+		"write() and flush() send everything through the transmit ring");
+
+	const std::string response = pattern(1000);
+	LTlsHost::serverWrite(ctx, response.data(), response.size());
+	std::string got;
+	uint8_t buf[50];
+	while(got.size() < response.size() && client.waitAvailable(1000))
+	{
+		const int n = client.read(buf, sizeof(buf));
+		got.append((const char*)buf, n);
+	}
+	check(got == response, "read() receives everything through the receive ring");
+	client.stop();
+}
+
+struct DelayedWrite
+{
+	VMINT ctx;
+	unsigned long delayMs;
+};
+
+static void *writeLater(void *arg)
+{
+	const DelayedWrite *pWrite = (const DelayedWrite*)arg;
+	usleep(pWrite->delayMs * 1000);
+	LTlsHost::serverWrite(pWrite->ctx, "late", 4);
+	return NULL;
+}
+
+static void testWaitAvailable()
+{
+	TestTlsClient client;
+	client.connect(IPAddress(10, 0, 0, 3), 443);
+	const VMINT ctx = LTlsHost::lastContext();
+
+	unsigned long start = millis();
+	const bool none = client.waitAvailable(100);
+	const unsigned long timedOut = millis() - start;
+	check(!none && timedOut >= 100 && timedOut < 1000, "waitAvailable() times out without data");
+
+	DelayedWrite later = {ctx, 50};
+	pthread_t thread;
+	pthread_create(&thread, NULL, writeLater, &later);
+	start = millis();
+	const bool woken = client.waitAvailable(5000);
+	const unsigned long waited = millis() - start;
+	pthread_join(thread, NULL);
+	printf("     woken by VM_TLS_READ after %lu ms\n", waited);
+	check(woken && waited < 1000 && client.available() == 4, "waitAvailable() wakes on VM_TLS_READ");
+
+	// data sent before the close can still be read, then the wait ends
+	LTlsHost::serverWrite(ctx, "bye", 3);
+	LTlsHost::serverClose(ctx);
+	char buf[16];
+	std::string got;
+	start = millis();
+	while(client.waitAvailable(5000))
+	{
+		const int n = client.read((uint8_t*)buf, sizeof(buf));
+		got.append(buf, n);
+	}
+	check(got == "latebye" && millis() - start < 1000 && !client.connected(),
+		"waitAvailable() returns false once a closed connection is read");
+	client.stop();
+	check(!LTlsHost::contextAlive(ctx), "a closed connection deletes its context");
+}
+
+// the cache holds LTLS_SESSION_CACHE_SIZE contexts and evicts the one
+// unused for the longest time
+static void testSessionCache()
+{
+	LTlsClient::clearSessions();
+	TestTlsClient client;
+	VMINT ctx[LTLS_SESSION_CACHE_SIZE + 1];
+
+	for(int i = 0; i < LTLS_SESSION_CACHE_SIZE; ++i)
+	{
+		client.connect(IPAddress(10, 0, 1, i), 443);
+		ctx[i] = LTlsHost::lastContext();
+		client.stop();
+		delay(2);
+	}
+
+	const int created = LTlsHost::contextsCreated();
+	const int reusedHandshakes = LTlsHost::handshakesOnUsedContext();
+	client.connect(IPAddress(10, 0, 1, 0), 443);
+	check(client.reusedContext() && LTlsHost::contextsCreated() == created &&
+		LTlsHost::handshakesOnUsedContext() == reusedHandshakes + 1, "connecting again reuses the context");
+	client.stop();
+	delay(2);
+
+	client.connect(IPAddress(10, 0, 1, 0), 444);
+	check(!client.reusedContext(), "another port gets its own context");
+	ctx[LTLS_SESSION_CACHE_SIZE] = LTlsHost::lastContext();
+	client.stop();
+
+	// server 0 was used last, so server 1 was evicted
+	bool others = true;
+	for(int i = 2; i <= LTLS_SESSION_CACHE_SIZE; ++i)
+	{
+		others = others && LTlsHost::contextAlive(ctx[i]);
+	}
+	check(!LTlsHost::contextAlive(ctx[1]) && LTlsHost::contextAlive(ctx[0]) && others,
+		"a full cache evicts the context unused the longest");
+
+	client.connect(IPAddress(10, 0, 1, 1), 443);
+	check(!client.reusedContext(), "an evicted server gets a new context");
+	client.stop();
+
+	// a connection the server closed leaves a context that is not reused
+	client.connect(IPAddress(10, 0, 1, 2), 443);
+	const VMINT broken = LTlsHost::lastContext();
+	LTlsHost::serverClose(broken);
+	while(client.connected())
+	{
+		client.waitAvailable(100);
+	}
+	client.stop();
+	client.connect(IPAddress(10, 0, 1, 2), 443);
+	check(!LTlsHost::contextAlive(broken) && !client.reusedContext(), "a broken context is deleted, not reused");
+	client.stop();
+
+	LTlsClient::clearSessions();
+	bool cleared = true;
+	for(int i = 0; i <= LTLS_SESSION_CACHE_SIZE; ++i)
+	{
+		cleared = cleared && !LTlsHost::contextAlive(ctx[i]);
+	}
+	check(cleared, "clearSessions() deletes the idle contexts");
+}
+
+// every context in use: one more connection fails
+static void testAllInUse()
+{
+	TestTlsClient clients[LTLS_SESSION_CACHE_SIZE + 1];
+	bool opened = true;
+	for(int i = 0; i < LTLS_SESSION_CACHE_SIZE; ++i)
+	{
+		opened = opened && clients[i].connect(IPAddress(10, 0, 2, i), 443);
+	}
+	const int extra = clients[LTLS_SESSION_CACHE_SIZE].connect(IPAddress(10, 0, 2, 99), 443);
+	check(opened && extra == 0, "connections beyond LTLS_SESSION_CACHE_SIZE fail");
+	for(int i = 0; i < LTLS_SESSION_CACHE_SIZE; ++i)
+	{
+		clients[i].stop();
+	}
+}
+
+int main()
+{
+	LVmHost::start(onMessage);
+	testConnect();
+	testReadWrite();
+	testWaitAvailable();
+	testSessionCache();
+	testAllInUse();
+	LTlsClient::clearSessions();
+	LVmHost::stop();
+	return s_failures ? 1 : 0;
+}
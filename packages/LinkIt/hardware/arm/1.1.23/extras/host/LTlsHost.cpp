@@ -0,0 +1,388 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include <pthread.h>
+#include <string.h>
+#include <map>
+#include "LTlsHost.h"
+#include "vmconn.h"
+#include "vmthread.h"
+
+// a context and the simulated server of its connection
+struct LTlsHostContext
+{
+	callback_t callback;
+	bool alive;
+	bool handshaked;        // a handshake completed on it
+	bool peerClosed;
+	bool writeBlocked;      // waiting for VM_TLS_WRITE
+	std::string toClient;
+	std::string fromClient;
+	std::string peerName;
+};
+
+// any of the events LTlsClient.cpp handles
+union LTlsHostEvent
+{
+	vm_tls_event_struct header;
+	vm_tls_soc_notify_ind_struct soc;
+	vm_tls_notify_ind_struct tls;
+};
+
+// one lock for all contexts; the test thread and the MMI thread use them
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static std::map<VMINT, LTlsHostContext> s_contexts;
+static VMINT s_nextContext = 1;
+static VMINT s_lastContext = -1;
+static size_t s_writeLimit = 0;
+static bool s_failHandshakes = false;
+static int s_created = 0;
+static int s_deleted = 0;
+static int s_handshakes = 0;
+static int s_handshakesOnUsed = 0;
+
+// the context of ctx if it is alive, else NULL; s_lock held
+static LTlsHostContext *contextFromId(VMINT ctx)
+{
+	std::map<VMINT, LTlsHostContext>::iterator it = s_contexts.find(ctx);
+	if(it == s_contexts.end() || !it->second.alive)
+	{
+		return NULL;
+	}
+	return &it->second;
+}
+
+static void sendSocEvent(VMINT ctx, vm_soc_event_enum type, VMINT result)
+{
+	LTlsHostEvent *pEvent = new LTlsHostEvent;
+	memset(pEvent, 0, sizeof(*pEvent));
+	pEvent->soc.msg = VM_MSG_ID_APP_SOC_NOTIFY_IND;
+	pEvent->soc.res_id = ctx;
+	pEvent->soc.event_type = type;
+	pEvent->soc.result = result;
+	vm_thread_send_msg(vm_thread_get_main_handle(), LTLSHOST_MSG_EVENT, pEvent);
+}
+
+static void sendTlsEvent(VMINT ctx, vm_tls_event_enum event, VMINT result)
+{
+	LTlsHostEvent *pEvent = new LTlsHostEvent;
+	memset(pEvent, 0, sizeof(*pEvent));
+	pEvent->tls.msg = VM_MSG_ID_APP_TLS_NOTIFY_IND;
+	pEvent->tls.res_id = ctx;
+	pEvent->tls.event = event;
+	pEvent->tls.result = result;
+	vm_thread_send_msg(vm_thread_get_main_handle(), LTLSHOST_MSG_EVENT, pEvent);
+}
+
+bool LTlsHost::handle(VMUINT32 msgId, void *userData)
+{
+	if(msgId != LTLSHOST_MSG_EVENT)
+	{
+		return false;
+	}
+
+	LTlsHostEvent *pEvent = (LTlsHostEvent*)userData;
+	callback_t callback = NULL;
+	pthread_mutex_lock(&s_lock);
+	LTlsHostContext *pContext = contextFromId(pEvent->header.res_id);
+	if(pContext)
+	{
+		callback = pContext->callback;
+		if(pEvent->header.msg == VM_MSG_ID_APP_TLS_NOTIFY_IND)
+		{
+			if(pEvent->tls.event == VM_TLS_HANDSHAKE_DONE && pEvent->tls.result)
+			{
+				pContext->handshaked = true;
+			}
+			else if(pEvent->tls.event == VM_TLS_WRITE)
+			{
+				pContext->writeBlocked = false;
+			}
+		}
+	}
+	pthread_mutex_unlock(&s_lock);
+
+	// events of a deleted context are dropped, as the platform does
+	if(callback)
+	{
+		callback(&pEvent->header);
+	}
+	delete pEvent;
+	return true;
+}
+
+void LTlsHost::serverWrite(VMINT ctx, const char *data, size_t len)
+{
+	pthread_mutex_lock(&s_lock);
+	LTlsHostContext *pContext = contextFromId(ctx);
+	if(pContext)
+	{
+		pContext->toClient.append(data, len);
+	}
+	pthread_mutex_unlock(&s_lock);
+	if(pContext)
+	{
+		sendTlsEvent(ctx, VM_TLS_READ, 1);
+	}
+}
+
+void LTlsHost::serverClose(VMINT ctx)
+{
+	pthread_mutex_lock(&s_lock);
+	LTlsHostContext *pContext = contextFromId(ctx);
+	if(pContext)
+	{
+		pContext->peerClosed = true;
+	}
+	pthread_mutex_unlock(&s_lock);
+	if(pContext)
+	{
+		sendTlsEvent(ctx, VM_TLS_CLOSE, 1);
+	}
+}
+
+std::string LTlsHost::serverReceived(VMINT ctx)
+{
+	pthread_mutex_lock(&s_lock);
+	std::map<VMINT, LTlsHostContext>::iterator it = s_contexts.find(ctx);
+	const std::string received = (it == s_contexts.end()) ? std::string() : it->second.fromClient;
+	pthread_mutex_unlock(&s_lock);
+	return received;
+}
+
+void LTlsHost::setWriteLimit(size_t bytes)
+{
+	pthread_mutex_lock(&s_lock);
+	s_writeLimit = bytes;
+	pthread_mutex_unlock(&s_lock);
+}
+
+void LTlsHost::failHandshakes(bool fail)
+{
+	pthread_mutex_lock(&s_lock);
+	s_failHandshakes = fail;
+	pthread_mutex_unlock(&s_lock);
+}
+
+VMINT LTlsHost::lastContext()
+{
+	pthread_mutex_lock(&s_lock);
+	const VMINT ctx = s_lastContext;
+	pthread_mutex_unlock(&s_lock);
+	return ctx;
+}
+
+bool LTlsHost::contextAlive(VMINT ctx)
+{
+	pthread_mutex_lock(&s_lock);
+	const bool alive = (contextFromId(ctx) != NULL);
+	pthread_mutex_unlock(&s_lock);
+	return alive;
+}
+
+std::string LTlsHost::peerName(VMINT ctx)
+{
+	pthread_mutex_lock(&s_lock);
+	std::map<VMINT, LTlsHostContext>::iterator it = s_contexts.find(ctx);
+	const std::string name = (it == s_contexts.end()) ? std::string() : it->second.peerName;
+	pthread_mutex_unlock(&s_lock);
+	return name;
+}
+
+int LTlsHost::contextsCreated()
+{
+	pthread_mutex_lock(&s_lock);
+	const int count = s_created;
+	pthread_mutex_unlock(&s_lock);
+	return count;
+}
+
+int LTlsHost::contextsDeleted()
+{
+	pthread_mutex_lock(&s_lock);
+	const int count = s_deleted;
+	pthread_mutex_unlock(&s_lock);
+	return count;
+}
+
+int LTlsHost::handshakes()
+{
+	pthread_mutex_lock(&s_lock);
+	const int count = s_handshakes;
+	pthread_mutex_unlock(&s_lock);
+	return count;
+}
+
+int LTlsHost::handshakesOnUsedContext()
+{
+	pthread_mutex_lock(&s_lock);
+	const int count = s_handshakesOnUsed;
+	pthread_mutex_unlock(&s_lock);
+	return count;
+}
+
+extern "C" {
+
+VMINT vm_tls_new_ctx(vm_tls_version_enum /* ver */, vm_socket_type_enum /* sock_type */, VMINT /* apn */,
+	vm_tls_side_enum /* side */, callback_t cb)
+{
+	pthread_mutex_lock(&s_lock);
+	// ids are not reused, so late events of a deleted context find nothing
+	const VMINT ctx = s_nextContext++;
+	s_lastContext = ctx;
+	LTlsHostContext &context = s_contexts[ctx];
+	context.callback = cb;
+	context.alive = true;
+	context.handshaked = false;
+	context.peerClosed = false;
+	context.writeBlocked = false;
+	s_created++;
+	pthread_mutex_unlock(&s_lock);
+	return ctx;
+}
+
+VMINT vm_tls_delete_ctx(VMINT res_id)
+{
+	pthread_mutex_lock(&s_lock);
+	LTlsHostContext *pContext = contextFromId(res_id);
+	if(pContext)
+	{
+		pContext->alive = false;
+		s_deleted++;
+	}
+	pthread_mutex_unlock(&s_lock);
+	return pContext ? VM_TLS_ERR_NONE : VM_TLS_ERR_INVALID_CONTEXT;
+}
+
+VMINT vm_tls_check_peer_name(VMINT res_id, const VMCHAR *name)
+{
+	pthread_mutex_lock(&s_lock);
+	LTlsHostContext *pContext = contextFromId(res_id);
+	if(pContext)
+	{
+		pContext->peerName = name;
+	}
+	pthread_mutex_unlock(&s_lock);
+	return pContext ? VM_TLS_ERR_NONE : VM_TLS_ERR_INVALID_CONTEXT;
+}
+
+VMINT vm_tls_new_conn(VMINT res_id, vm_sockaddr_ex_struct * /* faddr */)
+{
+	pthread_mutex_lock(&s_lock);
+	LTlsHostContext *pContext = contextFromId(res_id);
+	if(pContext)
+	{
+		pContext->peerClosed = false;
+		pContext->writeBlocked = false;
+		pContext->toClient.clear();
+		pContext->fromClient.clear();
+	}
+	pthread_mutex_unlock(&s_lock);
+	return pContext ? VM_TLS_ERR_NONE : VM_TLS_ERR_INVALID_CONTEXT;
+}
+
+VMINT vm_tls_connect(VMINT res_id, vm_sockaddr_ex_struct * /* faddr */)
+{
+	if(!LTlsHost::contextAlive(res_id))
+	{
+		return VM_TLS_ERR_INVALID_CONTEXT;
+	}
+	sendSocEvent(res_id, VM_SOC_CONNECT, 1);
+	return VM_TLS_ERR_WOULDBLOCK;
+}
+
+VMINT vm_tls_handshake(VMINT res_id)
+{
+	pthread_mutex_lock(&s_lock);
+	LTlsHostContext *pContext = contextFromId(res_id);
+	const bool fail = s_failHandshakes;
+	if(pContext)
+	{
+		s_handshakes++;
+		s_handshakesOnUsed += pContext->handshaked;
+	}
+	pthread_mutex_unlock(&s_lock);
+	if(pContext == NULL)
+	{
+		return VM_TLS_ERR_INVALID_CONTEXT;
+	}
+	sendTlsEvent(res_id, VM_TLS_HANDSHAKE_DONE, fail ? 0 : 1);
+	return VM_TLS_ERR_WOULDBLOCK;
+}
+
+VMINT vm_tls_read(VMINT res_id, void *buf, VMINT32 len)
+{
+	pthread_mutex_lock(&s_lock);
+	LTlsHostContext *pContext = contextFromId(res_id);
+	VMINT ret = VM_TLS_ERR_INVALID_CONTEXT;
+	if(pContext)
+	{
+		if(!pContext->toClient.empty())
+		{
+			ret = (pContext->toClient.size() < (size_t)len) ? pContext->toClient.size() : len;
+			memcpy(buf, pContext->toClient.data(), ret);
+			pContext->toClient.erase(0, ret);
+		}
+		else
+		{
+			ret = pContext->peerClosed ? VM_TLS_ERR_CONN_CLOSED : VM_TLS_ERR_WOULDBLOCK;
+		}
+	}
+	pthread_mutex_unlock(&s_lock);
+	return ret;
+}
+
+VMINT vm_tls_write(VMINT res_id, const void *buf, VMINT32 len)
+{
+	pthread_mutex_lock(&s_lock);
+	LTlsHostContext *pContext = contextFromId(res_id);
+	VMINT ret = VM_TLS_ERR_INVALID_CONTEXT;
+	bool blocked = false;
+	if(pContext)
+	{
+		if(pContext->peerClosed)
+		{
+			ret = VM_TLS_ERR_CONN_CLOSED;
+		}
+		else if(pContext->writeBlocked)
+		{
+			ret = VM_TLS_ERR_WOULDBLOCK;
+		}
+		else
+		{
+			ret = (s_writeLimit && s_writeLimit < (size_t)len) ? s_writeLimit : len;
+			pContext->fromClient.append((const char*)buf, ret);
+			// with a limit, each write fills the connection
+			blocked = pContext->writeBlocked = (s_writeLimit != 0);
+		}
+	}
+	pthread_mutex_unlock(&s_lock);
+	if(blocked)
+	{
+		sendTlsEvent(res_id, VM_TLS_WRITE, 1);
+	}
+	return ret;
+}
+
+VMINT vm_tls_shutdown(VMINT res_id)
+{
+	return LTlsHost::contextAlive(res_id) ? VM_TLS_ERR_NONE : VM_TLS_ERR_INVALID_CONTEXT;
+}
+
+VMINT vm_tls_delete_conn(VMINT res_id)
+{
+	return LTlsHost::contextAlive(res_id) ? VM_TLS_ERR_NONE : VM_TLS_ERR_INVALID_CONTEXT;
+}
+
+}
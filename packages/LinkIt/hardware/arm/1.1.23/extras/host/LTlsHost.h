@@ -0,0 +1,98 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LTlsHost_h
+#define _LTlsHost_h
+
+#include <sys/time.h>
+#include <string>
+#include "vmsys.h"
+
+// vmsock.h, which vmtls.h includes, declares a timeval type of its own
+// that clashes with the one of the C library; it gets another name here.
+// Its connect() macro is dropped, as LTlsClient.cpp does.
+#define timeval vm_sock_timeval
+#include "vmtls.h"
+#undef timeval
+#undef connect
+
+// Linux stand-ins for the vmtls.h calls LTlsClient.cpp makes. There is no
+// network and no TLS: each context talks to a simulated server that the
+// test drives with the methods below. Connecting and the handshake always
+// complete through events, like on the board, and the events are sent to
+// the MMI thread of LVmHost as LTLSHOST_MSG_EVENT messages. The LVmHost
+// handler passes them to handle(). Code that includes vmtls.h is built
+// with this header included first, for example:
+//
+//   g++ -std=gnu++98 -Icores/arduino -Ivariants/linkit_one -Isystem/libmtk -Isystem/libmtk/include
+//       -include extras/host/LTlsHost.h cores/arduino/LTlsClient.cpp cores/arduino/LTask.cpp ...
+//       extras/host/LVmHost.cpp extras/host/LTlsHost.cpp app.cpp -lpthread
+//
+// EXAMPLE:
+// <code>
+//     static void onMessage(VMUINT32 msgId, void *userData)
+//     {
+//       if(msgId == VM_MSG_ARDUINO_CALL) _LTaskClass::drain();
+//       else LTlsHost::handle(msgId, userData);
+//     }
+//
+//     client.connect(IPAddress(10, 0, 0, 1), 443);
+//     LTlsHost::serverWrite(LTlsHost::lastContext(), "hello", 5);
+// </code>
+
+// message id of the events the stand-ins send to the MMI thread
+#define LTLSHOST_MSG_EVENT 3100
+
+class LTlsHost
+{
+public:
+  // calls the callback of the context with the event in userData and frees
+  // it; returns false if msgId is not LTLSHOST_MSG_EVENT. MMI thread only.
+  static bool handle(VMUINT32 msgId, void *userData);
+
+  // the server sends data on the connection of ctx, reported by VM_TLS_READ
+  static void serverWrite(VMINT ctx, const char *data, size_t len);
+
+  // the server closes the connection of ctx, reported by VM_TLS_CLOSE;
+  // data it sent before can still be read
+  static void serverClose(VMINT ctx);
+
+  // what the client wrote on ctx since its last vm_tls_new_conn()
+  static std::string serverReceived(VMINT ctx);
+
+  // vm_tls_write() takes at most bytes per call, then returns
+  // VM_TLS_ERR_WOULDBLOCK until it sends VM_TLS_WRITE. 0 takes everything.
+  static void setWriteLimit(size_t bytes);
+
+  // makes the following handshakes fail
+  static void failHandshakes(bool fail);
+
+  // the context created last, -1 if none
+  static VMINT lastContext();
+
+  // true between vm_tls_new_ctx() and vm_tls_delete_ctx() of ctx
+  static bool contextAlive(VMINT ctx);
+
+  // name passed to vm_tls_check_peer_name() for ctx
+  static std::string peerName(VMINT ctx);
+
+  // contexts created, contexts deleted, handshakes started and those of
+  // them on a context that had completed a handshake before
+  static int contextsCreated();
+  static int contextsDeleted();
+  static int handshakes();
+  static int handshakesOnUsedContext();
+};
+
+#endif
@@ -0,0 +1,347 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+// Host test of LUDP, on the pthread stand-ins of LVmHost and the vmudp.h
+// stand-ins below, which record what is sent and hand out the datagrams a
+// case makes pending. From the platform folder:
+//
+//   gcc -c cores/arduino/itoa.c cores/arduino/avr/dtostrf.c
+//   g++ -std=gnu++98 -O2 -Icores/arduino -Ivariants/linkit_one -Isystem/libmtk -Isystem/libmtk/include
+//       cores/arduino/LUdp.cpp cores/arduino/LTask.cpp cores/arduino/Stream.cpp cores/arduino/Print.cpp
+//       cores/arduino/LFormat.cpp cores/arduino/WString.cpp cores/arduino/IPAddress.cpp itoa.o dtostrf.o
+//       extras/host/LVmHost.cpp extras/host/LUdpTest.cpp -lpthread -o ludp_test
+//   ./ludp_test
+//
+// It prints one line per case and exits with 1 if any of them failed.
+
+#include <stdio.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "LTask.h"
+#include "LUdp.h"
+#include "LVmHost.h"
+#include "vmconn.h"
+#include "vmlog.h"
+#include "vmudp.h"
+
+#define TEST_HANDLE 7
+#define TEST_FAIL_PORT 9999     // vm_udp_sendto() sends nothing to this port
+
+// a datagram handed to vm_udp_sendto() or waiting for vm_udp_recvfrom()
+struct Datagram
+{
+	std::string data;
+	VMUINT8 ip[4];
+	VMINT port;
+};
+
+static std::vector<Datagram> s_sent;
+// only the MMI thread takes from it, while the test thread waits
+static std::deque<Datagram> s_pending;
+static void (*s_udpCallback)(VMINT hdl, VMINT event) = NULL;
+
+VMINT vm_udp_create(VMINT, VMINT, void (*callback)(VMINT, VMINT), VMINT)
+{
+	s_udpCallback = callback;
+	return TEST_HANDLE;
+}
+
+VMINT vm_udp_sendto(VMINT, const void *buf, VMINT32 len, const vm_sockaddr_struct *addr)
+{
+	if(addr->port == TEST_FAIL_PORT)
+	{
+		return 0;
+	}
+	Datagram sent;
+	sent.data.assign((const char*)buf, len);
+	memcpy(sent.ip, addr->addr, 4);
+	sent.port = addr->port;
+	s_sent.push_back(sent);
+	return len;
+}
+
+VMINT vm_udp_recvfrom(VMINT, void *buf, VMINT32 len, vm_sockaddr_struct *addr)
+{
+	if(s_pending.empty())
+	{
+		return -1;
+	}
+	// like a socket, the rest of a longer datagram is lost
+	const Datagram &datagram = s_pending.front();
+	const VMINT32 size = (VMINT32)datagram.data.size() < len ? (VMINT32)datagram.data.size() : len;
+	memcpy(buf, datagram.data.data(), size);
+	memcpy(addr->addr, datagram.ip, 4);
+	addr->addr_len = 4;
+	addr->port = datagram.port;
+	s_pending.pop_front();
+	return size;
+}
+
+VMINT vm_udp_close(VMINT)
+{
+	return 0;
+}
+
+// logging is off
+int _vm_log_module(const char *, const int) { return 0; }
+void _vm_log_info(char *, ...) {}
+void _vm_log_error(char *, ...) {}
+
+// Stream.cpp needs these; nothing here waits on them
+uint32_t millis(void) { return 0; }
+void delay(uint32_t) {}
+
+// LUDP with the parts LWiFiUDP and LGPRSUDP add
+class TestUDP : public LUDP
+{
+public:
+	using LUDP::beginPacket;
+	virtual int beginPacket(const char *, uint16_t) { return 0; }
+
+protected:
+	virtual VMINT getAPN() const { return 0; }
+};
+
+static int s_failures = 0;
+
+static void check(bool ok, const char *name)
+{
+	printf("%s %s\n", ok ? "ok  " : "FAIL", name);
+	if(!ok)
+	{
+		s_failures++;
+	}
+}
+
+// what main.cpp does with the messages of the MMI thread
+static void onMessage(VMUINT32 msgId, void * /* userData */)
+{
+	if(msgId == VM_MSG_ARDUINO_CALL)
+	{
+		_LTaskClass::drain();
+	}
+}
+
+// remote_call_ptr; what the platform does when datagrams arrive
+static boolean readEvent(void * /* userdata */)
+{
+	s_udpCallback(TEST_HANDLE, VM_UDP_EVT_READ);
+	return true;
+}
+
+static void arrive(const char *data, VMUINT8 lastOctet, VMINT port)
+{
+	Datagram datagram;
+	datagram.data = data;
+	datagram.ip[0] = 192;
+	datagram.ip[1] = 168;
+	datagram.ip[2] = 1;
+	datagram.ip[3] = lastOctet;
+	datagram.port = port;
+	s_pending.push_back(datagram);
+}
+
+static std::string readAll(LUDP &udp)
+{
+	std::string s;
+	int c;
+	while((c = udp.read()) != -1)
+	{
+		s += (char)c;
+	}
+	return s;
+}
+
+static void writeString(LUDP &udp, const char *s)
+{
+	udp.write((const uint8_t*)s, strlen(s));
+}
+
+static void testBatch()
+{
+	TestUDP udp;
+	udp.begin(1234);
+	s_sent.clear();
+
+	const char *payloads[] = {"one", "two", "three"};
+	bool queued = true;
+	for(int i = 0; i < 3; ++i)
+	{
+		queued = queued && udp.beginPacket(IPAddress(10, 0, 0, i + 1), 5000 + i);
+		writeString(udp, payloads[i]);
+		queued = queued && udp.queuePacket();
+	}
+	queued = queued && udp.queuedPackets() == 3 && s_sent.empty();
+
+	int results[3] = {-1, -1, -1};
+	const unsigned long before = LVmHost::messages();
+	const int sent = udp.sendQueued(results, 3);
+	const unsigned long hops = LVmHost::messages() - before;
+
+	bool ok = (sent == 3 && s_sent.size() == 3 && udp.queuedPackets() == 0);
+	for(size_t i = 0; ok && i < 3; ++i)
+	{
+		ok = s_sent[i].data == payloads[i] && s_sent[i].ip[3] == i + 1 && s_sent[i].port == (VMINT)(5000 + i) &&
+			results[i] == 1;
+	}
+	check(queued, "queuePacket() holds datagrams until sendQueued()");
+	check(ok && hops == 1, "sendQueued() sends them in order in one hop");
+
+	// a failed datagram does not stop the ones after it
+	s_sent.clear();
+	udp.beginPacket(IPAddress(10, 0, 0, 1), TEST_FAIL_PORT);
+	writeString(udp, "lost");
+	udp.queuePacket();
+	udp.beginPacket(IPAddress(10, 0, 0, 2), 5000);
+	writeString(udp, "kept");
+	udp.queuePacket();
+	results[0] = results[1] = -1;
+	check(udp.sendQueued(results, 2) == 1 && results[0] == 0 && results[1] == 1 &&
+		s_sent.size() == 1 && s_sent[0].data == "kept", "sendQueued() reports each datagram");
+	udp.stop();
+}
+
+// sendQueued() between beginPacket() and endPacket() keeps the open datagram
+static void testOpenDatagram()
+{
+	TestUDP udp;
+	udp.begin(1234);
+	s_sent.clear();
+
+	udp.beginPacket(IPAddress(10, 0, 0, 1), 5000);
+	writeString(udp, "queued");
+	udp.queuePacket();
+	udp.beginPacket(IPAddress(10, 0, 0, 2), 6000);
+	writeString(udp, "first half ");
+	const int sent = udp.sendQueued();
+	writeString(udp, "second half");
+	const int ended = udp.endPacket();
+
+	check(sent == 1 && ended == 1 && s_sent.size() == 2 && s_sent[0].data == "queued" &&
+		s_sent[1].data == "first half second half" && s_sent[1].port == 6000,
+		"an open datagram survives sendQueued()");
+	udp.stop();
+}
+
+static void testArena()
+{
+	TestUDP udp;
+	udp.setSendQueue(2, 16);
+	udp.begin(1234);
+	s_sent.clear();
+
+	// one datagram larger than the arena
+	udp.clearWriteError();
+	udp.beginPacket(IPAddress(10, 0, 0, 1), 5000);
+	const size_t written = udp.write((const uint8_t*)"0123456789abcdefXYZ", 19);
+	const bool error = udp.getWriteError();
+	udp.endPacket();
+	check(written == 16 && error && s_sent.size() == 1 && s_sent[0].data == "0123456789abcdef",
+		"a datagram is truncated at the end of the arena");
+
+	// queued datagrams share the arena with the one being written
+	s_sent.clear();
+	udp.clearWriteError();
+	udp.beginPacket(IPAddress(10, 0, 0, 1), 5000);
+	writeString(udp, "0123456789");
+	udp.queuePacket();
+	udp.beginPacket(IPAddress(10, 0, 0, 2), 5000);
+	const LIoVec iov[2] = {{(const uint8_t*)"abcd", 4}, {(const uint8_t*)"efgh", 4}};
+	const size_t gathered = udp.writev(iov, 2);
+	udp.queuePacket();
+	const bool full = !udp.beginPacket(IPAddress(10, 0, 0, 3), 5000);
+	udp.sendQueued();
+	check(gathered == 6 && udp.getWriteError() && s_sent.size() == 2 && s_sent[1].data == "abcdef",
+		"queued datagrams share the arena");
+	check(full, "beginPacket() fails while all slots are queued");
+
+	// after sendQueued() the whole arena is free again
+	s_sent.clear();
+	udp.beginPacket(IPAddress(10, 0, 0, 1), 5000);
+	check(udp.write((const uint8_t*)"0123456789abcdef", 16) == 16 && udp.endPacket() == 1 &&
+		s_sent.size() == 1 && s_sent[0].data.size() == 16, "sendQueued() frees the arena");
+	udp.stop();
+}
+
+// a burst larger than the queue: the rest waits in the platform buffer and
+// parsePacket() fetches it without a new VM_UDP_EVT_READ
+static void testReceiveBurst()
+{
+	TestUDP udp;
+	udp.setReceiveQueue(3, 8);
+	udp.begin(1234);
+
+	const char *payloads[] = {"a0", "b1", "", "c3", "0123456789", "d5", "e6"};
+	const int count = sizeof(payloads) / sizeof(payloads[0]);
+	for(int i = 0; i < count; ++i)
+	{
+		arrive(payloads[i], 10 + i, 7000 + i);
+	}
+	LTask.remoteCall(readEvent, NULL);
+	const size_t waiting = s_pending.size();
+
+	bool ok = true;
+	int received = 0;
+	for(int i = 0; i < count; ++i)
+	{
+		const int size = udp.parsePacket();
+		const std::string want = std::string(payloads[i]).substr(0, 8);
+		const IPAddress ip = udp.remoteIP();
+		const bool match = size == (int)want.size() && readAll(udp) == want && ip[0] == 192 && ip[3] == 10 + i &&
+			udp.remotePort() == 7000 + i;
+		if(!match)
+		{
+			printf("     datagram %d: size %d, port %u\n", i, size, udp.remotePort());
+		}
+		ok = ok && match;
+		received += match;
+	}
+	printf("     %d of %d datagrams after one event, %d received\n", count - (int)waiting, count, received);
+	check(waiting == (size_t)(count - 3), "the queue takes as many datagrams as it has slots");
+	check(ok, "the rest are fetched by parsePacket(), each with its own sender");
+	check(udp.parsePacket() == 0 && s_pending.empty(), "then the queue is empty");
+	udp.stop();
+}
+
+// an empty datagram has a sender and does not end the drain
+static void testEmptyDatagram()
+{
+	TestUDP udp;
+	udp.begin(1234);
+
+	arrive("", 1, 8000);
+	arrive("after", 2, 8001);
+	LTask.remoteCall(readEvent, NULL);
+	const bool drained = s_pending.empty();
+
+	const int empty = udp.parsePacket();
+	const uint16_t emptyPort = udp.remotePort();
+	const int next = udp.parsePacket();
+	check(drained && empty == 0 && emptyPort == 8000 && next == 5 && readAll(udp) == "after" &&
+		udp.remotePort() == 8001, "an empty datagram is queued like any other");
+	udp.stop();
+}
+
+int main()
+{
+	LVmHost::start(onMessage);
+	testBatch();
+	testOpenDatagram();
+	testArena();
+	testReceiveBurst();
+	testEmptyDatagram();
+	LVmHost::stop();
+	return s_failures ? 1 : 0;
+}
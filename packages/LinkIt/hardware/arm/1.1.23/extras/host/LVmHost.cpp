@@ -0,0 +1,254 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <deque>
+#include "LVmHost.h"
+
+#define LVMHOST_MAIN_HANDLE 1
+#define LVMHOST_MAX_SIGNALS 64
+#define LVMHOST_MAX_MUTEXES 64
+
+struct LVmHostSignal
+{
+	bool set;
+	pthread_cond_t cond;
+};
+
+struct LVmHostMsg
+{
+	VMUINT32 msgId;
+	void *userData;
+};
+
+// one lock for the message queue and all signals
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_queueCond = PTHREAD_COND_INITIALIZER;
+static std::deque<LVmHostMsg> s_queue;
+static LVmHostSignal s_signals[LVMHOST_MAX_SIGNALS];
+static VMUINT32 s_signalCount = 0;
+static pthread_mutex_t s_mutexes[LVMHOST_MAX_MUTEXES];
+static VMUINT32 s_mutexCount = 0;
+
+static pthread_t s_mmiThread;
+static LVmHostHandler s_handler = NULL;
+static bool s_running = false;
+static unsigned long s_messages = 0;
+
+static void *mmiThread(void *)
+{
+	pthread_mutex_lock(&s_lock);
+	for(;;)
+	{
+		while(s_running && s_queue.empty())
+		{
+			pthread_cond_wait(&s_queueCond, &s_lock);
+		}
+		if(s_queue.empty())
+		{
+			break;
+		}
+
+		const LVmHostMsg msg = s_queue.front();
+		s_queue.pop_front();
+		s_messages++;
+		pthread_mutex_unlock(&s_lock);
+		s_handler(msg.msgId, msg.userData);
+		pthread_mutex_lock(&s_lock);
+	}
+	pthread_mutex_unlock(&s_lock);
+	return NULL;
+}
+
+void LVmHost::start(LVmHostHandler handler)
+{
+	s_handler = handler;
+	s_running = true;
+	s_messages = 0;
+	pthread_create(&s_mmiThread, NULL, mmiThread, NULL);
+}
+
+void LVmHost::stop()
+{
+	pthread_mutex_lock(&s_lock);
+	s_running = false;
+	pthread_cond_broadcast(&s_queueCond);
+	pthread_mutex_unlock(&s_lock);
+	pthread_join(s_mmiThread, NULL);
+}
+
+unsigned long LVmHost::messages()
+{
+	pthread_mutex_lock(&s_lock);
+	const unsigned long count = s_messages;
+	pthread_mutex_unlock(&s_lock);
+	return count;
+}
+
+static LVmHostSignal *signalFromId(VM_SIGNAL_ID s_id)
+{
+	if(s_id == 0 || s_id > s_signalCount)
+	{
+		return NULL;
+	}
+	return &s_signals[s_id - 1];
+}
+
+extern "C" {
+
+VM_THREAD_HANDLE vm_thread_get_main_handle(void)
+{
+	return LVMHOST_MAIN_HANDLE;
+}
+
+void vm_thread_send_msg(VM_THREAD_HANDLE /* thread_handle */, VMUINT32 msg_id, void* user_data)
+{
+	LVmHostMsg msg;
+	msg.msgId = msg_id;
+	msg.userData = user_data;
+
+	pthread_mutex_lock(&s_lock);
+	s_queue.push_back(msg);
+	pthread_cond_broadcast(&s_queueCond);
+	pthread_mutex_unlock(&s_lock);
+}
+
+void vm_thread_sleep(VMUINT32 timeout)
+{
+	usleep(timeout * 1000);
+}
+
+VM_SIGNAL_ID vm_signal_init(void)
+{
+	pthread_mutex_lock(&s_lock);
+	if(s_signalCount == LVMHOST_MAX_SIGNALS)
+	{
+		pthread_mutex_unlock(&s_lock);
+		return 0;
+	}
+	LVmHostSignal *signal = &s_signals[s_signalCount++];
+	signal->set = false;
+	pthread_cond_init(&signal->cond, NULL);
+	const VM_SIGNAL_ID s_id = s_signalCount;
+	pthread_mutex_unlock(&s_lock);
+	return s_id;
+}
+
+// the slot stays allocated so that a stale id cannot reach another signal
+void vm_signal_deinit(VM_SIGNAL_ID /* s_id */)
+{
+}
+
+void vm_signal_clean(VM_SIGNAL_ID s_id)
+{
+	pthread_mutex_lock(&s_lock);
+	LVmHostSignal *signal = signalFromId(s_id);
+	if(signal)
+	{
+		signal->set = false;
+	}
+	pthread_mutex_unlock(&s_lock);
+}
+
+void vm_signal_post(VM_SIGNAL_ID s_id)
+{
+	pthread_mutex_lock(&s_lock);
+	LVmHostSignal *signal = signalFromId(s_id);
+	if(signal)
+	{
+		signal->set = true;
+		pthread_cond_broadcast(&signal->cond);
+	}
+	pthread_mutex_unlock(&s_lock);
+}
+
+VMINT32 vm_signal_wait(VM_SIGNAL_ID s_id)
+{
+	pthread_mutex_lock(&s_lock);
+	LVmHostSignal *signal = signalFromId(s_id);
+	if(signal == NULL)
+	{
+		pthread_mutex_unlock(&s_lock);
+		return VM_SIGNAL_RESULT_CANCEL;
+	}
+	while(!signal->set)
+	{
+		pthread_cond_wait(&signal->cond, &s_lock);
+	}
+	signal->set = false;
+	pthread_mutex_unlock(&s_lock);
+	return VM_SIGNAL_RESULT_SUCCESS;
+}
+
+VMINT32 vm_signal_timedwait(VM_SIGNAL_ID s_id, VMUINT32 time_count)
+{
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += time_count / 1000000;
+	deadline.tv_nsec += (long)(time_count % 1000000) * 1000;
+	if(deadline.tv_nsec >= 1000000000)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&s_lock);
+	LVmHostSignal *signal = signalFromId(s_id);
+	if(signal == NULL)
+	{
+		pthread_mutex_unlock(&s_lock);
+		return VM_SIGNAL_RESULT_CANCEL;
+	}
+	while(!signal->set)
+	{
+		if(pthread_cond_timedwait(&signal->cond, &s_lock, &deadline) != 0 && !signal->set)
+		{
+			pthread_mutex_unlock(&s_lock);
+			return VM_SIGNAL_RESULT_TIMEOUT;
+		}
+	}
+	signal->set = false;
+	pthread_mutex_unlock(&s_lock);
+	return VM_SIGNAL_RESULT_SUCCESS;
+}
+
+void vm_mutex_create(vm_thread_mutex_struct *mutex)
+{
+	pthread_mutex_lock(&s_lock);
+	if(s_mutexCount < LVMHOST_MAX_MUTEXES)
+	{
+		pthread_mutexattr_t attr;
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+		pthread_mutex_init(&s_mutexes[s_mutexCount++], &attr);
+		pthread_mutexattr_destroy(&attr);
+		mutex->guard = s_mutexCount;
+		mutex->mutex_info = NULL;
+	}
+	pthread_mutex_unlock(&s_lock);
+}
+
+void vm_mutex_lock(vm_thread_mutex_struct *mutex)
+{
+	pthread_mutex_lock(&s_mutexes[mutex->guard - 1]);
+}
+
+void vm_mutex_unlock(vm_thread_mutex_struct *mutex)
+{
+	pthread_mutex_unlock(&s_mutexes[mutex->guard - 1]);
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LVmHost_h
+#define _LVmHost_h
+
+#include "vmsys.h"
+#include "vmthread.h"
+
+// Linux stand-ins for the vmthread.h calls the core makes: vm_mutex_*,
+// vm_signal_*, vm_thread_send_msg, vm_thread_get_main_handle and
+// vm_thread_sleep. They run on pthreads, so core code such as LTask.cpp
+// can be built and measured on a PC. The calling thread plays the Arduino
+// thread and a second thread plays the MMI thread, which takes the
+// messages sent with vm_thread_send_msg one at a time and hands them to
+// a handler. Build it from the platform folder, for example:
+//
+//   g++ -std=gnu++98 -Icores/arduino -Ivariants/linkit_one -Isystem/libmtk -Isystem/libmtk/include
+//       cores/arduino/LTask.cpp extras/host/LVmHost.cpp app.cpp -lpthread
+//
+// EXAMPLE:
+// <code>
+//     static void onMessage(VMUINT32 msgId, void *userData)
+//     {
+//       if(msgId == VM_MSG_ARDUINO_CALL) _LTaskClass::drain();
+//     }
+//
+//     LVmHost::start(onMessage);
+//     LTask.remoteCall(handler, NULL);
+//     LVmHost::stop();
+// </code>
+
+typedef void (*LVmHostHandler)(VMUINT32 msgId, void *userData);
+
+class LVmHost
+{
+public:
+  // starts the MMI thread, which passes every message to handler
+  static void start(LVmHostHandler handler);
+
+  // handles the messages still queued, then ends the MMI thread
+  static void stop();
+
+  // messages handled since start()
+  static unsigned long messages();
+};
+
+#endif
@@ -0,0 +1,201 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+// Host test of String and StringBuilder that counts heap allocations. It
+// replaces malloc() and realloc() with counting versions on top of glibc,
+// so it needs a glibc host. From the platform folder:
+//
+//   gcc -c cores/arduino/itoa.c cores/arduino/avr/dtostrf.c
+//   g++ -std=gnu++98 -O2 -Icores/arduino -Ivariants/linkit_one -Isystem/libmtk -Isystem/libmtk/include
+//       cores/arduino/WString.cpp cores/arduino/Print.cpp cores/arduino/LFormat.cpp
+//       cores/arduino/StringBuilder.cpp itoa.o dtostrf.o extras/host/WStringAllocTest.cpp -o wstring_test
+//   ./wstring_test
+//
+// It prints one line per case, with the allocations counted where the case
+// has a limit on them, and exits with 1 if any of them failed.
+
+#include <stdio.h>
+#include <string>
+#include "WString.h"
+#include "StringBuilder.h"
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static int s_allocs = 0;
+
+void *malloc(size_t size)
+{
+	s_allocs++;
+	return __libc_malloc(size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	s_allocs++;
+	return __libc_realloc(ptr, size);
+}
+
+static int s_failures = 0;
+
+// allocs is what the case counted, or -1 if it does not count
+static void check(bool ok, const char *name, int allocs)
+{
+	if(allocs < 0)
+	{
+		printf("%s %s\n", ok ? "ok  " : "FAIL", name);
+	}
+	else
+	{
+		printf("%s %-44s %4d allocations\n", ok ? "ok  " : "FAIL", name, allocs);
+	}
+	if(!ok)
+	{
+		s_failures++;
+	}
+}
+
+static void testInline()
+{
+	int start = s_allocs;
+	{
+		String s("hi");
+		String c('x');
+		String n(12345);
+		String e;
+		String longest("12345678901");
+		check(s == "hi" && c == "x" && n == "12345" && e == "" && longest.length() == STRING_INLINE_SIZE - 1 &&
+			s_allocs == start, "Strings up to 11 characters", s_allocs - start);
+	}
+
+	start = s_allocs;
+	{
+		String s("123456789012");
+		check(s == "123456789012" && s_allocs == start + 1, "a String of 12 characters", s_allocs - start);
+	}
+}
+
+static void testGrowth()
+{
+	String s;
+	std::string want;
+	want.reserve(1000);
+	int start = s_allocs;
+	for(int i = 0; i < 1000; ++i)
+	{
+		s += (char)('a' + i % 26);
+		want += (char)('a' + i % 26);
+	}
+	check(want == s.c_str() && s_allocs - start <= 12, "1000 char appends", s_allocs - start);
+
+	String list;
+	start = s_allocs;
+	for(int i = 0; i < 200; ++i)
+	{
+		list += i;
+		list += ',';
+	}
+	check(list.startsWith("0,1,2,") && list.endsWith(",199,") && s_allocs - start <= 11,
+		"200 int and ',' appends", s_allocs - start);
+}
+
+static void testNumbers()
+{
+	String s;
+	s += -2147483647L - 1;
+	bool ok = (s == "-2147483648");
+	s = "";
+	s += 4294967295UL;
+	ok = ok && s == "4294967295";
+	s = "";
+	s += (unsigned char)200;
+	s += -5;
+	ok = ok && s == "200-5";
+	s = "";
+	s += 1.5f;
+	ok = ok && s == "1.50";
+	check(ok, "numeric concat", -1);
+
+	const int start = s_allocs;
+	{
+		String sum = String("id=") + 42 + " t=" + String(21.456, 1);
+		check(sum == "id=42 t=21.5" && s_allocs - start <= 2, "\"id=\" + 42 + \" t=\" + String(x, 1)", s_allocs - start);
+	}
+}
+
+// appending a String to itself while its buffer moves
+static void testSelfConcat()
+{
+	String s("abcdefgh");
+	s += s;
+	bool ok = (s == "abcdefghabcdefgh");
+	s += s;
+	ok = ok && s == "abcdefghabcdefghabcdefghabcdefgh";
+	s.concat(s.c_str() + 2, 3);
+	ok = ok && s.endsWith("cde");
+	check(ok, "self concat", -1);
+}
+
+static void testCopies()
+{
+	String a("short");
+	String b(a);
+	a = "a much longer string than inline";
+	String c = a;
+	b = c;
+	bool ok = (b == a && c == a);
+	b = "x";
+	String d;
+	d = b;
+	ok = ok && b == "x" && d == "x";
+
+	String e("hello world");
+	e.replace("o", "0000");
+	ok = ok && e == "hell0000 w0000rld";
+	e.remove(0, 4);
+	ok = ok && e == "0000 w0000rld";
+	ok = ok && e.substring(5) == "w0000rld" && e.indexOf('w') == 5;
+
+	String bad((const char*)0);
+	ok = ok && !bad;
+	bad += "x";
+	ok = ok && bad == "x";
+	check(ok, "copy, assign, replace and remove", -1);
+}
+
+static void testBuilder()
+{
+	const int start = s_allocs;
+	{
+		StringBuilder sb(64);
+		const int reserved = s_allocs;
+		sb.append("id=").append(42).append(" t=").append(21.456, 1).append(',').append(255u, HEX).append(-7L);
+		sb.printf(" %s:%d", "p", 3);
+		check(sb.str() == "id=42 t=21.5,FF-7 p:3" && reserved == start + 1 && s_allocs == reserved,
+			"StringBuilder with a reserved size", s_allocs - start);
+		sb.clear();
+		check(sb.length() == 0 && !sb.getWriteError(), "StringBuilder clear", -1);
+	}
+}
+
+int main()
+{
+	testInline();
+	testGrowth();
+	testNumbers();
+	testSelfConcat();
+	testCopies();
+	testBuilder();
+	return s_failures ? 1 : 0;
+}
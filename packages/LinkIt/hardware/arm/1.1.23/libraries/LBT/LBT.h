@@ -20,6 +20,7 @@
 
 #include <Arduino.h>
 #include "LTask.h"
+#include "RingBuffer.h"
 #include "vmbtcm.h"
 #include <stdint.h>
 
@@ -45,17 +46,25 @@ typedef struct
 	char name[56];
 } LBTDeviceInfo;
 
-#define LBT_SERIAL_BUFFER_SIZE (1024*6)
+// default receive buffer size in bytes of LBTClient and LBTServer; SPP
+// data is read straight into it
+#ifndef LBT_SERIAL_BUFFER_SIZE
+#define LBT_SERIAL_BUFFER_SIZE (1024*4)
+#endif
 
-class LBTRingBuffer
-{
-  public:
-    uint8_t _aucBuffer[LBT_SERIAL_BUFFER_SIZE] ;
-    int _iHead ;
-    int _iTail ;
-
-  public:
-    LBTRingBuffer( void ) ;
-    void store_char( uint8_t c ) ;
-} ;
+// stack bytes used to discard SPP data that arrives while the receive
+// buffer is full
+#ifndef LBT_RX_DISCARD_SIZE
+#define LBT_RX_DISCARD_SIZE 64
+#endif
+
+#ifndef LBT_CLIENT_RX_BUFFER_SIZE
+#define LBT_CLIENT_RX_BUFFER_SIZE LBT_SERIAL_BUFFER_SIZE
+#endif
+
+#ifndef LBT_SERVER_RX_BUFFER_SIZE
+#define LBT_SERVER_RX_BUFFER_SIZE LBT_SERIAL_BUFFER_SIZE
+#endif
+
+typedef RingBuffer<LBT_SERIAL_BUFFER_SIZE> LBTRingBuffer;
 #endif //#ifndef LBT_H
@@ -27,7 +27,7 @@ extern void app_log_file(char *fmt, ...);
 #endif
 
 vm_thread_mutex_struct client_mutex = {0};
-LBTClientClass::LBTClientClass(LBTRingBuffer* pRx_buffer) : m_post_write(0), m_post_read(0)
+LBTClientClass::LBTClientClass(RingBufferBase* pRx_buffer) : m_post_write(0), m_post_read(0)
 {
   _rx_buffer = pRx_buffer;
 }
@@ -49,10 +49,13 @@ boolean LBTClientClass::begin(void)
 void LBTClientClass::end(void)
 {
     _LTaskClass::stop();
+	// waitAvailable() must not wait on the signal once it is gone
+	const VM_SIGNAL_ID signalRead = m_signal_read;
+	m_signal_read = 0;
 	vm_signal_clean(m_signal_write);
 	vm_signal_deinit(m_signal_write);
-	vm_signal_clean(m_signal_read);
-	vm_signal_deinit(m_signal_read);
+	vm_signal_clean(signalRead);
+	vm_signal_deinit(signalRead);
 	remoteCall(btClientEnd, (void*)NULL);
 }
 
@@ -152,6 +155,27 @@ size_t LBTClientClass::write(const uint8_t *buf, size_t size)
 	return c.lenProcessed;
 }
 
+size_t LBTClientClass::writev(const LIoVec *iov, int count)
+{
+    LBTClientWritevContext c;
+	c.iov = iov;
+	c.count = count;
+
+	if (!m_post_write)
+	{
+        APP_LOG((char*)"LBTClientClass::writev wait");
+        vm_signal_wait(m_signal_write); // wait for VM_SRV_SPP_EVENT_READY_TO_WRITE
+        APP_LOG((char*)"LBTClientClass::writev wait ok");
+    }
+    vm_signal_clean(m_signal_write);
+    m_post_write = 0;
+
+    remoteCall(btClientWritev, (void*)&c);
+    m_post_write = 1;
+
+	return c.lenProcessed;
+}
+
 void LBTClientClass::post_signal_write()
 {
     APP_LOG((char*)"LBTClientClass::post_signal_write");
@@ -162,34 +186,34 @@ void LBTClientClass::post_signal_write()
 void LBTClientClass::post_signal_read()
 {
     APP_LOG((char*)"LBTClientClass::post_signal_read");
-	vm_signal_post(m_signal_read);
+	if(m_signal_read)
+	{
+		vm_signal_post(m_signal_read);
+	}
 	m_post_read = 1;
 }
 
 int LBTClientClass::available(void)
 {
-  return (uint32_t)(LBT_SERIAL_BUFFER_SIZE + _rx_buffer->_iHead - _rx_buffer->_iTail) % LBT_SERIAL_BUFFER_SIZE;
+  return _rx_buffer->available();
 }
 
 int LBTClientClass::peek(void)
 {
-  if(_rx_buffer->_iHead == _rx_buffer->_iTail)
-  	return -1;
-  return _rx_buffer->_aucBuffer[_rx_buffer->_iTail];
+  return _rx_buffer->peek();
 }
 
 int LBTClientClass::read(void)
 {
 
-  if(_rx_buffer->_iHead == _rx_buffer->_iTail)
+  if(_rx_buffer->available() == 0)
   	return -1;
 	if(client_mutex.guard == 0)
 	{
 		vm_mutex_create(&client_mutex);
 	}
   vm_mutex_lock(&client_mutex);
-  uint8_t uc = _rx_buffer->_aucBuffer[_rx_buffer->_iTail];
-  _rx_buffer->_iTail = (unsigned int)(_rx_buffer->_iTail + 1) % LBT_SERIAL_BUFFER_SIZE;
+  const int uc = _rx_buffer->read();
   vm_mutex_unlock(&client_mutex);
   return uc;
 }
@@ -199,6 +223,22 @@ void LBTClientClass::flush(void)
   while(read()!=-1);
 }
 
+int LBTClientClass::read(uint8_t *buf, size_t size)
+{
+  return _rx_buffer->read(buf, size);
+}
+
+int LBTClientClass::readAvailableUntil(uint8_t terminator, uint8_t *buf, size_t size)
+{
+  return _rx_buffer->readUntil(terminator, buf, size);
+}
+
+bool LBTClientClass::waitAvailable(unsigned long timeout)
+{
+  // posted by the VM_SRV_SPP_EVENT_READY_TO_READ handler; 0 until begin()
+  return waitSignal(m_signal_read, timeout);
+}
+
 size_t LBTClientClass::write(const uint8_t data)
 {
   LBTClientReadWriteContext c;
@@ -220,7 +260,7 @@ size_t LBTClientClass::write(const uint8_t data)
 	return c.lenProcessed;
 }
 
-LBTRingBuffer LBTClient_rx_buffer;
+RingBuffer<LBT_CLIENT_RX_BUFFER_SIZE> LBTClient_rx_buffer;
 LBTClientClass LBTClient(&LBTClient_rx_buffer);
 
 
@@ -27,7 +27,7 @@ extern void app_log_file(char *fmt, ...);
 #endif
 
 vm_thread_mutex_struct server_mutex = {0};
-LBTServerClass::LBTServerClass(LBTRingBuffer* pRx_buffer) : m_post_write(0), m_post_read(0)
+LBTServerClass::LBTServerClass(RingBufferBase* pRx_buffer) : m_post_write(0), m_post_read(0)
 {
   _rx_buffer = pRx_buffer;
 }
@@ -65,10 +65,13 @@ void LBTServerClass::end(void)
 {
     _LTaskClass::stop();
     
+	// waitAvailable() must not wait on the signal once it is gone
+	const VM_SIGNAL_ID signalRead = m_signal_read;
+	m_signal_read = 0;
 	vm_signal_clean(m_signal_write);
 	vm_signal_deinit(m_signal_write);
-	vm_signal_clean(m_signal_read);
-	vm_signal_deinit(m_signal_read);
+	vm_signal_clean(signalRead);
+	vm_signal_deinit(signalRead);
 	remoteCall(btServerEnd, (void*)NULL);
 }
 
@@ -135,6 +138,27 @@ size_t LBTServerClass::write(const uint8_t *buf, size_t size)
 	return c.lenProcessed;
 }
 
+size_t LBTServerClass::writev(const LIoVec *iov, int count)
+{
+    LBTServerWritevContext c;
+	c.iov = iov;
+	c.count = count;
+
+	if (!m_post_write)
+	{
+        APP_LOG((char*)"LBTServerClass::writev wait");
+        vm_signal_wait(m_signal_write); // wait for VM_SRV_SPP_EVENT_READY_TO_WRITE
+        APP_LOG((char*)"LBTServerClass::writev wait ok");
+    }
+    vm_signal_clean(m_signal_write);
+    m_post_write = 0;
+
+    remoteCall(btServerWritev, (void*)&c);
+    m_post_write = 1;
+
+	return c.lenProcessed;
+}
+
 void LBTServerClass::post_signal_write()
 {
     APP_LOG((char*)"LBTServerClass::post_signal_write");
@@ -145,7 +169,10 @@ void LBTServerClass::post_signal_write()
 void LBTServerClass::post_signal_read()
 {
     APP_LOG((char*)"LBTServerClass::post_signal_read");
-	vm_signal_post(m_signal_read);
+	if(m_signal_read)
+	{
+		vm_signal_post(m_signal_read);
+	}
 	m_post_read = 1;
 }
 
@@ -241,20 +268,18 @@ int addrStr2Mac(const char *MACAddr, LBTAddress &address)
 
 int LBTServerClass::available(void)
 {
-  return (uint32_t)(LBT_SERIAL_BUFFER_SIZE + _rx_buffer->_iHead - _rx_buffer->_iTail) % LBT_SERIAL_BUFFER_SIZE;
+  return _rx_buffer->available();
 }
 
 int LBTServerClass::peek(void)
 {
-  if(_rx_buffer->_iHead == _rx_buffer->_iTail)
-  	return -1;
-  return _rx_buffer->_aucBuffer[_rx_buffer->_iTail];
+  return _rx_buffer->peek();
 }
 
 int LBTServerClass::read(void)
 {
 
-  if(_rx_buffer->_iHead == _rx_buffer->_iTail)
+  if(_rx_buffer->available() == 0)
   {
   	return -1;
   }
@@ -263,8 +288,7 @@ int LBTServerClass::read(void)
 		vm_mutex_create(&server_mutex);
 	}	
  	vm_mutex_lock(&server_mutex); 
-  uint8_t uc = _rx_buffer->_aucBuffer[_rx_buffer->_iTail];
-  _rx_buffer->_iTail = (unsigned int)(_rx_buffer->_iTail + 1) % LBT_SERIAL_BUFFER_SIZE;
+  const int uc = _rx_buffer->read();
   vm_mutex_unlock(&server_mutex);
   return uc;
   
@@ -275,6 +299,22 @@ void LBTServerClass::flush(void)
   while(read()!=-1);
 }
 
+int LBTServerClass::read(uint8_t *buf, size_t size)
+{
+  return _rx_buffer->read(buf, size);
+}
+
+int LBTServerClass::readAvailableUntil(uint8_t terminator, uint8_t *buf, size_t size)
+{
+  return _rx_buffer->readUntil(terminator, buf, size);
+}
+
+bool LBTServerClass::waitAvailable(unsigned long timeout)
+{
+  // posted by the VM_SRV_SPP_EVENT_READY_TO_READ handler; 0 until begin()
+  return waitSignal(m_signal_read, timeout);
+}
+
 size_t LBTServerClass::write(const uint8_t data)
 {
   LBTServerReadWriteContext c;
@@ -297,6 +337,6 @@ size_t LBTServerClass::write(const uint8_t data)
 }
 
 
-LBTRingBuffer LBTServer_rx_buffer;
+RingBuffer<LBT_SERVER_RX_BUFFER_SIZE> LBTServer_rx_buffer;
 LBTServerClass LBTServer(&LBTServer_rx_buffer);
 
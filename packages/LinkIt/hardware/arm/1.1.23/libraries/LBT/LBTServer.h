@@ -77,15 +77,30 @@ struct LBTServerReadWriteContext : BTBase
 	}
 };
 
+struct LBTServerWritevContext : BTBase
+{
+    const LIoVec *iov;
+    int count;
+    VMINT lenProcessed;	// Number of bytes written.
+
+	LBTServerWritevContext():
+		iov(NULL),
+		count(0),
+		lenProcessed(0)
+	{
+
+	}
+};
+
 
 // LBTServer class interface.
 class LBTServerClass  : public _LTaskClass,public Stream{
 public:
-	LBTRingBuffer *_rx_buffer;
+	RingBufferBase *_rx_buffer;
 	uint8_t _pincode_buffer[LBT_PIN_CODE_BUFFER_SIZE];
 // Constructor
 public:
-	LBTServerClass(LBTRingBuffer* pRx_buffer);
+	LBTServerClass(RingBufferBase* pRx_buffer);
 
 // Method
 public:
@@ -425,6 +440,27 @@ public:
 
     int read(void);
 
+// Reads the received data that is buffered, without waiting.
+//
+// RETURNS
+// Number of bytes read, 0 if no data is available.
+    int read(uint8_t *buf,   //[OUT] Buffer for the data.
+             size_t size     //[IN] Size of buf.
+            );
+
+// As read(buf, size), but stops after the first terminator byte, which is
+// the last byte read. Used by readBytesUntil().
+    int readAvailableUntil(uint8_t terminator, uint8_t *buf, size_t size);
+
+// Waits until data from the SPP client is available to read. The Arduino
+// thread sleeps until the data arrives or the timeout expires.
+//
+// RETURNS
+// true: Data is available.
+// false: Timed out.
+    bool waitAvailable(unsigned long timeout  //[IN] Longest wait in milliseconds.
+                      );
+
     // DESCRIPTION
     //    Writes data to a Bluetooth SPP client.
     // RETURNS
@@ -505,6 +541,13 @@ public:
     size_t write(const uint8_t data  //[IN] The input character.
                 );
                 
+// Writes several buffers in order, passing all of them to the SPP connection
+// in one call to the main thread instead of one per buffer.
+//
+// RETURNS
+// Total bytes written. Less than the total size if the connection did not take all data.
+    size_t writev(const LIoVec *iov, int count);
+
     using Print::write;
 
     void post_signal_write();
@@ -311,7 +311,6 @@ static void bt_client_btcm_cb(VMUINT evt, void * param, void * user_data)
 static int bt_client_spp_read(void* data)
 {
 	  VMINT ret = 0;
-	  VMINT i = 0;
     if(g_clientContext.conn_id < 0)
     {
 
@@ -319,37 +318,54 @@ static int bt_client_spp_read(void* data)
 
         return true;
     }
-    char *readdata = new char[LBT_SERIAL_BUFFER_SIZE];
-    if(readdata == NULL)
-  	{
-  		APP_LOG((char*)"[BTC]bt_client_spp_read : allocate memory fail");
-  		return false;
-  	}
-    ret = vm_btspp_read(g_clientContext.conn_id, (void*)readdata, LBT_SERIAL_BUFFER_SIZE);
-
-    APP_LOG("[BTC]bt_client_spp_read, ret: %d", ret);
-
-    if (ret < 0)
+    if(client_mutex.guard == 0)
     {
-       APP_LOG((char*)"[BTC]bt_client_spp_read : read data fail");
-
+        vm_mutex_create(&client_mutex);
     }
-    else 
+    vm_mutex_lock(&client_mutex);
+
+    // read straight into the ring, in up to two pieces when it wraps
+    RingBufferBase *rx = LBTClient._rx_buffer;
+    VMINT total = 0;
+    for(;;)
     {
-    	  if(client_mutex.guard == 0)
-    	  {
-    	      vm_mutex_create(&client_mutex);
-    	  }
-    	  vm_mutex_lock(&client_mutex);
-        for(i=0;i<ret;i++)
+        size_t len = 0;
+        uint8_t *dst = rx->writeBuffer(len);
+        if(len == 0)
+        {
+            // full: empty the connection anyway, so the next event reports
+            // new data, and count what is lost
+            char discard[LBT_RX_DISCARD_SIZE];
+            ret = vm_btspp_read(g_clientContext.conn_id, (void*)discard, sizeof(discard));
+            if(ret <= 0)
+            {
+                break;
+            }
+            rx->drop(ret);
+            continue;
+        }
+
+        ret = vm_btspp_read(g_clientContext.conn_id, (void*)dst, len);
+        if(ret <= 0)
         {
-        	LBTClient._rx_buffer->store_char(readdata[i]);
+            break;
+        }
+        rx->commit(ret);
+        total += ret;
+        if((size_t)ret < len)
+        {
+            break;
         }
-        vm_mutex_unlock(&client_mutex);
-        APP_LOG((char*)"[BTC]bt_client_spp_read : read data success");
     }
-    delete[] readdata;
-	return ret;
+    vm_mutex_unlock(&client_mutex);
+
+    APP_LOG("[BTC]bt_client_spp_read, stored: %d", total);
+
+    if (ret < 0)
+    {
+       APP_LOG((char*)"[BTC]bt_client_spp_read : read data fail");
+    }
+	return total;
 }
 
 static void bt_client_spp_cb(VMUINT evt, void * param, void * user_data)
@@ -404,10 +420,8 @@ static void bt_client_spp_cb(VMUINT evt, void * param, void * user_data)
         case VM_SRV_SPP_EVENT_READY_TO_READ:
         {
         	  bt_client_spp_read(NULL);
-        	
-#if(0)
+            // wakes waitAvailable()
             g_clientContext.ptr->post_signal_read();
-#endif
             break;
         }
 
@@ -829,6 +843,44 @@ boolean btClientRead(void *userData)
 	return true;
 }
 
+boolean btClientWritev(void *userData)
+{
+    LBTClientWritevContext* pContext = (LBTClientWritevContext*)userData;
+    pContext->lenProcessed = 0;
+
+    if(g_clientContext.conn_id < 0)
+    {
+        //not connected yet
+
+        APP_LOG((char*)"[BTC]btClientWritev : not connected yet");
+        return true;
+    }
+
+    for (int i = 0; i < pContext->count; i++)
+    {
+        if (pContext->iov[i].len == 0)
+        {
+            continue;
+        }
+
+        VMINT ret = vm_btspp_write(g_clientContext.conn_id, (void*)pContext->iov[i].buf, pContext->iov[i].len);
+        APP_LOG("[BTC]btClientWritev, ret: %d", ret);
+        if (ret <= 0)
+        {
+            break;
+        }
+
+        pContext->lenProcessed += ret;
+        if ((size_t)ret < pContext->iov[i].len)
+        {
+            // SPP buffer full, the caller sees the short count
+            break;
+        }
+    }
+
+	return true;
+}
+
 boolean btClientWrite(void *userData)
 {
     LBTClientReadWriteContext* pContext = (LBTClientReadWriteContext*)userData;
@@ -26,6 +26,7 @@ boolean btClientScan(void *userData);
 boolean btClientGetDeviceInfo(void *userData);
 boolean btClientRead(void *userData);
 boolean btClientWrite(void *userData);
+boolean btClientWritev(void *userData);
 
 #ifdef __cplusplus
 }
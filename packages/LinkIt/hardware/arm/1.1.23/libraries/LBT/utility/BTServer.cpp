@@ -242,7 +242,6 @@ static int bt_server_spp_read(void* data)
 {
 	
 	  VMINT ret = 0;
-	  VMINT i = 0;
     if(g_serverContext.conn_id < 0)
     {
         //not connected yet
@@ -251,39 +250,54 @@ static int bt_server_spp_read(void* data)
 
         return true;
     }
-    char *readdata = new char[LBT_SERIAL_BUFFER_SIZE];
-    if(readdata == NULL)
-  	{
-  		APP_LOG((char*)"[BTC]bt_server_spp_read : allocate memory fail");
-  		return false;
-  	}
-    ret = vm_btspp_read(g_serverContext.conn_id, (void*)readdata, LBT_SERIAL_BUFFER_SIZE);
-
-    APP_LOG("[BTC]bt_server_spp_read, ret: %d", ret);
-
-    if (ret < 0)
+    if(server_mutex.guard == 0)
     {
-       APP_LOG((char*)"[BTC]bt_server_spp_read : read data fail");
-
+        vm_mutex_create(&server_mutex);
     }
-    else 
+    vm_mutex_lock(&server_mutex);
+
+    // read straight into the ring, in up to two pieces when it wraps
+    RingBufferBase *rx = LBTServer._rx_buffer;
+    VMINT total = 0;
+    for(;;)
     {
+        size_t len = 0;
+        uint8_t *dst = rx->writeBuffer(len);
+        if(len == 0)
+        {
+            // full: empty the connection anyway, so the next event reports
+            // new data, and count what is lost
+            char discard[LBT_RX_DISCARD_SIZE];
+            ret = vm_btspp_read(g_serverContext.conn_id, (void*)discard, sizeof(discard));
+            if(ret <= 0)
+            {
+                break;
+            }
+            rx->drop(ret);
+            continue;
+        }
 
-    	  if(server_mutex.guard == 0)
-    	  {
-    	      vm_mutex_create(&server_mutex);
-    	  }
-    	  vm_mutex_lock(&server_mutex);
-        for(i=0;i<ret;i++)
+        ret = vm_btspp_read(g_serverContext.conn_id, (void*)dst, len);
+        if(ret <= 0)
         {
-        	LBTServer._rx_buffer->store_char(readdata[i]);
+            break;
+        }
+        rx->commit(ret);
+        total += ret;
+        if((size_t)ret < len)
+        {
+            break;
         }
-        vm_mutex_unlock(&server_mutex);
+    }
+    vm_mutex_unlock(&server_mutex);
+
+    APP_LOG("[BTC]bt_server_spp_read, stored: %d", total);
 
-        APP_LOG((char*)"[BTC]btServerRead : read data success");
+    if (ret < 0)
+    {
+       APP_LOG((char*)"[BTC]bt_server_spp_read : read data fail");
     }
-    delete[] readdata;
-	return ret;
+	return total;
 }
 
 static void bt_server_spp_cb(VMUINT evt, void * param, void * user_data)
@@ -393,9 +407,8 @@ static void bt_server_spp_cb(VMUINT evt, void * param, void * user_data)
         case VM_SRV_SPP_EVENT_READY_TO_READ:
         {
         	  bt_server_spp_read(NULL);
-        	#if(0)
+            // wakes waitAvailable()
             g_serverContext.ptr->post_signal_read();
-            #endif
             break;
         }
 
@@ -740,6 +753,42 @@ boolean btServerRead(void *userData)
 	return true;
 }
 
+boolean btServerWritev(void *userData)
+{
+    LBTServerWritevContext* pContext = (LBTServerWritevContext*)userData;
+    pContext->lenProcessed = 0;
+
+    if(g_serverContext.conn_id < 0)
+    {
+        //not connected yet
+        return true;
+    }
+
+    for (int i = 0; i < pContext->count; i++)
+    {
+        if (pContext->iov[i].len == 0)
+        {
+            continue;
+        }
+
+        VMINT ret = vm_btspp_write(g_serverContext.conn_id, (void*)pContext->iov[i].buf, pContext->iov[i].len);
+        APP_LOG("vm_btspp_write ret[%d]", ret);
+        if (ret <= 0)
+        {
+            break;
+        }
+
+        pContext->lenProcessed += ret;
+        if ((size_t)ret < pContext->iov[i].len)
+        {
+            // SPP buffer full, the caller sees the short count
+            break;
+        }
+    }
+
+	return true;
+}
+
 boolean btServerWrite(void *userData)
 {
     LBTServerReadWriteContext* pContext = (LBTServerReadWriteContext*)userData;
@@ -28,6 +28,7 @@ boolean btServerConnected(void *userData);
 boolean btServerGetHostDeviceInfo(void *userData);
 boolean btServerRead(void *userData);
 boolean btServerWrite(void *userData);
+boolean btServerWritev(void *userData);
  
 #ifdef __cplusplus
 }
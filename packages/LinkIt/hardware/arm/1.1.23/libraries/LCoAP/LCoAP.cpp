@@ -0,0 +1,110 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include "LCoAP.h"
+
+LCoAP::LCoAP(LUDP &udp):
+	m_udp(udp)
+{
+}
+
+void LCoAP::begin()
+{
+	// new message ids and tokens per run, so a server does not take
+	// requests for duplicates of the previous run
+	reset((millis() << 12) ^ micros());
+}
+
+LCoapAddress LCoAP::address(IPAddress ip, uint16_t port)
+{
+	LCoapAddress addr;
+	for(int i = 0; i < 4; ++i)
+	{
+		addr.ip[i] = ip[i];
+	}
+	addr.port = port;
+	return addr;
+}
+
+int LCoAP::get(IPAddress ip, uint16_t port, const char *path, LCoapResponseHandler handler, void *userData,
+			   uint8_t *responseBuf, size_t responseSize)
+{
+	const int id = request(address(ip, port), LCOAP_GET, path, NULL, 0, LCOAP_FORMAT_NONE,
+						   handler, userData, responseBuf, responseSize);
+	sendQueued();
+	return id;
+}
+
+int LCoAP::send(IPAddress ip, uint16_t port, uint8_t method, const char *path,
+				const uint8_t *payload, size_t len, int contentFormat,
+				LCoapResponseHandler handler, void *userData, boolean confirmable)
+{
+	const int id = request(address(ip, port), method, path, payload, len, contentFormat,
+						   handler, userData, NULL, 0, confirmable);
+	sendQueued();
+	return id;
+}
+
+int LCoAP::observe(IPAddress ip, uint16_t port, const char *path, LCoapResponseHandler handler, void *userData)
+{
+	const int id = LCoapEndpoint::observe(address(ip, port), path, handler, userData);
+	sendQueued();
+	return id;
+}
+
+void LCoAP::poll()
+{
+	while(m_udp.parsePacket())
+	{
+		const int len = m_udp.read(m_rxPacket, sizeof(m_rxPacket));
+		if(len > 0)
+		{
+			input(address(m_udp.remoteIP(), m_udp.remotePort()), m_rxPacket, len);
+		}
+		m_udp.flush();
+	}
+
+	tick();
+	sendQueued();
+}
+
+void LCoAP::transmit(const LCoapAddress &to, const uint8_t *buf, size_t len)
+{
+	// queued, so the answers to one poll() cost one hop
+	const IPAddress ip(to.ip[0], to.ip[1], to.ip[2], to.ip[3]);
+	if(!m_udp.beginPacket(ip, to.port))
+	{
+		sendQueued();
+		if(!m_udp.beginPacket(ip, to.port))
+		{
+			// counts as lost; confirmable messages are sent again
+			return;
+		}
+	}
+	m_udp.write(buf, len);
+	m_udp.queuePacket();
+}
+
+uint32_t LCoAP::clock()
+{
+	return millis();
+}
+
+void LCoAP::sendQueued()
+{
+	if(m_udp.queuedPackets())
+	{
+		m_udp.sendQueued();
+	}
+}
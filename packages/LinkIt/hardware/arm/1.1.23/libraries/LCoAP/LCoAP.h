@@ -0,0 +1,165 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LCoAP_h
+#define _LCoAP_h
+
+#include <Arduino.h>
+#include <LUdp.h>
+#include "LCoapEndpoint.h"
+
+//LCoAP Class
+//
+// CoAP (RFC 7252) client and server for constrained uplinks, where HTTP over
+// TCP costs several round trips before the first byte of data. A request is
+// one datagram and its response another; confirmable messages are sent again
+// until acknowledged. Many requests can be in progress at once, matched to
+// their responses by token. Payloads above LCOAP_BLOCK_SIZE are carried
+// block-wise (Block1 and Block2), and Observe lets a client receive updates
+// of a resource without polling.
+//
+// LCoAP runs on top of an LWiFiUDP or LGPRSUDP object, which chooses the
+// network. Messages are kept in a fixed pool inside the object; nothing is
+// allocated at run time. Response and resource handlers run on the Arduino
+// thread, inside poll().
+//
+// The protocol engine is shared with the Linux adapter in extras/host of this
+// library, and both talk to any RFC 7252 peer, e.g. libcoap's coap-client.
+//
+// EXAMPLE:
+// <code>
+//     LWiFiUDP udp;
+//     LCoAP coap(udp);
+//     udp.begin(LCOAP_DEFAULT_PORT);
+//     coap.begin();
+//     coap.addResource("sensors/temp", readTemp, NULL, true);
+//     coap.get(IPAddress(192, 168, 1, 10), LCOAP_DEFAULT_PORT, "config", onConfig, NULL);
+//     ...
+//     coap.poll();   // call often, e.g. once per loop()
+// </code>
+class LCoAP : public LCoapEndpoint
+{
+public:
+  // DESCRIPTION
+  //   Constructs a CoAP endpoint on top of a UDP object.
+  // 
+  // PARAMETERS
+  //   udp: an LWiFiUDP or LGPRSUDP object; begin() it with the local port
+  //        (usually LCOAP_DEFAULT_PORT) before use
+  LCoAP(LUDP &udp);
+
+  // DESCRIPTION
+  //   Starts the endpoint, dropping requests and observers of an earlier run.
+  //   Registered resources are kept.
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   N/A
+  void begin();
+
+  // DESCRIPTION
+  //   Sends a GET request.
+  // 
+  // PARAMETERS
+  //   ip: IP address of the server
+  //   port: UDP port of the server
+  //   path: resource path, e.g. "sensors/temp"; must stay valid until the request ends
+  //   handler: called with the response, or with the reason there is none
+  //   userData: passed to handler
+  //   responseBuf: buffer for a block-wise response; NULL to get it block by block
+  //   responseSize: size of responseBuf
+  // 
+  // RETURNS
+  //   An exchange id for cancel() and pending(), -1 if too many requests are in progress.
+  int get(IPAddress ip, uint16_t port, const char *path, LCoapResponseHandler handler, void *userData,
+          uint8_t *responseBuf = NULL, size_t responseSize = 0);
+
+  // DESCRIPTION
+  //   Sends a POST or PUT request with a payload. Payloads above
+  //   LCOAP_BLOCK_SIZE bytes are sent block-wise.
+  // 
+  // PARAMETERS
+  //   ip: IP address of the server
+  //   port: UDP port of the server
+  //   method: LCOAP_POST or LCOAP_PUT
+  //   path: resource path; must stay valid until the request ends
+  //   payload: data to send; must stay valid until the request ends
+  //   len: size of payload in bytes
+  //   contentFormat: LCOAP_FORMAT_TEXT, LCOAP_FORMAT_JSON, ...
+  //   handler: called with the response, or with the reason there is none
+  //   userData: passed to handler
+  //   confirmable: false to send a non-confirmable request, which is not repeated
+  // 
+  // RETURNS
+  //   An exchange id for cancel() and pending(), -1 if too many requests are in progress.
+  int send(IPAddress ip, uint16_t port, uint8_t method, const char *path,
+           const uint8_t *payload, size_t len, int contentFormat,
+           LCoapResponseHandler handler, void *userData, boolean confirmable = true);
+
+  // DESCRIPTION
+  //   Registers as observer of a resource. handler is called with
+  //   LCOAP_RESULT_NOTIFICATION for every update until cancel().
+  // 
+  // PARAMETERS
+  //   ip: IP address of the server
+  //   port: UDP port of the server
+  //   path: resource path; must stay valid until the observation ends
+  //   handler: called with each notification
+  //   userData: passed to handler
+  // 
+  // RETURNS
+  //   An exchange id for cancel(), -1 if too many requests are in progress.
+  int observe(IPAddress ip, uint16_t port, const char *path, LCoapResponseHandler handler, void *userData);
+
+  // DESCRIPTION
+  //   Receives pending datagrams, runs response and resource handlers,
+  //   repeats unacknowledged messages and times out requests.
+  //   Call it often, e.g. once per loop().
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   N/A
+  void poll();
+
+  // DESCRIPTION
+  //   Converts an IP address and port for the LCoapEndpoint methods.
+  // 
+  // PARAMETERS
+  //   ip: IP address
+  //   port: UDP port
+  // 
+  // RETURNS
+  //   The address.
+  static LCoapAddress address(IPAddress ip, uint16_t port);
+
+  // addResource(), notify(), cancel(), pending() and the other methods of
+  // LCoapEndpoint can be used directly.
+  using LCoapEndpoint::observe;
+
+protected:
+  /* DOM-NOT_FOR_SDK-BEGIN */
+  virtual void transmit(const LCoapAddress &to, const uint8_t *buf, size_t len);
+  virtual uint32_t clock();
+  void sendQueued();
+
+  LUDP &m_udp;
+  uint8_t m_rxPacket[LCOAP_MAX_MESSAGE];
+  /* DOM-NOT_FOR_SDK-END */
+};
+
+#endif
@@ -0,0 +1,870 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include <string.h>
+#include "LCoapEndpoint.h"
+
+#define LCOAP_CLASS(code) ((code) >> 5)
+
+// wrap-safe: time t has come
+#define LCOAP_DUE(now, t) ((int32_t)((now) - (t)) >= 0)
+
+// RFC 7641: a notification older than this may carry a smaller Observe value
+#define LCOAP_OBSERVE_FRESHNESS 128000
+
+LCoapEndpoint::LCoapEndpoint():
+	m_resourceCount(0)
+{
+	reset(0);
+}
+
+LCoapEndpoint::~LCoapEndpoint()
+{
+}
+
+void LCoapEndpoint::reset(uint32_t seed)
+{
+	m_random = seed ? seed : 0x2545F491;
+	m_nextMessageId = (uint16_t)random();
+
+	for(int i = 0; i < LCOAP_MAX_EXCHANGES; ++i)
+	{
+		m_exchanges[i].used = false;
+		m_exchanges[i].tx.pool = -1;
+	}
+	for(int i = 0; i < LCOAP_MAX_OBSERVERS; ++i)
+	{
+		m_observers[i].used = false;
+		m_observers[i].tx.pool = -1;
+	}
+	for(int i = 0; i < LCOAP_DEDUP_SIZE; ++i)
+	{
+		m_dedup[i].used = false;
+		m_dedup[i].pool = -1;
+	}
+	for(int i = 0; i < LCOAP_POOL_SIZE; ++i)
+	{
+		m_pool[i].used = false;
+	}
+}
+
+bool LCoapEndpoint::addResource(const char *path, LCoapResourceHandler handler, void *userData, bool observable)
+{
+	if(m_resourceCount == LCOAP_MAX_RESOURCES)
+	{
+		return false;
+	}
+
+	Resource &res = m_resources[m_resourceCount++];
+	res.path = path;
+	res.handler = handler;
+	res.userData = userData;
+	res.observable = observable;
+	return true;
+}
+
+bool LCoapEndpoint::sameAddress(const LCoapAddress &a, const LCoapAddress &b)
+{
+	return a.port == b.port && memcmp(a.ip, b.ip, 4) == 0;
+}
+
+uint32_t LCoapEndpoint::random()
+{
+	// xorshift32
+	m_random ^= m_random << 13;
+	m_random ^= m_random >> 17;
+	m_random ^= m_random << 5;
+	return m_random;
+}
+
+int LCoapEndpoint::allocPool()
+{
+	for(int i = 0; i < LCOAP_POOL_SIZE; ++i)
+	{
+		if(!m_pool[i].used)
+		{
+			m_pool[i].used = true;
+			return i;
+		}
+	}
+	return -1;
+}
+
+int LCoapEndpoint::freePoolCount() const
+{
+	int count = 0;
+	for(int i = 0; i < LCOAP_POOL_SIZE; ++i)
+	{
+		if(!m_pool[i].used)
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+void LCoapEndpoint::freePool(int &pool)
+{
+	if(pool >= 0)
+	{
+		m_pool[pool].used = false;
+		pool = -1;
+	}
+}
+
+void LCoapEndpoint::startTransmission(Transmission &tx, const LCoapAddress &to, const uint8_t *buf, size_t len)
+{
+	// without a free buffer the message is sent once, without retransmission
+	tx.pool = allocPool();
+	if(tx.pool >= 0)
+	{
+		memcpy(m_pool[tx.pool].data, buf, len);
+		m_pool[tx.pool].len = (uint16_t)len;
+	}
+
+	// RFC 7252: initial timeout between ACK_TIMEOUT and 1.5 times it
+	tx.retries = 0;
+	tx.timeout = LCOAP_ACK_TIMEOUT + random() % (LCOAP_ACK_TIMEOUT / 2);
+	tx.nextAt = clock() + tx.timeout;
+	transmit(to, buf, len);
+}
+
+bool LCoapEndpoint::retransmit(Transmission &tx, const LCoapAddress &to)
+{
+	if(tx.retries >= LCOAP_MAX_RETRANSMIT)
+	{
+		freePool(tx.pool);
+		return false;
+	}
+
+	tx.retries++;
+	tx.timeout *= 2;
+	tx.nextAt = clock() + tx.timeout;
+	transmit(to, m_pool[tx.pool].data, m_pool[tx.pool].len);
+	return true;
+}
+
+void LCoapEndpoint::sendEmpty(const LCoapAddress &to, uint8_t type, uint16_t messageId)
+{
+	LCoapMessage msg;
+	msg.type = type;
+	msg.code = LCOAP_EMPTY;
+	msg.messageId = messageId;
+	const size_t len = msg.serialize(m_packet, sizeof(m_packet));
+	transmit(to, m_packet, len);
+}
+
+int LCoapEndpoint::startExchange(const LCoapAddress &server, uint8_t method, const char *path,
+								 const uint8_t *payload, size_t len, int contentFormat,
+								 LCoapResponseHandler handler, void *userData,
+								 uint8_t *responseBuf, size_t responseSize, bool confirmable, bool observe)
+{
+	int id = -1;
+	for(int i = 0; i < LCOAP_MAX_EXCHANGES; ++i)
+	{
+		if(!m_exchanges[i].used)
+		{
+			id = i;
+			break;
+		}
+	}
+	if(id < 0)
+	{
+		return -1;
+	}
+
+	Exchange &ex = m_exchanges[id];
+	ex.used = true;
+	ex.peer = server;
+	const uint32_t token = random();
+	memcpy(ex.token, &token, sizeof(ex.token));
+	ex.method = method;
+	ex.confirmable = confirmable;
+	ex.observe = observe;
+	ex.observing = false;
+	ex.waiting = true;
+	ex.lastObserve = 0;
+	ex.lastObserveAt = 0;
+	ex.path = path;
+	ex.payload = payload;
+	ex.payloadLen = len;
+	ex.contentFormat = contentFormat;
+	ex.block1Num = 0;
+	ex.block2Num = 0;
+	ex.block2Szx = LCOAP_BLOCK_SZX;
+	ex.respBuf = responseBuf;
+	ex.respSize = responseSize;
+	ex.handler = handler;
+	ex.userData = userData;
+	ex.tx.pool = -1;
+
+	sendRequest(ex);
+	return ex.used ? id : -1;
+}
+
+int LCoapEndpoint::request(const LCoapAddress &server, uint8_t method, const char *path,
+						   const uint8_t *payload, size_t len, int contentFormat,
+						   LCoapResponseHandler handler, void *userData,
+						   uint8_t *responseBuf, size_t responseSize, bool confirmable)
+{
+	return startExchange(server, method, path, payload, len, contentFormat, handler, userData,
+						 responseBuf, responseSize, confirmable, false);
+}
+
+int LCoapEndpoint::observe(const LCoapAddress &server, const char *path, LCoapResponseHandler handler, void *userData)
+{
+	return startExchange(server, LCOAP_GET, path, NULL, 0, LCOAP_FORMAT_NONE, handler, userData,
+						 NULL, 0, true, true);
+}
+
+void LCoapEndpoint::cancel(int id)
+{
+	if(id >= 0 && id < LCOAP_MAX_EXCHANGES && m_exchanges[id].used)
+	{
+		freePool(m_exchanges[id].tx.pool);
+		m_exchanges[id].used = false;
+	}
+}
+
+bool LCoapEndpoint::pending(int id) const
+{
+	return id >= 0 && id < LCOAP_MAX_EXCHANGES && m_exchanges[id].used;
+}
+
+void LCoapEndpoint::sendRequest(Exchange &ex)
+{
+	LCoapMessage msg;
+	msg.type = ex.confirmable ? LCOAP_CON : LCOAP_NON;
+	msg.code = ex.method;
+	msg.messageId = m_nextMessageId++;
+	msg.setToken(ex.token, sizeof(ex.token));
+
+	// later blocks of a notification are fetched without registering again
+	if(ex.observe && ex.block2Num == 0)
+	{
+		msg.addUintOption(LCOAP_OPTION_OBSERVE, 0);
+	}
+	msg.addPath(ex.path);
+	if(ex.payloadLen && ex.contentFormat >= 0)
+	{
+		msg.addUintOption(LCOAP_OPTION_CONTENT_FORMAT, ex.contentFormat);
+	}
+
+	if(ex.payloadLen > LCOAP_BLOCK_SIZE)
+	{
+		const size_t offset = ex.block1Num * LCOAP_BLOCK_SIZE;
+		const bool more = offset + LCOAP_BLOCK_SIZE < ex.payloadLen;
+		msg.addBlock(LCOAP_OPTION_BLOCK1, ex.block1Num, more, LCOAP_BLOCK_SZX);
+		if(ex.block1Num == 0)
+		{
+			msg.addUintOption(LCOAP_OPTION_SIZE1, ex.payloadLen);
+		}
+		msg.payload = ex.payload + offset;
+		msg.payloadLen = more ? LCOAP_BLOCK_SIZE : ex.payloadLen - offset;
+	}
+	else
+	{
+		msg.payload = ex.payload;
+		msg.payloadLen = ex.payloadLen;
+	}
+
+	if(ex.block2Num)
+	{
+		msg.addBlock(LCOAP_OPTION_BLOCK2, ex.block2Num, false, ex.block2Szx);
+	}
+
+	const size_t len = msg.serialize(m_packet, sizeof(m_packet));
+	if(len == 0)
+	{
+		finish(ex, LCOAP_RESULT_FAILED, NULL);
+		return;
+	}
+
+	freePool(ex.tx.pool);
+	ex.tx.messageId = msg.messageId;
+	ex.waiting = true;
+	ex.deadline = clock() + LCOAP_RESPONSE_TIMEOUT;
+	if(ex.confirmable)
+	{
+		startTransmission(ex.tx, ex.peer, m_packet, len);
+	}
+	else
+	{
+		transmit(ex.peer, m_packet, len);
+	}
+}
+
+void LCoapEndpoint::finish(Exchange &ex, LCoapResult result, const LCoapMessage *response)
+{
+	// free first, so the handler can start a new request
+	freePool(ex.tx.pool);
+	ex.used = false;
+	if(ex.handler)
+	{
+		ex.handler(ex.userData, result, response);
+	}
+}
+
+void LCoapEndpoint::input(const LCoapAddress &from, const uint8_t *buf, size_t len)
+{
+	LCoapMessage msg;
+	if(!msg.parse(buf, len))
+	{
+		// a confirmable message that cannot be processed is rejected
+		if(len >= 4 && (buf[0] >> 6) == 1 && ((buf[0] >> 4) & 0x03) == LCOAP_CON)
+		{
+			sendEmpty(from, LCOAP_RST, (buf[2] << 8) | buf[3]);
+		}
+		return;
+	}
+
+	if(msg.code == LCOAP_EMPTY)
+	{
+		handleEmpty(from, msg);
+	}
+	else if(LCOAP_CLASS(msg.code) == 0)
+	{
+		handleRequest(from, msg);
+	}
+	else if(LCOAP_CLASS(msg.code) >= 2)
+	{
+		handleResponse(from, msg);
+	}
+	else if(msg.type == LCOAP_CON)
+	{
+		sendEmpty(from, LCOAP_RST, msg.messageId);
+	}
+}
+
+void LCoapEndpoint::handleEmpty(const LCoapAddress &from, const LCoapMessage &msg)
+{
+	if(msg.type == LCOAP_CON)
+	{
+		// ping
+		sendEmpty(from, LCOAP_RST, msg.messageId);
+		return;
+	}
+	if(msg.type != LCOAP_ACK && msg.type != LCOAP_RST)
+	{
+		return;
+	}
+
+	for(int i = 0; i < LCOAP_MAX_EXCHANGES; ++i)
+	{
+		Exchange &ex = m_exchanges[i];
+		if(!ex.used || ex.tx.messageId != msg.messageId || !sameAddress(ex.peer, from))
+		{
+			continue;
+		}
+		if(msg.type == LCOAP_RST)
+		{
+			finish(ex, LCOAP_RESULT_RESET, NULL);
+		}
+		else
+		{
+			// a separate response follows
+			freePool(ex.tx.pool);
+			ex.deadline = clock() + LCOAP_RESPONSE_TIMEOUT;
+		}
+		return;
+	}
+
+	for(int i = 0; i < LCOAP_MAX_OBSERVERS; ++i)
+	{
+		Observer &obs = m_observers[i];
+		if(!obs.used || obs.tx.messageId != msg.messageId || !sameAddress(obs.peer, from))
+		{
+			continue;
+		}
+		freePool(obs.tx.pool);
+		if(msg.type == LCOAP_RST)
+		{
+			// the client lost interest
+			obs.used = false;
+		}
+		return;
+	}
+}
+
+int LCoapEndpoint::findResource(const LCoapMessage &msg) const
+{
+	for(int i = 0; i < m_resourceCount; ++i)
+	{
+		if(msg.pathEquals(m_resources[i].path))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+uint8_t LCoapEndpoint::runHandler(int resource, const LCoapMessage &request, uint32_t block2Num, uint8_t szx, LCoapMessage &response)
+{
+	const Resource &res = m_resources[resource];
+	LCoapResponse r;
+	r.buf = m_block;
+	r.capacity = 16 << szx;
+	r.offset = block2Num * r.capacity;
+	r.len = 0;
+	r.total = 0;
+	r.contentFormat = LCOAP_FORMAT_NONE;
+
+	const uint8_t code = res.handler(res.userData, request, r);
+	if(r.len > r.capacity)
+	{
+		r.len = r.capacity;
+	}
+
+	if(r.contentFormat >= 0)
+	{
+		response.addUintOption(LCOAP_OPTION_CONTENT_FORMAT, r.contentFormat);
+	}
+
+	const size_t total = r.total ? r.total : r.offset + r.len;
+	const bool more = r.offset + r.len < total;
+	if(block2Num || more)
+	{
+		response.addBlock(LCOAP_OPTION_BLOCK2, block2Num, more, szx);
+		if(block2Num == 0)
+		{
+			response.addUintOption(LCOAP_OPTION_SIZE2, total);
+		}
+	}
+	response.payload = m_block;
+	response.payloadLen = r.len;
+	return code;
+}
+
+void LCoapEndpoint::handleRequest(const LCoapAddress &from, const LCoapMessage &msg)
+{
+	if(msg.type != LCOAP_CON && msg.type != LCOAP_NON)
+	{
+		return;
+	}
+
+	const uint32_t now = clock();
+	if(msg.type == LCOAP_CON)
+	{
+		for(int i = 0; i < LCOAP_DEDUP_SIZE; ++i)
+		{
+			Dedup &d = m_dedup[i];
+			if(d.used && d.messageId == msg.messageId && sameAddress(d.peer, from))
+			{
+				// the ACK got lost: answer again without running the handler
+				if(d.pool >= 0)
+				{
+					transmit(from, m_pool[d.pool].data, m_pool[d.pool].len);
+					return;
+				}
+				break;
+			}
+		}
+	}
+
+	LCoapMessage resp;
+	resp.type = (msg.type == LCOAP_CON) ? LCOAP_ACK : LCOAP_NON;
+	resp.messageId = (msg.type == LCOAP_CON) ? msg.messageId : m_nextMessageId++;
+	resp.setToken(msg.token, msg.tokenLen);
+
+	const int resource = findResource(msg);
+	if(resource < 0)
+	{
+		resp.code = LCOAP_NOT_FOUND;
+	}
+	else
+	{
+		uint32_t num = 0;
+		bool more = false;
+		uint8_t szx = LCOAP_BLOCK_SZX;
+		if(msg.block(LCOAP_OPTION_BLOCK2, num, more, szx))
+		{
+			// the client may ask for smaller blocks, not larger ones
+			if(szx > LCOAP_BLOCK_SZX)
+			{
+				szx = LCOAP_BLOCK_SZX;
+			}
+		}
+		else
+		{
+			num = 0;
+			szx = LCOAP_BLOCK_SZX;
+		}
+
+		Observer *pObs = NULL;
+		uint32_t observe = 0;
+		if(msg.code == LCOAP_GET && num == 0 && m_resources[resource].observable &&
+		   msg.uintOption(LCOAP_OPTION_OBSERVE, observe))
+		{
+			Observer *pFree = NULL;
+			for(int i = 0; i < LCOAP_MAX_OBSERVERS; ++i)
+			{
+				Observer &obs = m_observers[i];
+				if(!obs.used)
+				{
+					pFree = pFree ? pFree : &obs;
+				}
+				else if(sameAddress(obs.peer, from) && msg.tokenEquals(obs.token, obs.tokenLen))
+				{
+					pObs = &obs;
+				}
+			}
+
+			if(observe == 1 && pObs)
+			{
+				freePool(pObs->tx.pool);
+				pObs->used = false;
+				pObs = NULL;
+			}
+			else if(observe == 0)
+			{
+				if(pObs == NULL && pFree)
+				{
+					// when all are used the client gets a plain response
+					pObs = pFree;
+					pObs->used = true;
+					pObs->peer = from;
+					memcpy(pObs->token, msg.token, msg.tokenLen);
+					pObs->tokenLen = msg.tokenLen;
+					pObs->resource = resource;
+					pObs->seq = 0;
+					pObs->count = 0;
+					pObs->tx.pool = -1;
+					pObs->tx.messageId = resp.messageId;
+				}
+			}
+			else
+			{
+				pObs = NULL;
+			}
+		}
+
+		uint8_t code = runHandler(resource, msg, num, szx, resp);
+
+		uint32_t block1Num = 0;
+		bool block1More = false;
+		uint8_t block1Szx = 0;
+		if(msg.block(LCOAP_OPTION_BLOCK1, block1Num, block1More, block1Szx))
+		{
+			if(block1More && LCOAP_CLASS(code) == 2)
+			{
+				code = LCOAP_CONTINUE;
+			}
+			resp.addBlock(LCOAP_OPTION_BLOCK1, block1Num, block1More, block1Szx);
+		}
+
+		if(pObs)
+		{
+			if(LCOAP_CLASS(code) == 2)
+			{
+				resp.addUintOption(LCOAP_OPTION_OBSERVE, pObs->seq);
+			}
+			else
+			{
+				// an error ends the observation
+				freePool(pObs->tx.pool);
+				pObs->used = false;
+			}
+		}
+		resp.code = code;
+	}
+
+	size_t len = resp.serialize(m_packet, sizeof(m_packet));
+	if(len == 0)
+	{
+		resp.clear();
+		resp.type = (msg.type == LCOAP_CON) ? LCOAP_ACK : LCOAP_NON;
+		resp.messageId = (msg.type == LCOAP_CON) ? msg.messageId : m_nextMessageId++;
+		resp.setToken(msg.token, msg.tokenLen);
+		resp.code = LCOAP_INTERNAL_SERVER_ERROR;
+		len = resp.serialize(m_packet, sizeof(m_packet));
+	}
+	transmit(from, m_packet, len);
+
+	if(msg.type != LCOAP_CON)
+	{
+		return;
+	}
+
+	// remember the request, replacing the oldest one
+	Dedup *pDedup = &m_dedup[0];
+	for(int i = 0; i < LCOAP_DEDUP_SIZE; ++i)
+	{
+		if(!m_dedup[i].used)
+		{
+			pDedup = &m_dedup[i];
+			break;
+		}
+		if(LCOAP_DUE(pDedup->at, m_dedup[i].at))
+		{
+			pDedup = &m_dedup[i];
+		}
+	}
+	freePool(pDedup->pool);
+	pDedup->used = true;
+	pDedup->peer = from;
+	pDedup->messageId = msg.messageId;
+	pDedup->at = now;
+	// keep a buffer free for retransmissions
+	if(freePoolCount() > 1)
+	{
+		pDedup->pool = allocPool();
+		memcpy(m_pool[pDedup->pool].data, m_packet, len);
+		m_pool[pDedup->pool].len = (uint16_t)len;
+	}
+}
+
+void LCoapEndpoint::handleResponse(const LCoapAddress &from, LCoapMessage &msg)
+{
+	Exchange *pEx = NULL;
+	for(int i = 0; i < LCOAP_MAX_EXCHANGES; ++i)
+	{
+		Exchange &ex = m_exchanges[i];
+		if(ex.used && sameAddress(ex.peer, from) && msg.tokenEquals(ex.token, sizeof(ex.token)))
+		{
+			pEx = &ex;
+			break;
+		}
+	}
+
+	if(pEx == NULL)
+	{
+		// unknown token, e.g. a notification after cancel(): tell the server
+		if(msg.type == LCOAP_CON || msg.type == LCOAP_NON)
+		{
+			sendEmpty(from, LCOAP_RST, msg.messageId);
+		}
+		return;
+	}
+
+	Exchange &ex = *pEx;
+	if(msg.type == LCOAP_ACK && msg.messageId != ex.tx.messageId)
+	{
+		// answer to an older message of this exchange
+		return;
+	}
+	if(msg.type == LCOAP_CON)
+	{
+		sendEmpty(from, LCOAP_ACK, msg.messageId);
+	}
+	freePool(ex.tx.pool);
+
+	const uint32_t now = clock();
+	uint32_t observe = 0;
+	const bool hasObserve = ex.observe && msg.uintOption(LCOAP_OPTION_OBSERVE, observe);
+	if(hasObserve && ex.observing)
+	{
+		// reordered notification
+		const uint32_t diff = (observe - ex.lastObserve) & 0xFFFFFF;
+		if((diff == 0 || diff >= 0x800000) && now - ex.lastObserveAt < LCOAP_OBSERVE_FRESHNESS)
+		{
+			return;
+		}
+	}
+	if(hasObserve)
+	{
+		// the server accepted the registration; later blocks carry no Observe
+		ex.observing = true;
+		ex.lastObserve = observe;
+		ex.lastObserveAt = now;
+	}
+
+	// next block of the request payload
+	if(msg.code == LCOAP_CONTINUE && (ex.block1Num + 1) * LCOAP_BLOCK_SIZE < ex.payloadLen)
+	{
+		ex.block1Num++;
+		sendRequest(ex);
+		return;
+	}
+
+	uint32_t num = 0;
+	bool more = false;
+	uint8_t szx = 0;
+	if(msg.block(LCOAP_OPTION_BLOCK2, num, more, szx))
+	{
+		const size_t offset = num * (16 << szx);
+		if(ex.respBuf)
+		{
+			if(offset + msg.payloadLen > ex.respSize)
+			{
+				finish(ex, LCOAP_RESULT_TOO_LARGE, NULL);
+				return;
+			}
+			memcpy(ex.respBuf + offset, msg.payload, msg.payloadLen);
+			if(more)
+			{
+				ex.block2Num = num + 1;
+				ex.block2Szx = szx;
+				sendRequest(ex);
+				return;
+			}
+			msg.payload = ex.respBuf;
+			msg.payloadLen = offset + msg.payloadLen;
+		}
+		else if(more)
+		{
+			if(ex.handler)
+			{
+				ex.handler(ex.userData, LCOAP_RESULT_BLOCK, &msg);
+			}
+			// the handler may have cancelled the exchange
+			if(ex.used)
+			{
+				ex.block2Num = num + 1;
+				ex.block2Szx = szx;
+				sendRequest(ex);
+			}
+			return;
+		}
+	}
+
+	if(ex.observing && LCOAP_CLASS(msg.code) == 2)
+	{
+		// stays registered; the server sends the next notification by itself
+		ex.waiting = false;
+		ex.block2Num = 0;
+		if(ex.handler)
+		{
+			ex.handler(ex.userData, LCOAP_RESULT_NOTIFICATION, &msg);
+		}
+		return;
+	}
+
+	finish(ex, LCOAP_RESULT_RESPONSE, &msg);
+}
+
+int LCoapEndpoint::sendNotification(Observer &obs)
+{
+	LCoapMessage req;
+	req.code = LCOAP_GET;
+	req.addPath(m_resources[obs.resource].path);
+	req.setToken(obs.token, obs.tokenLen);
+
+	LCoapMessage resp;
+	obs.count++;
+	obs.seq = (obs.seq + 1) & 0xFFFFFF;
+	resp.type = (obs.count % LCOAP_OBSERVE_CON_INTERVAL == 0) ? LCOAP_CON : LCOAP_NON;
+	resp.messageId = m_nextMessageId++;
+	resp.setToken(obs.token, obs.tokenLen);
+
+	const uint8_t code = runHandler(obs.resource, req, 0, LCOAP_BLOCK_SZX, resp);
+	if(LCOAP_CLASS(code) == 2)
+	{
+		resp.addUintOption(LCOAP_OPTION_OBSERVE, obs.seq);
+	}
+	resp.code = code;
+
+	const size_t len = resp.serialize(m_packet, sizeof(m_packet));
+	if(len == 0)
+	{
+		return 0;
+	}
+
+	// the newer state replaces one still being retransmitted
+	freePool(obs.tx.pool);
+	obs.tx.messageId = resp.messageId;
+	if(resp.type == LCOAP_CON)
+	{
+		startTransmission(obs.tx, obs.peer, m_packet, len);
+	}
+	else
+	{
+		transmit(obs.peer, m_packet, len);
+	}
+
+	if(LCOAP_CLASS(code) != 2)
+	{
+		freePool(obs.tx.pool);
+		obs.used = false;
+	}
+	return 1;
+}
+
+int LCoapEndpoint::notify(const char *path)
+{
+	int count = 0;
+	for(int r = 0; r < m_resourceCount; ++r)
+	{
+		if(strcmp(m_resources[r].path, path) != 0)
+		{
+			continue;
+		}
+		for(int i = 0; i < LCOAP_MAX_OBSERVERS; ++i)
+		{
+			if(m_observers[i].used && m_observers[i].resource == r)
+			{
+				count += sendNotification(m_observers[i]);
+			}
+		}
+	}
+	return count;
+}
+
+int LCoapEndpoint::observerCount(const char *path) const
+{
+	int count = 0;
+	for(int i = 0; i < LCOAP_MAX_OBSERVERS; ++i)
+	{
+		const Observer &obs = m_observers[i];
+		if(obs.used && strcmp(m_resources[obs.resource].path, path) == 0)
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+void LCoapEndpoint::tick()
+{
+	const uint32_t now = clock();
+
+	for(int i = 0; i < LCOAP_MAX_EXCHANGES; ++i)
+	{
+		Exchange &ex = m_exchanges[i];
+		if(!ex.used)
+		{
+			continue;
+		}
+		if(ex.tx.pool >= 0)
+		{
+			if(LCOAP_DUE(now, ex.tx.nextAt) && !retransmit(ex.tx, ex.peer))
+			{
+				finish(ex, LCOAP_RESULT_TIMEOUT, NULL);
+			}
+		}
+		else if(ex.waiting && LCOAP_DUE(now, ex.deadline))
+		{
+			finish(ex, LCOAP_RESULT_TIMEOUT, NULL);
+		}
+	}
+
+	for(int i = 0; i < LCOAP_MAX_OBSERVERS; ++i)
+	{
+		Observer &obs = m_observers[i];
+		if(obs.used && obs.tx.pool >= 0 && LCOAP_DUE(now, obs.tx.nextAt) && !retransmit(obs.tx, obs.peer))
+		{
+			// the client is gone
+			obs.used = false;
+		}
+	}
+
+	for(int i = 0; i < LCOAP_DEDUP_SIZE; ++i)
+	{
+		Dedup &d = m_dedup[i];
+		if(d.used && now - d.at >= LCOAP_DEDUP_LIFETIME)
+		{
+			freePool(d.pool);
+			d.used = false;
+		}
+	}
+}
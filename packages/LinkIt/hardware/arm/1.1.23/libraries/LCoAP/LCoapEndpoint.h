@@ -0,0 +1,278 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LCoapEndpoint_h
+#define _LCoapEndpoint_h
+
+#include "LCoapMessage.h"
+
+// CoAP client and server engine, shared with the Linux adapter in extras/host.
+// It has no platform dependency: the owner feeds received datagrams to
+// input(), calls tick() regularly and sends what transmit() hands out.
+// All buffers are fixed size members, nothing is allocated at run time.
+// Handlers run in input() and tick(), so on the thread that calls them.
+
+// message buffers kept for retransmission and for answering duplicates
+#ifndef LCOAP_POOL_SIZE
+#define LCOAP_POOL_SIZE 6
+#endif
+
+// client requests and observations in progress
+#ifndef LCOAP_MAX_EXCHANGES
+#define LCOAP_MAX_EXCHANGES 8
+#endif
+
+#ifndef LCOAP_MAX_RESOURCES
+#define LCOAP_MAX_RESOURCES 8
+#endif
+
+// clients observing resources of this server
+#ifndef LCOAP_MAX_OBSERVERS
+#define LCOAP_MAX_OBSERVERS 4
+#endif
+
+// recent confirmable requests remembered to detect duplicates
+#ifndef LCOAP_DEDUP_SIZE
+#define LCOAP_DEDUP_SIZE 8
+#endif
+
+// block size exponent for Block1/Block2 transfers: 16 << LCOAP_BLOCK_SZX bytes
+#ifndef LCOAP_BLOCK_SZX
+#define LCOAP_BLOCK_SZX 4
+#endif
+#define LCOAP_BLOCK_SIZE (16 << LCOAP_BLOCK_SZX)
+
+// RFC 7252 transmission parameters, in milliseconds
+#ifndef LCOAP_ACK_TIMEOUT
+#define LCOAP_ACK_TIMEOUT 2000
+#endif
+#ifndef LCOAP_MAX_RETRANSMIT
+#define LCOAP_MAX_RETRANSMIT 4
+#endif
+
+// longest wait for a separate or non-confirmable response
+#ifndef LCOAP_RESPONSE_TIMEOUT
+#define LCOAP_RESPONSE_TIMEOUT 60000
+#endif
+
+// how long a request id is remembered for duplicate detection
+#ifndef LCOAP_DEDUP_LIFETIME
+#define LCOAP_DEDUP_LIFETIME 60000
+#endif
+
+// every Nth notification is confirmable, to find out when an observer is gone
+#ifndef LCOAP_OBSERVE_CON_INTERVAL
+#define LCOAP_OBSERVE_CON_INTERVAL 8
+#endif
+
+struct LCoapAddress
+{
+  uint8_t ip[4];
+  uint16_t port;
+};
+
+// why a response handler is called
+enum LCoapResult
+{
+  LCOAP_RESULT_RESPONSE,      // final response; for Block2 with a response buffer, the whole representation
+  LCOAP_RESULT_NOTIFICATION,  // a notification of an observed resource, more may follow
+  LCOAP_RESULT_BLOCK,         // one block of a Block2 transfer without response buffer, more follow
+  LCOAP_RESULT_TIMEOUT,       // no response; response is NULL
+  LCOAP_RESULT_RESET,         // the server rejected the message; response is NULL
+  LCOAP_RESULT_TOO_LARGE,     // the representation did not fit the response buffer; response is NULL
+  LCOAP_RESULT_FAILED         // the request could not be sent; response is NULL
+};
+
+typedef void (*LCoapResponseHandler)(void *userData, LCoapResult result, const LCoapMessage *response);
+
+// what a resource handler fills in
+struct LCoapResponse
+{
+  uint8_t *buf;           // payload buffer, capacity bytes
+  size_t capacity;
+  size_t offset;          // Block2: offset of buf in the whole representation
+  size_t len;             // payload bytes written to buf
+  size_t total;           // size of the whole representation; 0 if it is just len
+  int contentFormat;      // LCOAP_FORMAT_*, LCOAP_FORMAT_NONE by default
+};
+
+// handles a request to a resource and returns the response code, e.g. LCOAP_CONTENT.
+// For large representations, write bytes [offset, offset + capacity) of it and set total.
+typedef uint8_t (*LCoapResourceHandler)(void *userData, const LCoapMessage &request, LCoapResponse &response);
+
+class LCoapEndpoint
+{
+public:
+  LCoapEndpoint();
+  virtual ~LCoapEndpoint();
+
+  // drops exchanges, observers and remembered requests; resources stay.
+  // seed varies message ids and tokens between runs.
+  void reset(uint32_t seed);
+
+  // serves path, e.g. "sensors/temp". path must stay valid.
+  // observable resources accept Observe registrations, see notify().
+  // Returns false when LCOAP_MAX_RESOURCES are registered.
+  bool addResource(const char *path, LCoapResourceHandler handler, void *userData, bool observable = false);
+
+  // sends a request. path and payload must stay valid until the handler
+  // reports the end of the exchange. Payloads above LCOAP_BLOCK_SIZE are sent
+  // with Block1. A Block2 response is fetched block by block and assembled in
+  // responseBuf, or handed over block by block if responseBuf is NULL.
+  // Returns an exchange id, or -1 if LCOAP_MAX_EXCHANGES are in progress.
+  int request(const LCoapAddress &server, uint8_t method, const char *path,
+              const uint8_t *payload, size_t len, int contentFormat,
+              LCoapResponseHandler handler, void *userData,
+              uint8_t *responseBuf = NULL, size_t responseSize = 0, bool confirmable = true);
+
+  // registers as observer of path; handler gets each notification until cancel()
+  int observe(const LCoapAddress &server, const char *path, LCoapResponseHandler handler, void *userData);
+
+  // forgets an exchange without calling its handler. An observed server is
+  // told to stop at its next notification.
+  void cancel(int id);
+
+  // true while the exchange is in progress
+  bool pending(int id) const;
+
+  // sends the current state of path to its observers.
+  // Returns the number of notifications sent.
+  int notify(const char *path);
+
+  // number of clients observing path
+  int observerCount(const char *path) const;
+
+  // handles a datagram received from a peer
+  void input(const LCoapAddress &from, const uint8_t *buf, size_t len);
+
+  // retransmits and times out messages
+  void tick();
+
+protected:
+  // sends one datagram
+  virtual void transmit(const LCoapAddress &to, const uint8_t *buf, size_t len) = 0;
+
+  // current time in milliseconds
+  virtual uint32_t clock() = 0;
+
+private:
+  struct Transmission
+  {
+    int pool;               // buffer of the message being retransmitted, -1 if none
+    uint16_t messageId;
+    uint8_t retries;
+    uint32_t timeout;
+    uint32_t nextAt;
+  };
+
+  struct Exchange
+  {
+    bool used;
+    LCoapAddress peer;
+    uint8_t token[4];
+    uint8_t method;
+    bool confirmable;
+    bool observe;           // registers as observer
+    bool observing;         // a notification arrived
+    bool waiting;           // a response is due before deadline
+    uint32_t lastObserve;   // Observe value of the newest notification
+    uint32_t lastObserveAt;
+    const char *path;
+    const uint8_t *payload;
+    size_t payloadLen;
+    int contentFormat;
+    uint32_t block1Num;     // block of the payload being sent
+    uint32_t block2Num;     // block of the response being fetched
+    uint8_t block2Szx;
+    uint8_t *respBuf;
+    size_t respSize;
+    LCoapResponseHandler handler;
+    void *userData;
+    uint32_t deadline;      // end of the wait for a response
+    Transmission tx;
+  };
+
+  struct Resource
+  {
+    const char *path;
+    LCoapResourceHandler handler;
+    void *userData;
+    bool observable;
+  };
+
+  struct Observer
+  {
+    bool used;
+    LCoapAddress peer;
+    uint8_t token[LCOAP_MAX_TOKEN];
+    uint8_t tokenLen;
+    int resource;
+    uint32_t seq;           // value of the Observe option
+    uint32_t count;         // notifications sent
+    Transmission tx;
+  };
+
+  struct Dedup
+  {
+    bool used;
+    LCoapAddress peer;
+    uint16_t messageId;
+    uint32_t at;
+    int pool;               // the response sent, -1 if it could not be kept
+  };
+
+  struct PoolEntry
+  {
+    bool used;
+    uint16_t len;
+    uint8_t data[LCOAP_MAX_MESSAGE];
+  };
+
+  LCoapEndpoint(const LCoapEndpoint&);
+  LCoapEndpoint& operator=(const LCoapEndpoint&);
+
+  static bool sameAddress(const LCoapAddress &a, const LCoapAddress &b);
+  uint32_t random();
+  int allocPool();
+  int freePoolCount() const;
+  void freePool(int &pool);
+  void startTransmission(Transmission &tx, const LCoapAddress &to, const uint8_t *buf, size_t len);
+  bool retransmit(Transmission &tx, const LCoapAddress &to);
+  void sendEmpty(const LCoapAddress &to, uint8_t type, uint16_t messageId);
+  int startExchange(const LCoapAddress &server, uint8_t method, const char *path,
+                    const uint8_t *payload, size_t len, int contentFormat,
+                    LCoapResponseHandler handler, void *userData,
+                    uint8_t *responseBuf, size_t responseSize, bool confirmable, bool observe);
+  void sendRequest(Exchange &ex);
+  void finish(Exchange &ex, LCoapResult result, const LCoapMessage *response);
+  void handleRequest(const LCoapAddress &from, const LCoapMessage &msg);
+  void handleResponse(const LCoapAddress &from, LCoapMessage &msg);
+  void handleEmpty(const LCoapAddress &from, const LCoapMessage &msg);
+  int findResource(const LCoapMessage &msg) const;
+  uint8_t runHandler(int resource, const LCoapMessage &request, uint32_t block2Num, uint8_t szx, LCoapMessage &response);
+  int sendNotification(Observer &obs);
+
+  Exchange m_exchanges[LCOAP_MAX_EXCHANGES];
+  Resource m_resources[LCOAP_MAX_RESOURCES];
+  int m_resourceCount;
+  Observer m_observers[LCOAP_MAX_OBSERVERS];
+  Dedup m_dedup[LCOAP_DEDUP_SIZE];
+  PoolEntry m_pool[LCOAP_POOL_SIZE];
+  uint16_t m_nextMessageId;
+  uint32_t m_random;
+  uint8_t m_block[LCOAP_BLOCK_SIZE];      // payload written by resource handlers
+  uint8_t m_packet[LCOAP_MAX_MESSAGE];    // messages that are not retransmitted
+};
+
+#endif
@@ -0,0 +1,357 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include <string.h>
+#include "LCoapMessage.h"
+
+#define LCOAP_VERSION 1
+#define LCOAP_PAYLOAD_MARKER 0xFF
+
+LCoapMessage::LCoapMessage()
+{
+	clear();
+}
+
+void LCoapMessage::clear()
+{
+	type = LCOAP_CON;
+	code = LCOAP_EMPTY;
+	messageId = 0;
+	tokenLen = 0;
+	optionCount = 0;
+	payload = NULL;
+	payloadLen = 0;
+	m_uintCount = 0;
+}
+
+// reads the 4 bit delta or length nibble and its extended bytes
+static bool parseNibble(uint32_t nibble, const uint8_t *&p, const uint8_t *end, uint32_t &value)
+{
+	if(nibble < 13)
+	{
+		value = nibble;
+	}
+	else if(nibble == 13)
+	{
+		if(p + 1 > end)
+		{
+			return false;
+		}
+		value = *p++ + 13;
+	}
+	else if(nibble == 14)
+	{
+		if(p + 2 > end)
+		{
+			return false;
+		}
+		value = ((p[0] << 8) | p[1]) + 269;
+		p += 2;
+	}
+	else
+	{
+		// 15 is reserved for the payload marker
+		return false;
+	}
+	return true;
+}
+
+bool LCoapMessage::parse(const uint8_t *buf, size_t len)
+{
+	clear();
+	if(len < 4 || (buf[0] >> 6) != LCOAP_VERSION)
+	{
+		return false;
+	}
+
+	type = (buf[0] >> 4) & 0x03;
+	tokenLen = buf[0] & 0x0F;
+	code = buf[1];
+	messageId = (buf[2] << 8) | buf[3];
+	if(tokenLen > LCOAP_MAX_TOKEN || 4 + (size_t)tokenLen > len)
+	{
+		return false;
+	}
+	memcpy(token, buf + 4, tokenLen);
+
+	const uint8_t *p = buf + 4 + tokenLen;
+	const uint8_t *end = buf + len;
+	uint32_t number = 0;
+	while(p < end)
+	{
+		if(*p == LCOAP_PAYLOAD_MARKER)
+		{
+			p++;
+			if(p == end)
+			{
+				// a marker must be followed by a payload
+				return false;
+			}
+			payload = p;
+			payloadLen = end - p;
+			break;
+		}
+
+		const uint8_t head = *p++;
+		uint32_t delta = 0;
+		uint32_t optLen = 0;
+		if(!parseNibble(head >> 4, p, end, delta) || !parseNibble(head & 0x0F, p, end, optLen))
+		{
+			return false;
+		}
+		if(p + optLen > end || optionCount == LCOAP_MAX_OPTIONS)
+		{
+			return false;
+		}
+
+		number += delta;
+		LCoapOption &opt = options[optionCount++];
+		opt.number = (uint16_t)number;
+		opt.len = (uint16_t)optLen;
+		opt.value = p;
+		p += optLen;
+	}
+	return true;
+}
+
+// writes a nibble's extended bytes, returns the nibble
+static uint8_t encodeNibble(uint32_t value, uint8_t *ext, size_t &extLen)
+{
+	if(value < 13)
+	{
+		return (uint8_t)value;
+	}
+	if(value < 269)
+	{
+		ext[extLen++] = (uint8_t)(value - 13);
+		return 13;
+	}
+	value -= 269;
+	ext[extLen++] = (uint8_t)(value >> 8);
+	ext[extLen++] = (uint8_t)value;
+	return 14;
+}
+
+size_t LCoapMessage::serialize(uint8_t *buf, size_t size) const
+{
+	if(size < 4 + (size_t)tokenLen)
+	{
+		return 0;
+	}
+
+	buf[0] = (LCOAP_VERSION << 6) | ((type & 0x03) << 4) | tokenLen;
+	buf[1] = code;
+	buf[2] = (uint8_t)(messageId >> 8);
+	buf[3] = (uint8_t)messageId;
+	memcpy(buf + 4, token, tokenLen);
+	size_t pos = 4 + tokenLen;
+
+	uint16_t number = 0;
+	for(int i = 0; i < optionCount; ++i)
+	{
+		const LCoapOption &opt = options[i];
+		uint8_t ext[4];
+		size_t extLen = 0;
+		const uint8_t deltaNibble = encodeNibble(opt.number - number, ext, extLen);
+		const uint8_t lenNibble = encodeNibble(opt.len, ext, extLen);
+		if(pos + 1 + extLen + opt.len > size)
+		{
+			return 0;
+		}
+		buf[pos++] = (deltaNibble << 4) | lenNibble;
+		memcpy(buf + pos, ext, extLen);
+		pos += extLen;
+		memcpy(buf + pos, opt.value, opt.len);
+		pos += opt.len;
+		number = opt.number;
+	}
+
+	if(payloadLen)
+	{
+		if(pos + 1 + payloadLen > size)
+		{
+			return 0;
+		}
+		buf[pos++] = LCOAP_PAYLOAD_MARKER;
+		memcpy(buf + pos, payload, payloadLen);
+		pos += payloadLen;
+	}
+	return pos;
+}
+
+bool LCoapMessage::addOption(uint16_t number, const uint8_t *value, uint16_t len)
+{
+	if(optionCount == LCOAP_MAX_OPTIONS)
+	{
+		return false;
+	}
+
+	// after the options with the same number, so repeated options keep their order
+	int i = optionCount;
+	while(i > 0 && options[i - 1].number > number)
+	{
+		options[i] = options[i - 1];
+		i--;
+	}
+	options[i].number = number;
+	options[i].value = value;
+	options[i].len = len;
+	optionCount++;
+	return true;
+}
+
+bool LCoapMessage::addUintOption(uint16_t number, uint32_t value)
+{
+	if(m_uintCount == LCOAP_MAX_OPTIONS)
+	{
+		return false;
+	}
+
+	// shortest big endian form, 0 is empty
+	uint8_t *store = m_uintValues + m_uintCount * 4;
+	uint16_t len = 0;
+	for(int shift = 24; shift >= 0; shift -= 8)
+	{
+		const uint8_t b = (uint8_t)(value >> shift);
+		if(len || b)
+		{
+			store[len++] = b;
+		}
+	}
+	if(!addOption(number, store, len))
+	{
+		return false;
+	}
+	m_uintCount++;
+	return true;
+}
+
+bool LCoapMessage::addPath(const char *path)
+{
+	while(*path)
+	{
+		while(*path == '/')
+		{
+			path++;
+		}
+		const char *segment = path;
+		while(*path && *path != '/')
+		{
+			path++;
+		}
+		if(path != segment && !addOption(LCOAP_OPTION_URI_PATH, (const uint8_t*)segment, (uint16_t)(path - segment)))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void LCoapMessage::removeOption(uint16_t number)
+{
+	int j = 0;
+	for(int i = 0; i < optionCount; ++i)
+	{
+		if(options[i].number != number)
+		{
+			options[j++] = options[i];
+		}
+	}
+	optionCount = j;
+}
+
+const LCoapOption* LCoapMessage::findOption(uint16_t number, const LCoapOption *after) const
+{
+	const int start = after ? (int)(after - options) + 1 : 0;
+	for(int i = start; i < optionCount; ++i)
+	{
+		if(options[i].number == number)
+		{
+			return &options[i];
+		}
+	}
+	return NULL;
+}
+
+bool LCoapMessage::uintOption(uint16_t number, uint32_t &value) const
+{
+	const LCoapOption *opt = findOption(number);
+	if(opt == NULL || opt->len > 4)
+	{
+		return false;
+	}
+	value = 0;
+	for(int i = 0; i < opt->len; ++i)
+	{
+		value = (value << 8) | opt->value[i];
+	}
+	return true;
+}
+
+bool LCoapMessage::pathEquals(const char *path) const
+{
+	const LCoapOption *opt = findOption(LCOAP_OPTION_URI_PATH);
+	while(true)
+	{
+		while(*path == '/')
+		{
+			path++;
+		}
+		if(*path == 0 || opt == NULL)
+		{
+			return *path == 0 && opt == NULL;
+		}
+
+		const char *segment = path;
+		while(*path && *path != '/')
+		{
+			path++;
+		}
+		if((size_t)(path - segment) != opt->len || memcmp(segment, opt->value, opt->len) != 0)
+		{
+			return false;
+		}
+		opt = findOption(LCOAP_OPTION_URI_PATH, opt);
+	}
+}
+
+bool LCoapMessage::block(uint16_t number, uint32_t &num, bool &more, uint8_t &szx) const
+{
+	uint32_t value = 0;
+	if(!uintOption(number, value))
+	{
+		return false;
+	}
+	num = value >> 4;
+	more = (value & 0x08) != 0;
+	szx = value & 0x07;
+	// 7 is reserved
+	return szx != 7;
+}
+
+bool LCoapMessage::addBlock(uint16_t number, uint32_t num, bool more, uint8_t szx)
+{
+	return addUintOption(number, (num << 4) | (more ? 0x08 : 0) | (szx & 0x07));
+}
+
+void LCoapMessage::setToken(const uint8_t *value, uint8_t len)
+{
+	tokenLen = (len > LCOAP_MAX_TOKEN) ? LCOAP_MAX_TOKEN : len;
+	memcpy(token, value, tokenLen);
+}
+
+bool LCoapMessage::tokenEquals(const uint8_t *value, uint8_t len) const
+{
+	return len == tokenLen && memcmp(token, value, len) == 0;
+}
@@ -0,0 +1,166 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LCoapMessage_h
+#define _LCoapMessage_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CoAP (RFC 7252) message encoding and decoding, without allocation.
+// Parsed options and payload point into the received datagram; added
+// options point to the caller's data, except integer values, which are
+// kept in the message itself.
+
+// largest encoded message, see also LCOAP_BLOCK_SZX
+#ifndef LCOAP_MAX_MESSAGE
+#define LCOAP_MAX_MESSAGE 320
+#endif
+
+// options a message can hold
+#ifndef LCOAP_MAX_OPTIONS
+#define LCOAP_MAX_OPTIONS 16
+#endif
+
+#define LCOAP_MAX_TOKEN 8
+
+// UDP port of CoAP servers
+#define LCOAP_DEFAULT_PORT 5683
+
+// message types
+#define LCOAP_CON 0
+#define LCOAP_NON 1
+#define LCOAP_ACK 2
+#define LCOAP_RST 3
+
+// codes, class.detail
+#define LCOAP_CODE(c, d) ((uint8_t)(((c) << 5) | (d)))
+#define LCOAP_EMPTY 0
+#define LCOAP_GET 1
+#define LCOAP_POST 2
+#define LCOAP_PUT 3
+#define LCOAP_DELETE 4
+#define LCOAP_CREATED LCOAP_CODE(2, 1)
+#define LCOAP_DELETED LCOAP_CODE(2, 2)
+#define LCOAP_VALID LCOAP_CODE(2, 3)
+#define LCOAP_CHANGED LCOAP_CODE(2, 4)
+#define LCOAP_CONTENT LCOAP_CODE(2, 5)
+#define LCOAP_CONTINUE LCOAP_CODE(2, 31)
+#define LCOAP_BAD_REQUEST LCOAP_CODE(4, 0)
+#define LCOAP_NOT_FOUND LCOAP_CODE(4, 4)
+#define LCOAP_METHOD_NOT_ALLOWED LCOAP_CODE(4, 5)
+#define LCOAP_REQUEST_ENTITY_INCOMPLETE LCOAP_CODE(4, 8)
+#define LCOAP_REQUEST_ENTITY_TOO_LARGE LCOAP_CODE(4, 13)
+#define LCOAP_INTERNAL_SERVER_ERROR LCOAP_CODE(5, 0)
+#define LCOAP_SERVICE_UNAVAILABLE LCOAP_CODE(5, 3)
+
+// option numbers
+#define LCOAP_OPTION_IF_MATCH 1
+#define LCOAP_OPTION_URI_HOST 3
+#define LCOAP_OPTION_ETAG 4
+#define LCOAP_OPTION_OBSERVE 6
+#define LCOAP_OPTION_URI_PORT 7
+#define LCOAP_OPTION_URI_PATH 11
+#define LCOAP_OPTION_CONTENT_FORMAT 12
+#define LCOAP_OPTION_MAX_AGE 14
+#define LCOAP_OPTION_URI_QUERY 15
+#define LCOAP_OPTION_ACCEPT 17
+#define LCOAP_OPTION_BLOCK2 23
+#define LCOAP_OPTION_BLOCK1 27
+#define LCOAP_OPTION_SIZE2 28
+#define LCOAP_OPTION_SIZE1 60
+
+// content formats
+#define LCOAP_FORMAT_NONE -1
+#define LCOAP_FORMAT_TEXT 0
+#define LCOAP_FORMAT_LINK 40
+#define LCOAP_FORMAT_OCTETS 42
+#define LCOAP_FORMAT_JSON 50
+#define LCOAP_FORMAT_CBOR 60
+
+struct LCoapOption
+{
+  uint16_t number;
+  uint16_t len;
+  const uint8_t *value;
+};
+
+class LCoapMessage
+{
+public:
+  LCoapMessage();
+
+  // empties the message for reuse
+  void clear();
+
+  // decodes len bytes; the message points into buf afterwards.
+  // Returns false if buf is not a valid CoAP message.
+  bool parse(const uint8_t *buf, size_t len);
+
+  // encodes into buf. Returns the encoded size, 0 if it does not fit.
+  size_t serialize(uint8_t *buf, size_t size) const;
+
+  // adds an option, kept sorted by number; value must stay valid until serialize().
+  // Returns false when LCOAP_MAX_OPTIONS are used.
+  bool addOption(uint16_t number, const uint8_t *value, uint16_t len);
+
+  // adds an option with an integer value, stored in the message
+  bool addUintOption(uint16_t number, uint32_t value);
+
+  // adds one Uri-Path option per segment of path, e.g. "sensors/temp"
+  bool addPath(const char *path);
+
+  // removes every option with that number
+  void removeOption(uint16_t number);
+
+  // returns the first option with that number following after, or from the start if after is NULL.
+  // NULL if there is none.
+  const LCoapOption* findOption(uint16_t number, const LCoapOption *after = NULL) const;
+
+  // reads an integer option. Returns false if the option is missing.
+  bool uintOption(uint16_t number, uint32_t &value) const;
+
+  // true if the Uri-Path options spell path, e.g. "sensors/temp"
+  bool pathEquals(const char *path) const;
+
+  // reads a Block1 or Block2 option
+  bool block(uint16_t number, uint32_t &num, bool &more, uint8_t &szx) const;
+
+  // adds a Block1 or Block2 option
+  bool addBlock(uint16_t number, uint32_t num, bool more, uint8_t szx);
+
+  void setToken(const uint8_t *token, uint8_t len);
+  bool tokenEquals(const uint8_t *token, uint8_t len) const;
+
+  uint8_t type;
+  uint8_t code;
+  uint16_t messageId;
+  uint8_t tokenLen;
+  uint8_t token[LCOAP_MAX_TOKEN];
+  LCoapOption options[LCOAP_MAX_OPTIONS];
+  int optionCount;
+  const uint8_t *payload;
+  size_t payloadLen;
+
+private:
+  // options point into it, so a message cannot be copied
+  LCoapMessage(const LCoapMessage&);
+  LCoapMessage& operator=(const LCoapMessage&);
+
+  // values of addUintOption(), 4 bytes per option
+  uint8_t m_uintValues[LCOAP_MAX_OPTIONS * 4];
+  int m_uintCount;
+};
+
+#endif
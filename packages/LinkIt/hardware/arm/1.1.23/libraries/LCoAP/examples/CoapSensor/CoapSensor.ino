@@ -0,0 +1,97 @@
+/*
+
+ CoAP sensor
+
+ Serves the value of A0 as the observable CoAP resource "sensors/a0"
+ and accepts a new report interval with PUT on "config/interval".
+ Observers get a notification whenever the value changes by more than 8.
+
+ Try it from a Linux PC with libcoap:
+   coap-client -m get -s 60 coap://<board address>/sensors/a0
+   coap-client -m put -e 5000 coap://<board address>/config/interval
+
+ This code is in the public domain.
+
+ */
+#include <LWiFi.h>
+#include <LWiFiUdp.h>
+#include <LCoAP.h>
+
+char ssid[] = "yourssid";  //  your network SSID (name)
+char pass[] = "yourpassword";       // your network password
+
+LWiFiUDP udp;
+LCoAP coap(udp);
+
+int lastValue = 0;
+unsigned long interval = 1000;
+unsigned long lastCheck = 0;
+
+// GET sensors/a0
+uint8_t readSensor(void *userData, const LCoapMessage &request, LCoapResponse &response)
+{
+  response.len = sprintf((char*)response.buf, "%d", lastValue);
+  response.contentFormat = LCOAP_FORMAT_TEXT;
+  return LCOAP_CONTENT;
+}
+
+// GET and PUT config/interval
+uint8_t configInterval(void *userData, const LCoapMessage &request, LCoapResponse &response)
+{
+  if (request.code == LCOAP_PUT)
+  {
+    char text[12];
+    size_t len = min(request.payloadLen, sizeof(text) - 1);
+    memcpy(text, request.payload, len);
+    text[len] = 0;
+    unsigned long value = strtoul(text, NULL, 10);
+    if (value < 100)
+    {
+      return LCOAP_BAD_REQUEST;
+    }
+    interval = value;
+    return LCOAP_CHANGED;
+  }
+
+  response.len = sprintf((char*)response.buf, "%lu", interval);
+  response.contentFormat = LCOAP_FORMAT_TEXT;
+  return LCOAP_CONTENT;
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+  LWiFi.begin();
+  while (!LWiFi.connectWPA(ssid, pass))
+  {
+    delay(1000);
+    Serial.println("retry WiFi AP");
+  }
+  Serial.print("CoAP server at ");
+  Serial.println(LWiFi.localIP());
+
+  udp.begin(LCOAP_DEFAULT_PORT);
+  coap.addResource("sensors/a0", readSensor, NULL, true);
+  coap.addResource("config/interval", configInterval, NULL);
+  coap.begin();
+
+  lastValue = analogRead(A0);
+  Serial.println("setup() done");
+}
+
+void loop()
+{
+  coap.poll();
+
+  if (millis() - lastCheck >= interval)
+  {
+    lastCheck = millis();
+    int value = analogRead(A0);
+    if (abs(value - lastValue) > 8)
+    {
+      lastValue = value;
+      coap.notify("sensors/a0");
+    }
+  }
+}
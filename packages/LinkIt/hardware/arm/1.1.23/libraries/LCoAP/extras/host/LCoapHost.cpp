@@ -0,0 +1,138 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include <netdb.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "LCoapHost.h"
+
+LCoapHost::LCoapHost():
+	m_fd(-1)
+{
+}
+
+LCoapHost::~LCoapHost()
+{
+	close();
+}
+
+uint32_t LCoapHost::now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+uint32_t LCoapHost::clock()
+{
+	return now();
+}
+
+LCoapAddress LCoapHost::address(const char *host, uint16_t port)
+{
+	LCoapAddress addr;
+	memset(&addr, 0, sizeof(addr));
+
+	struct addrinfo hints;
+	struct addrinfo *res = NULL;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if(getaddrinfo(host, NULL, &hints, &res) != 0 || res == NULL)
+	{
+		return addr;
+	}
+	memcpy(addr.ip, &((struct sockaddr_in*)res->ai_addr)->sin_addr.s_addr, 4);
+	addr.port = port;
+	freeaddrinfo(res);
+	return addr;
+}
+
+bool LCoapHost::open(uint16_t localPort)
+{
+	close();
+
+	m_fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if(m_fd < 0)
+	{
+		return false;
+	}
+
+	struct sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(localPort);
+	if(bind(m_fd, (struct sockaddr*)&local, sizeof(local)) < 0)
+	{
+		close();
+		return false;
+	}
+
+	reset(now() ^ ((uint32_t)getpid() << 16));
+	return true;
+}
+
+void LCoapHost::close()
+{
+	if(m_fd >= 0)
+	{
+		::close(m_fd);
+		m_fd = -1;
+	}
+}
+
+void LCoapHost::poll(int waitMs)
+{
+	if(m_fd < 0)
+	{
+		return;
+	}
+
+	struct pollfd pfd;
+	pfd.fd = m_fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if(::poll(&pfd, 1, waitMs) > 0)
+	{
+		uint8_t buf[LCOAP_MAX_MESSAGE];
+		struct sockaddr_in from;
+		socklen_t fromLen = sizeof(from);
+		ssize_t n;
+		while((n = recvfrom(m_fd, buf, sizeof(buf), MSG_DONTWAIT, (struct sockaddr*)&from, &fromLen)) >= 0)
+		{
+			LCoapAddress addr;
+			memcpy(addr.ip, &from.sin_addr.s_addr, 4);
+			addr.port = ntohs(from.sin_port);
+			input(addr, buf, (size_t)n);
+			fromLen = sizeof(from);
+		}
+	}
+	tick();
+}
+
+void LCoapHost::transmit(const LCoapAddress &to, const uint8_t *buf, size_t len)
+{
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	memcpy(&addr.sin_addr.s_addr, to.ip, 4);
+	addr.sin_port = htons(to.port);
+	sendto(m_fd, buf, len, 0, (struct sockaddr*)&addr, sizeof(addr));
+}
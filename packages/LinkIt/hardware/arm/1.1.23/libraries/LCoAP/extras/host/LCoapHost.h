@@ -0,0 +1,64 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LCoapHost_h
+#define _LCoapHost_h
+
+#include "../../LCoapEndpoint.h"
+
+// Linux CoAP endpoint, for servers and for testing a board against a PC or
+// against another CoAP implementation such as libcoap's coap-client and
+// coap-server. It runs the same engine as the board over a POSIX UDP socket.
+// Build it together with the engine, for example:
+//
+//   g++ -I<path>/LCoAP <path>/LCoAP/LCoapMessage.cpp <path>/LCoAP/LCoapEndpoint.cpp LCoapHost.cpp app.cpp
+//
+// EXAMPLE:
+// <code>
+//     LCoapHost coap;
+//     coap.open(LCOAP_DEFAULT_PORT);
+//     coap.observe(LCoapHost::address("192.168.1.20", LCOAP_DEFAULT_PORT), "sensors/temp", onTemp, NULL);
+//     for (;;) coap.poll(100);
+// </code>
+class LCoapHost : public LCoapEndpoint
+{
+public:
+  LCoapHost();
+  virtual ~LCoapHost();
+
+  // binds localPort, 0 for any. Returns false if the socket cannot be opened.
+  bool open(uint16_t localPort);
+
+  void close();
+
+  // waits up to waitMs for datagrams, handles them and runs the timers
+  void poll(int waitMs);
+
+  // resolves host, e.g. "192.168.1.20" or "localhost". The port is 0 if host is unknown.
+  static LCoapAddress address(const char *host, uint16_t port);
+
+  // current time in milliseconds, the clock the endpoint runs on
+  static uint32_t now();
+
+  // socket descriptor, for use in the caller's own poll() loop; -1 if closed
+  int fd() const { return m_fd; }
+
+protected:
+  virtual void transmit(const LCoapAddress &to, const uint8_t *buf, size_t len);
+  virtual uint32_t clock();
+
+  int m_fd;
+};
+
+#endif
@@ -53,6 +53,7 @@ public:
 
     // DESCRIPTION
     //  Resolves the given hostname to an IP address.
+    //  Answers, including failures, are cached in LDnsCache.
     // 
     // PARAMETERS
     //  aHostname: The URL name string to be resolved.
@@ -36,6 +36,11 @@ LGPRSClient::LGPRSClient(VMINT handle, VMINT serverHandle):
 {
 }
 
+LGPRSClient::LGPRSClient(const SharedHandle &handle):
+  LTcpClient(handle)
+{
+}
+
 VMINT LGPRSClient::getAPN() const
 {
   return LGPRS.getAPN();
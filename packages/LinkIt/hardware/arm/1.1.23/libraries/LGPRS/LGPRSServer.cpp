@@ -23,6 +23,11 @@ LGPRSServer::LGPRSServer(uint16_t port):
 
 LGPRSClient LGPRSServer::available()
 {
+	if(m_maxClients)
+	{
+		return LGPRSClient(availableSlot());
+	}
+
 	VMINT hClient = -1;
 	VMINT hServer = -1;
 	availableImpl(hClient, hServer);
@@ -32,6 +37,11 @@ LGPRSClient LGPRSServer::available()
 	return LGPRSClient(hClient, hServer);
 }
 
+LGPRSClient LGPRSServer::client(int slot)
+{
+	return LGPRSClient(slotHandle(slot));
+}
+
 VMINT LGPRSServer::getAPN() const
 {
   return LGPRS.getAPN();
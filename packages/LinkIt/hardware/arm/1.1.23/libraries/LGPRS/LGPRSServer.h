@@ -42,8 +42,21 @@ public:
   // RETURNS
   //   An LGPRSClient object representing the connection between this server object and the remote client.
   //   This object will return false if there is no incoming connection.
+  //   After begin(maxClients), newly accepted clients are returned first, in the order they connected,
+  //   then each client with unread data in turn.
   LGPRSClient available();
 
+  // DESCRIPTION
+  //   Returns the client in a slot reported by poll(). Only valid after begin(maxClients).
+  // 
+  // PARAMETERS
+  //   slot: slot index, from 0 to maxClients - 1.
+  // 
+  // RETURNS
+  //   An LGPRSClient object for the client in that slot.
+  //   This object will return false if no client is connected in that slot.
+  LGPRSClient client(int slot);
+
   /* DOM-NOT_FOR_SDK-BEGIN */
   virtual VMINT getAPN() const;
   /* DOM-NOT_FOR_SDK-END */
@@ -0,0 +1,39 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+   See the GNU Lesser General Public License for more details.
+*/
+#ifndef LGPRSTlsClient_h
+#define LGPRSTlsClient_h
+#include "Arduino.h"
+#include <LTlsClient.h>
+
+//LGPRSTlsClient Class
+// 
+// Please see the method description of LTlsClient class.
+//
+// EXAMPLE:
+// <code>
+//     LGPRS.attachGPRS();
+//     LGPRSTlsClient c;
+//     c.connect("www.website.com", 443);
+// </code>
+class LGPRSTlsClient : public LTlsClient
+{
+public:
+  LGPRSTlsClient();
+
+  /* DOM-NOT_FOR_SDK-BEGIN */
+  virtual VMINT getAPN() const;
+  /* DOM-NOT_FOR_SDK-END */
+};
+
+#endif  // LGPRSTlsClient_h
@@ -44,6 +44,16 @@ public:
         uint8_t c   // [IN] The byte to write.
     );
 
+	// DESCRIPTION
+	//  Appends a block of bytes to the SMS content in one step; print() and BufferedPrint use it.
+	// RETURNS
+	//  Number of bytes written.
+	//  0: Failed.
+    size_t write(
+        const uint8_t *buf, // [IN] The bytes to write.
+        size_t size         // [IN] The number of bytes in buf.
+    );
+
 	// DESCRIPTION
 	//  This function is the step one of sending an SMS, which is to input the destination number.
 	// RETURNS
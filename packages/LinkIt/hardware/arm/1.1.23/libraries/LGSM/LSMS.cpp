@@ -75,12 +75,19 @@ int LSMSClass::beginSMS(const char* to)
 {
     _toNumber = to;
     _toContent = "";
+    // print() appends piece by piece; avoid growing the string each time
+    _toContent.reserve(LGSM_MAX_SMS_LEN);
     return 1;
 }
 
 size_t LSMSClass::write(uint8_t c)
 {
-    _toContent += (char)c;
+    return _toContent.concat((char)c) ? 1 : 0;
+}
+
+size_t LSMSClass::write(const uint8_t *buf, size_t size)
+{
+    return _toContent.concat((const char*)buf, size) ? size : 0;
 }
 
 int LSMSClass::endSMS()
@@ -0,0 +1,92 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include "LReliableUDP.h"
+
+LReliableUDP::LReliableUDP(LUDP &udp):
+	m_udp(udp),
+	m_peerIP(INADDR_NONE),
+	m_peerPort(0)
+{
+}
+
+void LReliableUDP::begin(IPAddress ip, uint16_t port, LRudpMode mode)
+{
+	m_peerIP = ip;
+	m_peerPort = port;
+	// a new id per begin(), so the peer drops what it kept from an earlier run
+	reset(mode, (millis() << 12) ^ micros());
+}
+
+void LReliableUDP::transmit(const uint8_t *buf, size_t len)
+{
+	// queued, so a poll() that sends again several segments costs one hop
+	if(!m_udp.beginPacket(m_peerIP, m_peerPort))
+	{
+		sendQueued();
+		if(!m_udp.beginPacket(m_peerIP, m_peerPort))
+		{
+			// counts as lost, the timer sends it again
+			return;
+		}
+	}
+	m_udp.write(buf, len);
+	m_udp.queuePacket();
+}
+
+void LReliableUDP::sendQueued()
+{
+	if(m_udp.queuedPackets())
+	{
+		m_udp.sendQueued();
+	}
+}
+
+size_t LReliableUDP::write(const uint8_t *buf, size_t size)
+{
+	const size_t queued = send(buf, size, millis());
+	sendQueued();
+	return queued;
+}
+
+void LReliableUDP::poll()
+{
+	while(m_udp.parsePacket())
+	{
+		const int len = m_udp.read(m_rxPacket, sizeof(m_rxPacket));
+		if(len > 0 && m_udp.remoteIP() == m_peerIP && m_udp.remotePort() == m_peerPort)
+		{
+			input(m_rxPacket, len, millis());
+		}
+		m_udp.flush();
+	}
+
+	tick(millis());
+	sendQueued();
+}
+
+boolean LReliableUDP::flush(unsigned long timeoutMs)
+{
+	const unsigned long start = millis();
+	while(!idle() && !failed())
+	{
+		if(millis() - start >= timeoutMs)
+		{
+			return false;
+		}
+		poll();
+		delay(1);
+	}
+	return !failed();
+}
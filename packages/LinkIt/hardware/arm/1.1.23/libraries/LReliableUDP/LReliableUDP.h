@@ -0,0 +1,117 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LReliableUDP_h
+#define _LReliableUDP_h
+
+#include <Arduino.h>
+#include <LUdp.h>
+#include "LRudpSession.h"
+
+//LReliableUDP Class
+//
+// Reliable transport over UDP for lossy links such as GPRS, where TCP stalls
+// for seconds on retransmission backoff and one lost segment holds back all
+// data behind it. Data is numbered and acknowledged selectively: only lost
+// segments are sent again, with a timeout that follows the measured round
+// trip time. In LRUDP_MESSAGE_UNORDERED mode a lost message does not delay
+// the ones after it at all.
+//
+// LReliableUDP runs on top of an LWiFiUDP or LGPRSUDP object, which chooses
+// the network, and talks to one peer: another board, or the Linux peer in
+// extras/host of this library. The UDP object is used only by LReliableUDP
+// while the session is open.
+//
+// EXAMPLE:
+// <code>
+//     LGPRSUDP udp;
+//     LReliableUDP link(udp);
+//     udp.begin(5000);
+//     link.begin(IPAddress(203, 0, 113, 7), 5000, LRUDP_MESSAGE);
+//     link.write(frame, frameSize);
+//     ...
+//     link.poll();   // call often, e.g. once per loop()
+// </code>
+class LReliableUDP : public LRudpSession
+{
+public:
+  // DESCRIPTION
+  //   Constructs a reliable session on top of a UDP object.
+  // 
+  // PARAMETERS
+  //   udp: an LWiFiUDP or LGPRSUDP object; begin() it with the local port before use
+  LReliableUDP(LUDP &udp);
+
+  // DESCRIPTION
+  //   Starts a new session with a peer, dropping any data of a previous one.
+  // 
+  // PARAMETERS
+  //   ip: IP address of the peer
+  //   port: UDP port of the peer
+  //   mode: LRUDP_STREAM, LRUDP_MESSAGE or LRUDP_MESSAGE_UNORDERED
+  // 
+  // RETURNS
+  //   N/A
+  void begin(IPAddress ip, uint16_t port, LRudpMode mode = LRUDP_MESSAGE);
+
+  // DESCRIPTION
+  //   Queues data for the peer and sends what its window allows right away.
+  //   In message modes, buf is one message of at most LRUDP_MAX_PAYLOAD bytes.
+  // 
+  // PARAMETERS
+  //   buf: data to send
+  //   size: size of buf in bytes
+  // 
+  // RETURNS
+  //   Number of bytes queued. Less than size, or 0 for a message, when the
+  //   send window is full; poll() and try again.
+  size_t write(const uint8_t *buf, size_t size);
+
+  // DESCRIPTION
+  //   Receives pending datagrams, sends segments again whose timeout expired
+  //   and acknowledges received data. Call it often, e.g. once per loop().
+  // 
+  // PARAMETERS
+  //   N/A
+  // 
+  // RETURNS
+  //   N/A
+  void poll();
+
+  // DESCRIPTION
+  //   Waits until the peer acknowledged everything written.
+  // 
+  // PARAMETERS
+  //   timeoutMs: longest wait in milliseconds
+  // 
+  // RETURNS
+  //   true if all data was acknowledged, false on timeout or if the session failed.
+  boolean flush(unsigned long timeoutMs);
+
+  // available(), read(), writable(), failed(), rtt() and the other
+  // methods of LRudpSession can be used directly.
+
+protected:
+  /* DOM-NOT_FOR_SDK-BEGIN */
+  virtual void transmit(const uint8_t *buf, size_t len);
+  void sendQueued();
+
+  LUDP &m_udp;
+  IPAddress m_peerIP;
+  uint16_t m_peerPort;
+  uint8_t m_rxPacket[LRUDP_MAX_DATAGRAM];
+  /* DOM-NOT_FOR_SDK-END */
+};
+
+#endif
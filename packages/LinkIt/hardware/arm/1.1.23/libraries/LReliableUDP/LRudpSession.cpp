@@ -0,0 +1,515 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include <string.h>
+#include "LRudpSession.h"
+
+#if LRUDP_WINDOW > 32
+#error LRUDP_WINDOW must fit the 32 bit acknowledgement bitmap
+#endif
+
+// Datagram layout, all fields big endian:
+//   0  magic 'R'
+//   1  type, LRUDP_TYPE_DATA or LRUDP_TYPE_ACK
+//   2  free receive window in segments (ACK)
+//   3  reserved, 0
+//   4  session id of the data stream
+//   8  sequence number (DATA) or next sequence number expected (ACK)
+//  12  ACK: bit i set if segment ack + 1 + i was received
+//  16  DATA: send time; ACK: send time of the segment that triggered it
+//  20  payload (DATA)
+#define LRUDP_MAGIC 'R'
+#define LRUDP_TYPE_DATA 1
+#define LRUDP_TYPE_ACK 2
+
+#define LRUDP_SLOT_FREE 0
+#define LRUDP_SLOT_FILLED 1
+#define LRUDP_SLOT_READ 2       // read out of order, waits for the older ones
+
+// wrap-safe: a is before b
+#define LRUDP_BEFORE(a, b) ((int32_t)((a) - (b)) < 0)
+
+static void put32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)(v >> 24);
+	p[1] = (uint8_t)(v >> 16);
+	p[2] = (uint8_t)(v >> 8);
+	p[3] = (uint8_t)v;
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+LRudpSession::LRudpSession()
+{
+	reset(LRUDP_STREAM, 0);
+}
+
+LRudpSession::~LRudpSession()
+{
+}
+
+void LRudpSession::reset(LRudpMode mode, uint32_t sessionId)
+{
+	m_mode = mode;
+	m_session = sessionId;
+	m_failed = false;
+
+	m_sndUna = 0;
+	m_sndNxt = 0;
+	m_sndLimit = LRUDP_WINDOW;
+	m_lastAckAt = 0;
+	m_srtt = 0;
+	m_rttvar = 0;
+	m_rto = LRUDP_INITIAL_RTO;
+	m_retransmissions = 0;
+
+	for(int i = 0; i < LRUDP_WINDOW; ++i)
+	{
+		m_rcv[i].state = LRUDP_SLOT_FREE;
+	}
+	m_peerSession = 0;
+	m_peerKnown = false;
+	m_oldPeerSession = 0;
+	m_oldPeerKnown = false;
+	m_rcvBase = 0;
+	m_rcvNxt = 0;
+	m_ackEcho = 0;
+	m_ackPending = false;
+}
+
+size_t LRudpSession::writable() const
+{
+	if(m_failed)
+	{
+		return 0;
+	}
+	const uint32_t segments = LRUDP_WINDOW - (m_sndNxt - m_sndUna);
+	if(m_mode == LRUDP_STREAM)
+	{
+		return segments * LRUDP_MAX_PAYLOAD;
+	}
+	return segments ? LRUDP_MAX_PAYLOAD : 0;
+}
+
+size_t LRudpSession::send(const uint8_t *buf, size_t len, uint32_t now)
+{
+	if(m_failed || len == 0)
+	{
+		return 0;
+	}
+	if(m_mode != LRUDP_STREAM && len > LRUDP_MAX_PAYLOAD)
+	{
+		return 0;
+	}
+
+	size_t done = 0;
+	while(done < len && m_sndNxt - m_sndUna < LRUDP_WINDOW)
+	{
+		size_t chunk = len - done;
+		if(chunk > LRUDP_MAX_PAYLOAD)
+		{
+			chunk = LRUDP_MAX_PAYLOAD;
+		}
+
+		Segment &seg = m_snd[m_sndNxt % LRUDP_WINDOW];
+		memcpy(seg.data, buf + done, chunk);
+		seg.len = (uint16_t)chunk;
+		seg.retries = 0;
+		seg.missCount = 0;
+		seg.acked = false;
+		m_sndNxt++;
+		done += chunk;
+	}
+
+	flushSegments(now);
+	return done;
+}
+
+int LRudpSession::nextSlot() const
+{
+	if(m_mode != LRUDP_MESSAGE_UNORDERED)
+	{
+		if(LRUDP_BEFORE(m_rcvBase, m_rcvNxt))
+		{
+			return m_rcvBase % LRUDP_WINDOW;
+		}
+		return -1;
+	}
+
+	// oldest message that arrived, holes or not
+	for(uint32_t seq = m_rcvBase; seq != m_rcvBase + LRUDP_WINDOW; ++seq)
+	{
+		if(m_rcv[seq % LRUDP_WINDOW].state == LRUDP_SLOT_FILLED)
+		{
+			return seq % LRUDP_WINDOW;
+		}
+	}
+	return -1;
+}
+
+int LRudpSession::available() const
+{
+	if(m_mode != LRUDP_STREAM)
+	{
+		const int slot = nextSlot();
+		return slot < 0 ? 0 : m_rcv[slot].len;
+	}
+
+	int total = 0;
+	for(uint32_t seq = m_rcvBase; LRUDP_BEFORE(seq, m_rcvNxt); ++seq)
+	{
+		const Slot &s = m_rcv[seq % LRUDP_WINDOW];
+		total += s.len - s.pos;
+	}
+	return total;
+}
+
+void LRudpSession::releaseSlots()
+{
+	const uint8_t before = freeWindow();
+	while(m_rcv[m_rcvBase % LRUDP_WINDOW].state == LRUDP_SLOT_READ)
+	{
+		m_rcv[m_rcvBase % LRUDP_WINDOW].state = LRUDP_SLOT_FREE;
+		m_rcvBase++;
+	}
+
+	// the sender may be waiting for room, tell it
+	if(before == 0 && freeWindow())
+	{
+		m_ackPending = true;
+	}
+}
+
+int LRudpSession::read(uint8_t *buf, size_t len)
+{
+	if(m_mode != LRUDP_STREAM)
+	{
+		const int slot = nextSlot();
+		if(slot < 0)
+		{
+			return 0;
+		}
+		Slot &s = m_rcv[slot];
+		const size_t n = (s.len < len) ? s.len : len;
+		memcpy(buf, s.data, n);
+		s.state = LRUDP_SLOT_READ;
+		releaseSlots();
+		return (int)n;
+	}
+
+	size_t done = 0;
+	while(done < len && LRUDP_BEFORE(m_rcvBase, m_rcvNxt))
+	{
+		Slot &s = m_rcv[m_rcvBase % LRUDP_WINDOW];
+		size_t n = s.len - s.pos;
+		if(n > len - done)
+		{
+			n = len - done;
+		}
+		memcpy(buf + done, s.data + s.pos, n);
+		s.pos += n;
+		done += n;
+		if(s.pos == s.len)
+		{
+			s.state = LRUDP_SLOT_READ;
+			releaseSlots();
+		}
+	}
+	return (int)done;
+}
+
+uint8_t LRudpSession::freeWindow() const
+{
+	return (uint8_t)(LRUDP_WINDOW - (m_rcvNxt - m_rcvBase));
+}
+
+void LRudpSession::input(const uint8_t *buf, size_t len, uint32_t now)
+{
+	if(len < LRUDP_HEADER_SIZE || buf[0] != LRUDP_MAGIC)
+	{
+		return;
+	}
+
+	if(buf[1] == LRUDP_TYPE_DATA)
+	{
+		handleData(buf, len);
+	}
+	else if(buf[1] == LRUDP_TYPE_ACK)
+	{
+		handleAck(buf, now);
+	}
+}
+
+void LRudpSession::handleData(const uint8_t *buf, size_t len)
+{
+	const uint32_t session = get32(buf + 4);
+	const uint32_t seq = get32(buf + 8);
+	const size_t payload = len - LRUDP_HEADER_SIZE;
+	if(payload > LRUDP_MAX_PAYLOAD)
+	{
+		return;
+	}
+
+	// the peer restarted: its old data is gone. Only the first segment of
+	// a stream switches over, and never back to the session it replaced,
+	// so that a late datagram of the old stream cannot reset the new one.
+	if(!m_peerKnown || session != m_peerSession)
+	{
+		if(seq != 0 || (m_oldPeerKnown && session == m_oldPeerSession))
+		{
+			return;
+		}
+		for(int i = 0; i < LRUDP_WINDOW; ++i)
+		{
+			m_rcv[i].state = LRUDP_SLOT_FREE;
+		}
+		m_oldPeerSession = m_peerSession;
+		m_oldPeerKnown = m_peerKnown;
+		m_peerSession = session;
+		m_peerKnown = true;
+		m_rcvBase = 0;
+		m_rcvNxt = 0;
+	}
+
+	// duplicates and data beyond the window are acknowledged again,
+	// that also answers window probes
+	m_ackPending = true;
+	m_ackEcho = get32(buf + 16);
+	if(LRUDP_BEFORE(seq, m_rcvBase) || seq - m_rcvBase >= LRUDP_WINDOW)
+	{
+		return;
+	}
+
+	Slot &s = m_rcv[seq % LRUDP_WINDOW];
+	if(s.state != LRUDP_SLOT_FREE)
+	{
+		return;
+	}
+	memcpy(s.data, buf + LRUDP_HEADER_SIZE, payload);
+	s.len = (uint16_t)payload;
+	s.pos = 0;
+	s.state = LRUDP_SLOT_FILLED;
+
+	while(m_rcvNxt - m_rcvBase < LRUDP_WINDOW && m_rcv[m_rcvNxt % LRUDP_WINDOW].state != LRUDP_SLOT_FREE)
+	{
+		m_rcvNxt++;
+	}
+}
+
+void LRudpSession::updateRtt(uint32_t sample)
+{
+	// Jacobson/Karels estimator, as in RFC 6298
+	if(m_srtt == 0)
+	{
+		m_srtt = sample ? sample : 1;
+		m_rttvar = sample / 2;
+	}
+	else
+	{
+		const uint32_t delta = (sample > m_srtt) ? sample - m_srtt : m_srtt - sample;
+		m_rttvar = (3 * m_rttvar + delta) / 4;
+		m_srtt = (7 * m_srtt + sample) / 8;
+	}
+
+	m_rto = m_srtt + 4 * m_rttvar;
+	if(m_rto < LRUDP_MIN_RTO)
+	{
+		m_rto = LRUDP_MIN_RTO;
+	}
+	if(m_rto > LRUDP_MAX_RTO)
+	{
+		m_rto = LRUDP_MAX_RTO;
+	}
+}
+
+void LRudpSession::handleAck(const uint8_t *buf, uint32_t now)
+{
+	const uint32_t session = get32(buf + 4);
+	const uint32_t ack = get32(buf + 8);
+	const uint32_t sack = get32(buf + 12);
+	const uint32_t echo = get32(buf + 16);
+	if(session != m_session || LRUDP_BEFORE(ack, m_sndUna) || LRUDP_BEFORE(m_sndNxt, ack))
+	{
+		// stale or not ours
+		return;
+	}
+
+	bool progress = (ack != m_sndUna);
+	m_sndUna = ack;
+	m_sndLimit = ack + buf[2];
+	m_lastAckAt = now;
+
+	if(buf[2] == 0)
+	{
+		// the peer is alive but full: the segments it refused were window
+		// probes, which do not count toward LRUDP_MAX_RETRIES (TCP persist)
+		for(uint32_t seq = ack; LRUDP_BEFORE(seq, m_sndNxt); ++seq)
+		{
+			Segment &seg = m_snd[seq % LRUDP_WINDOW];
+			if(seg.retries > 1 && !seg.acked)
+			{
+				seg.retries = 1;
+			}
+		}
+	}
+
+	uint32_t highest = ack;
+	for(int i = 0; i < 32; ++i)
+	{
+		const uint32_t seq = ack + 1 + i;
+		if(!LRUDP_BEFORE(seq, m_sndNxt))
+		{
+			break;
+		}
+		if(sack & (1UL << i))
+		{
+			Segment &seg = m_snd[seq % LRUDP_WINDOW];
+			progress = progress || !seg.acked;
+			seg.acked = true;
+			highest = seq;
+		}
+	}
+
+	// the echoed time belongs to the transmission that was received, so
+	// retransmissions do not spoil the sample
+	if(progress && echo)
+	{
+		updateRtt(now - echo);
+	}
+
+	// segments skipped by three acknowledgements are taken as lost
+	for(uint32_t seq = m_sndUna; LRUDP_BEFORE(seq, highest); ++seq)
+	{
+		Segment &seg = m_snd[seq % LRUDP_WINDOW];
+		if(!seg.acked && seg.retries && ++seg.missCount == 3)
+		{
+			m_retransmissions++;
+			transmitSegment(seq, now);
+		}
+	}
+
+	flushSegments(now);
+}
+
+void LRudpSession::transmitSegment(uint32_t seq, uint32_t now)
+{
+	Segment &seg = m_snd[seq % LRUDP_WINDOW];
+	if(seg.retries >= LRUDP_MAX_RETRIES)
+	{
+		m_failed = true;
+		return;
+	}
+
+	// 0 means no sample in the echo
+	const uint32_t stamp = now ? now : 1;
+	m_packet[0] = LRUDP_MAGIC;
+	m_packet[1] = LRUDP_TYPE_DATA;
+	m_packet[2] = 0;
+	m_packet[3] = 0;
+	put32(m_packet + 4, m_session);
+	put32(m_packet + 8, seq);
+	put32(m_packet + 12, 0);
+	put32(m_packet + 16, stamp);
+	memcpy(m_packet + LRUDP_HEADER_SIZE, seg.data, seg.len);
+	transmit(m_packet, LRUDP_HEADER_SIZE + seg.len);
+
+	seg.sentAt = now;
+	seg.retries++;
+	seg.missCount = 0;
+}
+
+void LRudpSession::transmitAck()
+{
+	uint32_t sack = 0;
+	for(int i = 0; i < 32; ++i)
+	{
+		const uint32_t seq = m_rcvNxt + 1 + i;
+		if(seq - m_rcvBase >= LRUDP_WINDOW)
+		{
+			break;
+		}
+		if(m_rcv[seq % LRUDP_WINDOW].state != LRUDP_SLOT_FREE)
+		{
+			sack |= (1UL << i);
+		}
+	}
+
+	m_packet[0] = LRUDP_MAGIC;
+	m_packet[1] = LRUDP_TYPE_ACK;
+	m_packet[2] = freeWindow();
+	m_packet[3] = 0;
+	put32(m_packet + 4, m_peerSession);
+	put32(m_packet + 8, m_rcvNxt);
+	put32(m_packet + 12, sack);
+	put32(m_packet + 16, m_ackEcho);
+	transmit(m_packet, LRUDP_HEADER_SIZE);
+	m_ackPending = false;
+}
+
+void LRudpSession::flushSegments(uint32_t now)
+{
+	// new segments the peer has room for
+	bool inFlight = false;
+	for(uint32_t seq = m_sndUna; LRUDP_BEFORE(seq, m_sndNxt); ++seq)
+	{
+		Segment &seg = m_snd[seq % LRUDP_WINDOW];
+		if(seg.retries)
+		{
+			inFlight = inFlight || !seg.acked;
+			continue;
+		}
+		if(!LRUDP_BEFORE(seq, m_sndLimit))
+		{
+			// closed window: probe with one segment once nothing else is out
+			if(!inFlight && now - m_lastAckAt >= m_rto)
+			{
+				transmitSegment(seq, now);
+			}
+			break;
+		}
+		transmitSegment(seq, now);
+		inFlight = true;
+	}
+}
+
+void LRudpSession::tick(uint32_t now)
+{
+	bool expired = false;
+	for(uint32_t seq = m_sndUna; LRUDP_BEFORE(seq, m_sndNxt); ++seq)
+	{
+		Segment &seg = m_snd[seq % LRUDP_WINDOW];
+		if(seg.retries && !seg.acked && now - seg.sentAt >= m_rto)
+		{
+			m_retransmissions++;
+			transmitSegment(seq, now);
+			expired = true;
+		}
+	}
+
+	// back off once per timeout, not once per segment
+	if(expired)
+	{
+		m_rto = (m_rto * 2 > LRUDP_MAX_RTO) ? LRUDP_MAX_RTO : m_rto * 2;
+	}
+
+	flushSegments(now);
+
+	if(m_ackPending)
+	{
+		transmitAck();
+	}
+}
@@ -0,0 +1,184 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LRudpSession_h
+#define _LRudpSession_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Protocol engine of LReliableUDP, shared with the Linux peer in extras/host.
+// It has no platform dependency: the owner feeds received datagrams to
+// input(), calls tick() regularly and sends what transmit() hands out.
+//
+// Each direction is an independent stream of numbered segments. The receiver
+// answers with the next sequence number it expects, a bitmap of the segments
+// received beyond it (selective acknowledgement) and its free window.
+// Lost segments are sent again after a retransmit timeout adapted to the
+// measured round trip time, or as soon as three acknowledgements show later
+// segments arriving, so one loss does not stall the segments behind it.
+
+// segments in flight per direction, at most 32
+#ifndef LRUDP_WINDOW
+#define LRUDP_WINDOW 16
+#endif
+
+// largest segment payload in bytes, and so the largest message
+#ifndef LRUDP_MAX_PAYLOAD
+#define LRUDP_MAX_PAYLOAD 512
+#endif
+
+// retransmit timeout before the first round trip is measured, in milliseconds
+#ifndef LRUDP_INITIAL_RTO
+#define LRUDP_INITIAL_RTO 1000
+#endif
+
+// bounds of the retransmit timeout, in milliseconds
+#ifndef LRUDP_MIN_RTO
+#define LRUDP_MIN_RTO 200
+#endif
+#ifndef LRUDP_MAX_RTO
+#define LRUDP_MAX_RTO 6000
+#endif
+
+// the session fails when a segment was sent this many times without acknowledgement
+#ifndef LRUDP_MAX_RETRIES
+#define LRUDP_MAX_RETRIES 12
+#endif
+
+#define LRUDP_HEADER_SIZE 20
+#define LRUDP_MAX_DATAGRAM (LRUDP_HEADER_SIZE + LRUDP_MAX_PAYLOAD)
+
+// how the data handed to send() is delivered to read()
+enum LRudpMode
+{
+  LRUDP_STREAM,             // ordered bytes, message boundaries are not kept
+  LRUDP_MESSAGE,            // ordered messages, one per send()
+  LRUDP_MESSAGE_UNORDERED   // messages as soon as they arrive, a lost one does not hold back the next
+};
+
+class LRudpSession
+{
+public:
+  LRudpSession();
+  virtual ~LRudpSession();
+
+  // starts a new session, dropping all data in both directions.
+  // sessionId should differ from the one used before, the peer resets its
+  // receive side when the first segment of the new session arrives.
+  // Datagrams of the session it replaced are ignored from then on.
+  void reset(LRudpMode mode, uint32_t sessionId);
+
+  // queues data and sends what the window allows. In message modes buf is one
+  // message of at most LRUDP_MAX_PAYLOAD bytes, queued whole or not at all.
+  // Returns the number of bytes queued.
+  size_t send(const uint8_t *buf, size_t len, uint32_t now);
+
+  // number of bytes send() would take now
+  size_t writable() const;
+
+  // stream mode: bytes that can be read.
+  // message modes: size of the next message, 0 if none.
+  int available() const;
+
+  // stream mode: reads up to len bytes.
+  // message modes: reads the next message, the part beyond len is dropped.
+  // Returns the number of bytes read, 0 if nothing is available.
+  int read(uint8_t *buf, size_t len);
+
+  // handles a datagram received from the peer
+  void input(const uint8_t *buf, size_t len, uint32_t now);
+
+  // runs the retransmit timer and sends pending acknowledgements
+  void tick(uint32_t now);
+
+  // true when everything sent has been acknowledged
+  bool idle() const { return m_sndUna == m_sndNxt; }
+
+  // true once a segment exceeded LRUDP_MAX_RETRIES, until reset()
+  bool failed() const { return m_failed; }
+
+  // smoothed round trip time and current retransmit timeout, in milliseconds
+  uint32_t rtt() const { return m_srtt; }
+  uint32_t rto() const { return m_rto; }
+
+  // number of segments sent again since reset()
+  uint32_t retransmissions() const { return m_retransmissions; }
+
+protected:
+  // sends one datagram of len bytes to the peer
+  virtual void transmit(const uint8_t *buf, size_t len) = 0;
+
+private:
+  struct Segment
+  {
+    uint32_t sentAt;        // time of the last transmission
+    uint16_t len;
+    uint8_t retries;        // transmissions so far, 0 if not sent yet
+    uint8_t missCount;      // acknowledgements that skipped this segment
+    bool acked;             // selectively acknowledged
+    uint8_t data[LRUDP_MAX_PAYLOAD];
+  };
+
+  struct Slot
+  {
+    uint16_t len;
+    uint16_t pos;           // bytes already read, stream mode
+    uint8_t state;
+    uint8_t data[LRUDP_MAX_PAYLOAD];
+  };
+
+  LRudpSession(const LRudpSession&);
+  LRudpSession& operator=(const LRudpSession&);
+
+  void transmitSegment(uint32_t seq, uint32_t now);
+  void transmitAck();
+  void flushSegments(uint32_t now);
+  void handleData(const uint8_t *buf, size_t len);
+  void handleAck(const uint8_t *buf, uint32_t now);
+  void updateRtt(uint32_t sample);
+  int nextSlot() const;
+  void releaseSlots();
+  uint8_t freeWindow() const;
+
+  LRudpMode m_mode;
+  uint32_t m_session;       // our sending session
+  bool m_failed;
+
+  // sending side
+  Segment m_snd[LRUDP_WINDOW];
+  uint32_t m_sndUna;        // oldest segment not acknowledged
+  uint32_t m_sndNxt;        // next sequence number to use
+  uint32_t m_sndLimit;      // the peer has room below this sequence number
+  uint32_t m_lastAckAt;
+  uint32_t m_srtt;
+  uint32_t m_rttvar;
+  uint32_t m_rto;
+  uint32_t m_retransmissions;
+
+  // receiving side
+  Slot m_rcv[LRUDP_WINDOW];
+  uint32_t m_peerSession;
+  bool m_peerKnown;
+  uint32_t m_oldPeerSession; // the session m_peerSession replaced
+  bool m_oldPeerKnown;
+  uint32_t m_rcvBase;       // oldest segment not read
+  uint32_t m_rcvNxt;        // next segment expected in order
+  uint32_t m_ackEcho;       // send time of the last data segment, echoed for the rtt
+  bool m_ackPending;
+
+  uint8_t m_packet[LRUDP_MAX_DATAGRAM];
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+
+ Reliable telemetry over GPRS
+
+ Sends one sensor frame per second to a server with LReliableUDP.
+ Lost frames are sent again without holding back the newer ones.
+ On the server, run the Linux peer from extras/host of this library
+ in LRUDP_MESSAGE_UNORDERED mode on port 5000.
+
+ This code is in the public domain.
+
+ */
+#include <LGPRS.h>
+#include <LGPRSUdp.h>
+#include <LReliableUDP.h>
+
+IPAddress server(203, 0, 113, 7);   // replace with your server address
+const uint16_t port = 5000;
+
+LGPRSUDP udp;
+LReliableUDP telemetry(udp);
+unsigned long lastFrame = 0;
+unsigned long frameCount = 0;
+
+void setup()
+{
+  Serial.begin(115200);
+
+  while (!LGPRS.attachGPRS())
+  {
+    Serial.println("retry GPRS attach");
+    delay(1000);
+  }
+
+  udp.begin(port);
+  telemetry.begin(server, port, LRUDP_MESSAGE_UNORDERED);
+  Serial.println("setup() done");
+}
+
+void loop()
+{
+  telemetry.poll();
+
+  if (millis() - lastFrame >= 1000)
+  {
+    lastFrame = millis();
+
+    char frame[64];
+    int len = sprintf(frame, "frame %lu a0=%d", frameCount, analogRead(A0));
+    if (telemetry.write((const uint8_t*)frame, len))
+    {
+      frameCount++;
+    }
+    else
+    {
+      Serial.println("send window full");
+    }
+
+    Serial.print("rtt ");
+    Serial.print(telemetry.rtt());
+    Serial.print(" ms, retransmissions ");
+    Serial.println(telemetry.retransmissions());
+  }
+
+  if (telemetry.failed())
+  {
+    Serial.println("peer lost, restarting session");
+    telemetry.begin(server, port, LRUDP_MESSAGE_UNORDERED);
+  }
+}
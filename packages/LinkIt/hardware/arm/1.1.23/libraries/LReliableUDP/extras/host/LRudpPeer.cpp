@@ -0,0 +1,135 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#include <netdb.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "LRudpPeer.h"
+
+LRudpPeer::LRudpPeer():
+	m_fd(-1),
+	m_remoteAddr(0),
+	m_remotePort(0)
+{
+}
+
+LRudpPeer::~LRudpPeer()
+{
+	close();
+}
+
+uint32_t LRudpPeer::now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+bool LRudpPeer::open(uint16_t localPort, const char *remoteHost, uint16_t remotePort, LRudpMode mode)
+{
+	close();
+
+	struct addrinfo hints;
+	struct addrinfo *res = NULL;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if(getaddrinfo(remoteHost, NULL, &hints, &res) != 0 || res == NULL)
+	{
+		return false;
+	}
+	m_remoteAddr = ((struct sockaddr_in*)res->ai_addr)->sin_addr.s_addr;
+	m_remotePort = htons(remotePort);
+	freeaddrinfo(res);
+
+	m_fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if(m_fd < 0)
+	{
+		return false;
+	}
+
+	struct sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(localPort);
+	if(bind(m_fd, (struct sockaddr*)&local, sizeof(local)) < 0)
+	{
+		close();
+		return false;
+	}
+
+	// a new id per open, so the board drops what it kept from an earlier run
+	reset(mode, now() ^ ((uint32_t)getpid() << 16));
+	return true;
+}
+
+void LRudpPeer::close()
+{
+	if(m_fd >= 0)
+	{
+		::close(m_fd);
+		m_fd = -1;
+	}
+}
+
+size_t LRudpPeer::write(const uint8_t *buf, size_t len)
+{
+	return send(buf, len, now());
+}
+
+void LRudpPeer::poll(int waitMs)
+{
+	if(m_fd < 0)
+	{
+		return;
+	}
+
+	struct pollfd pfd;
+	pfd.fd = m_fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if(::poll(&pfd, 1, waitMs) > 0)
+	{
+		uint8_t buf[LRUDP_MAX_DATAGRAM];
+		struct sockaddr_in from;
+		socklen_t fromLen = sizeof(from);
+		ssize_t n;
+		while((n = recvfrom(m_fd, buf, sizeof(buf), MSG_DONTWAIT, (struct sockaddr*)&from, &fromLen)) >= 0)
+		{
+			// only the peer of this session
+			if(from.sin_addr.s_addr == m_remoteAddr && from.sin_port == m_remotePort)
+			{
+				input(buf, (size_t)n, now());
+			}
+			fromLen = sizeof(from);
+		}
+	}
+	tick(now());
+}
+
+void LRudpPeer::transmit(const uint8_t *buf, size_t len)
+{
+	struct sockaddr_in to;
+	memset(&to, 0, sizeof(to));
+	to.sin_family = AF_INET;
+	to.sin_addr.s_addr = m_remoteAddr;
+	to.sin_port = m_remotePort;
+	sendto(m_fd, buf, len, 0, (struct sockaddr*)&to, sizeof(to));
+}
@@ -0,0 +1,69 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+#ifndef _LRudpPeer_h
+#define _LRudpPeer_h
+
+#include "../../LRudpSession.h"
+
+// Linux end of an LReliableUDP session, for servers and for testing a board
+// against a PC. It runs the same protocol engine as the board over a POSIX
+// UDP socket. Build it together with the engine, for example:
+//
+//   g++ -I<path>/LReliableUDP <path>/LReliableUDP/LRudpSession.cpp LRudpPeer.cpp app.cpp
+//
+// EXAMPLE:
+// <code>
+//     LRudpPeer peer;
+//     peer.open(5000, "192.168.1.20", 5000, LRUDP_MESSAGE);
+//     uint8_t msg[LRUDP_MAX_PAYLOAD];
+//     for (;;) {
+//         peer.poll(10);
+//         while (int n = peer.read(msg, sizeof(msg))) handle(msg, n);
+//     }
+// </code>
+class LRudpPeer : public LRudpSession
+{
+public:
+  LRudpPeer();
+  virtual ~LRudpPeer();
+
+  // binds localPort and starts a session with remoteHost:remotePort.
+  // Returns false if the socket cannot be opened or the host is unknown.
+  bool open(uint16_t localPort, const char *remoteHost, uint16_t remotePort, LRudpMode mode);
+
+  void close();
+
+  // queues data, see LRudpSession::send()
+  size_t write(const uint8_t *buf, size_t len);
+
+  // waits up to waitMs for datagrams, handles them and runs the timers
+  void poll(int waitMs);
+
+  // current time in milliseconds, the clock the session runs on
+  static uint32_t now();
+
+  // socket descriptor, for use in the caller's own poll() loop; -1 if closed
+  int fd() const { return m_fd; }
+
+protected:
+  virtual void transmit(const uint8_t *buf, size_t len);
+
+private:
+  int m_fd;
+  uint32_t m_remoteAddr;   // network byte order
+  uint16_t m_remotePort;   // network byte order
+};
+
+#endif
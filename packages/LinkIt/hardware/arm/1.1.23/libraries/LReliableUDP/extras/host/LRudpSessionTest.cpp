@@ -0,0 +1,189 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+   See the GNU Lesser General Public License for more details.
+*/
+
+// Host test of the LReliableUDP protocol engine. Two sessions exchange
+// datagrams through memory on a simulated clock, so no network is needed:
+//
+//   g++ -I<path>/LReliableUDP <path>/LReliableUDP/LRudpSession.cpp LRudpSessionTest.cpp -o rudp_test
+//   ./rudp_test
+//
+// It prints one line per case and exits with 1 if any of them failed.
+
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+#include "../../LRudpSession.h"
+
+typedef std::vector<uint8_t> Datagram;
+
+// keeps what the session sends until the test delivers it
+class TestSession : public LRudpSession
+{
+public:
+	std::deque<Datagram> out;
+
+protected:
+	virtual void transmit(const uint8_t *buf, size_t len)
+	{
+		out.push_back(Datagram(buf, buf + len));
+	}
+};
+
+static int s_failures = 0;
+
+static void check(bool ok, const char *name)
+{
+	printf("%s %s\n", ok ? "ok  " : "FAIL", name);
+	if(!ok)
+	{
+		s_failures++;
+	}
+}
+
+// hands everything one side sent to the other
+static void deliver(TestSession &from, TestSession &to, uint32_t now)
+{
+	while(!from.out.empty())
+	{
+		const Datagram d = from.out.front();
+		from.out.pop_front();
+		to.input(&d[0], d.size(), now);
+	}
+}
+
+static void step(TestSession &a, TestSession &b, uint32_t now)
+{
+	a.tick(now);
+	b.tick(now);
+	deliver(a, b, now);
+	deliver(b, a, now);
+}
+
+static void readAll(TestSession &s, std::vector<uint8_t> &got)
+{
+	uint8_t buf[LRUDP_MAX_PAYLOAD];
+	int n;
+	while((n = s.read(buf, sizeof(buf))) > 0)
+	{
+		got.insert(got.end(), buf, buf + n);
+	}
+}
+
+// sends data from a to b, reading as it arrives; returns what b got
+static std::vector<uint8_t> transfer(TestSession &a, TestSession &b, const std::vector<uint8_t> &data, uint32_t &now)
+{
+	std::vector<uint8_t> got;
+	size_t queued = 0;
+	const uint32_t end = now + 120000;
+	while((queued < data.size() || !a.idle()) && now < end && !a.failed())
+	{
+		if(queued < data.size())
+		{
+			queued += a.send(&data[queued], data.size() - queued, now);
+		}
+		step(a, b, now);
+		readAll(b, got);
+		now += 10;
+	}
+	return got;
+}
+
+static std::vector<uint8_t> pattern(size_t size, int seed)
+{
+	std::vector<uint8_t> data;
+	for(size_t i = 0; i < size; ++i)
+	{
+		data.push_back((uint8_t)(i * 7 + seed));
+	}
+	return data;
+}
+
+static void testTransfer()
+{
+	TestSession a, b;
+	a.reset(LRUDP_STREAM, 1);
+	b.reset(LRUDP_STREAM, 2);
+
+	uint32_t now = 1;
+	const std::vector<uint8_t> data = pattern(20000, 0);
+	check(transfer(a, b, data, now) == data && !a.failed(), "stream transfer");
+}
+
+// a datagram of the peer's previous session arrives after it restarted
+static void testStaleSession()
+{
+	TestSession a, b;
+	a.reset(LRUDP_STREAM, 1);
+	b.reset(LRUDP_STREAM, 2);
+
+	uint32_t now = 1;
+	const std::vector<uint8_t> first = pattern(2000, 1);
+	a.send(&first[0], first.size(), now);
+	// the network holds on to the first datagram of the old session
+	const Datagram stale = a.out.front();
+	step(a, b, now);
+	std::vector<uint8_t> got;
+	readAll(b, got);
+
+	// the new session gets further than one window, then the stale
+	// datagram arrives
+	a.reset(LRUDP_STREAM, 3);
+	const std::vector<uint8_t> second = pattern(LRUDP_WINDOW * LRUDP_MAX_PAYLOAD * 4, 2);
+	const size_t half = second.size() / 2;
+	got = transfer(a, b, std::vector<uint8_t>(second.begin(), second.begin() + half), now);
+	b.input(&stale[0], stale.size(), now);
+	const std::vector<uint8_t> tail = transfer(a, b, std::vector<uint8_t>(second.begin() + half, second.end()), now);
+	got.insert(got.end(), tail.begin(), tail.end());
+	check(got == second && !a.failed(), "stale datagram of an old session");
+}
+
+// the receiver stops reading for longer than the retries would last
+static void testZeroWindow()
+{
+	TestSession a, b;
+	a.reset(LRUDP_STREAM, 1);
+	b.reset(LRUDP_STREAM, 2);
+
+	uint32_t now = 1;
+	const std::vector<uint8_t> data = pattern(LRUDP_WINDOW * LRUDP_MAX_PAYLOAD * 3, 3);
+	size_t queued = 0;
+	const uint32_t stall = now + 5 * 60000;
+	while(now < stall && !a.failed())
+	{
+		if(queued < data.size())
+		{
+			queued += a.send(&data[queued], data.size() - queued, now);
+		}
+		step(a, b, now);
+		now += 10;
+	}
+	const bool survived = !a.failed();
+
+	// reading again opens the window and the rest follows
+	std::vector<uint8_t> got;
+	readAll(b, got);
+	const std::vector<uint8_t> rest(data.begin() + queued, data.end());
+	const std::vector<uint8_t> tail = transfer(a, b, rest, now);
+	got.insert(got.end(), tail.begin(), tail.end());
+	check(survived && got == data && !a.failed(), "zero window for five minutes");
+}
+
+int main()
+{
+	testTransfer();
+	testStaleSession();
+	testZeroWindow();
+	return s_failures ? 1 : 0;
+}
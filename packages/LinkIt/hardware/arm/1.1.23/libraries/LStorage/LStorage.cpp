@@ -142,6 +142,7 @@ struct linkit_file_read_struct
     void *buf;
     VMUINT nbyte;
     boolean peek_mode;
+    VMINT terminator;   // >= 0: stop after this byte
 
 };
 
@@ -205,6 +206,21 @@ struct linkit_file_handle_struct
 #define HDL(fd)  ((linkit_file_handle_struct*)fd)->_hdl
 #define REF(fd) ((linkit_file_handle_struct*)fd)->_ref
 
+// queue the pending write buffer in front of the next file operation,
+// so both run in the same MMI thread hop
+static void _batch_flush(LTaskBatch &batch, linkit_file_flush_struct &data, VMUINT fd, uint8_t *buf, uint8_t &bufPos)
+{
+    if(bufPos == 0)
+        return;
+
+    data.fd = fd;
+    data.buf = buf;
+    data.nbyte = bufPos;
+    batch.add(linkit_file_flush_handler, &data);
+
+    bufPos = 0;
+}
+
 /*****************************************************************************
 * 
 * LFile class
@@ -246,6 +262,39 @@ size_t LFile::write(uint8_t v)
     return 1;
 }
 
+size_t LFile::write(const uint8_t *buf, size_t size)
+{
+    if(!_fd || _isDir)
+        return 0;
+
+    if(size < LS_WRITE_BUF_SIZE)
+    {
+        size_t done = 0;
+        while(done < size)
+        {
+            size_t chunk = LS_WRITE_BUF_SIZE - _bufPos;
+            if(chunk > size - done)
+                chunk = size - done;
+            memcpy(_buf + _bufPos, buf + done, chunk);
+            _bufPos += chunk;
+            done += chunk;
+            if(_bufPos == LS_WRITE_BUF_SIZE)
+                flush();
+        }
+        return size;
+    }
+
+    // large blocks go straight to the file, after what is buffered
+    flush();
+
+    linkit_file_flush_struct data;
+    data.fd = _fd;
+    data.buf = (void*)buf;
+    data.nbyte = size;
+    LTask.remoteCall(linkit_file_flush_handler, &data);
+    return size;
+}
+
 int LFile::read()
 {
     uint8_t buf[1];
@@ -311,7 +360,18 @@ int LFile::read(void *buf, uint16_t nbyte)
     return _read(buf, nbyte, false);
 }
 
-int LFile::_read(void *buf, uint16_t nbyte, boolean peek_mode)
+int LFile::read(uint8_t *buf, size_t size)
+{
+    return _read(buf, size > 0xFFFF ? 0xFFFF : size, false);
+}
+
+int LFile::readAvailableUntil(uint8_t terminator, uint8_t *buf, size_t size)
+{
+    int result = _read(buf, size > 0xFFFF ? 0xFFFF : size, false, terminator);
+    return result < 0 ? 0 : result;
+}
+
+int LFile::_read(void *buf, uint16_t nbyte, boolean peek_mode, VMINT terminator)
 {
     linkit_file_read_struct data;
     
@@ -322,6 +382,7 @@ int LFile::_read(void *buf, uint16_t nbyte, boolean peek_mode)
     data.buf = buf;
     data.nbyte = nbyte;
     data.peek_mode = peek_mode;
+    data.terminator = terminator;
 
     LTask.remoteCall(linkit_file_read_handler, &data);
     
@@ -331,14 +392,19 @@ int LFile::_read(void *buf, uint16_t nbyte, boolean peek_mode)
 boolean LFile::seek(uint32_t pos)
 {
     linkit_file_seek_struct data;
+    linkit_file_flush_struct flushData;
+    LTaskBatch batch;
     
     if(!_fd || _isDir)
         return false;
 
+    _batch_flush(batch, flushData, _fd, _buf, _bufPos);
+
     data.fd = _fd;
     data.pos = pos;
+    batch.add(linkit_file_seek_handler, &data);
 
-    LTask.remoteCall(linkit_file_seek_handler, &data);
+    LTask.batch(batch);
     
     return data.result;
 }
@@ -346,13 +412,18 @@ boolean LFile::seek(uint32_t pos)
 uint32_t LFile::position()
 {
     linkit_file_general_struct data;
+    linkit_file_flush_struct flushData;
+    LTaskBatch batch;
     
     if(!_fd || _isDir)
         return 0;
 
+    _batch_flush(batch, flushData, _fd, _buf, _bufPos);
+
     data.fd = _fd;
+    batch.add(linkit_file_position_handler, &data);
 
-    LTask.remoteCall(linkit_file_position_handler, &data);
+    LTask.batch(batch);
     
     return data.value;
 }
@@ -360,13 +431,18 @@ uint32_t LFile::position()
 uint32_t LFile::size()
 {
     linkit_file_general_struct data;
+    linkit_file_flush_struct flushData;
+    LTaskBatch batch;
     
     if(!_fd || _isDir)
         return 0;
 
+    _batch_flush(batch, flushData, _fd, _buf, _bufPos);
+
     data.fd = _fd;
+    batch.add(linkit_file_size_handler, &data);
 
-    LTask.remoteCall(linkit_file_size_handler, &data);
+    LTask.batch(batch);
     
     return data.value;
 }
@@ -374,18 +450,23 @@ uint32_t LFile::size()
 void LFile::close()
 {
     linkit_file_general_struct data;
+    linkit_file_flush_struct flushData;
+    LTaskBatch batch;
     
     if(!_fd)
         return;
 
-    flush();
+    if(!_isDir)
+        _batch_flush(batch, flushData, _fd, _buf, _bufPos);
         
     data.fd = _fd;
 
     if(_isDir)
-        LTask.remoteCall(linkit_file_find_close_handler, &data);
+        batch.add(linkit_file_find_close_handler, &data);
     else
-        LTask.remoteCall(linkit_file_close_handler, &data);
+        batch.add(linkit_file_close_handler, &data);
+
+    LTask.batch(batch);
         
     _fd = 0;
 }
@@ -478,6 +559,17 @@ boolean linkit_file_read_handler(void* userdata)
         // peek mode, rewind back
         vm_file_seek(HDL(data->fd), -read, BASE_CURR);
     }
+    else if(data->terminator >= 0 && data->result > 0)
+    {
+        // keep the bytes after the terminator for the next read
+        const void *found = memchr(data->buf, data->terminator, read);
+        if(found)
+        {
+            VMUINT used = (const char*)found - (const char*)data->buf + 1;
+            vm_file_seek(HDL(data->fd), -(VMINT)(read - used), BASE_CURR);
+            data->result = used;
+        }
+    }
     
     return true;
 }
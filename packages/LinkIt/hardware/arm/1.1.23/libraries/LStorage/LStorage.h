@@ -56,7 +56,15 @@ public:
         uint8_t v   // [IN] The byte to write.
     );
 
-    //virtual size_t write(const uint8_t *buf, size_t size);
+	// DESCRIPTION
+	//  Writes a block of data to the file opened with FILE_WRITE mode.
+	//  Small blocks are collected like single bytes; large ones are written with one request to the file system.
+	// RETURNS
+	//  Number of bytes written.
+    virtual size_t write(
+        const uint8_t *buf, // [IN] The data to write.
+        size_t size         // [IN] The number of bytes in buf.
+    );
 
 	// DESCRIPTION
 	//  Reads single byte from the file and moves the file cursor 1 step further.
@@ -94,6 +102,28 @@ public:
         uint16_t nbyte  // [IN] The size of buffer.
     );
 
+	// DESCRIPTION
+	//  Reads up to size bytes from the file with a single request to the file system.
+	// RETURNS
+	//  Number of bytes read.
+	//  0: The end of file.
+    virtual int read(
+        uint8_t *buf,   // [OUT] The buffer to retrieve data.
+        size_t size     // [IN] The size of buffer.
+    );
+
+	// DESCRIPTION
+	//  Reads up to size bytes from the file, stopping after the first terminator byte.
+	//  The cursor is left just after the last byte returned.
+	// RETURNS
+	//  Number of bytes read, including the terminator if it was found.
+	//  0: The end of file.
+    virtual int readAvailableUntil(
+        uint8_t terminator, // [IN] The byte to stop at.
+        uint8_t *buf,       // [OUT] The buffer to retrieve data.
+        size_t size         // [IN] The size of buffer.
+    );
+
 	// DESCRIPTION
 	//  Changes the cursor position; it can be from 0 to the size of file.
 	//
@@ -161,7 +191,7 @@ public:
     void rewindDirectory(void);
 
 private:
-    int _read(void *buf, uint16_t nbyte, boolean peek_mode);
+    int _read(void *buf, uint16_t nbyte, boolean peek_mode, VMINT terminator = -1);
 
 private:
     unsigned int _fd;
@@ -14,6 +14,7 @@
 
 #include <Arduino.h>
 #include "LTask.h"
+#include "LDnsCache.h"
 #include "LWiFi.h"
 #include "vmhttp.h"
 #include "vmlog.h"
@@ -557,117 +558,11 @@ LWifiStatus LWiFiClass::status()
   }
 }
 
-struct LWiFiResolveContext
-{
-  const char *domainName;
-  vm_soc_dns_result dns;
-  VMINT resolveState;
-
-  LWiFiResolveContext():
-      domainName(NULL),
-      resolveState(VM_E_SOC_INVAL)
-  {
-    memset(&dns, 0, sizeof(dns));
-  }
-
-  ~LWiFiResolveContext()
-  {
-  }
-};
-
-static VMINT wifiResolveCallback(VMINT jobId, vm_soc_dns_result *pDNS, void *userData)
-{
-  vm_log_info("wifiResolveCallback");
-  LWiFiResolveContext *pContext = (LWiFiResolveContext*)userData;
-  unsigned char* ipArray = (unsigned char*)&pDNS->address[0];
-  vm_log_info("DNS resolve callback, cause=%d, num=%d, address=%d.%d.%d.%d",
-              pDNS->error_cause,
-              pDNS->num,
-              ipArray[0],
-              ipArray[1],
-              ipArray[2],
-              ipArray[3]);
-
-  // TODO: since we don't know the definition of error_cause yet,
-  // treat all as OK.
-  if (pDNS && pDNS != &pContext->dns)
-  {
-    vm_log_info("pDNS != pContext->dns");
-    pContext->dns = *pDNS;
-  }
-  pContext->resolveState = VM_E_SOC_SUCCESS;
-  LTask.post_signal();
-}
-
-static boolean wifiResolveDomainName(void *userData)
-{
-  LWiFiResolveContext *pContext = (LWiFiResolveContext*)userData;
-
-  vm_log_info("vm_soc_get_host_by_name_ex: %s", pContext->domainName);
-  pContext->resolveState = vm_soc_get_host_by_name_ex(VM_TCP_APN_WIFI,
-                           pContext->domainName,
-                           &pContext->dns,
-                           &wifiResolveCallback,
-                           pContext);
-  vm_log_info("vm_soc_get_host_by_name_ex ret = %d", pContext->resolveState);
-
-  if (pContext->resolveState > 0)
-  {
-    // not done yet
-    return false;
-  }
-
-  switch (pContext->resolveState)
-  {
-  case VM_E_SOC_SUCCESS:  // Get IP address successfully, result is filled.
-    return true;
-  case VM_E_SOC_WOULDBLOCK:  // wait response from network, result could be gotten from callback.
-    // need to wait, return directly
-    // so MMI message loop may continue.
-    return false;
-  case VM_E_SOC_INVAL:  // invalid arguments: null domain_name, etc.
-  case VM_E_SOC_ERROR:  // unspecified error
-  case VM_E_SOC_LIMIT_RESOURCE:  // socket resources not available
-  case VM_E_SOC_INVALID_ACCOUNT:  // invalid data account id
-    return true;
-  }
-}
-
 int LWiFiClass::hostByName(const char* aHostname, IPAddress& aResult)
 {
   vm_log_info("hostByName");
-  LWiFiResolveContext context;
-  // no memory copy since we're blocking call
-  context.domainName = aHostname;
-  LTask.remoteCall(&wifiResolveDomainName, (void*)&context);
-
-  vm_log_info("context.resolveState = %d", context.resolveState);
-  unsigned char* ipArray = (unsigned char*)&context.dns.address[0];
-  vm_log_info("Arduino DNS resolve callback, cause=%d, num=%d, address=%d.%d.%d.%d",
-              context.dns.error_cause,
-              context.dns.num,
-              ipArray[0],
-              ipArray[1],
-              ipArray[2],
-              ipArray[3]);
-  // parse result
-  if (VM_E_SOC_SUCCESS == context.resolveState)
-  {
-    // TODO: why are there multiple ip addresses?
-
-    aResult = context.dns.address[0];
-
-    vm_log_info("get IP=%d.%d.%d.%d",
-                aResult[0],
-                aResult[1],
-                aResult[2],
-                aResult[3]);
-    return 1;
-  }
-  else
-  {
-    return 0;
-  }
+  // cached answers need no trip to the network
+  return LDnsCache.resolve(VM_TCP_APN_WIFI, aHostname, aResult);
 }
 
 //------------------------------------
@@ -340,6 +340,7 @@ public:
 
   // DESCRIPTION
   //  Resolves the given hostname to an IP address.
+  //  Answers, including failures, are cached in LDnsCache.
   //
   // PARAMETERS
   //  param aHostname: The name to be resolved.
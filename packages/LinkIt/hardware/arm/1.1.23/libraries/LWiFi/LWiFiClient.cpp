@@ -36,6 +36,11 @@ LWiFiClient::LWiFiClient(VMINT handle, VMINT serverHandle):
 {
 }
 
+LWiFiClient::LWiFiClient(const SharedHandle &handle):
+    LTcpClient(handle)
+{
+}
+
 VMINT LWiFiClient::getAPN() const
 {
   return VM_TCP_APN_WIFI;
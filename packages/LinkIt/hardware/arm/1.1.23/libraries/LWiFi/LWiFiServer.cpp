@@ -23,6 +23,11 @@ LWiFiServer::LWiFiServer(uint16_t port):
 
 LWiFiClient LWiFiServer::available()
 {
+  if(m_maxClients)
+  {
+    return LWiFiClient(availableSlot());
+  }
+
   VMINT hClient = -1;
   VMINT hServer = -1;
   availableImpl(hClient, hServer);
@@ -32,6 +37,11 @@ LWiFiClient LWiFiServer::available()
   return LWiFiClient(hClient, hServer);
 }
 
+LWiFiClient LWiFiServer::client(int slot)
+{
+  return LWiFiClient(slotHandle(slot));
+}
+
 VMINT LWiFiServer::getAPN() const
 {
   return VM_TCP_APN_WIFI;
@@ -0,0 +1,40 @@
+/*
+  Copyright (c) 2014 MediaTek Inc.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License..
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+   See the GNU Lesser General Public License for more details.
+*/
+#ifndef LWiFiTlsClient_h
+#define LWiFiTlsClient_h
+#include "Arduino.h"
+#include <LTlsClient.h>
+
+//LWiFiTlsClient Class
+// 
+// Please see the method description of LTlsClient class.
+//
+// EXAMPLE:
+// <code>
+//     LWiFi.begin();
+//     LWiFi.connect("open_network");
+//     LWiFiTlsClient c;
+//     c.connect("www.website.com", 443);
+// </code>
+class LWiFiTlsClient : public LTlsClient
+{
+public:
+  LWiFiTlsClient();
+
+  /* DOM-NOT_FOR_SDK-BEGIN */
+  virtual VMINT getAPN() const;
+  /* DOM-NOT_FOR_SDK-END */
+};
+
+#endif  // LWiFiTlsClient_h
@@ -198,8 +198,8 @@ void setPinHandle(uint32_t ulPin, VM_DCL_HANDLE handle)
 /*
  * UART objects
  */
-RingBuffer rx_buffer1;
-RingBuffer rx_buffer2;
+RingBuffer<SERIAL_BUFFER_SIZE> rx_buffer1;
+RingBuffer<SERIAL_BUFFER_SIZE> rx_buffer2;
 
 UARTClass Serial(1, &rx_buffer1);
 UARTClass Serial1(2, &rx_buffer2);
@@ -217,11 +217,11 @@ void setPinHandle(uint32_t ulPin, VM_DCL_HANDLE handle)
 /*
  * UART objects
  */
-RingBuffer rx_buffer1;
-RingBuffer rx_buffer2;
+RingBuffer<SERIAL_RX_BUFFER_SIZE> rx_buffer1;
+RingBuffer<SERIAL1_RX_BUFFER_SIZE> rx_buffer2;
 
-UARTClass Serial(1, &rx_buffer1);
-UARTClass Serial1(2, &rx_buffer2);
+UARTClass Serial(1, &rx_buffer1, SERIAL_TX_BUFFER_SIZE);
+UARTClass Serial1(2, &rx_buffer2, SERIAL1_TX_BUFFER_SIZE);
 
 void serialEvent() __attribute__((weak));
 void serialEvent1() __attribute__((weak));
@@ -43,6 +43,22 @@
 #include "UARTClass.h"
 #endif
 
+/*
+ * Serial buffer sizes in bytes; set them with -D to override.
+ * SERIAL_* applies to Serial (USB) and is the default for Serial1.
+ * A transmit size of 0 writes straight to the port.
+ * SERIAL_TX_BUFFER_SIZE is set in UARTClass.h.
+ */
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE SERIAL_BUFFER_SIZE
+#endif
+#ifndef SERIAL1_RX_BUFFER_SIZE
+#define SERIAL1_RX_BUFFER_SIZE SERIAL_RX_BUFFER_SIZE
+#endif
+#ifndef SERIAL1_TX_BUFFER_SIZE
+#define SERIAL1_TX_BUFFER_SIZE SERIAL_TX_BUFFER_SIZE
+#endif
+
 static const uint8_t LED_BUILTIN = 13;
 static const uint8_t A0  = 14;/*analog input pin A0*/
 static const uint8_t A1  = 15;/*analog input pin A1*/